@@ -0,0 +1,94 @@
+//
+//  AlignedAllocator.h
+//  MatrixDSP
+//
+//  A standard allocator that returns memory aligned to "Alignment" bytes.  It's the default
+//  allocator of Vector, ComplexVector and Matrix2d, with 64 byte alignment, so their data
+//  starts on a cache line and full width AVX-512 loads from the start of a buffer never split
+//  cache lines.
+//
+
+#ifndef AlignedAllocator_h
+#define AlignedAllocator_h
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <malloc.h>
+#endif
+
+namespace MatrixDSP {
+
+/**
+ * \brief The alignment, in bytes, of the data of the library's containers.  One cache line,
+ *      which is also the width of an AVX-512 register.
+ */
+const std::size_t defaultAlignment = 64;
+
+template <class T, std::size_t Alignment = defaultAlignment>
+class AlignedAllocator {
+    static_assert(Alignment >= alignof(void *) && (Alignment & (Alignment - 1)) == 0,
+                  "Alignment must be a power of 2 that is at least the alignment of a pointer");
+
+    public:
+    typedef T value_type;
+    typedef T *pointer;
+    typedef const T *const_pointer;
+    typedef T &reference;
+    typedef const T &const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    static const std::size_t alignment = Alignment;
+
+    AlignedAllocator() noexcept {}
+
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+    T * allocate(std::size_t n) {
+        if (n == 0) {
+            return nullptr;
+        }
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        void *ptr = nullptr;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+        ptr = _aligned_malloc(n * sizeof(T), Alignment);
+#else
+        if (posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0) {
+            ptr = nullptr;
+        }
+#endif
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(ptr);
+    }
+
+    void deallocate(T *ptr, std::size_t) noexcept {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+};
+
+template <class T, class U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &) {return true;}
+
+template <class T, class U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &) {return false;}
+
+}
+
+#endif /* AlignedAllocator_h */
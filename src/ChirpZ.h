@@ -0,0 +1,203 @@
+//
+//  ChirpZ.h
+//  MatrixDSP
+//
+//  The chirp-z transform, which evaluates the z-transform of N samples at K points along a
+//  spiral z = a w^-k, k = 0 ... K - 1.  With a and w on the unit circle that's K bins of a DFT
+//  with any starting frequency and spacing, which is how a zoom FFT looks closely at a narrow
+//  band without a huge FFT.
+//
+//  It's done with Bluestein's algorithm.  nk = (n^2 + k^2 - (k - n)^2) / 2, so
+//
+//      X[k] = sum x[n] a^-n w^nk = w^(k^2/2) sum (x[n] a^-n w^(n^2/2)) w^(-(k-n)^2/2)
+//
+//  which is a convolution of the premultiplied samples with a chirp, done with FFTs of a
+//  length that kissfft is fast at.  The chirps and the FFT of the filter are worked out once,
+//  when the transform is made.
+//
+
+#ifndef ChirpZ_h
+#define ChirpZ_h
+
+#include <algorithm>
+#include <cassert>
+#include <complex>
+#include <vector>
+#include "FftSetupManager.h"
+#include "ScratchArena.h"
+#include "Simd.h"
+#include "Vector.h"
+
+namespace MatrixDSP {
+
+/**
+ * \brief Chirp-z transform of a fixed number of samples to a fixed number of points.
+ *
+ * Output k is the sum over n of x[n] a^-n w^nk.  With K = N, w = exp(-2 pi j / K) and the
+ * default a = 1 it's the DFT.
+ */
+template <class T>
+class ChirpZ {
+    typedef std::complex<T> Complex;
+
+    unsigned inputLen;
+    unsigned outputLen;
+    unsigned fftLen;
+    std::vector<Complex> premultiply;   // a^-n w^(n^2/2)
+    std::vector<Complex> postmultiply;  // w^(k^2/2)
+    std::vector<Complex> filter;        // FFT of w^(-m^2/2) for m = -(N-1) ... K-1, divided by fftLen
+
+    /**
+     * \brief exp(exponent * logBase), worked out in double precision.
+     */
+    static Complex power(const std::complex<double> &logBase, double exponent) {
+        return (Complex) std::exp(logBase * exponent);
+    }
+
+    /**
+     * \brief Works out the chirps and the filter from the logs of w and a.  They're logs so that
+     *      the zoom FFT's angles aren't rounded to T first, which would be squared along with n.
+     */
+    void init(const std::complex<double> &logW, const std::complex<double> &logA) {
+        assert(inputLen > 0 && outputLen > 0);
+        fftLen = fastFftLength(inputLen + outputLen - 1);
+
+        premultiply.resize(inputLen);
+        for (unsigned n = 0; n < inputLen; n++) {
+            premultiply[n] = (Complex) std::exp(logW * (0.5 * n * n) - logA * (double) n);
+        }
+        postmultiply.resize(outputLen);
+        for (unsigned k = 0; k < outputLen; k++) {
+            postmultiply[k] = power(logW, 0.5 * k * k);
+        }
+
+        // The filter at negative lags wraps around to the end, which the outputs never reach
+        ScratchBuffer<Complex> chirp(fftLen);
+        std::fill(chirp.data(), chirp.data() + fftLen, Complex());
+        for (unsigned m = 0; m < outputLen; m++) {
+            chirp[m] = power(logW, -0.5 * m * m);
+        }
+        for (unsigned m = 1; m < inputLen; m++) {
+            chirp[fftLen - m] = power(logW, -0.5 * m * m);
+        }
+        filter.resize(fftLen);
+        fftSetupManager<T>().getFftSetup(fftLen)->transform(chirp.data(), filter.data());
+        for (Complex &bin : filter) {
+            bin /= (T) fftLen;
+        }
+    }
+
+public:
+    /**
+     * \brief Constructor.
+     *
+     * \param inputLen The number of samples, N.
+     * \param outputLen The number of points, K.
+     * \param w The ratio between successive points.
+     * \param a The first point.  Defaults to 1.
+     */
+    ChirpZ(unsigned inputLen, unsigned outputLen, std::complex<T> w, std::complex<T> a = 1) :
+            inputLen(inputLen), outputLen(outputLen) {
+        assert(w != Complex(0) && a != Complex(0));
+        init(std::log(std::complex<double>(w)), std::log(std::complex<double>(a)));
+    }
+
+    /**
+     * \brief Zoom FFT constructor: "numBins" bins of a DFT, starting at "startFreq" and
+     *      "binSpacing" apart.
+     *
+     * \param inputLen The number of samples.
+     * \param numBins The number of bins.
+     * \param startFreq The frequency of the first bin.
+     * \param binSpacing The frequency spacing of the bins.
+     * \param sampleFreq The sample rate that the frequencies are relative to.  Defaults to 1.
+     */
+    ChirpZ(unsigned inputLen, unsigned numBins, double startFreq, double binSpacing, double sampleFreq = 1) :
+            inputLen(inputLen), outputLen(numBins) {
+        init(std::complex<double>(0, -2 * M_PI * binSpacing / sampleFreq),
+             std::complex<double>(0, 2 * M_PI * startFreq / sampleFreq));
+    }
+
+    unsigned inputLength() const {return inputLen;}
+    unsigned outputLength() const {return outputLen;}
+
+    /**
+     * \brief The length of the FFTs that the transform uses.
+     */
+    unsigned fftLength() const {return fftLen;}
+
+    /**
+     * \brief Transforms inputLength() samples into outputLength() points.
+     *
+     * \param input The samples.
+     * \param output The points.  May be "input" if there is room in it for the output.
+     */
+    void transform(const Complex *input, Complex *output) const {
+        ScratchBuffer<Complex> work(2 * fftLen);
+        Complex *samples = work.data();
+        Complex *bins = samples + fftLen;
+        std::copy(input, input + inputLen, samples);
+        simd::multiplySpectrum(samples, premultiply.data(), inputLen);
+        std::fill(samples + inputLen, samples + fftLen, Complex());
+        fftSetupManager<T>().getFftSetup(fftLen)->transform(samples, bins);
+        simd::multiplySpectrum(bins, filter.data(), fftLen);
+        fftSetupManager<T>().getFftSetup(fftLen, true)->transform(bins, samples);
+        std::copy(samples, samples + outputLen, output);
+        simd::multiplySpectrum(output, postmultiply.data(), outputLen);
+    }
+
+    /**
+     * \brief Transforms "input", which must have inputLength() samples.
+     *
+     * \param output The points.  Resized to outputLength().  May be "input".
+     * \return Reference to "output".
+     */
+    template <class InputAlloc, class OutputAlloc>
+    Vector<Complex, OutputAlloc> & transform(const Vector<Complex, InputAlloc> &input, Vector<Complex, OutputAlloc> &output) const {
+        assert(input.size() == inputLen);
+        if ((const void *) &input == (const void *) &output) {
+            output.resize(std::max(inputLen, outputLen));
+            transform(output.vec.data(), output.vec.data());
+            output.resize(outputLen);
+            return output;
+        }
+        output.resize(outputLen);
+        output.rowVector = input.rowVector;
+        transform(input.vec.data(), output.vec.data());
+        return output;
+    }
+};
+
+/**
+ * \brief Chirp-z transform of "input" with a fresh ChirpZ.
+ *
+ * \param output "numPoints" points of the z-transform of "input", at a w^-k for k = 0 ...
+ *      numPoints - 1.  May be "input".
+ * \return Reference to "output".
+ */
+template <class T, class InputAlloc, class OutputAlloc>
+Vector<std::complex<T>, OutputAlloc> & czt(const Vector<std::complex<T>, InputAlloc> &input,
+                                           Vector<std::complex<T>, OutputAlloc> &output, unsigned numPoints,
+                                           std::complex<T> w, std::complex<T> a = 1) {
+    ChirpZ<T> chirpZ(input.size(), numPoints, w, a);
+    return chirpZ.transform(input, output);
+}
+
+/**
+ * \brief Zoom FFT of "input": "numBins" DFT bins from "startFreq", "binSpacing" apart.
+ *
+ * \param output The bins.  May be "input".
+ * \param sampleFreq The sample rate that the frequencies are relative to.  Defaults to 1.
+ * \return Reference to "output".
+ */
+template <class T, class InputAlloc, class OutputAlloc>
+Vector<std::complex<T>, OutputAlloc> & zoomFft(const Vector<std::complex<T>, InputAlloc> &input,
+                                               Vector<std::complex<T>, OutputAlloc> &output, unsigned numBins,
+                                               double startFreq, double binSpacing, double sampleFreq = 1) {
+    ChirpZ<T> chirpZ(input.size(), numBins, startFreq, binSpacing, sampleFreq);
+    return chirpZ.transform(input, output);
+}
+
+}
+
+#endif /* ChirpZ_h */
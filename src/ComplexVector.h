@@ -11,21 +11,25 @@
 
 #include <complex>
 #include <cassert>
+#include <algorithm>
+#include <utility>
+#include <vector>
 #include "Vector.h"
 #include "FftSetupManager.h"
+#include "PeakSearch.h"
+#include "Transcendental.h"
 #include <iostream>
 #include <iomanip>
 
 namespace MatrixDSP {
  
-template <class T>
-class ComplexVector : public Vector< std::complex<T> > {
+template <class T, class Alloc = AlignedAllocator< std::complex<T> > >
+class ComplexVector : public Vector< std::complex<T>, Alloc > {
     private:
     
-    static FftSetupManager<T, typename std::vector<T>::iterator, typename std::vector< std::complex<T> >::iterator >& GetFftSetupManager()
+    static FftSetupManager<T, T *, std::complex<T> *> & GetFftSetupManager()
     {
-        static FftSetupManager<T, typename std::vector<T>::iterator, typename std::vector< std::complex<T> >::iterator > managerInstance;
-        return managerInstance;
+        return fftSetupManager<T>();
     }
 
     public:
@@ -36,73 +40,98 @@ class ComplexVector : public Vector< std::complex<T> > {
     /**
      * \brief Basic constructor.
      *
-     * Just sets the size of \ref vec and the pointer to the scratch buffer, if one is provided.
+     * Just sets the size of \ref vec.
      * \param len Length of \ref vec.
-     * \param scratch Pointer to a scratch buffer.  The scratch buffer can be shared by multiple
-     *      objects (in fact, I recommend it), but if there are multiple threads then it should
-     *      be shared only by objects that are accessed by a single thread.  Objects in other
-     *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
      */
-    ComplexVector<T>(unsigned len = 0, bool rowVec = false, std::shared_ptr< std::vector< std::complex<T> > > scratch = nullptr) :
-            Vector< std::complex<T> >(len, rowVec, scratch) {}
+    ComplexVector(unsigned len = 0, bool rowVec = false) :
+            Vector< std::complex<T>, Alloc >(len, rowVec) {}
     
     /**
      * \brief Vector constructor.
      *
-     * Sets vec equal to the input "data" parameter and sets the pointer to the scratch buffer,
-     *      if one is provided.
+     * Sets vec equal to the input "data" parameter.
      * \param data Vector that \ref vec will be set equal to.
-     * \param scratch Pointer to a scratch buffer.  The scratch buffer can be shared by multiple
-     *      objects (in fact, I recommend it), but if there are multiple threads then it should
-     *      be shared only by objects that are accessed by a single thread.  Objects in other
-     *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
      */
-    ComplexVector<T>(std::vector< std::complex<T> > *data, bool rowVec = false, std::shared_ptr< std::vector< std::complex<T> > > scratch = nullptr) :
-            Vector< std::complex<T> >(data, rowVec, scratch) {}
+    template <class OtherAlloc>
+    ComplexVector(std::vector< std::complex<T>, OtherAlloc > *data, bool rowVec = false) :
+            Vector< std::complex<T>, Alloc >(data, rowVec) {}
     
     /**
      * \brief Array constructor.
      *
-     * Sets vec equal to the input "data" array and sets the pointer to the scratch buffer,
-     *      if one is provided.
+     * Sets vec equal to the input "data" array.
      * \param data Array that \ref vec will be set equal to.
      * \param dataLen Length of "data".
-     * \param scratch Pointer to a scratch buffer.  The scratch buffer can be shared by multiple
-     *      objects (in fact, I recommend it), but if there are multiple threads then it should
-     *      be shared only by objects that are accessed by a single thread.  Objects in other
-     *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
      */
     template <class U>
-    ComplexVector<T>(std::complex<U> *data, uint32_t dataLen, bool rowVec = false, std::shared_ptr< std::vector< std::complex<T> > > scratch = nullptr) :
-            Vector< std::complex<T> >(data, dataLen, rowVec, scratch) {}
+    ComplexVector(std::complex<U> *data, uint32_t dataLen, bool rowVec = false) :
+            Vector< std::complex<T>, Alloc >(data, dataLen, rowVec) {}
     
-    ComplexVector<T>(std::initializer_list< std::complex<T> > initVals, bool rowVec = false, std::shared_ptr< std::vector< std::complex<T> > > scratch = nullptr) : Vector< std::complex<T> >(initVals, rowVec, scratch) {}
+    ComplexVector(std::initializer_list< std::complex<T> > initVals, bool rowVec = false) : Vector< std::complex<T>, Alloc >(initVals, rowVec) {}
+    
+    /**
+     * \brief Expression constructor.
+     *
+     * Evaluates an element-wise expression such as "a*b + c" in a single pass, without any
+     * temporary vectors.
+     */
+    template <class E>
+    ComplexVector(const VectorExpression<E> &expr) :
+            Vector< std::complex<T>, Alloc >(expr) {}
     
     /**
      * \brief Copy constructor.
      */
-    ComplexVector<T>(const ComplexVector<T>& other) {*this = other;}
+    ComplexVector(const ComplexVector<T, Alloc>& other) : Vector< std::complex<T>, Alloc >(other) {}
     
     /**
      * \brief Copy constructor.
      */
-    ComplexVector<T>(const Vector< std::complex<T> >& other) {
-        this->vec = other.vec;
-        this->rowVector = other.rowVector;
-        this->scratchBuf = other.getScratchBuf();
-    }
+    ComplexVector(const Vector< std::complex<T>, Alloc >& other) : Vector< std::complex<T>, Alloc >(other) {}
+    
+    /**
+     * \brief Move constructor.
+     */
+    ComplexVector(ComplexVector<T, Alloc>&& other) noexcept : Vector< std::complex<T>, Alloc >(std::move(other)) {}
+    
+    /**
+     * \brief Move constructor.
+     */
+    ComplexVector(Vector< std::complex<T>, Alloc >&& other) noexcept : Vector< std::complex<T>, Alloc >(std::move(other)) {}
     
     /**
      * \brief Virtual destructor.
      */
     virtual ~ComplexVector() = default;
 
+    /*****************************************************************************************
+                                            Operators
+    *****************************************************************************************/
+    /**
+     * \brief Assignment operator.
+     */
+    ComplexVector<T, Alloc> & operator=(const ComplexVector<T, Alloc> &rhs) {
+        Vector< std::complex<T>, Alloc >::operator=(rhs);
+        return *this;
+    }
+
+    /**
+     * \brief Move assignment operator.
+     */
+    ComplexVector<T, Alloc> & operator=(ComplexVector<T, Alloc> &&rhs) noexcept {
+        Vector< std::complex<T>, Alloc >::operator=(std::move(rhs));
+        return *this;
+    }
+
+    /**
+     * \brief Expression assignment operator.
+     */
+    template <class E>
+    ComplexVector<T, Alloc> & operator=(const VectorExpression<E> &expr) {
+        Vector< std::complex<T>, Alloc >::operator=(expr);
+        return *this;
+    }
+
     /*****************************************************************************************
                                             Methods
     *****************************************************************************************/
@@ -111,6 +140,7 @@ class ComplexVector : public Vector< std::complex<T> > {
     /**
      * \brief Returns the element in \ref vec with the largest absolute value.
      *
+     * Compares squared magnitudes, so there is no square root per element.
      * \param maxLoc If it isn't equal to nullptr the index of the maximum element
      *      will be returned via this pointer.  If more than one element is equal
      *      to the maximum value the index of the first will be returned.
@@ -119,27 +149,17 @@ class ComplexVector : public Vector< std::complex<T> > {
     const std::complex<T> max(unsigned *maxLoc = nullptr) const {
         assert(this->size() > 0);
         
-        T maxVal = std::abs(this->vec[0]);
-        std::complex<T> maxElement = this->vec[0];
-        unsigned maxIndex = 0;
-        
-        for (unsigned index=1; index<this->size(); index++) {
-            T absVal = std::abs(this->vec[index]);
-            if (maxVal < absVal) {
-                maxVal = absVal;
-                maxElement = this->vec[index];
-                maxIndex = index;
-            }
-        }
+        unsigned maxIndex = (unsigned) simd::maxNormIndex(this->vec.data(), this->size());
         if (maxLoc != nullptr) {
             *maxLoc = maxIndex;
         }
-        return maxElement;
+        return this->vec[maxIndex];
     }
     
     /**
      * \brief Returns the element in \ref vec with the smallest absolute value.
      *
+     * Compares squared magnitudes, so there is no square root per element.
      * \param minLoc If it isn't equal to nullptr the index of the minimum element
      *      will be returned via this pointer.  If more than one element is equal
      *      to the minimum value the index of the first will be returned.
@@ -148,24 +168,177 @@ class ComplexVector : public Vector< std::complex<T> > {
     const std::complex<T> min(unsigned *minLoc = nullptr) const {
         assert(this->size() > 0);
         
-        T minVal = std::abs(this->vec[0]);
-        std::complex<T> minElement = this->vec[0];
-        unsigned minIndex = 0;
+        unsigned minIndex = (unsigned) simd::minNormIndex(this->vec.data(), this->size());
+        if (minLoc != nullptr) {
+            *minLoc = minIndex;
+        }
+        return this->vec[minIndex];
+    }
+    
+    /**
+     * \brief Returns the indexes of the "k" elements in \ref vec with the largest absolute
+     *      values, largest first.  Elements with equal magnitudes are in index order.
+     *
+     * Keeps the best "k" so far in a heap, so most elements cost one comparison with the
+     * smallest of them.
+     */
+    std::vector<unsigned> topK(unsigned k) const {
+        typedef std::pair<T, unsigned> Candidate;
+        // "First" is true if "a" ranks above "b"
+        auto first = [](const Candidate &a, const Candidate &b) {
+            return b.first < a.first || (a.first == b.first && a.second < b.second);
+        };
+        k = std::min(k, this->size());
+        std::vector<Candidate> heap;
+        heap.reserve(k);
+        for (unsigned index=0; index<this->size() && k>0; index++) {
+            T norm = simd::squaredMagnitude(this->vec[index]);
+            if (heap.size() < k) {
+                heap.emplace_back(norm, index);
+                std::push_heap(heap.begin(), heap.end(), first);
+            }
+            else if (heap.front().first < norm) {
+                // The front of the heap is the lowest ranked
+                std::pop_heap(heap.begin(), heap.end(), first);
+                heap.back() = Candidate(norm, index);
+                std::push_heap(heap.begin(), heap.end(), first);
+            }
+        }
+        std::sort(heap.begin(), heap.end(), first);
+        std::vector<unsigned> indexes(heap.size());
+        for (unsigned index=0; index<heap.size(); index++) {
+            indexes[index] = heap[index].second;
+        }
+        return indexes;
+    }
+    
+    /**
+     * \brief Returns the indexes of the peaks in \ref vec, in increasing order.
+     *
+     * A peak is an element whose absolute value is at least "threshold" and is greater than
+     * those of its neighbours.  The first and last elements aren't peaks.  For a flat top the
+     * first element of it is the peak.  Like MATLAB's findpeaks(), peaks closer than
+     * "minSeparation" elements to a bigger peak are dropped, biggest first.
+     *
+     * \param threshold The smallest absolute value that a peak can have.
+     * \param minSeparation The smallest distance between peaks.  Defaults to 1, which keeps
+     *      them all.
+     */
+    std::vector<unsigned> peaks(T threshold, unsigned minSeparation = 1) const {
+        assert(threshold >= 0);
         
-        for (unsigned index=1; index<this->size(); index++) {
-            T absVal = std::abs(this->vec[index]);
-            if (minVal > absVal) {
-                minVal = absVal;
-                minElement = this->vec[index];
-                minIndex = index;
+        T thresholdNorm = threshold * threshold;
+        std::vector<unsigned> indexes;
+        std::vector<T> norms;
+        unsigned len = this->size();
+        if (len < 3) {
+            return indexes;
+        }
+        T previous = simd::squaredMagnitude(this->vec[0]);
+        T current = simd::squaredMagnitude(this->vec[1]);
+        for (unsigned index=1; index<len-1; index++) {
+            T next = simd::squaredMagnitude(this->vec[index + 1]);
+            if (current >= thresholdNorm && previous < current && !(current < next)) {
+                // Find the end of a flat top, which is a peak if it then goes down
+                unsigned last = index;
+                while (last + 1 < len - 1 && next == current) {
+                    last++;
+                    next = simd::squaredMagnitude(this->vec[last + 1]);
+                }
+                if (next < current) {
+                    indexes.push_back(index);
+                    norms.push_back(current);
+                }
+                index = last;
             }
+            previous = current;
+            current = next;
         }
-        if (minLoc != nullptr) {
-            *minLoc = minIndex;
+        
+        if (minSeparation > 1 && indexes.size() > 1) {
+            std::vector<unsigned> order(indexes.size());
+            for (unsigned peak=0; peak<order.size(); peak++) {
+                order[peak] = peak;
+            }
+            std::stable_sort(order.begin(), order.end(), [&norms](unsigned a, unsigned b) {return norms[b] < norms[a];});
+            std::vector<bool> dropped(indexes.size(), false);
+            for (unsigned peak : order) {
+                if (dropped[peak]) {
+                    continue;
+                }
+                for (unsigned other=peak; other>0 && indexes[peak] - indexes[other - 1] < minSeparation; other--) {
+                    dropped[other - 1] = true;
+                }
+                for (unsigned other=peak+1; other<indexes.size() && indexes[other] - indexes[peak] < minSeparation; other++) {
+                    dropped[other] = true;
+                }
+            }
+            unsigned kept = 0;
+            for (unsigned peak=0; peak<indexes.size(); peak++) {
+                if (!dropped[peak]) {
+                    indexes[kept++] = indexes[peak];
+                }
+            }
+            indexes.resize(kept);
+        }
+        return indexes;
+    }
+    
+    /**
+     * \brief Estimates where the peak at "index" really is by fitting a parabola to the log
+     *      magnitudes of it and its neighbours.
+     *
+     * For a windowed FFT output this gives the frequency of a tone to a fraction of a bin, since
+     * the main lobe of a window is close to a parabola in dB.
+     * \param index The index of the peak, e.g. from max(), topK() or peaks().
+     * \param peakMagnitude If it isn't equal to nullptr the absolute value at the top of the
+     *      parabola is returned via this pointer.  Defaults to nullptr.
+     * \return The index of the top of the parabola, which is within half an element of
+     *      "index" if it's a peak.  The first and last elements, and peaks next to a zero,
+     *      return "index".
+     */
+    T interpolatePeak(unsigned index, T *peakMagnitude = nullptr) const {
+        assert(index < this->size());
+        
+        T center = simd::squaredMagnitude(this->vec[index]);
+        T offset = 0;
+        T top = std::sqrt(center);
+        if (index > 0 && index + 1 < this->size()) {
+            T left = simd::squaredMagnitude(this->vec[index - 1]);
+            T right = simd::squaredMagnitude(this->vec[index + 1]);
+            if (left > 0 && center > 0 && right > 0) {
+                // Natural logs of the magnitudes
+                T logLeft = std::log(left) / 2;
+                T logCenter = std::log(center) / 2;
+                T logRight = std::log(right) / 2;
+                T curvature = logLeft - 2 * logCenter + logRight;
+                if (curvature < 0) {
+                    offset = (logLeft - logRight) / (2 * curvature);
+                    top = std::exp(logCenter - (logLeft - logRight) * offset / 4);
+                }
+            }
+        }
+        if (peakMagnitude != nullptr) {
+            *peakMagnitude = top;
         }
-        return minElement;
+        return index + offset;
     }
     
+    /**
+     * \brief Computes the power of each element in dB, 10 log10(|x|^2), in one pass without
+     *      forming the magnitudes.  Zeros give -infinity.
+     *
+     * \param output The result.  Resized to the size of \ref vec.
+     * \return Reference to "output".
+     */
+    template <class RealAlloc>
+    Vector<T, RealAlloc> & powerDb(Vector<T, RealAlloc> &output) const {
+        output.resize(this->size());
+        output.rowVector = this->rowVector;
+        simd::powerDb(this->vec.data(), output.vec.data(), this->size());
+        return output;
+    }
+
     /**
      * \brief Sets the upper and lower limit of the values in \ref buf.
      *
@@ -174,7 +347,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      *      any that are less than -val are made equal to -val.
      * \return Reference to "this".
      */
-    ComplexVector<T> & saturate(std::complex<T> val) {
+    ComplexVector<T, Alloc> & saturate(std::complex<T> val) {
         assert(val.real() >= 0);
         assert(val.imag() >= 0);
         
@@ -191,7 +364,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \brief Does a "ceil" operation on \ref vec.
      * \return Reference to "this".
      */
-    ComplexVector<T> & ceil(void) {
+    ComplexVector<T, Alloc> & ceil(void) {
         for (unsigned index=0; index<this->size(); index++) {
             this->vec[index].real(std::ceil(this->vec[index].real()));
             this->vec[index].imag(std::ceil(this->vec[index].imag()));
@@ -203,7 +376,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \brief Does a "floor" operation on \ref vec.
      * \return Reference to "this".
      */
-    ComplexVector<T> & floor(void) {
+    ComplexVector<T, Alloc> & floor(void) {
         for (unsigned index=0; index<this->size(); index++) {
             this->vec[index].real(std::floor(this->vec[index].real()));
             this->vec[index].imag(std::floor(this->vec[index].imag()));
@@ -215,7 +388,7 @@ class ComplexVector : public Vector< std::complex<T> > {
      * \brief Does a "round" operation on \ref vec.
      * \return Reference to "this".
      */
-    ComplexVector<T> & round(void) {
+    ComplexVector<T, Alloc> & round(void) {
         for (unsigned index=0; index<this->size(); index++) {
             this->vec[index].real(std::round(this->vec[index].real()));
             this->vec[index].imag(std::round(this->vec[index].imag()));
@@ -240,13 +413,9 @@ class ComplexVector : public Vector< std::complex<T> > {
             this->resize(numSamples);
         }
     
-        T phaseInc = (freq / sampleFreq) * 2 * M_PI;
-        for (unsigned i=0; i<this->size(); i++) {
-            this->vec[i].real(std::cos(phase));
-            this->vec[i].imag(std::sin(phase));
-            phase += phaseInc;
-        }
-        return phase;
+        Nco<T> nco(freq, sampleFreq, phase);
+        nco.generate(this->vec.data(), this->size());
+        return phase + this->size() * nco.phaseIncrement();
     }
     
     /**
@@ -260,32 +429,110 @@ class ComplexVector : public Vector< std::complex<T> > {
     T modulate(T freq, T sampleFreq = 1.0, T phase = 0.0) {
         assert(sampleFreq > 0.0);
     
-        T phaseInc = (freq / sampleFreq) * 2 * M_PI;
-        for (unsigned i=0; i<this->size(); i++) {
-            this->vec[i] *= std::complex<T>(std::cos(phase), std::sin(phase));
-            phase += phaseInc;
-        }
-        return phase;
+        Nco<T> nco(freq, sampleFreq, phase);
+        nco.mix(this->vec.data(), this->size());
+        return phase + this->size() * nco.phaseIncrement();
     }
     
-    ComplexVector<T> & fft(MatrixDSP::Vector<T> &input, bool inverseFft = false) {
+    /**
+     * \brief FFT of real data.
+     *
+     * Even length inputs use a real-input FFT, which does about half the work of a complex FFT
+     * of the same length.
+     * \param input The data to transform.
+     * \param inverseFft Do an inverse FFT instead of a forward one.  Defaults to false.
+     * \param halfSpectrum If true, only the input.size()/2+1 non-redundant bins are returned.
+     *      The others are the complex conjugates of these (bin N-k is the conjugate of bin k).
+     *      Defaults to false.
+     * \return Reference to "this".
+     */
+    template <class RealAlloc>
+    ComplexVector<T, Alloc> & fft(MatrixDSP::Vector<T, RealAlloc> &input, bool inverseFft = false, bool halfSpectrum = false) {
         assert(input.size() > 1);
         
-        this->resize(input.size());
-        auto *fftSetup = GetFftSetupManager().getFftSetup(input.size(), inverseFft);
-        fftSetup->transform(input.vec.begin(), this->vec.begin());
+        unsigned fftLen = input.size();
+        unsigned numBins = halfSpectrum ? fftLen/2 + 1 : fftLen;
+        if (fftLen % 2) {
+            this->resize(fftLen);
+            auto *fftSetup = GetFftSetupManager().getFftSetup(fftLen, inverseFft);
+            fftSetup->transform(input.vec.data(), this->vec.data());
+            this->resize(numBins);
+            return *this;
+        }
+        
+        this->resize(numBins);
+        ScratchBuffer< std::complex<T> > scratch(fftLen/2);
+        auto *fftSetup = GetFftSetupManager().getRealFftSetup(fftLen);
+        fftSetup->transform(input.vec.data(), this->vec.data(), scratch.data());
+        for (unsigned index=fftLen/2+1; index<numBins; index++) {
+            this->vec[index] = std::conj(this->vec[fftLen - index]);
+        }
+        if (inverseFft) {
+            // The inverse DFT of real data is the conjugate of the forward DFT
+            for (unsigned index=0; index<numBins; index++) {
+                this->vec[index] = std::conj(this->vec[index]);
+            }
+        }
         return *this;
     }
     
-    ComplexVector<T> & fft(MatrixDSP::ComplexVector<T> &input, bool inverseFft = false) {
+    template <class InputAlloc>
+    ComplexVector<T, Alloc> & fft(MatrixDSP::ComplexVector<T, InputAlloc> &input, bool inverseFft = false) {
         assert(input.size() > 1);
         
         this->resize(input.size());
         auto *fftSetup = GetFftSetupManager().getFftSetup(input.size(), inverseFft);
-        fftSetup->transform(input.vec.begin(), this->vec.begin());
+        fftSetup->transform(input.vec.data(), this->vec.data());
         return *this;
     }
     
+    /**
+     * \brief Inverse FFT of a conjugate symmetric spectrum, which gives real data.
+     *
+     * Even lengths use a real-output inverse FFT, which does about half the work of a complex
+     * inverse FFT.  Like fft(), the result isn't scaled, so ifftReal(fft(x)) is N times x.
+     * \param output The real result.
+     * \param fftLen Length of the inverse FFT.  0 means that \ref vec holds the N/2+1
+     *      non-redundant bins of an even length spectrum (the output of fft() with
+     *      halfSpectrum set), so N is 2*(size()-1).  Otherwise \ref vec must hold at least
+     *      fftLen/2+1 bins, and any bins after that are ignored, so a full spectrum works too.
+     *      Defaults to 0.
+     * \return Reference to "output".
+     */
+    template <class RealAlloc>
+    MatrixDSP::Vector<T, RealAlloc> & ifftReal(MatrixDSP::Vector<T, RealAlloc> &output, unsigned fftLen = 0) {
+        if (fftLen == 0) {
+            assert(this->size() > 1);
+            fftLen = 2 * (this->size() - 1);
+        }
+        assert(fftLen > 1);
+        assert(this->size() >= fftLen/2 + 1);
+        
+        output.resize(fftLen);
+        if (fftLen % 2) {
+            // Odd lengths don't have a real-output FFT, so rebuild the full spectrum and do a
+            // complex inverse FFT.
+            ScratchBuffer< std::complex<T> > scratch(2*fftLen);
+            for (unsigned index=0; index<=fftLen/2; index++) {
+                scratch[index] = this->vec[index];
+            }
+            for (unsigned index=fftLen/2+1; index<fftLen; index++) {
+                scratch[index] = std::conj(this->vec[fftLen - index]);
+            }
+            auto *fftSetup = GetFftSetupManager().getFftSetup(fftLen, true);
+            fftSetup->transform(scratch.data(), scratch.data() + fftLen);
+            for (unsigned index=0; index<fftLen; index++) {
+                output[index] = scratch[fftLen + index].real();
+            }
+            return output;
+        }
+        
+        ScratchBuffer< std::complex<T> > scratch(fftLen);
+        auto *fftSetup = GetFftSetupManager().getRealFftSetup(fftLen);
+        fftSetup->inverse(this->vec.data(), output.vec.data(), scratch.data());
+        return output;
+    }
+    
     void print() {
         std::string divider;
         if (this->rowVector) {
@@ -302,8 +549,8 @@ class ComplexVector : public Vector< std::complex<T> > {
     }
 };
 
-template <class T>
-ComplexVector<T> operator<(ComplexVector<T> lhs, const std::complex<T> & rhs) {
+template <class T, class Alloc>
+ComplexVector<T, Alloc> operator<(ComplexVector<T, Alloc> lhs, const std::complex<T> & rhs) {
 	T rhsSquareVal = rhs.real() * rhs.real() + rhs.imag() * rhs.imag();
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		T lhsSquareVal = lhs[index].real() * lhs[index].real() + lhs[index].imag() * lhs[index].imag();
@@ -312,8 +559,8 @@ ComplexVector<T> operator<(ComplexVector<T> lhs, const std::complex<T> & rhs) {
 	return lhs;
 }
 
-template <class T>
-ComplexVector<T> operator<=(ComplexVector<T> lhs, const std::complex<T> & rhs) {
+template <class T, class Alloc>
+ComplexVector<T, Alloc> operator<=(ComplexVector<T, Alloc> lhs, const std::complex<T> & rhs) {
 	T rhsSquareVal = rhs.real() * rhs.real() + rhs.imag() * rhs.imag();
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		T lhsSquareVal = lhs[index].real() * lhs[index].real() + lhs[index].imag() * lhs[index].imag();
@@ -322,8 +569,8 @@ ComplexVector<T> operator<=(ComplexVector<T> lhs, const std::complex<T> & rhs) {
 	return lhs;
 }
 
-template <class T>
-ComplexVector<T> operator>(ComplexVector<T> lhs, const std::complex<T> & rhs) {
+template <class T, class Alloc>
+ComplexVector<T, Alloc> operator>(ComplexVector<T, Alloc> lhs, const std::complex<T> & rhs) {
 	T rhsSquareVal = rhs.real() * rhs.real() + rhs.imag() * rhs.imag();
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		T lhsSquareVal = lhs[index].real() * lhs[index].real() + lhs[index].imag() * lhs[index].imag();
@@ -332,8 +579,8 @@ ComplexVector<T> operator>(ComplexVector<T> lhs, const std::complex<T> & rhs) {
 	return lhs;
 }
 
-template <class T>
-ComplexVector<T> operator>=(ComplexVector<T> lhs, const std::complex<T> & rhs) {
+template <class T, class Alloc>
+ComplexVector<T, Alloc> operator>=(ComplexVector<T, Alloc> lhs, const std::complex<T> & rhs) {
 	T rhsSquareVal = rhs.real() * rhs.real() + rhs.imag() * rhs.imag();
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		T lhsSquareVal = lhs[index].real() * lhs[index].real() + lhs[index].imag() * lhs[index].imag();
@@ -342,17 +589,61 @@ ComplexVector<T> operator>=(ComplexVector<T> lhs, const std::complex<T> & rhs) {
 	return lhs;
 }
 
-template <class T>
-ComplexVector<T> & fft(Vector<T> &input, ComplexVector<T> &output, bool inverseFft = false) {
-    return output.fft(input, inverseFft);
+/**
+ * \brief Returns the indexes of the "k" elements in \ref vec with the largest absolute values,
+ *      largest first.
+ */
+template <class T, class Alloc>
+std::vector<unsigned> topK(ComplexVector<T, Alloc> &vec, unsigned k) {return vec.topK(k);}
+
+/**
+ * \brief Returns the indexes of the peaks in \ref vec, in increasing order.
+ *
+ * \param threshold The smallest absolute value that a peak can have.
+ * \param minSeparation The smallest distance between peaks.  Defaults to 1, which keeps them
+ *      all.
+ */
+template <class T, class Alloc>
+std::vector<unsigned> peaks(ComplexVector<T, Alloc> &vec, T threshold, unsigned minSeparation = 1) {
+    return vec.peaks(threshold, minSeparation);
+}
+
+/**
+ * \brief Estimates where the peak at "index" really is by fitting a parabola to the log
+ *      magnitudes of it and its neighbours.
+ *
+ * \param peakMagnitude If it isn't equal to nullptr the absolute value at the top of the
+ *      parabola is returned via this pointer.  Defaults to nullptr.
+ */
+template <class T, class Alloc>
+T interpolatePeak(ComplexVector<T, Alloc> &vec, unsigned index, T *peakMagnitude = nullptr) {
+    return vec.interpolatePeak(index, peakMagnitude);
 }
 
-template <class T>
-ComplexVector<T> & fft(ComplexVector<T> &input, ComplexVector<T> &output, bool inverseFft = false) {
+/**
+ * \brief Computes the power of each element of \ref vec in dB, 10 log10(|x|^2).
+ *
+ * \param output The result.  Resized to the size of \ref vec.
+ * \return Reference to "output".
+ */
+template <class T, class Alloc, class RealAlloc>
+Vector<T, RealAlloc> & powerDb(ComplexVector<T, Alloc> &vec, Vector<T, RealAlloc> &output) {return vec.powerDb(output);}
+
+template <class T, class RealAlloc, class Alloc>
+ComplexVector<T, Alloc> & fft(Vector<T, RealAlloc> &input, ComplexVector<T, Alloc> &output, bool inverseFft = false, bool halfSpectrum = false) {
+    return output.fft(input, inverseFft, halfSpectrum);
+}
+
+template <class T, class InputAlloc, class Alloc>
+ComplexVector<T, Alloc> & fft(ComplexVector<T, InputAlloc> &input, ComplexVector<T, Alloc> &output, bool inverseFft = false) {
     return output.fft(input, inverseFft);
 }
 
+template <class T, class Alloc, class RealAlloc>
+Vector<T, RealAlloc> & ifftReal(ComplexVector<T, Alloc> &input, Vector<T, RealAlloc> &output, unsigned fftLen = 0) {
+    return input.ifftReal(output, fftLen);
 }
 
-#endif
+}
 
+#endif
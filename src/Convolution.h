@@ -0,0 +1,316 @@
+//
+//  Convolution.h
+//  MatrixDSP
+//
+//  MATLAB style convolution (conv()) and cross-correlation (xcorr()) of whole vectors.
+//
+//  Both come down to working out a range of the full convolution, which is done one of three
+//  ways depending on the lengths.  The shorter input is used as the taps.  If they're short,
+//  the range is worked out in direct form with firDirect(), and if they aren't, the longer
+//  input is run through an overlap-save FirFilter (see FirFilter.h).  When the inputs are of similar lengths, overlap-save would
+//  need FFTs as long as the whole output anyway, so the convolution is done with one FFT of
+//  each input instead, padded to a length that kissfft is fast at (see fastFftLength()).
+//
+//  Working space comes from the scratch arena (ScratchArena.h).
+//
+
+#ifndef Convolution_h
+#define Convolution_h
+
+#include <algorithm>
+#include <cassert>
+#include <complex>
+#include <type_traits>
+#include "FftSetupManager.h"
+#include "FirFilter.h"
+#include "ScratchArena.h"
+#include "Vector.h"
+
+namespace MatrixDSP {
+
+/**
+ * \brief Which part of the convolution conv() returns.
+ *
+ * Full is all of it, La + Lb - 1 samples for inputs of La and Lb samples.  Same is the
+ * central La samples, the same size as the first input.  Valid is the La - Lb + 1 samples
+ * that don't depend on the zero padding, or none if the first input is the shorter one.
+ */
+enum class ConvMode {Full, Same, Valid};
+
+/**
+ * \brief The type of the convolution of samples of types "T" and "U": complex if either of them
+ *      is.
+ */
+template <class T, class U>
+struct ConvResult {
+    typedef T type;
+};
+
+template <class T>
+struct ConvResult<T, std::complex<T> > {
+    typedef std::complex<T> type;
+};
+
+/**
+ * \brief The complex conjugate of "value", or "value" itself if it's real.
+ */
+template <class T>
+T conjugate(const T &value) {return value;}
+
+template <class T>
+std::complex<T> conjugate(const std::complex<T> &value) {return std::conj(value);}
+
+/**
+ * \brief FFTs of "signal" and "taps", zero padded to "fftLen".  Real samples and taps use
+ *      real-input FFTs, which give fftLen/2+1 bins.
+ */
+template <class T>
+void convolveSpectra(const T *signal, unsigned signalLen, const T *taps, unsigned numTaps, unsigned fftLen,
+                     std::complex<T> *signalBins, std::complex<T> *tapBins) {
+    auto *setup = fftSetupManager<T>().getRealFftSetup(fftLen);
+    ScratchBuffer<T> padded(fftLen);
+    ScratchBuffer< std::complex<T> > scratch(fftLen / 2);
+    std::copy(signal, signal + signalLen, padded.data());
+    std::fill(padded.data() + signalLen, padded.data() + fftLen, T());
+    setup->transform(padded.data(), signalBins, scratch.data());
+    std::copy(taps, taps + numTaps, padded.data());
+    std::fill(padded.data() + numTaps, padded.data() + fftLen, T());
+    setup->transform(padded.data(), tapBins, scratch.data());
+}
+
+template <class T, class Tap>
+void convolveSpectra(const std::complex<T> *signal, unsigned signalLen, const Tap *taps, unsigned numTaps, unsigned fftLen,
+                     std::complex<T> *signalBins, std::complex<T> *tapBins) {
+    auto *setup = fftSetupManager<T>().getFftSetup(fftLen);
+    ScratchBuffer< std::complex<T> > padded(fftLen);
+    std::copy(signal, signal + signalLen, padded.data());
+    std::fill(padded.data() + signalLen, padded.data() + fftLen, std::complex<T>());
+    setup->transform(padded.data(), signalBins);
+    std::copy(taps, taps + numTaps, padded.data());
+    std::fill(padded.data() + numTaps, padded.data() + fftLen, std::complex<T>());
+    setup->transform(padded.data(), tapBins);
+}
+
+/**
+ * \brief Unscaled inverse FFT of the bins from convolveSpectra().  "scratch" needs room for
+ *      "fftLen" complex values.
+ */
+template <class T>
+void inverseSpectrum(std::complex<T> *bins, unsigned fftLen, T *output, std::complex<T> *scratch) {
+    fftSetupManager<T>().getRealFftSetup(fftLen)->inverse(bins, output, scratch);
+}
+
+template <class T>
+void inverseSpectrum(std::complex<T> *bins, unsigned fftLen, std::complex<T> *output, std::complex<T> *) {
+    fftSetupManager<T>().getFftSetup(fftLen, true)->transform(bins, output);
+}
+
+/**
+ * \brief Runs samples [from, to) of "signal", with zeros after its end, through "filter".
+ */
+template <class V, class Tap>
+void filterPadded(FirFilter<V, Tap> &filter, const V *signal, long long signalLen, long long from, long long to, V *output) {
+    long long signalEnd = std::min(to, signalLen);
+    if (from < signalEnd) {
+        filter.filter(signal + from, output, signalEnd - from);
+    }
+    long long zerosFrom = std::max(from, signalLen);
+    if (zerosFrom < to) {
+        ScratchBuffer<V> zeros(to - zerosFrom);
+        std::fill(zeros.data(), zeros.data() + (to - zerosFrom), V());
+        filter.filter(zeros.data(), output + (zerosFrom - from), to - zerosFrom);
+    }
+}
+
+/**
+ * \brief Works out the convolution of "signal" and "taps" for indexes [first, first + count),
+ *      where some of the range may be outside of the full convolution.
+ *
+ * The samples are of type V, and the taps are V or its real type.  "taps" should be the
+ * shorter of the two.
+ */
+template <class V, class Tap>
+void convolveRange(const V *signal, unsigned signalLen, const Tap *taps, unsigned numTaps, long long first, unsigned count,
+                   V *output) {
+    typedef typename FirTap<V>::type Real;
+    const long long fullLen = (long long) signalLen + numTaps - 1;
+    // The part of the range inside the full convolution
+    long long begin = std::max(first, 0LL);
+    long long end = std::min(first + (long long) count, fullLen);
+    std::fill(output, output + count, V());
+    if (begin >= end) {
+        return;
+    }
+    V *out = output + (begin - first);
+
+    if (numTaps >= FirFilter<V, Tap>::crossover() && 4ULL * numTaps >= signalLen) {
+        // One FFT of each, long enough that nothing wraps around
+        const bool realFft = std::is_same<V, Real>::value;
+        unsigned fftLen = fastFftLength((unsigned) fullLen, realFft);
+        ScratchBuffer<std::complex<Real> > signalBins(fftLen);
+        ScratchBuffer<std::complex<Real> > tapBins(fftLen);
+        convolveSpectra(signal, signalLen, taps, numTaps, fftLen, signalBins.data(), tapBins.data());
+        simd::multiplySpectrum(signalBins.data(), tapBins.data(), realFft ? fftLen / 2 + 1 : fftLen);
+        ScratchBuffer<V> full(fftLen);
+        inverseSpectrum(signalBins.data(), fftLen, full.data(), tapBins.data());
+        Real scale = (Real) 1 / fftLen;
+        for (long long index = begin; index < end; index++) {
+            out[index - begin] = full[index] * scale;
+        }
+        return;
+    }
+
+    if (numTaps < FirFilter<V, Tap>::crossover()) {
+        // Direct form over the signal with numTaps - 1 zeros on each side, so output n is
+        // convolution index n
+        ScratchBuffer<Tap> reversed(numTaps);
+        std::reverse_copy(taps, taps + numTaps, reversed.data());
+        long long lineBegin = begin - (long long) (numTaps - 1);
+        std::size_t lineLen = (std::size_t) (end - lineBegin);
+        ScratchBuffer<V> line(lineLen);
+        std::fill(line.data(), line.data() + lineLen, V());
+        long long copyBegin = std::max(lineBegin, 0LL);
+        long long copyEnd = std::min(end, (long long) signalLen);
+        if (copyBegin < copyEnd) {
+            std::copy(signal + copyBegin, signal + copyEnd, line.data() + (copyBegin - lineBegin));
+        }
+        firDirect(reversed.data(), numTaps, line.data(), (std::size_t) (end - begin), out);
+        return;
+    }
+
+    // Overlap-save with a FirFilter.  Output n of the filter is convolution index n, so start
+    // the filter up to numTaps - 1 samples early to fill its history.
+    FirFilter<V, Tap> filter(taps, numTaps, FirMethod::OverlapSave);
+    long long warmup = std::max(begin - (long long) (numTaps - 1), 0LL);
+    if (warmup < begin) {
+        ScratchBuffer<V> discard(begin - warmup);
+        filterPadded(filter, signal, signalLen, warmup, begin, discard.data());
+    }
+    filterPadded(filter, signal, signalLen, begin, end, out);
+}
+
+template <class V, class T, class U>
+void convolveTaps(const T *signal, unsigned signalLen, const U *taps, unsigned numTaps, long long first, unsigned count,
+                  V *output, std::true_type) {
+    convolveRange(signal, signalLen, taps, numTaps, first, count, output);
+}
+
+template <class V, class T, class U>
+void convolveTaps(const T *signal, unsigned signalLen, const U *taps, unsigned numTaps, long long first, unsigned count,
+                  V *output, std::false_type) {
+    // A real signal with complex taps, which FirFilter doesn't do, so make the signal complex
+    ScratchBuffer<V> promoted(signalLen);
+    std::copy(signal, signal + signalLen, promoted.data());
+    convolveRange(promoted.data(), signalLen, taps, numTaps, first, count, output);
+}
+
+/**
+ * \brief Works out indexes [first, first + count) of the convolution of "a" and "b", with the
+ *      shorter of the two as the taps.
+ */
+template <class V, class T, class U>
+void convolveInputs(const T *a, unsigned aLen, const U *b, unsigned bLen, long long first, unsigned count, V *output) {
+    // Convolution commutes, so swap them if "a" is the shorter
+    if (aLen < bLen) {
+        return convolveInputs(b, bLen, a, aLen, first, count, output);
+    }
+    convolveTaps(a, aLen, b, bLen, first, count, output, std::integral_constant<bool, std::is_same<T, V>::value>());
+}
+
+/**
+ * \brief Convolves "a" with "b".
+ *
+ * Like MATLAB's conv(a, b, shape).  Either input can be real or complex, and the output is
+ * complex if either of them is.  Short inputs are convolved in the time domain and long ones
+ * with FFTs.
+ *
+ * \param a The first input.
+ * \param b The second input.
+ * \param output The result.  Resized to the length that "mode" gives.  Must not be "a" or "b".
+ * \param mode Which part of the convolution to return.  Defaults to Full.
+ * \return Reference to "output".
+ */
+template <class T, class U, class V, class AllocA, class AllocB, class AllocOut>
+Vector<V, AllocOut> & conv(const Vector<T, AllocA> &a, const Vector<U, AllocB> &b, Vector<V, AllocOut> &output,
+                           ConvMode mode = ConvMode::Full) {
+    static_assert(std::is_same<V, typename ConvResult<T, U>::type>::value || std::is_same<V, typename ConvResult<U, T>::type>::value,
+                  "The output must be complex if either input is");
+    const unsigned aLen = a.size();
+    const unsigned bLen = b.size();
+    long long first = 0;
+    unsigned count = 0;
+    if (aLen && bLen) {
+        switch (mode) {
+            case ConvMode::Full:
+                count = aLen + bLen - 1;
+                break;
+            case ConvMode::Same:
+                first = bLen / 2;
+                count = aLen;
+                break;
+            case ConvMode::Valid:
+                first = bLen - 1;
+                count = aLen >= bLen ? aLen - bLen + 1 : 0;
+                break;
+        }
+    }
+    output.resize(count);
+    output.rowVector = a.rowVector;
+    if (count) {
+        convolveInputs(a.vec.data(), aLen, b.vec.data(), bLen, first, count, output.vec.data());
+    }
+    return output;
+}
+
+/**
+ * \brief Cross-correlates "a" with "b" for lags -maxLag to maxLag.
+ *
+ * Like MATLAB's xcorr(a, b, maxLag): output k is the sum over n of a[n + m] * conj(b[n]) for
+ * lag m = k - maxLag, with zeros outside of the inputs.  So a peak at lag m means that "a" has
+ * a copy of "b" starting m samples in, which makes this a matched filter when "b" is the
+ * template being looked for.
+ *
+ * \param a The first input.
+ * \param b The second input.
+ * \param output The result, 2 * maxLag + 1 samples.  Must not be "a" or "b".
+ * \param maxLag The largest lag to work out.
+ * \return Reference to "output".
+ */
+template <class T, class U, class V, class AllocA, class AllocB, class AllocOut>
+Vector<V, AllocOut> & xcorr(const Vector<T, AllocA> &a, const Vector<U, AllocB> &b, Vector<V, AllocOut> &output,
+                            unsigned maxLag) {
+    static_assert(std::is_same<V, typename ConvResult<T, U>::type>::value || std::is_same<V, typename ConvResult<U, T>::type>::value,
+                  "The output must be complex if either input is");
+    const unsigned count = 2 * maxLag + 1;
+    output.resize(count);
+    output.rowVector = a.rowVector;
+    if (a.size() == 0 || b.size() == 0) {
+        std::fill(output.vec.begin(), output.vec.end(), V());
+        return output;
+    }
+    // The correlation is the convolution with "b" conjugated and reversed, and lag m is
+    // index m + bLen - 1 of it
+    const unsigned bLen = b.size();
+    ScratchBuffer<U> reversed(bLen);
+    for (unsigned index = 0; index < bLen; index++) {
+        reversed[index] = conjugate(b[bLen - 1 - index]);
+    }
+    convolveInputs(a.vec.data(), a.size(), reversed.data(), bLen, (long long) bLen - 1 - maxLag, count, output.vec.data());
+    return output;
+}
+
+/**
+ * \brief Cross-correlates "a" with "b" for every lag at which they overlap, -(L - 1) to L - 1
+ *      where L is the length of the longer input.  Like MATLAB's xcorr(a, b).
+ *
+ * \return Reference to "output".
+ */
+template <class T, class U, class V, class AllocA, class AllocB, class AllocOut>
+Vector<V, AllocOut> & xcorr(const Vector<T, AllocA> &a, const Vector<U, AllocB> &b, Vector<V, AllocOut> &output) {
+    unsigned len = std::max(a.size(), b.size());
+    return xcorr(a, b, output, len ? len - 1 : 0);
+}
+
+}
+
+#endif /* Convolution_h */
@@ -0,0 +1,382 @@
+//
+//  Expression.h
+//  MatrixDSP
+//
+//  Lazy element-wise expressions.  The free arithmetic operators for Vector and Matrix2d return
+//  lightweight expression objects instead of containers, and the whole expression is evaluated
+//  in a single pass when it is assigned to (or used to construct) a Vector, ComplexVector or
+//  Matrix2d.  So "a*b + c*d - e" doesn't create any temporaries and only walks memory once.
+//
+//  Expressions refer to their operands, they don't copy them, so they are only valid until the
+//  end of the statement that creates them.  Don't store one with "auto"; assign it to a
+//  container instead.
+//
+//  The expressions also have the methods that the old operators' Vector and Matrix2d results
+//  had, so "(a + b).sum()" and "(a - b).abs()" still work.  Each of those evaluates the
+//  expression into a container first.
+//
+//  Matrix expressions are evaluated a row at a time, so their operands (and the matrix that
+//  they are assigned to) can be views of part of a bigger matrix, with rows that aren't next
+//  to each other in memory.
+//
+
+#ifndef Expression_h
+#define Expression_h
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "Simd.h"
+
+namespace MatrixDSP {
+
+template <class T, class Alloc> class Vector;
+template <class T, class Alloc> class Matrix2d;
+
+/**
+ * \brief Base class of all of the vector expression nodes.
+ */
+template <class E>
+class VectorExpression {
+    public:
+    const E & derived() const {return static_cast<const E &>(*this);}
+};
+
+/**
+ * \brief Base class of all of the matrix expression nodes.
+ */
+template <class E>
+class MatrixExpression {
+    public:
+    const E & derived() const {return static_cast<const E &>(*this);}
+};
+
+/*****************************************************************************************
+                                        Operands
+*****************************************************************************************/
+/**
+ * \brief A reference to the contiguous data of a Vector.
+ */
+template <class T>
+class VectorOperand {
+    private:
+    const T *dataPtr;
+    unsigned len;
+    bool rowVec;
+
+    public:
+    typedef T value_type;
+
+    VectorOperand(const T *data, unsigned length, bool rowVector) : dataPtr(data), len(length), rowVec(rowVector) {}
+
+    const T & operator[](unsigned index) const {return dataPtr[index];}
+    unsigned size() const {return len;}
+    bool rowVector() const {return rowVec;}
+    const T * data() const {return dataPtr;}
+};
+
+/**
+ * \brief A reference to the data of a Matrix2d or MatrixView.  The rows are contiguous, and
+ *      each row starts "ld" elements after the one before it.
+ */
+template <class T>
+class MatrixOperand {
+    private:
+    const T *dataPtr;
+    unsigned numRows;
+    unsigned numCols;
+    unsigned stride;
+
+    public:
+    typedef T value_type;
+
+    MatrixOperand(const T *data, unsigned rows, unsigned cols, unsigned ld) : dataPtr(data), numRows(rows), numCols(cols), stride(ld) {}
+
+    const T & operator()(unsigned row, unsigned col) const {return dataPtr[row * stride + col];}
+    unsigned getRows() const {return numRows;}
+    unsigned getCols() const {return numCols;}
+    unsigned ld() const {return stride;}
+    const T * data() const {return dataPtr;}
+    const T * rowData(unsigned row) const {return dataPtr + row * stride;}
+};
+
+/**
+ * \brief A scalar that looks like a container with every element equal to the scalar.
+ */
+template <class T>
+class ScalarOperand {
+    private:
+    T val;
+
+    public:
+    typedef T value_type;
+
+    explicit ScalarOperand(const T &value) : val(value) {}
+
+    const T & operator[](unsigned) const {return val;}
+    const T & operator()(unsigned, unsigned) const {return val;}
+    const T & value() const {return val;}
+};
+
+/*****************************************************************************************
+                                        Expression nodes
+*****************************************************************************************/
+/**
+ * \brief lhs "Op" rhs, element by element.
+ *
+ * The element type is the element type of lhs, and each element is converted to it the same
+ * way that "lhs op= rhs" would, so the result is the same as the old copy-then-modify operators.
+ */
+template <class Op, class L, class R>
+class VectorBinaryExpression : public VectorExpression< VectorBinaryExpression<Op, L, R> > {
+    private:
+    L lhs;
+    R rhs;
+
+    public:
+    typedef typename L::value_type value_type;
+    typedef Vector<value_type, AlignedAllocator<value_type> > vector_type;
+
+    VectorBinaryExpression(const L &left, const R &right) : lhs(left), rhs(right) {}
+
+    value_type operator[](unsigned index) const {return static_cast<value_type>(Op::eval(lhs[index], rhs[index]));}
+    value_type operator()(unsigned index) const {return (*this)[index];}
+    unsigned size() const {return lhs.size();}
+    bool rowVector() const {return lhs.rowVector();}
+    const L & left() const {return lhs;}
+    const R & right() const {return rhs;}
+
+    /**
+     * \brief Evaluates the expression into a new Vector.
+     */
+    vector_type eval() const {return vector_type(*this);}
+
+    // The Vector methods.  The ones that modify the Vector return a modified copy.
+    std::vector<unsigned> find() const {return eval().find();}
+    value_type sum() const {return eval().sum();}
+    value_type mean() const {return eval().mean();}
+    value_type var(const bool subset = true) const {return eval().var(subset);}
+    value_type stdDev(const bool subset = true) const {return eval().stdDev(subset);}
+    value_type median() const {return eval().median();}
+    value_type max(unsigned *maxLoc = nullptr) const {return eval().max(maxLoc);}
+    value_type min(unsigned *minLoc = nullptr) const {return eval().min(minLoc);}
+    value_type sin(value_type freq, value_type sampleFreq = 1.0, value_type phase = 0.0, unsigned numSamples = 0) const {
+        return eval().sin(freq, sampleFreq, phase, numSamples);
+    }
+    value_type cos(value_type freq, value_type sampleFreq = 1.0, value_type phase = 0.0, unsigned numSamples = 0) const {
+        return eval().cos(freq, sampleFreq, phase, numSamples);
+    }
+
+    vector_type operator-() const {return std::move(-eval());}
+    vector_type pow(const value_type exponent) const {return std::move(eval().pow(exponent));}
+    vector_type saturate(value_type val) const {return std::move(eval().saturate(val));}
+    vector_type ceil() const {return std::move(eval().ceil());}
+    vector_type floor() const {return std::move(eval().floor());}
+    vector_type round() const {return std::move(eval().round());}
+    vector_type abs() const {return std::move(eval().abs());}
+    vector_type exp() const {return std::move(eval().exp());}
+    vector_type log() const {return std::move(eval().log());}
+    vector_type log10() const {return std::move(eval().log10());}
+    vector_type vectorRotate(int numToShift) const {return std::move(eval().vectorRotate(numToShift));}
+    vector_type reverse() const {return std::move(eval().reverse());}
+    vector_type resize(unsigned len, value_type val = (value_type) 0) const {return std::move(eval().resize(len, val));}
+    vector_type pad(unsigned len, value_type val = (value_type) 0) const {return std::move(eval().pad(len, val));}
+    vector_type upsample(int rate, int phase = 0) const {return std::move(eval().upsample(rate, phase));}
+    vector_type downsample(int rate, int phase = 0) const {return std::move(eval().downsample(rate, phase));}
+    vector_type cumsum(value_type initialVal = 0) const {return std::move(eval().cumsum(initialVal));}
+    vector_type diff(value_type *previousVal = nullptr) const {return std::move(eval().diff(previousVal));}
+    vector_type modulate(value_type freq, value_type sampleFreq = 1.0, value_type phase = 0.0) const {
+        vector_type result = eval();
+        result.modulate(freq, sampleFreq, phase);
+        return result;
+    }
+};
+
+template <class Op, class L, class R>
+class MatrixBinaryExpression : public MatrixExpression< MatrixBinaryExpression<Op, L, R> > {
+    private:
+    L lhs;
+    R rhs;
+
+    public:
+    typedef typename L::value_type value_type;
+    typedef Matrix2d<value_type, AlignedAllocator<value_type> > matrix_type;
+
+    MatrixBinaryExpression(const L &left, const R &right) : lhs(left), rhs(right) {}
+
+    value_type operator()(unsigned row, unsigned col) const {return static_cast<value_type>(Op::eval(lhs(row, col), rhs(row, col)));}
+    unsigned getRows() const {return lhs.getRows();}
+    unsigned getCols() const {return lhs.getCols();}
+    std::pair<unsigned, unsigned> size() const {return std::make_pair(getRows(), getCols());}
+    const L & left() const {return lhs;}
+    const R & right() const {return rhs;}
+
+    /**
+     * \brief Evaluates the expression into a new Matrix2d.
+     */
+    matrix_type eval() const {return matrix_type(*this);}
+
+    // The Matrix2d methods.  The ones that modify the matrix return a modified copy.
+    std::vector< std::pair<unsigned, unsigned> > find() const {return eval().find();}
+
+    matrix_type operator-() const {return std::move(-eval());}
+    matrix_type transpose() const {return std::move(eval().transpose());}
+    matrix_type resize(unsigned rows, unsigned cols, value_type val = 0) const {return std::move(eval().resize(rows, cols, val));}
+    matrix_type reshape(unsigned rows, unsigned cols) const {return std::move(eval().reshape(rows, cols));}
+    template <class VectorAlloc>
+    matrix_type appendRow(Vector<value_type, VectorAlloc> &appendVec) const {return std::move(eval().appendRow(appendVec));}
+    template <class VectorAlloc>
+    matrix_type appendCol(Vector<value_type, VectorAlloc> &appendVec) const {return std::move(eval().appendCol(appendVec));}
+    matrix_type appendRows(matrix_type &appendMat) const {return std::move(eval().appendRows(appendMat));}
+    matrix_type appendCols(matrix_type &appendMat) const {return std::move(eval().appendCols(appendMat));}
+};
+
+/**
+ * \brief Expression nodes are operands of other expression nodes, by value.
+ *
+ * The containers provide their own overloads (see Vector.h and Matrix2d.h).
+ */
+template <class E>
+const E & vectorOperand(const VectorExpression<E> &expr) {return expr.derived();}
+
+template <class E>
+const E & matrixOperand(const MatrixExpression<E> &expr) {return expr.derived();}
+
+/*****************************************************************************************
+                                        Evaluation
+*****************************************************************************************/
+/**
+ * \brief Writes every element of "expr" to "out".
+ *
+ * This is the single pass that the whole expression is fused into.  Simple two operand
+ * expressions go straight to the SIMD kernels.  "out" may be one of the operands, because
+ * each element only depends on the operand elements at the same index.
+ */
+template <class T, class E>
+void evaluateExpression(T *out, const E &expr, unsigned len) {
+    for (unsigned index=0; index<len; index++) {
+        out[index] = expr[index];
+    }
+}
+
+template <class T, class Op>
+void evaluateExpression(T *out, const VectorBinaryExpression<Op, VectorOperand<T>, VectorOperand<T> > &expr, unsigned len) {
+    simd::binary<Op>(out, expr.left().data(), expr.right().data(), len);
+}
+
+template <class T, class Op>
+void evaluateExpression(T *out, const VectorBinaryExpression<Op, VectorOperand<T>, ScalarOperand<T> > &expr, unsigned len) {
+    simd::binaryScalar<Op>(out, expr.left().data(), expr.right().value(), len);
+}
+
+template <class T>
+void evaluateExpression(T *out, const VectorOperand<T> &operand, unsigned len) {
+    std::copy(operand.data(), operand.data() + len, out);
+}
+
+/**
+ * \brief Writes every element of the matrix expression "expr" to "out", a row at a time.
+ *
+ * \param ldo The distance between the starts of the rows of "out".
+ */
+template <class T, class E>
+void evaluateMatrixExpression(T *out, unsigned ldo, const E &expr, unsigned rows, unsigned cols) {
+    for (unsigned row=0; row<rows; row++) {
+        T *outRow = out + row * ldo;
+        for (unsigned col=0; col<cols; col++) {
+            outRow[col] = expr(row, col);
+        }
+    }
+}
+
+template <class T>
+void evaluateMatrixExpression(T *out, unsigned ldo, const MatrixOperand<T> &operand, unsigned rows, unsigned cols) {
+    for (unsigned row=0; row<rows; row++) {
+        std::copy(operand.rowData(row), operand.rowData(row) + cols, out + row * ldo);
+    }
+}
+
+template <class T, class Op>
+void evaluateMatrixExpression(T *out, unsigned ldo, const MatrixBinaryExpression<Op, MatrixOperand<T>, MatrixOperand<T> > &expr,
+        unsigned rows, unsigned cols) {
+    const MatrixOperand<T> &lhs = expr.left();
+    const MatrixOperand<T> &rhs = expr.right();
+    if (ldo == cols && lhs.ld() == cols && rhs.ld() == cols) {
+        simd::binary<Op>(out, lhs.data(), rhs.data(), rows * cols);
+        return;
+    }
+    for (unsigned row=0; row<rows; row++) {
+        simd::binary<Op>(out + row * ldo, lhs.rowData(row), rhs.rowData(row), cols);
+    }
+}
+
+template <class T, class Op>
+void evaluateMatrixExpression(T *out, unsigned ldo, const MatrixBinaryExpression<Op, MatrixOperand<T>, ScalarOperand<T> > &expr,
+        unsigned rows, unsigned cols) {
+    const MatrixOperand<T> &lhs = expr.left();
+    if (ldo == cols && lhs.ld() == cols) {
+        simd::binaryScalar<Op>(out, lhs.data(), expr.right().value(), rows * cols);
+        return;
+    }
+    for (unsigned row=0; row<rows; row++) {
+        simd::binaryScalar<Op>(out + row * ldo, lhs.rowData(row), expr.right().value(), cols);
+    }
+}
+
+/*****************************************************************************************
+                                    Operator helpers
+*****************************************************************************************/
+// These are aliases rather than traits classes so that using them with something that isn't an
+// operand is a substitution failure instead of an error, which keeps the operators out of the
+// way of everything else.
+template <class A>
+using VectorOperandType = typename std::decay<decltype(vectorOperand(std::declval<const A &>()))>::type;
+
+template <class A>
+using MatrixOperandType = typename std::decay<decltype(matrixOperand(std::declval<const A &>()))>::type;
+
+template <class Op, class L, class R>
+using VectorBinaryResult = VectorBinaryExpression<Op, VectorOperandType<L>, VectorOperandType<R>>;
+
+template <class Op, class L>
+using VectorScalarResult = VectorBinaryExpression<Op, VectorOperandType<L>,
+        ScalarOperand<typename VectorOperandType<L>::value_type> >;
+
+template <class Op, class L, class R>
+using MatrixBinaryResult = MatrixBinaryExpression<Op, MatrixOperandType<L>, MatrixOperandType<R>>;
+
+template <class Op, class L>
+using MatrixScalarResult = MatrixBinaryExpression<Op, MatrixOperandType<L>,
+        ScalarOperand<typename MatrixOperandType<L>::value_type> >;
+
+template <class Op, class L, class R>
+VectorBinaryResult<Op, L, R> makeVectorExpression(const L &lhs, const R &rhs) {
+    assert(vectorOperand(lhs).size() == vectorOperand(rhs).size());
+    return VectorBinaryResult<Op, L, R>(vectorOperand(lhs), vectorOperand(rhs));
+}
+
+template <class Op, class L>
+VectorScalarResult<Op, L> makeVectorExpression(const L &lhs, const typename VectorOperandType<L>::value_type &rhs) {
+    typedef typename VectorOperandType<L>::value_type value_type;
+    return VectorScalarResult<Op, L>(vectorOperand(lhs), ScalarOperand<value_type>(rhs));
+}
+
+template <class Op, class L, class R>
+MatrixBinaryResult<Op, L, R> makeMatrixExpression(const L &lhs, const R &rhs) {
+    assert(matrixOperand(lhs).getRows() == matrixOperand(rhs).getRows());
+    assert(matrixOperand(lhs).getCols() == matrixOperand(rhs).getCols());
+    return MatrixBinaryResult<Op, L, R>(matrixOperand(lhs), matrixOperand(rhs));
+}
+
+template <class Op, class L>
+MatrixScalarResult<Op, L> makeMatrixExpression(const L &lhs, const typename MatrixOperandType<L>::value_type &rhs) {
+    typedef typename MatrixOperandType<L>::value_type value_type;
+    return MatrixScalarResult<Op, L>(matrixOperand(lhs), ScalarOperand<value_type>(rhs));
+}
+
+}
+
+#endif /* Expression_h */
@@ -0,0 +1,556 @@
+//
+//  FftButterflies.h
+//  MatrixDSP
+//
+//  Vectorized radix 2, 3, 4 and 5 butterflies for kissfft.  A stage of the FFT does "m"
+//  independent butterflies, and butterfly k only touches Fout[k], Fout[k+m], ... so "width"
+//  consecutive butterflies fit in one register per leg.  The twiddles that kissfft reads with a
+//  stride of fstride are copied into a contiguous table for each stage when the plan is made,
+//  so the kernels only do unit stride loads.
+//
+//  The same butterflies also do batches of interleaved transforms (see
+//  kissfft::transform_batch()).  There element n of transform b is at [n*batch + b], so
+//  butterfly k of every transform in the batch uses the same twiddles, and the registers are
+//  filled with neighbouring transforms instead of neighbouring butterflies.  Each twiddle is
+//  then loaded once for the whole batch.
+//
+//  The kernels are selected at run time like the ones in Simd.h.  Stages with fewer than
+//  "width" butterflies (or batches of fewer than "width" transforms), and types other than
+//  float and double, use the scalar butterflies.
+//
+
+#ifndef FftButterflies_h
+#define FftButterflies_h
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+#include "Simd.h"
+
+namespace MatrixDSP {
+namespace simd {
+
+/**
+ * \brief The pre-computed data of one radix 2, 3, 4 or 5 stage of a kissfft plan.
+ */
+template <class T>
+struct ButterflyStage {
+    std::size_t radix = 0;
+    std::size_t m = 0;
+    bool inverse = false;
+    // exp(-/+ 2*pi*j/radix) and exp(-/+ 4*pi*j/radix), the radix 3 and 5 rotations
+    std::complex<T> ya;
+    std::complex<T> yb;
+    // twiddles[(q-1)*m + k] multiplies leg q of butterfly k
+    std::vector< std::complex<T> > twiddles;
+};
+
+/**
+ * \brief True if there are vectorized butterflies for type "T".
+ */
+template <class T>
+struct HasButterflyKernel : std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value> {};
+
+/*****************************************************************************************
+                                    Scalar butterflies
+*****************************************************************************************/
+// One butterfly whose legs are F[0], F[stride], ... and whose twiddles (for legs 1 and up)
+// are tw[0], tw[1], ...
+
+template <class T>
+void butterfly2Scalar(std::complex<T> *F, std::size_t stride, const std::complex<T> *tw, const ButterflyStage<T> &) {
+    const std::complex<T> t = F[stride] * tw[0];
+    F[stride] = F[0] - t;
+    F[0] += t;
+}
+
+template <class T>
+void butterfly3Scalar(std::complex<T> *F, std::size_t stride, const std::complex<T> *tw, const ButterflyStage<T> &stage) {
+    const std::complex<T> s1 = F[stride] * tw[0];
+    const std::complex<T> s2 = F[2*stride] * tw[1];
+    const std::complex<T> sum = s1 + s2;
+    const std::complex<T> diff = (s1 - s2) * stage.ya.imag();
+    const std::complex<T> mid = F[0] - sum * T(0.5);
+    F[0] += sum;
+    F[stride] = mid + std::complex<T>(-diff.imag(), diff.real());
+    F[2*stride] = mid + std::complex<T>(diff.imag(), -diff.real());
+}
+
+template <class T>
+void butterfly4Scalar(std::complex<T> *F, std::size_t stride, const std::complex<T> *tw, const ButterflyStage<T> &stage) {
+    const std::complex<T> s0 = F[stride] * tw[0];
+    const std::complex<T> s1 = F[2*stride] * tw[1];
+    const std::complex<T> s2 = F[3*stride] * tw[2];
+    const std::complex<T> s5 = F[0] - s1;
+    const std::complex<T> f0 = F[0] + s1;
+    const std::complex<T> s3 = s0 + s2;
+    std::complex<T> s4 = s0 - s2;
+    s4 = stage.inverse ? std::complex<T>(-s4.imag(), s4.real()) : std::complex<T>(s4.imag(), -s4.real());
+    F[2*stride] = f0 - s3;
+    F[0] = f0 + s3;
+    F[stride] = s5 + s4;
+    F[3*stride] = s5 - s4;
+}
+
+template <class T>
+void butterfly5Scalar(std::complex<T> *F, std::size_t stride, const std::complex<T> *tw, const ButterflyStage<T> &stage) {
+    const std::complex<T> ya = stage.ya;
+    const std::complex<T> yb = stage.yb;
+    const std::complex<T> s0 = F[0];
+    const std::complex<T> s1 = F[stride] * tw[0];
+    const std::complex<T> s2 = F[2*stride] * tw[1];
+    const std::complex<T> s3 = F[3*stride] * tw[2];
+    const std::complex<T> s4 = F[4*stride] * tw[3];
+    const std::complex<T> s7 = s1 + s4;
+    const std::complex<T> s10 = s1 - s4;
+    const std::complex<T> s8 = s2 + s3;
+    const std::complex<T> s9 = s2 - s3;
+
+    F[0] = s0 + s7 + s8;
+
+    const std::complex<T> s5 = s0 + s7 * ya.real() + s8 * yb.real();
+    const std::complex<T> u = s10 * ya.imag() + s9 * yb.imag();
+    const std::complex<T> s6(u.imag(), -u.real());
+    F[stride] = s5 - s6;
+    F[4*stride] = s5 + s6;
+
+    const std::complex<T> s11 = s0 + s7 * yb.real() + s8 * ya.real();
+    const std::complex<T> v = s9 * ya.imag() - s10 * yb.imag();
+    const std::complex<T> s12(v.imag(), -v.real());
+    F[2*stride] = s11 + s12;
+    F[3*stride] = s11 - s12;
+}
+
+template <class T>
+void butterflyScalar(std::complex<T> *F, std::size_t stride, const std::complex<T> *tw, const ButterflyStage<T> &stage) {
+    switch (stage.radix) {
+        case 2: butterfly2Scalar(F, stride, tw, stage); break;
+        case 3: butterfly3Scalar(F, stride, tw, stage); break;
+        case 4: butterfly4Scalar(F, stride, tw, stage); break;
+        case 5: butterfly5Scalar(F, stride, tw, stage); break;
+    }
+}
+
+/**
+ * \brief Butterflies kbegin to m-1 of a stage of a single transform.
+ */
+template <class T>
+void butterflyRunScalar(std::complex<T> *Fout, const ButterflyStage<T> &stage, std::size_t kbegin) {
+    const std::size_t m = stage.m;
+    std::complex<T> tw[4];
+    for (std::size_t k=kbegin; k<m; k++) {
+        for (std::size_t q=1; q<stage.radix; q++) {
+            tw[q-1] = stage.twiddles[(q-1)*m + k];
+        }
+        butterflyScalar(Fout + k, m, tw, stage);
+    }
+}
+
+/**
+ * \brief Every butterfly of transforms bbegin to batch-1 of a batch of interleaved transforms.
+ */
+template <class T>
+void butterflyBatchScalar(std::complex<T> *Fout, const ButterflyStage<T> &stage, std::size_t batch, std::size_t bbegin) {
+    const std::size_t m = stage.m;
+    std::complex<T> tw[4];
+    for (std::size_t k=0; k<m; k++) {
+        for (std::size_t q=1; q<stage.radix; q++) {
+            tw[q-1] = stage.twiddles[(q-1)*m + k];
+        }
+        for (std::size_t b=bbegin; b<batch; b++) {
+            butterflyScalar(Fout + k*batch + b, m*batch, tw, stage);
+        }
+    }
+}
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+/*****************************************************************************************
+                                            AVX2
+*****************************************************************************************/
+// As with the loops in Simd.h, the target attribute has to be a literal, so there is one copy
+// of each butterfly per instruction set.  Each one does "width" butterflies whose legs are
+// F[0], F[stride], ... with the twiddles in tw.
+
+template <class Cx>
+struct Radix2Avx2 {
+    typedef Cx Traits;
+    static const unsigned radix = 2;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void apply(typename Cx::Complex *F, std::size_t stride,
+            const typename Cx::Reg *tw, const ButterflyStage<typename Cx::Scalar> &) {
+        typename Cx::Reg f0 = Cx::load(F);
+        typename Cx::Reg t = Cx::mul(Cx::load(F + stride), tw[0]);
+        Cx::store(F + stride, Cx::sub(f0, t));
+        Cx::store(F, Cx::add(f0, t));
+    }
+};
+
+template <class Cx>
+struct Radix3Avx2 {
+    typedef Cx Traits;
+    static const unsigned radix = 3;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void apply(typename Cx::Complex *F, std::size_t stride,
+            const typename Cx::Reg *tw, const ButterflyStage<typename Cx::Scalar> &stage) {
+        typedef typename Cx::Reg Reg;
+        Reg s1 = Cx::mul(Cx::load(F + stride), tw[0]);
+        Reg s2 = Cx::mul(Cx::load(F + 2*stride), tw[1]);
+        Reg f0 = Cx::load(F);
+        Reg sum = Cx::add(s1, s2);
+        Reg diff = Cx::scale(Cx::sub(s1, s2), Cx::set1(stage.ya.imag()));
+        Reg mid = Cx::sub(f0, Cx::scale(sum, Cx::set1(0.5)));
+        Cx::store(F, Cx::add(f0, sum));
+        Cx::store(F + stride, Cx::add(mid, Cx::mulJ(diff)));
+        Cx::store(F + 2*stride, Cx::add(mid, Cx::mulMinusJ(diff)));
+    }
+};
+
+template <class Cx>
+struct Radix4Avx2 {
+    typedef Cx Traits;
+    static const unsigned radix = 4;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void apply(typename Cx::Complex *F, std::size_t stride,
+            const typename Cx::Reg *tw, const ButterflyStage<typename Cx::Scalar> &stage) {
+        typedef typename Cx::Reg Reg;
+        Reg s0 = Cx::mul(Cx::load(F + stride), tw[0]);
+        Reg s1 = Cx::mul(Cx::load(F + 2*stride), tw[1]);
+        Reg s2 = Cx::mul(Cx::load(F + 3*stride), tw[2]);
+        Reg f0 = Cx::load(F);
+        Reg s5 = Cx::sub(f0, s1);
+        f0 = Cx::add(f0, s1);
+        Reg s3 = Cx::add(s0, s2);
+        Reg s4 = stage.inverse ? Cx::mulJ(Cx::sub(s0, s2)) : Cx::mulMinusJ(Cx::sub(s0, s2));
+        Cx::store(F + 2*stride, Cx::sub(f0, s3));
+        Cx::store(F, Cx::add(f0, s3));
+        Cx::store(F + stride, Cx::add(s5, s4));
+        Cx::store(F + 3*stride, Cx::sub(s5, s4));
+    }
+};
+
+template <class Cx>
+struct Radix5Avx2 {
+    typedef Cx Traits;
+    static const unsigned radix = 5;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void apply(typename Cx::Complex *F, std::size_t stride,
+            const typename Cx::Reg *tw, const ButterflyStage<typename Cx::Scalar> &stage) {
+        typedef typename Cx::Reg Reg;
+        const Reg yaRe = Cx::set1(stage.ya.real());
+        const Reg yaIm = Cx::set1(stage.ya.imag());
+        const Reg ybRe = Cx::set1(stage.yb.real());
+        const Reg ybIm = Cx::set1(stage.yb.imag());
+        Reg s0 = Cx::load(F);
+        Reg s1 = Cx::mul(Cx::load(F + stride), tw[0]);
+        Reg s2 = Cx::mul(Cx::load(F + 2*stride), tw[1]);
+        Reg s3 = Cx::mul(Cx::load(F + 3*stride), tw[2]);
+        Reg s4 = Cx::mul(Cx::load(F + 4*stride), tw[3]);
+        Reg s7 = Cx::add(s1, s4);
+        Reg s10 = Cx::sub(s1, s4);
+        Reg s8 = Cx::add(s2, s3);
+        Reg s9 = Cx::sub(s2, s3);
+
+        Cx::store(F, Cx::add(s0, Cx::add(s7, s8)));
+
+        Reg s5 = Cx::add(s0, Cx::add(Cx::scale(s7, yaRe), Cx::scale(s8, ybRe)));
+        Reg s6 = Cx::mulMinusJ(Cx::add(Cx::scale(s10, yaIm), Cx::scale(s9, ybIm)));
+        Cx::store(F + stride, Cx::sub(s5, s6));
+        Cx::store(F + 4*stride, Cx::add(s5, s6));
+
+        Reg s11 = Cx::add(s0, Cx::add(Cx::scale(s7, ybRe), Cx::scale(s8, yaRe)));
+        Reg s12 = Cx::mulMinusJ(Cx::sub(Cx::scale(s9, yaIm), Cx::scale(s10, ybIm)));
+        Cx::store(F + 2*stride, Cx::add(s11, s12));
+        Cx::store(F + 3*stride, Cx::sub(s11, s12));
+    }
+};
+
+/**
+ * \brief Vectorizes across the butterflies of one transform.  Returns how many were done.
+ */
+template <class Radix>
+MATRIX_DSP_TARGET_AVX2 std::size_t butterflyRunAvx2(typename Radix::Traits::Complex *Fout,
+        const ButterflyStage<typename Radix::Traits::Scalar> &stage) {
+    typedef typename Radix::Traits Cx;
+    const std::size_t m = stage.m;
+    const typename Cx::Complex *twiddles = stage.twiddles.data();
+    typename Cx::Reg tw[Radix::radix - 1];
+    std::size_t k = 0;
+    for (; k + Cx::width <= m; k += Cx::width) {
+        for (unsigned q=1; q<Radix::radix; q++) {
+            tw[q-1] = Cx::load(twiddles + (q-1)*m + k);
+        }
+        Radix::apply(Fout + k, m, tw, stage);
+    }
+    return k;
+}
+
+/**
+ * \brief Vectorizes across a batch of interleaved transforms.  Returns how many were done.
+ */
+template <class Radix>
+MATRIX_DSP_TARGET_AVX2 std::size_t butterflyBatchAvx2(typename Radix::Traits::Complex *Fout,
+        const ButterflyStage<typename Radix::Traits::Scalar> &stage, std::size_t batch) {
+    typedef typename Radix::Traits Cx;
+    const std::size_t m = stage.m;
+    const std::size_t done = batch - batch % Cx::width;
+    typename Cx::Reg tw[Radix::radix - 1];
+    for (std::size_t k=0; k<m; k++) {
+        for (unsigned q=1; q<Radix::radix; q++) {
+            tw[q-1] = Cx::broadcast(stage.twiddles[(q-1)*m + k]);
+        }
+        for (std::size_t b=0; b<done; b += Cx::width) {
+            Radix::apply(Fout + k*batch + b, m*batch, tw, stage);
+        }
+    }
+    return done;
+}
+
+/*****************************************************************************************
+                                            AVX-512
+*****************************************************************************************/
+template <class Cx>
+struct Radix2Avx512 {
+    typedef Cx Traits;
+    static const unsigned radix = 2;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void apply(typename Cx::Complex *F, std::size_t stride,
+            const typename Cx::Reg *tw, const ButterflyStage<typename Cx::Scalar> &) {
+        typename Cx::Reg f0 = Cx::load(F);
+        typename Cx::Reg t = Cx::mul(Cx::load(F + stride), tw[0]);
+        Cx::store(F + stride, Cx::sub(f0, t));
+        Cx::store(F, Cx::add(f0, t));
+    }
+};
+
+template <class Cx>
+struct Radix3Avx512 {
+    typedef Cx Traits;
+    static const unsigned radix = 3;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void apply(typename Cx::Complex *F, std::size_t stride,
+            const typename Cx::Reg *tw, const ButterflyStage<typename Cx::Scalar> &stage) {
+        typedef typename Cx::Reg Reg;
+        Reg s1 = Cx::mul(Cx::load(F + stride), tw[0]);
+        Reg s2 = Cx::mul(Cx::load(F + 2*stride), tw[1]);
+        Reg f0 = Cx::load(F);
+        Reg sum = Cx::add(s1, s2);
+        Reg diff = Cx::scale(Cx::sub(s1, s2), Cx::set1(stage.ya.imag()));
+        Reg mid = Cx::sub(f0, Cx::scale(sum, Cx::set1(0.5)));
+        Cx::store(F, Cx::add(f0, sum));
+        Cx::store(F + stride, Cx::add(mid, Cx::mulJ(diff)));
+        Cx::store(F + 2*stride, Cx::add(mid, Cx::mulMinusJ(diff)));
+    }
+};
+
+template <class Cx>
+struct Radix4Avx512 {
+    typedef Cx Traits;
+    static const unsigned radix = 4;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void apply(typename Cx::Complex *F, std::size_t stride,
+            const typename Cx::Reg *tw, const ButterflyStage<typename Cx::Scalar> &stage) {
+        typedef typename Cx::Reg Reg;
+        Reg s0 = Cx::mul(Cx::load(F + stride), tw[0]);
+        Reg s1 = Cx::mul(Cx::load(F + 2*stride), tw[1]);
+        Reg s2 = Cx::mul(Cx::load(F + 3*stride), tw[2]);
+        Reg f0 = Cx::load(F);
+        Reg s5 = Cx::sub(f0, s1);
+        f0 = Cx::add(f0, s1);
+        Reg s3 = Cx::add(s0, s2);
+        Reg s4 = stage.inverse ? Cx::mulJ(Cx::sub(s0, s2)) : Cx::mulMinusJ(Cx::sub(s0, s2));
+        Cx::store(F + 2*stride, Cx::sub(f0, s3));
+        Cx::store(F, Cx::add(f0, s3));
+        Cx::store(F + stride, Cx::add(s5, s4));
+        Cx::store(F + 3*stride, Cx::sub(s5, s4));
+    }
+};
+
+template <class Cx>
+struct Radix5Avx512 {
+    typedef Cx Traits;
+    static const unsigned radix = 5;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void apply(typename Cx::Complex *F, std::size_t stride,
+            const typename Cx::Reg *tw, const ButterflyStage<typename Cx::Scalar> &stage) {
+        typedef typename Cx::Reg Reg;
+        const Reg yaRe = Cx::set1(stage.ya.real());
+        const Reg yaIm = Cx::set1(stage.ya.imag());
+        const Reg ybRe = Cx::set1(stage.yb.real());
+        const Reg ybIm = Cx::set1(stage.yb.imag());
+        Reg s0 = Cx::load(F);
+        Reg s1 = Cx::mul(Cx::load(F + stride), tw[0]);
+        Reg s2 = Cx::mul(Cx::load(F + 2*stride), tw[1]);
+        Reg s3 = Cx::mul(Cx::load(F + 3*stride), tw[2]);
+        Reg s4 = Cx::mul(Cx::load(F + 4*stride), tw[3]);
+        Reg s7 = Cx::add(s1, s4);
+        Reg s10 = Cx::sub(s1, s4);
+        Reg s8 = Cx::add(s2, s3);
+        Reg s9 = Cx::sub(s2, s3);
+
+        Cx::store(F, Cx::add(s0, Cx::add(s7, s8)));
+
+        Reg s5 = Cx::add(s0, Cx::add(Cx::scale(s7, yaRe), Cx::scale(s8, ybRe)));
+        Reg s6 = Cx::mulMinusJ(Cx::add(Cx::scale(s10, yaIm), Cx::scale(s9, ybIm)));
+        Cx::store(F + stride, Cx::sub(s5, s6));
+        Cx::store(F + 4*stride, Cx::add(s5, s6));
+
+        Reg s11 = Cx::add(s0, Cx::add(Cx::scale(s7, ybRe), Cx::scale(s8, yaRe)));
+        Reg s12 = Cx::mulMinusJ(Cx::sub(Cx::scale(s9, yaIm), Cx::scale(s10, ybIm)));
+        Cx::store(F + 2*stride, Cx::add(s11, s12));
+        Cx::store(F + 3*stride, Cx::sub(s11, s12));
+    }
+};
+
+template <class Radix>
+MATRIX_DSP_TARGET_AVX512 std::size_t butterflyRunAvx512(typename Radix::Traits::Complex *Fout,
+        const ButterflyStage<typename Radix::Traits::Scalar> &stage) {
+    typedef typename Radix::Traits Cx;
+    const std::size_t m = stage.m;
+    const typename Cx::Complex *twiddles = stage.twiddles.data();
+    typename Cx::Reg tw[Radix::radix - 1];
+    std::size_t k = 0;
+    for (; k + Cx::width <= m; k += Cx::width) {
+        for (unsigned q=1; q<Radix::radix; q++) {
+            tw[q-1] = Cx::load(twiddles + (q-1)*m + k);
+        }
+        Radix::apply(Fout + k, m, tw, stage);
+    }
+    return k;
+}
+
+template <class Radix>
+MATRIX_DSP_TARGET_AVX512 std::size_t butterflyBatchAvx512(typename Radix::Traits::Complex *Fout,
+        const ButterflyStage<typename Radix::Traits::Scalar> &stage, std::size_t batch) {
+    typedef typename Radix::Traits Cx;
+    const std::size_t m = stage.m;
+    const std::size_t done = batch - batch % Cx::width;
+    typename Cx::Reg tw[Radix::radix - 1];
+    for (std::size_t k=0; k<m; k++) {
+        for (unsigned q=1; q<Radix::radix; q++) {
+            tw[q-1] = Cx::broadcast(stage.twiddles[(q-1)*m + k]);
+        }
+        for (std::size_t b=0; b<done; b += Cx::width) {
+            Radix::apply(Fout + k*batch + b, m*batch, tw, stage);
+        }
+    }
+    return done;
+}
+
+/*****************************************************************************************
+                                        Dispatcher
+*****************************************************************************************/
+template <class Radix>
+std::size_t butterflyAvx2(typename Radix::Traits::Complex *Fout, const ButterflyStage<typename Radix::Traits::Scalar> &stage,
+                          std::size_t batch) {
+    return batch == 1 ? butterflyRunAvx2<Radix>(Fout, stage) : butterflyBatchAvx2<Radix>(Fout, stage, batch);
+}
+
+template <class Radix>
+std::size_t butterflyAvx512(typename Radix::Traits::Complex *Fout, const ButterflyStage<typename Radix::Traits::Scalar> &stage,
+                            std::size_t batch) {
+    return batch == 1 ? butterflyRunAvx512<Radix>(Fout, stage) : butterflyBatchAvx512<Radix>(Fout, stage, batch);
+}
+
+/**
+ * \brief Returns how many butterflies (batch == 1) or transforms (batch > 1) were done.
+ */
+template <class T>
+std::size_t butterflyVector(std::complex<T> *Fout, const ButterflyStage<T> &stage, std::size_t batch, std::true_type) {
+    typedef ComplexTraits<Isa::Avx512, T> Avx512;
+    typedef ComplexTraits<Isa::Avx2, T> Avx2;
+    const std::size_t count = batch == 1 ? stage.m : batch;
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && count >= Avx512::width && Avx512::available()) {
+        switch (stage.radix) {
+            case 2: return butterflyAvx512< Radix2Avx512<Avx512> >(Fout, stage, batch);
+            case 3: return butterflyAvx512< Radix3Avx512<Avx512> >(Fout, stage, batch);
+            case 4: return butterflyAvx512< Radix4Avx512<Avx512> >(Fout, stage, batch);
+            case 5: return butterflyAvx512< Radix5Avx512<Avx512> >(Fout, stage, batch);
+        }
+    }
+    if (isa >= Isa::Avx2 && count >= Avx2::width && Avx2::available()) {
+        switch (stage.radix) {
+            case 2: return butterflyAvx2< Radix2Avx2<Avx2> >(Fout, stage, batch);
+            case 3: return butterflyAvx2< Radix3Avx2<Avx2> >(Fout, stage, batch);
+            case 4: return butterflyAvx2< Radix4Avx2<Avx2> >(Fout, stage, batch);
+            case 5: return butterflyAvx2< Radix5Avx2<Avx2> >(Fout, stage, batch);
+        }
+    }
+    return 0;
+}
+
+#endif // MATRIX_DSP_X86_SIMD
+
+template <class T>
+std::size_t butterflyVector(std::complex<T> *, const ButterflyStage<T> &, std::size_t, std::false_type) {
+    return 0;
+}
+
+template <class T>
+std::size_t butterflyVector(std::complex<T> *Fout, const ButterflyStage<T> &stage, std::size_t batch) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    return butterflyVector(Fout, stage, batch, HasButterflyKernel<T>());
+#else
+    return butterflyVector(Fout, stage, batch, std::false_type());
+#endif
+}
+
+/**
+ * \brief Does all of the butterflies of one stage, if there is a vector kernel for it.
+ *
+ * \param Fout The stage's output, which is updated in place.
+ * \param stage The stage's pre-computed twiddles.
+ * \return False if there isn't a kernel for this radix, type and CPU and Fout is untouched, in
+ *         which case the caller should use its own scalar butterflies.
+ */
+template <class T>
+bool butterfly(std::complex<T> *Fout, const ButterflyStage<T> &stage) {
+    std::size_t done = butterflyVector(Fout, stage, 1);
+    if (done == 0) {
+        return false;
+    }
+    butterflyRunScalar(Fout, stage, done);
+    return true;
+}
+
+/**
+ * \brief Does all of the butterflies of one stage of a batch of interleaved transforms.
+ *
+ * \param Fout The stage's output, which is updated in place.  Element n of transform b is
+ *        Fout[n*batch + b].
+ * \param stage The stage's pre-computed twiddles.
+ * \param batch The number of transforms.
+ */
+template <class T>
+void butterflyBatch(std::complex<T> *Fout, const ButterflyStage<T> &stage, std::size_t batch) {
+    std::size_t done = batch > 1 ? butterflyVector(Fout, stage, batch) : 0;
+    butterflyBatchScalar(Fout, stage, batch, done);
+}
+
+/**
+ * \brief Builds the contiguous twiddle table of one stage from a kissfft twiddle table.
+ *
+ * \param twiddles The plan's twiddles, exp(-/+ 2*pi*j*i/nfft) for i = 0 ... nfft-1.
+ * \param radix The radix of the stage, 2 to 5.
+ * \param m The number of butterflies in the stage.
+ * \param fstride The stride that the stage reads twiddles with, which is the product of the
+ *        radices of the stages before it.
+ */
+template <class T>
+ButterflyStage<T> makeButterflyStage(const std::vector< std::complex<T> > &twiddles, std::size_t radix,
+                                     std::size_t m, std::size_t fstride, bool inverse) {
+    ButterflyStage<T> stage;
+    stage.radix = radix;
+    stage.m = m;
+    stage.inverse = inverse;
+    stage.ya = twiddles[fstride*m];
+    if (radix == 5) {
+        stage.yb = twiddles[2*fstride*m];
+    }
+    stage.twiddles.resize((radix - 1) * m);
+    for (std::size_t q=1; q<radix; q++) {
+        for (std::size_t k=0; k<m; k++) {
+            stage.twiddles[(q-1)*m + k] = twiddles[q*k*fstride];
+        }
+    }
+    return stage;
+}
+
+}
+}
+
+#endif /* FftButterflies_h */
@@ -9,53 +9,510 @@
 #define FftSetupManager_h
 
 #include <map>
+#include <vector>
+#include <atomic>
+#include <mutex>
 #include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
 #include "kissfft.h"
 
+namespace MatrixDSP {
+
+/**
+ * \brief How FftSetupManager plans the FFTs for lengths that it has no wisdom for.
+ */
+enum class FftPlanning {
+    Estimate,   ///< kissfft's own factorization, with Bluestein's algorithm where usesChirpZ() says
+    Measure     ///< Times the candidate plans and keeps the fastest, which becomes wisdom
+};
+
+}
+
+/**
+ * \brief A cache of FFT setups (plans) that can be shared by any number of threads.
+ *
+ * Lookups don't lock.  The setups are found through an immutable snapshot of the cache, and
+ * creating a setup copies the snapshot, adds the new setup, and swaps the copy in atomically
+ * (read-copy-update).  So finding an existing setup is an atomic load plus a map search, and
+ * only creating one is serialized.  A reader may still be searching a snapshot after it has
+ * been replaced, so the old snapshots are kept until cleanUp() or destruction.  That costs a
+ * copy of the map each time a new FFT length is used, which is fine for the handful of
+ * lengths that a program typically uses.
+ *
+ * The setups themselves are read-only once they are made, so one setup can be used by several
+ * threads at once.  Removing setups (removeFftSetup(), removeRealFftSetup() and cleanUp()) is
+ * the exception: it must not be done while another thread may be using the manager.
+ *
+ * Lengths with large prime factors get setups that use Bluestein's algorithm (see
+ * usesChirpZ()), so every length is O(N log N).
+ *
+ * With setPlanning(FftPlanning::Measure), a new length is planned by timing several orders and
+ * groupings of its factors, and Bluestein's algorithm when it has a large prime factor, and
+ * keeping the fastest.  That takes a few FFTs' worth of time per candidate.  The measured
+ * plans are the manager's "wisdom", which can be written to a file with exportWisdom() and read
+ * back with importWisdom(), so a program can plan once and start quickly from then on.  Wisdom
+ * is used whatever the planning mode, but only for setups made after it's known.
+ */
 template <class T, class RealIterator, class ComplexIterator>
 class FftSetupManager {
     private:
-    std::map<int, kissfft<T, RealIterator, ComplexIterator> * > fftSetups;
-    
+    typedef kissfft<T, RealIterator, ComplexIterator> Setup;
+    typedef kissfftr<T, RealIterator, ComplexIterator> RealSetup;
+
+    struct Snapshot {
+        std::map<int, Setup *> fftSetups;
+        std::map<int, RealSetup *> realFftSetups;
+    };
+
+    std::atomic<const Snapshot *> current;
+    std::vector<const Snapshot *> retired;
+    std::mutex writeMutex;
+    // These are only used with writeMutex held
+    std::map<int, kissfft_plan> wisdom;  // Measured plans, by complex FFT length
+    MatrixDSP::FftPlanning planning = MatrixDSP::FftPlanning::Estimate;
+
     int genKey(int fftLen, bool inverseFft) {return fftLen * 2 + (int) inverseFft;}
-    
+
+    template <class S>
+    static S * findSetup(const std::map<int, S *> &setups, int key) {
+        auto setupPtr = setups.find(key);
+        return setupPtr == setups.end() ? nullptr : setupPtr->second;
+    }
+
+    static const char * typeName() {
+        return std::is_same<T, float>::value ? "float" : (std::is_same<T, double>::value ? "double" : "long-double");
+    }
+
+    /**
+     * \brief The plans worth timing for a complex FFT of length "fftLen": kissfft's own
+     *      factorization, its factors in increasing and decreasing order with and without the
+     *      4's split into 2's, and Bluestein's algorithm if there's a factor above 5.
+     */
+    static std::vector<kissfft_plan> candidatePlans(std::size_t fftLen) {
+        std::vector<kissfft_plan> plans;
+        auto addPlan = [&plans](bool chirpZ, const std::vector<std::size_t> &radices) {
+            for (const kissfft_plan &plan : plans) {
+                if (plan.chirpZ == chirpZ && plan.radices == radices) {
+                    return;
+                }
+            }
+            plans.push_back(kissfft_plan{chirpZ, radices});
+        };
+
+        std::vector<std::size_t> fours = Setup::factorize(fftLen);
+        addPlan(false, fours);
+        std::vector<std::size_t> twos;
+        for (std::size_t radix : fours) {
+            if (radix == 4) {
+                twos.push_back(2);
+                twos.push_back(2);
+            } else {
+                twos.push_back(radix);
+            }
+        }
+        for (std::vector<std::size_t> radices : {fours, twos}) {
+            std::sort(radices.begin(), radices.end());
+            addPlan(false, radices);
+            std::reverse(radices.begin(), radices.end());
+            addPlan(false, radices);
+        }
+        if (fours.back() > 5) {
+            addPlan(true, std::vector<std::size_t>());
+        }
+        return plans;
+    }
+
+    /**
+     * \brief Times each of the candidate plans for a complex FFT of length "fftLen" and
+     *      returns the fastest.
+     */
+    static kissfft_plan measurePlan(std::size_t fftLen) {
+        typedef std::chrono::steady_clock Clock;
+        std::vector<kissfft_plan> plans = candidatePlans(fftLen);
+        if (plans.size() == 1) {
+            return plans[0];
+        }
+        std::vector< std::complex<T> > input(fftLen), output(fftLen);
+        for (std::size_t index = 0; index < fftLen; index++) {
+            input[index] = std::complex<T>(T((index * 7919) % 101) / 101, T((index * 104729) % 103) / 103);
+        }
+
+        std::size_t bestPlan = 0;
+        double bestTime = 0;
+        for (std::size_t which = 0; which < plans.size(); which++) {
+            Setup fft(fftLen, false, plans[which]);
+            // One transform warms up the caches, and says how many make a pass of about a
+            // millisecond, which is long enough to time
+            Clock::time_point start = Clock::now();
+            fft.transform(input.data(), output.data());
+            double once = std::chrono::duration<double>(Clock::now() - start).count();
+            const std::size_t reps = std::max<std::size_t>(1, (std::size_t) (1e-3 / std::max(once, 1e-9)));
+
+            double best = 0;
+            for (unsigned pass = 0; pass < 5; pass++) {
+                start = Clock::now();
+                for (std::size_t rep = 0; rep < reps; rep++) {
+                    fft.transform(input.data(), output.data());
+                }
+                double elapsed = std::chrono::duration<double>(Clock::now() - start).count() / reps;
+                if (pass == 0 || elapsed < best) {
+                    best = elapsed;
+                }
+                if (which > 0 && best > 2 * bestTime) {
+                    break;  // Not even close
+                }
+            }
+            if (which == 0) {
+                // kissfft's own plan gets a head start, so that noise doesn't swap it for one
+                // that's no faster
+                best *= 0.95;
+            }
+            if (which == 0 || best < bestTime) {
+                bestPlan = which;
+                bestTime = best;
+            }
+        }
+        return plans[bestPlan];
+    }
+
+    /**
+     * \brief The plan for a complex FFT of length "fftLen", from the wisdom if it's there.  The
+     *      caller must hold writeMutex.
+     */
+    kissfft_plan findPlan(int fftLen) {
+        auto known = wisdom.find(fftLen);
+        if (known != wisdom.end()) {
+            return known->second;
+        }
+        if (planning == MatrixDSP::FftPlanning::Measure) {
+            kissfft_plan plan = measurePlan(fftLen);
+            wisdom[fftLen] = plan;
+            return plan;
+        }
+        return kissfft_plan{usesChirpZ(fftLen), std::vector<std::size_t>()};
+    }
+
+    /**
+     * \brief Makes "next" the current snapshot.  The caller must hold writeMutex.
+     */
+    void publish(const Snapshot *next) {
+        retired.push_back(current.load(std::memory_order_relaxed));
+        current.store(next, std::memory_order_release);
+    }
+
     public:
-    FftSetupManager<T, RealIterator, ComplexIterator>() {}
-    
+    FftSetupManager<T, RealIterator, ComplexIterator>() : current(new Snapshot()) {}
+
     ~FftSetupManager() {
         cleanUp();
+        delete current.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief True if a complex FFT of length "fftLen" is done with Bluestein's algorithm rather
+     *      than kissfft's mixed radix stages.
+     *
+     * Each factor p above 5 is a stage of kissfft's generic butterfly, which costs about
+     * fftLen * p, and Bluestein's algorithm costs about M log2(M) for the power of two M that
+     * is at least 2 * fftLen - 1.  Bluestein's algorithm is used when it's the cheaper, which
+     * works out as a largest prime factor of more than about 20 to 40, depending on the length.
+     */
+    static bool usesChirpZ(std::size_t fftLen) {
+        if (fftLen < 2) {
+            return false;
+        }
+        double genericWork = 0;
+        std::size_t n = fftLen;
+        for (std::size_t p = 2; p * p <= n; p++) {
+            while (n % p == 0) {
+                n /= p;
+                genericWork += p > 5 ? (double) p : 0;
+            }
+        }
+        genericWork += n > 5 ? (double) n : 0;
+        double m = 1;
+        while (m < 2 * fftLen - 1) {
+            m *= 2;
+        }
+        return genericWork * fftLen > m * std::log2(m);
     }
-    
-    kissfft<T, RealIterator, ComplexIterator> * getFftSetup(int fftLen, bool inverseFft = false) {
+
+    Setup * getFftSetup(int fftLen, bool inverseFft = false) {
         int key = genKey(fftLen, inverseFft);
-        
-        auto setupPtr = fftSetups.find(key);
-        if (setupPtr != fftSetups.end()) {
-            return setupPtr->second;
-        }
-        
-        kissfft<T, RealIterator, ComplexIterator> *fftSetup = new kissfft<T, RealIterator, ComplexIterator>(fftLen, inverseFft);
-        fftSetups[key] = fftSetup;
+
+        Setup *fftSetup = findSetup(current.load(std::memory_order_acquire)->fftSetups, key);
+        if (fftSetup != nullptr) {
+            return fftSetup;
+        }
+
+        std::lock_guard<std::mutex> lock(writeMutex);
+        // Another thread may have made it while we were waiting for the lock
+        const Snapshot *snapshot = current.load(std::memory_order_relaxed);
+        fftSetup = findSetup(snapshot->fftSetups, key);
+        if (fftSetup != nullptr) {
+            return fftSetup;
+        }
+
+        fftSetup = new Setup(fftLen, inverseFft, findPlan(fftLen));
+        Snapshot *next = new Snapshot(*snapshot);
+        next->fftSetups[key] = fftSetup;
+        publish(next);
+        return fftSetup;
+    }
+
+    /**
+     * \brief Returns the setup for a real-input FFT of even length "fftLen", creating it if necessary.
+     */
+    RealSetup * getRealFftSetup(int fftLen) {
+        RealSetup *fftSetup = findSetup(current.load(std::memory_order_acquire)->realFftSetups, fftLen);
+        if (fftSetup != nullptr) {
+            return fftSetup;
+        }
+
+        std::lock_guard<std::mutex> lock(writeMutex);
+        const Snapshot *snapshot = current.load(std::memory_order_relaxed);
+        fftSetup = findSetup(snapshot->realFftSetups, fftLen);
+        if (fftSetup != nullptr) {
+            return fftSetup;
+        }
+
+        fftSetup = new RealSetup(fftLen, findPlan(fftLen / 2));
+        Snapshot *next = new Snapshot(*snapshot);
+        next->realFftSetups[fftLen] = fftSetup;
+        publish(next);
         return fftSetup;
     }
-    
+
     void removeFftSetup(int fftLen, bool inverseFft = false) {
-        auto setupPtr = fftSetups.find(genKey(fftLen, inverseFft));
-        if (setupPtr == fftSetups.end()) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        int key = genKey(fftLen, inverseFft);
+        const Snapshot *snapshot = current.load(std::memory_order_relaxed);
+        Setup *fftSetup = findSetup(snapshot->fftSetups, key);
+        if (fftSetup == nullptr) {
+            return;
+        }
+        Snapshot *next = new Snapshot(*snapshot);
+        next->fftSetups.erase(key);
+        publish(next);
+        delete fftSetup;
+    }
+
+    void removeRealFftSetup(int fftLen) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        const Snapshot *snapshot = current.load(std::memory_order_relaxed);
+        RealSetup *fftSetup = findSetup(snapshot->realFftSetups, fftLen);
+        if (fftSetup == nullptr) {
             return;
         }
-        delete setupPtr->second;
-        fftSetups.erase(setupPtr);
+        Snapshot *next = new Snapshot(*snapshot);
+        next->realFftSetups.erase(fftLen);
+        publish(next);
+        delete fftSetup;
+    }
+
+    /**
+     * \brief Sets how lengths without wisdom are planned.  Defaults to FftPlanning::Estimate.
+     */
+    void setPlanning(MatrixDSP::FftPlanning mode) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        planning = mode;
+    }
+
+    MatrixDSP::FftPlanning getPlanning() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        return planning;
+    }
+
+    /**
+     * \brief Returns the plan that a new complex FFT of length "fftLen" would get, measuring it
+     *      first if the planning mode is FftPlanning::Measure and there's no wisdom for it.
+     *      Real FFTs of length 2 * fftLen use the same plan.
+     */
+    kissfft_plan getPlan(int fftLen) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        return findPlan(fftLen);
+    }
+
+    /**
+     * \brief Writes the wisdom to "stream", one length per line.
+     *
+     * \return False if the write failed.
+     */
+    bool exportWisdom(std::ostream &stream) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        stream << "MatrixDSP FFT wisdom " << typeName() << "\n";
+        for (auto &entry : wisdom) {
+            stream << entry.first;
+            if (entry.second.chirpZ) {
+                stream << " bluestein";
+            }
+            for (std::size_t radix : entry.second.radices) {
+                stream << " " << radix;
+            }
+            stream << "\n";
+        }
+        return !stream.fail();
+    }
+
+    /**
+     * \brief Writes the wisdom to the file "path".
+     *
+     * \return False if the file couldn't be written.
+     */
+    bool exportWisdom(const std::string &path) {
+        std::ofstream file(path);
+        return file && exportWisdom(static_cast<std::ostream &>(file));
+    }
+
+    /**
+     * \brief Adds the wisdom in "stream", which exportWisdom() wrote, to what the manager knows.
+     *      Setups that have already been made aren't changed.
+     *
+     * \return False, leaving the wisdom as it was, if the stream isn't wisdom for this type or
+     *      doesn't make sense.
+     */
+    bool importWisdom(std::istream &stream) {
+        std::string line;
+        if (!std::getline(stream, line) || line != std::string("MatrixDSP FFT wisdom ") + typeName()) {
+            return false;
+        }
+        std::map<int, kissfft_plan> imported;
+        while (std::getline(stream, line)) {
+            std::istringstream fields(line);
+            int fftLen;
+            if (!(fields >> fftLen)) {
+                if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                    return false;
+                }
+                continue;
+            }
+            if (fftLen < 1) {
+                return false;
+            }
+            kissfft_plan plan;
+            std::string field;
+            std::size_t product = 1;
+            while (fields >> field) {
+                if (field == "bluestein" && !plan.chirpZ && plan.radices.empty()) {
+                    plan.chirpZ = true;
+                    continue;
+                }
+                std::istringstream number(field);
+                std::size_t radix;
+                if (!(number >> radix) || !number.eof() || radix < 1 || (radix == 1 && fftLen != 1)) {
+                    return false;
+                }
+                plan.radices.push_back(radix);
+                product *= radix;
+            }
+            if (!plan.radices.empty() && product != (std::size_t) fftLen) {
+                return false;
+            }
+            if (plan.chirpZ == !plan.radices.empty()) {
+                return false;
+            }
+            imported[fftLen] = plan;
+        }
+        if (stream.bad()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(writeMutex);
+        for (auto &entry : imported) {
+            wisdom[entry.first] = entry.second;
+        }
+        return true;
+    }
+
+    /**
+     * \brief Reads wisdom from the file "path" (see importWisdom(std::istream &)).
+     *
+     * \return False if the file couldn't be read or isn't wisdom for this type.
+     */
+    bool importWisdom(const std::string &path) {
+        std::ifstream file(path);
+        return file && importWisdom(static_cast<std::istream &>(file));
+    }
+
+    /**
+     * \brief Forgets the wisdom.  Setups that have already been made aren't changed.
+     */
+    void forgetWisdom() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        wisdom.clear();
     }
-    
+
     void cleanUp() {
-        auto it = fftSetups.begin();
-        while(it != fftSetups.end()) {
-            delete it->second;
-            it = fftSetups.erase(it);
+        std::lock_guard<std::mutex> lock(writeMutex);
+        const Snapshot *snapshot = current.load(std::memory_order_relaxed);
+        for (auto &setup : snapshot->fftSetups) {
+            delete setup.second;
+        }
+        for (auto &setup : snapshot->realFftSetups) {
+            delete setup.second;
+        }
+        publish(new Snapshot());
+        for (const Snapshot *old : retired) {
+            delete old;
         }
+        retired.clear();
     }
 };
 
+namespace MatrixDSP {
+
+/**
+ * \brief The process-wide FFT setups for type T, which are shared by every container that
+ *      does FFTs (ComplexVector, and the Matrix2d FFTs in VectorMatrix.h).
+ */
+template <class T>
+FftSetupManager<T, T *, std::complex<T> *> & fftSetupManager()
+{
+    static FftSetupManager<T, T *, std::complex<T> *> managerInstance;
+    return managerInstance;
+}
+
+/**
+ * \brief Returns the smallest length of at least "len" whose only factors are 2, 3 and 5,
+ *      which kissfft has fast butterflies for.  Lengths with larger prime factors use a generic
+ *      butterfly or Bluestein's algorithm, which are several times slower, so padding up to one
+ *      of these is usually worth it.
+ *
+ * \param len The minimum length.
+ * \param even Only return even lengths, for real-input FFTs.  Defaults to false.
+ */
+inline unsigned fastFftLength(unsigned len, bool even = false) {
+    if (even) {
+        return 2 * fastFftLength((len + 1) / 2);
+    }
+    if (len <= 1) {
+        return 1;
+    }
+    unsigned best = 1;
+    while (best < len) {
+        best *= 2;
+    }
+    // Try every 3^b 5^c below the power of two, made up to "len" with powers of 2
+    for (unsigned long long p5 = 1; p5 < best; p5 *= 5) {
+        for (unsigned long long p35 = p5; p35 < best; p35 *= 3) {
+            unsigned long long candidate = p35;
+            while (candidate < len) {
+                candidate *= 2;
+            }
+            if (candidate < best) {
+                best = (unsigned) candidate;
+            }
+        }
+    }
+    return best;
+}
+
+}
 
 #endif /* FftSetupManager_h */
@@ -0,0 +1,437 @@
+//
+//  FirFilter.h
+//  MatrixDSP
+//
+//  An FIR filter that keeps its state between calls, so a long stream can be filtered a block
+//  at a time.  There are two ways of doing the filtering:
+//
+//  Direct form works out each output as a dot product of the taps with the latest samples.
+//  The outputs of a block are x A, where x is the reversed taps and row i of A is the samples
+//  starting i samples into the block (so the rows overlap), and that product is done by the
+//  gemvTransposed() kernels in Gemv.h: each tap is broadcast and multiplied by a run of
+//  samples, which is the usual way of vectorizing an FIR filter.
+//
+//  Overlap-save filters N samples at a time by multiplying their FFT by the FFT of the taps.
+//  The first numTaps - 1 outputs of each inverse FFT wrap around and are thrown away, so each
+//  FFT gives N - numTaps + 1 new outputs, and the next FFT starts numTaps - 1 samples before
+//  where they end.  The FFT of the taps is worked out once, and the FFT setups come from the
+//  shared cache in FftSetupManager.h.  Real samples with real taps use real-input FFTs.
+//
+//  Direct form costs numTaps multiplies per output, and overlap-save costs about
+//  2 log2(N) N / (N - numTaps + 1), so direct form wins for short filters and overlap-save for
+//  long ones.  Where they cross depends on the CPU and the instruction set, so by default the
+//  filter picks between them with a tap count that is measured the first time it's needed
+//  (see FirFilter::crossover()).
+//
+
+#ifndef FirFilter_h
+#define FirFilter_h
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <complex>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "FftSetupManager.h"
+#include "Gemv.h"
+#include "ScratchArena.h"
+#include "Simd.h"
+#include "Vector.h"
+
+namespace MatrixDSP {
+
+/**
+ * \brief How FirFilter does the filtering.  Auto picks direct form or overlap-save from the
+ *      number of taps.
+ */
+enum class FirMethod {Auto, Direct, OverlapSave};
+
+/**
+ * \brief The default type of the taps for samples of type "T": "T" itself, or the real type of
+ *      complex samples.
+ */
+template <class T>
+struct FirTap {
+    typedef T type;
+};
+
+template <class T>
+struct FirTap< std::complex<T> > {
+    typedef T type;
+};
+
+/**
+ * \brief Outputs per direct form pass, which keeps the outputs in the L1 cache while the taps
+ *      go over them.
+ */
+const std::size_t firDirectChunk = 1024;
+
+// "line" is numTaps - 1 samples of history followed by "count" new samples, and output j is
+// the reversed taps times line[j], line[j + 1], ...
+
+template <class T, class TapT>
+void firDirect(const TapT *reversed, std::size_t numTaps, const T *line, std::size_t count, T *output, std::false_type) {
+    for (std::size_t start = 0; start < count; start += firDirectChunk) {
+        std::size_t n = std::min(firDirectChunk, count - start);
+        simd::gemvTransposed(numTaps, n, line + start, 1, reversed, output + start);
+    }
+}
+
+template <class T>
+typename std::enable_if<std::is_arithmetic<T>::value, std::complex<T> >::type firCombine(T re, T im) {
+    return std::complex<T>(re, im);
+}
+
+template <class T>
+std::complex<T> firCombine(const std::complex<T> &re, const std::complex<T> &im) {
+    return std::complex<T>(re.real() - im.imag(), re.imag() + im.real());
+}
+
+template <class T, class TapT>
+void firDirect(const TapT *reversed, std::size_t numTaps, const T *line, std::size_t count, T *output, std::true_type) {
+    // Complex samples are filtered as their real and imaginary parts
+    typedef typename FirTap<T>::type Real;
+    std::size_t lineLen = count + numTaps - 1;
+    ScratchBuffer<Real> parts(2 * lineLen);
+    Real *re = parts.data();
+    Real *im = re + lineLen;
+    for (std::size_t index = 0; index < lineLen; index++) {
+        re[index] = line[index].real();
+        im[index] = line[index].imag();
+    }
+    ScratchBuffer<TapT> products(2 * firDirectChunk);
+    for (std::size_t start = 0; start < count; start += firDirectChunk) {
+        std::size_t n = std::min(firDirectChunk, count - start);
+        simd::gemvTransposed(numTaps, n, re + start, 1, reversed, products.data());
+        simd::gemvTransposed(numTaps, n, im + start, 1, reversed, products.data() + firDirectChunk);
+        for (std::size_t index = 0; index < n; index++) {
+            output[start + index] = firCombine(products[index], products[firDirectChunk + index]);
+        }
+    }
+}
+
+/**
+ * \brief Direct form FIR filtering of "count" outputs, each the dot product of the reversed
+ *      taps with a run of numTaps samples from "line".
+ *
+ * \param reversed The taps, last one first.
+ * \param line numTaps - 1 samples of history followed by the "count" new samples.
+ * \param output The "count" outputs.
+ */
+template <class T, class TapT>
+void firDirect(const TapT *reversed, std::size_t numTaps, const T *line, std::size_t count, T *output) {
+    firDirect(reversed, numTaps, line, count, output,
+              std::integral_constant<bool, !std::is_same<T, typename FirTap<T>::type>::value>());
+}
+
+/**
+ * \brief Streaming FIR filter.
+ *
+ * Output n is the sum of taps[k] * input[n - k], with zeros before the first sample, so the
+ * output of each call is as long as its input.  The samples can be real or complex.  The taps
+ * can be real, or complex if the samples are.
+ *
+ * Overlap-save does a whole FFT however few samples a call has, so it's most efficient when
+ * the blocks are at least blockLength() samples long.
+ */
+template <class T, class TapT = typename FirTap<T>::type>
+class FirFilter {
+public:
+    typedef T value_type;
+    typedef TapT tap_type;
+    typedef typename FirTap<T>::type real_type;
+
+private:
+    static_assert(std::is_same<TapT, T>::value || std::is_same<TapT, real_type>::value,
+                  "The taps must be the same type as the samples, or their real type");
+
+    typedef std::complex<real_type> Complex;
+    typedef std::integral_constant<bool, !std::is_same<T, real_type>::value> IsComplex;
+
+    std::vector<TapT> reversed;     // The taps, last one first
+    std::vector<T> history;         // The latest numTaps - 1 input samples
+    FirMethod method;
+    unsigned fftLen;                // 0 for direct form
+    std::vector<Complex> spectrum;  // FFT of the taps divided by fftLen, fftLen/2+1 bins for real-input FFTs
+
+    /*****************************************************************************************
+                                        Direct form
+    *****************************************************************************************/
+
+    void direct(const T *line, std::size_t count, T *output) const {
+        firDirect(reversed.data(), reversed.size(), line, count, output);
+    }
+
+    /*****************************************************************************************
+                                        Overlap-save
+    *****************************************************************************************/
+    // The tap spectrum is scaled by 1/fftLen, so the inverse FFT needs no scaling.  Real
+    // samples and taps use a real-input FFT and its inverse, and everything else a complex FFT.
+
+    void tapSpectrum(const TapT *taps, unsigned numTaps, std::false_type) {
+        ScratchBuffer<real_type> padded(fftLen);
+        std::fill(padded.data(), padded.data() + fftLen, real_type());
+        std::copy(taps, taps + numTaps, padded.data());
+        ScratchBuffer<Complex> scratch(fftLen / 2);
+        spectrum.resize(fftLen / 2 + 1);
+        fftSetupManager<real_type>().getRealFftSetup(fftLen)->transform(padded.data(), spectrum.data(), scratch.data());
+        for (Complex &bin : spectrum) {
+            bin /= (real_type) fftLen;
+        }
+    }
+
+    void tapSpectrum(const TapT *taps, unsigned numTaps, std::true_type) {
+        ScratchBuffer<Complex> padded(fftLen);
+        std::fill(padded.data(), padded.data() + fftLen, Complex());
+        std::copy(taps, taps + numTaps, padded.data());
+        spectrum.resize(fftLen);
+        fftSetupManager<real_type>().getFftSetup(fftLen)->transform(padded.data(), spectrum.data());
+        for (Complex &bin : spectrum) {
+            bin /= (real_type) fftLen;
+        }
+    }
+
+    void overlapSave(const T *line, std::size_t count, T *output, std::false_type) const {
+        auto *setup = fftSetupManager<real_type>().getRealFftSetup(fftLen);
+        const std::size_t lineLen = count + history.size();
+        const std::size_t keep = fftLen - history.size();
+        ScratchBuffer<real_type> segment(fftLen);
+        ScratchBuffer<Complex> bins(fftLen / 2 + 1);
+        ScratchBuffer<Complex> scratch(fftLen);
+        for (std::size_t start = 0; start < count; start += keep) {
+            std::size_t len = std::min<std::size_t>(fftLen, lineLen - start);
+            std::copy(line + start, line + start + len, segment.data());
+            std::fill(segment.data() + len, segment.data() + fftLen, real_type());
+            setup->transform(segment.data(), bins.data(), scratch.data());
+            simd::multiplySpectrum(bins.data(), spectrum.data(), bins.size());
+            setup->inverse(bins.data(), segment.data(), scratch.data());
+            std::size_t n = std::min(keep, count - start);
+            std::copy(segment.data() + history.size(), segment.data() + history.size() + n, output + start);
+        }
+    }
+
+    void overlapSave(const T *line, std::size_t count, T *output, std::true_type) const {
+        auto *forward = fftSetupManager<real_type>().getFftSetup(fftLen);
+        auto *inverse = fftSetupManager<real_type>().getFftSetup(fftLen, true);
+        const std::size_t lineLen = count + history.size();
+        const std::size_t keep = fftLen - history.size();
+        ScratchBuffer<Complex> segment(fftLen);
+        ScratchBuffer<Complex> bins(fftLen);
+        for (std::size_t start = 0; start < count; start += keep) {
+            std::size_t len = std::min<std::size_t>(fftLen, lineLen - start);
+            std::copy(line + start, line + start + len, segment.data());
+            std::fill(segment.data() + len, segment.data() + fftLen, Complex());
+            forward->transform(segment.data(), bins.data());
+            simd::multiplySpectrum(bins.data(), spectrum.data(), fftLen);
+            inverse->transform(bins.data(), segment.data());
+            std::size_t n = std::min(keep, count - start);
+            std::copy(segment.data() + history.size(), segment.data() + history.size() + n, output + start);
+        }
+    }
+
+    /**
+     * \brief The FFT length for "numTaps" taps: the smallest power of two that's at least four
+     *      times the number of taps, so at least three quarters of each FFT is new outputs.
+     */
+    static unsigned chooseFftLength(unsigned numTaps) {
+        unsigned len = 64;
+        while (len < 4 * numTaps) {
+            len *= 2;
+        }
+        return len;
+    }
+
+    /**
+     * \brief Times direct form and overlap-save for increasing tap counts and returns the
+     *      first count from which overlap-save is clearly faster.
+     */
+    static unsigned measureCrossover() {
+        typedef std::chrono::steady_clock Clock;
+        const unsigned len = 8192;
+        // Overlap-save's shortest FFT is 64 points, which doesn't beat direct form below this
+        const unsigned minTaps = 16;
+        const unsigned maxTaps = 4096;
+        // Overlap-save has to be faster by this factor to count as a win
+        const double margin = 1.1;
+        std::vector<T> input(len);
+        std::vector<T> output(len);
+        for (unsigned index = 0; index < len; index++) {
+            input[index] = T((real_type) ((index * 7919) % 101) / 101);
+        }
+        unsigned firstWin = 0;
+        for (unsigned numTaps = minTaps; numTaps < maxTaps; numTaps *= 2) {
+            std::vector<TapT> taps(numTaps, TapT((real_type) 1 / numTaps));
+            FirFilter<T, TapT> filters[2] = {FirFilter<T, TapT>(taps.data(), numTaps, FirMethod::Direct),
+                                             FirFilter<T, TapT>(taps.data(), numTaps, FirMethod::OverlapSave)};
+            double best[2];
+            for (unsigned which = 0; which < 2; which++) {
+                // The first pass warms up the caches and isn't counted
+                for (unsigned pass = 0; pass < 5; pass++) {
+                    Clock::time_point start = Clock::now();
+                    filters[which].filter(input.data(), output.data(), len);
+                    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                    if (pass == 1 || (pass > 1 && elapsed < best[which])) {
+                        best[which] = elapsed;
+                    }
+                }
+            }
+            // It has to win at two tap counts in a row, so one lucky timing doesn't count
+            if (best[1] * margin < best[0]) {
+                if (firstWin) {
+                    return firstWin;
+                }
+                firstWin = numTaps;
+            }
+            else {
+                firstWin = 0;
+            }
+        }
+        return firstWin ? firstWin : maxTaps;
+    }
+
+public:
+    /**
+     * \brief Constructor.
+     *
+     * \param taps The filter taps.
+     * \param numTaps The number of taps.
+     * \param method How to do the filtering.  Defaults to Auto, which uses overlap-save if
+     *      there are at least crossover() taps.
+     */
+    FirFilter(const TapT *taps, unsigned numTaps, FirMethod method = FirMethod::Auto) : fftLen(0) {
+        assert(numTaps > 0);
+        reversed.assign(taps, taps + numTaps);
+        std::reverse(reversed.begin(), reversed.end());
+        history.resize(numTaps - 1);
+        if (method == FirMethod::Auto) {
+            method = numTaps >= crossover() ? FirMethod::OverlapSave : FirMethod::Direct;
+        }
+        this->method = method;
+        if (method == FirMethod::OverlapSave) {
+            fftLen = chooseFftLength(numTaps);
+            tapSpectrum(taps, numTaps, IsComplex());
+        }
+        reset();
+    }
+
+    /**
+     * \brief Constructor.
+     *
+     * \param taps The filter taps.
+     * \param method How to do the filtering.  Defaults to Auto.
+     */
+    template <class Alloc>
+    FirFilter(const Vector<TapT, Alloc> &taps, FirMethod method = FirMethod::Auto) :
+            FirFilter(taps.vec.data(), taps.size(), method) {}
+
+    /**
+     * \brief The number of taps from which Auto uses overlap-save rather than direct form.
+     *
+     * Measured by timing both methods the first time it's needed for each instruction set
+     * (see simd::setMaxIsa()), which takes a few milliseconds.
+     */
+    static unsigned crossover() {
+        static std::atomic<unsigned> measured[(int) simd::Isa::Avx512 + 1];
+        std::atomic<unsigned> &entry = measured[(int) simd::activeIsa()];
+        unsigned taps = entry.load(std::memory_order_relaxed);
+        if (taps == 0) {
+            // Two threads may both measure it, which is harmless
+            taps = measureCrossover();
+            entry.store(taps, std::memory_order_relaxed);
+        }
+        return taps;
+    }
+
+    /**
+     * \brief Clears the history, so the next sample starts a new stream.
+     */
+    void reset() {
+        std::fill(history.begin(), history.end(), T());
+    }
+
+    unsigned numTaps() const {return reversed.size();}
+
+    /**
+     * \brief Returns Direct or OverlapSave, whichever the filter is using.
+     */
+    FirMethod filterMethod() const {return method;}
+
+    /**
+     * \brief The FFT length that overlap-save uses, or 0 for direct form.
+     */
+    unsigned fftLength() const {return fftLen;}
+
+    /**
+     * \brief The number of new outputs that each overlap-save FFT gives, or 0 for direct form.
+     */
+    unsigned blockLength() const {return fftLen ? fftLen - history.size() : 0;}
+
+    /**
+     * \brief Filters "len" samples, carrying on from the previous call.
+     *
+     * \param input The samples to filter.
+     * \param output The filtered samples.  May be "input".
+     */
+    void filter(const T *input, T *output, unsigned len) {
+        std::size_t lineLen = history.size() + len;
+        ScratchBuffer<T> line(lineLen);
+        std::copy(history.begin(), history.end(), line.data());
+        std::copy(input, input + len, line.data() + history.size());
+        if (len) {
+            if (method == FirMethod::Direct) {
+                direct(line.data(), len, output);
+            }
+            else {
+                overlapSave(line.data(), len, output, IsComplex());
+            }
+        }
+        std::copy(line.data() + len, line.data() + lineLen, history.begin());
+    }
+
+    /**
+     * \brief Filters a block of samples, carrying on from the previous block.
+     *
+     * \param input The samples to filter.
+     * \param output The filtered samples.  Resized to the size of "input".  May be "input".
+     * \return Reference to "output".
+     */
+    template <class InputAlloc, class OutputAlloc>
+    Vector<T, OutputAlloc> & filter(const Vector<T, InputAlloc> &input, Vector<T, OutputAlloc> &output) {
+        output.resize(input.size());
+        output.rowVector = input.rowVector;
+        filter(input.vec.data(), output.vec.data(), input.size());
+        return output;
+    }
+
+    /**
+     * \brief Filters a block of samples in place, carrying on from the previous block.
+     *
+     * \return Reference to "data".
+     */
+    template <class Alloc>
+    Vector<T, Alloc> & filter(Vector<T, Alloc> &data) {
+        return filter(data, data);
+    }
+};
+
+/**
+ * \brief FIR filters "input" with a fresh filter.
+ *
+ * \param input The samples to filter.
+ * \param output The filtered samples, as many as the input.  May be "input".
+ * \param taps The filter taps.
+ * \return Reference to "output".
+ */
+template <class T, class TapT, class InputAlloc, class OutputAlloc, class TapAlloc>
+Vector<T, OutputAlloc> & firFilter(const Vector<T, InputAlloc> &input, Vector<T, OutputAlloc> &output,
+                                   const Vector<TapT, TapAlloc> &taps) {
+    FirFilter<T, TapT> filter(taps);
+    return filter.filter(input, output);
+}
+
+}
+
+#endif /* FirFilter_h */
@@ -0,0 +1,459 @@
+//
+//  Gemm.h
+//  MatrixDSP
+//
+//  Matrix multiplication, C = A * B, for row-major matrices.  It is organized like the
+//  GotoBLAS/BLIS GEMM.  B is copied a KC x NC block at a time into panels that are NR columns
+//  wide, A is copied an MC x KC block at a time into panels that are MR rows tall, and a
+//  micro-kernel multiplies one A panel by one B panel while holding the whole MR x NR block of
+//  C in registers.  The block sizes are picked so that a B panel stays in L1, the A block in
+//  L2 and the B block in L3.  Packing also makes every load in the micro-kernel unit stride,
+//  and the zero padding that it adds at the ragged edges means that the micro-kernel doesn't
+//  need any special cases.
+//
+//  There are micro-kernels for float, double and their complex types, with AVX2 and AVX-512
+//  versions that are selected at run time like the ones in Simd.h.  The complex kernel keeps
+//  the products with the real and imaginary parts of A in separate accumulators and only
+//  combines them at the end, so its inner loop is nothing but FMAs.  Other types, CPUs without
+//  AVX2, and small products use a plain loop in i-k-j order.
+//
+//  Big products can be split over a ThreadPool.  C is cut into tiles that are each computed
+//  by the single-threaded GEMM, with their own packed copies of A and B, so the threads don't
+//  share anything but the inputs.
+//
+
+#ifndef Gemm_h
+#define Gemm_h
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <type_traits>
+#include "ScratchArena.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+
+namespace MatrixDSP {
+namespace simd {
+
+/**
+ * \brief True if there are GEMM micro-kernels for type "T".
+ */
+template <class T>
+struct HasGemmKernel : std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value ||
+        std::is_same<T, std::complex<float> >::value || std::is_same<T, std::complex<double> >::value> {};
+
+/**
+ * \brief Products with fewer multiplies than this aren't worth splitting over threads.
+ */
+const std::size_t gemmParallelMinSize = 128 * 128 * 128;
+
+/**
+ * \brief Products with fewer multiplies than this don't use the blocked GEMM.  Packing costs
+ *      more than it saves for them.
+ */
+const std::size_t gemmBlockedMinSize = 16 * 16 * 16;
+
+/**
+ * \brief C = A * B with plain loops.
+ */
+template <class T>
+void gemmGeneric(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda,
+                 const T *b, std::size_t ldb, T *c, std::size_t ldc) {
+    for (std::size_t i = 0; i < m; i++) {
+        T *cRow = c + i * ldc;
+        std::fill(cRow, cRow + n, T());
+        for (std::size_t p = 0; p < k; p++) {
+            const T aVal = a[i * lda + p];
+            const T *bRow = b + p * ldb;
+            for (std::size_t j = 0; j < n; j++) {
+                cRow[j] += aVal * bRow[j];
+            }
+        }
+    }
+}
+
+/*****************************************************************************************
+                                        Packing
+*****************************************************************************************/
+/**
+ * \brief Copies an mc x kc block of A into panels of "mr" rows.  Element (i, p) of a panel is
+ *      at [p*mr + i].  Rows past the end of the block are zero.
+ */
+template <class T>
+void gemmPackA(std::size_t mc, std::size_t kc, const T *a, std::size_t lda, std::size_t mr, T *packed) {
+    for (std::size_t ir = 0; ir < mc; ir += mr, packed += mr * kc) {
+        std::size_t rows = std::min(mr, mc - ir);
+        for (std::size_t i = 0; i < rows; i++) {
+            const T *aRow = a + (ir + i) * lda;
+            for (std::size_t p = 0; p < kc; p++) {
+                packed[p * mr + i] = aRow[p];
+            }
+        }
+        for (std::size_t i = rows; i < mr; i++) {
+            for (std::size_t p = 0; p < kc; p++) {
+                packed[p * mr + i] = T();
+            }
+        }
+    }
+}
+
+/**
+ * \brief Copies a kc x nc block of B into panels of "nr" columns.  Element (p, j) of a panel
+ *      is at [p*nr + j].  Columns past the end of the block are zero.
+ */
+template <class T>
+void gemmPackB(std::size_t kc, std::size_t nc, const T *b, std::size_t ldb, std::size_t nr, T *packed) {
+    for (std::size_t jr = 0; jr < nc; jr += nr) {
+        std::size_t cols = std::min(nr, nc - jr);
+        for (std::size_t p = 0; p < kc; p++, packed += nr) {
+            const T *bRow = b + p * ldb + jr;
+            std::copy(bRow, bRow + cols, packed);
+            std::fill(packed + cols, packed + nr, T());
+        }
+    }
+}
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+/*****************************************************************************************
+                                    Micro-kernels
+*****************************************************************************************/
+// run() multiplies an A panel by a B panel (both "kc" long) and stores the mr x nr result to
+// "c", or adds it to "c" if "accumulate" is true.  There is one copy per instruction set
+// because the target attribute has to be a literal.
+
+template <Isa isa, class T>
+struct GemmKernel;
+
+template <class T>
+struct GemmKernel<Isa::Avx2, T> {
+    typedef Traits<Isa::Avx2, T> Tr;
+    typedef typename Tr::Reg Reg;
+    typedef T Element;
+    static const unsigned mr = 6;
+    static const unsigned nv = 2;
+    static const unsigned nr = nv * Tr::width;
+    static bool available() {return Tr::available();}
+
+    static MATRIX_DSP_TARGET_AVX2 void run(std::size_t kc, const T *a, const T *b, T *c, std::size_t ldc, bool accumulate) {
+        Reg acc[mr][nv];
+        MATRIX_DSP_UNROLL
+        for (unsigned i = 0; i < mr; i++) {
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                acc[i][v] = Tr::set1(0);
+            }
+        }
+        for (std::size_t p = 0; p < kc; p++, a += mr, b += nr) {
+            Reg bv[nv];
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                bv[v] = Tr::load(b + v * Tr::width);
+            }
+            MATRIX_DSP_UNROLL
+            for (unsigned i = 0; i < mr; i++) {
+                Reg ai = Tr::set1(a[i]);
+                MATRIX_DSP_UNROLL
+                for (unsigned v = 0; v < nv; v++) {
+                    acc[i][v] = Tr::fmadd(ai, bv[v], acc[i][v]);
+                }
+            }
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned i = 0; i < mr; i++) {
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                T *out = c + i * ldc + v * Tr::width;
+                Tr::store(out, accumulate ? Tr::apply(Add(), Tr::load(out), acc[i][v]) : acc[i][v]);
+            }
+        }
+    }
+};
+
+template <class T>
+struct GemmKernel<Isa::Avx2, std::complex<T> > {
+    typedef ComplexTraits<Isa::Avx2, T> Tr;
+    typedef typename Tr::Reg Reg;
+    typedef std::complex<T> Element;
+    static const unsigned mr = 3;
+    static const unsigned nv = 1;
+    static const unsigned nr = nv * Tr::width;
+    static bool available() {return Tr::available();}
+
+    static MATRIX_DSP_TARGET_AVX2 void run(std::size_t kc, const Element *a, const Element *b, Element *c, std::size_t ldc,
+                                           bool accumulate) {
+        // b * real(a) and swap(b) * imag(a)
+        Reg re[mr][nv];
+        Reg im[mr][nv];
+        MATRIX_DSP_UNROLL
+        for (unsigned i = 0; i < mr; i++) {
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                re[i][v] = Tr::set1(0);
+                im[i][v] = Tr::set1(0);
+            }
+        }
+        for (std::size_t p = 0; p < kc; p++, a += mr, b += nr) {
+            Reg bv[nv];
+            Reg bs[nv];
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                bv[v] = Tr::load(b + v * Tr::width);
+                bs[v] = Tr::swap(bv[v]);
+            }
+            MATRIX_DSP_UNROLL
+            for (unsigned i = 0; i < mr; i++) {
+                Reg ar = Tr::set1(a[i].real());
+                Reg ai = Tr::set1(a[i].imag());
+                MATRIX_DSP_UNROLL
+                for (unsigned v = 0; v < nv; v++) {
+                    re[i][v] = Tr::fmadd(bv[v], ar, re[i][v]);
+                    im[i][v] = Tr::fmadd(bs[v], ai, im[i][v]);
+                }
+            }
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned i = 0; i < mr; i++) {
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                Element *out = c + i * ldc + v * Tr::width;
+                Reg sum = Tr::addsub(re[i][v], im[i][v]);
+                Tr::store(out, accumulate ? Tr::add(Tr::load(out), sum) : sum);
+            }
+        }
+    }
+};
+
+template <class T>
+struct GemmKernel<Isa::Avx512, T> {
+    typedef Traits<Isa::Avx512, T> Tr;
+    typedef typename Tr::Reg Reg;
+    typedef T Element;
+    static const unsigned mr = 8;
+    static const unsigned nv = 2;
+    static const unsigned nr = nv * Tr::width;
+    static bool available() {return Tr::available();}
+
+    static MATRIX_DSP_TARGET_AVX512 void run(std::size_t kc, const T *a, const T *b, T *c, std::size_t ldc, bool accumulate) {
+        Reg acc[mr][nv];
+        MATRIX_DSP_UNROLL
+        for (unsigned i = 0; i < mr; i++) {
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                acc[i][v] = Tr::set1(0);
+            }
+        }
+        for (std::size_t p = 0; p < kc; p++, a += mr, b += nr) {
+            Reg bv[nv];
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                bv[v] = Tr::load(b + v * Tr::width);
+            }
+            MATRIX_DSP_UNROLL
+            for (unsigned i = 0; i < mr; i++) {
+                Reg ai = Tr::set1(a[i]);
+                MATRIX_DSP_UNROLL
+                for (unsigned v = 0; v < nv; v++) {
+                    acc[i][v] = Tr::fmadd(ai, bv[v], acc[i][v]);
+                }
+            }
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned i = 0; i < mr; i++) {
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                T *out = c + i * ldc + v * Tr::width;
+                Tr::store(out, accumulate ? Tr::apply(Add(), Tr::load(out), acc[i][v]) : acc[i][v]);
+            }
+        }
+    }
+};
+
+template <class T>
+struct GemmKernel<Isa::Avx512, std::complex<T> > {
+    typedef ComplexTraits<Isa::Avx512, T> Tr;
+    typedef typename Tr::Reg Reg;
+    typedef std::complex<T> Element;
+    static const unsigned mr = 4;
+    static const unsigned nv = 2;
+    static const unsigned nr = nv * Tr::width;
+    static bool available() {return Tr::available();}
+
+    static MATRIX_DSP_TARGET_AVX512 void run(std::size_t kc, const Element *a, const Element *b, Element *c, std::size_t ldc,
+                                             bool accumulate) {
+        Reg re[mr][nv];
+        Reg im[mr][nv];
+        MATRIX_DSP_UNROLL
+        for (unsigned i = 0; i < mr; i++) {
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                re[i][v] = Tr::set1(0);
+                im[i][v] = Tr::set1(0);
+            }
+        }
+        for (std::size_t p = 0; p < kc; p++, a += mr, b += nr) {
+            Reg bv[nv];
+            Reg bs[nv];
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                bv[v] = Tr::load(b + v * Tr::width);
+                bs[v] = Tr::swap(bv[v]);
+            }
+            MATRIX_DSP_UNROLL
+            for (unsigned i = 0; i < mr; i++) {
+                Reg ar = Tr::set1(a[i].real());
+                Reg ai = Tr::set1(a[i].imag());
+                MATRIX_DSP_UNROLL
+                for (unsigned v = 0; v < nv; v++) {
+                    re[i][v] = Tr::fmadd(bv[v], ar, re[i][v]);
+                    im[i][v] = Tr::fmadd(bs[v], ai, im[i][v]);
+                }
+            }
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned i = 0; i < mr; i++) {
+            MATRIX_DSP_UNROLL
+            for (unsigned v = 0; v < nv; v++) {
+                Element *out = c + i * ldc + v * Tr::width;
+                Reg sum = Tr::addsub(re[i][v], im[i][v]);
+                Tr::store(out, accumulate ? Tr::add(Tr::load(out), sum) : sum);
+            }
+        }
+    }
+};
+
+/*****************************************************************************************
+                                    Blocked driver
+*****************************************************************************************/
+/**
+ * \brief C = A * B with the packed, blocked algorithm and the micro-kernel "Kernel".
+ */
+template <class Kernel, class T>
+void gemmBlocked(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda,
+                 const T *b, std::size_t ldb, T *c, std::size_t ldc) {
+    const std::size_t mr = Kernel::mr;
+    const std::size_t nr = Kernel::nr;
+    // A B panel (kc x nr) is 16 KB, half of a typical L1.  The A block (mc x kc) is 128 KB
+    // and the B block (kc x nc) 2 MB, which leave room in L2 and L3 for C and the other
+    // operand.
+    const std::size_t kcMax = 16384 / (nr * sizeof(T));
+    const std::size_t mcMax = 131072 / (kcMax * sizeof(T)) / mr * mr;
+    const std::size_t ncMax = 2097152 / (kcMax * sizeof(T)) / nr * nr;
+
+    std::size_t kcSize = std::min(kcMax, k);
+    ScratchBuffer<T> packedA((std::min(mcMax, m) + mr - 1) / mr * mr * kcSize);
+    ScratchBuffer<T> packedB((std::min(ncMax, n) + nr - 1) / nr * nr * kcSize);
+    T edge[Kernel::mr * Kernel::nr];
+
+    for (std::size_t jc = 0; jc < n; jc += ncMax) {
+        std::size_t nc = std::min(ncMax, n - jc);
+        for (std::size_t pc = 0; pc < k; pc += kcMax) {
+            std::size_t kc = std::min(kcMax, k - pc);
+            bool accumulate = pc > 0;
+            gemmPackB(kc, nc, b + pc * ldb + jc, ldb, nr, packedB.data());
+            for (std::size_t ic = 0; ic < m; ic += mcMax) {
+                std::size_t mc = std::min(mcMax, m - ic);
+                gemmPackA(mc, kc, a + ic * lda + pc, lda, mr, packedA.data());
+                for (std::size_t jr = 0; jr < nc; jr += nr) {
+                    std::size_t cols = std::min(nr, nc - jr);
+                    const T *bPanel = packedB.data() + jr * kc;
+                    for (std::size_t ir = 0; ir < mc; ir += mr) {
+                        std::size_t rows = std::min(mr, mc - ir);
+                        const T *aPanel = packedA.data() + ir * kc;
+                        T *cBlock = c + (ic + ir) * ldc + jc + jr;
+                        if (rows == mr && cols == nr) {
+                            Kernel::run(kc, aPanel, bPanel, cBlock, ldc, accumulate);
+                            continue;
+                        }
+                        // The kernel always does a full block, so ragged edges go through "edge"
+                        Kernel::run(kc, aPanel, bPanel, edge, nr, false);
+                        for (std::size_t i = 0; i < rows; i++) {
+                            for (std::size_t j = 0; j < cols; j++) {
+                                T &out = cBlock[i * ldc + j];
+                                out = accumulate ? out + edge[i * nr + j] : edge[i * nr + j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif // MATRIX_DSP_X86_SIMD
+
+/*****************************************************************************************
+                                        Dispatchers
+*****************************************************************************************/
+template <class T>
+void gemmDispatch(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda,
+                  const T *b, std::size_t ldb, T *c, std::size_t ldc, std::false_type) {
+    gemmGeneric(m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+template <class T>
+void gemmDispatch(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda,
+                  const T *b, std::size_t ldb, T *c, std::size_t ldc, std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && GemmKernel<Isa::Avx512, T>::available()) {
+        return gemmBlocked< GemmKernel<Isa::Avx512, T> >(m, n, k, a, lda, b, ldb, c, ldc);
+    }
+    if (isa >= Isa::Avx2 && GemmKernel<Isa::Avx2, T>::available()) {
+        return gemmBlocked< GemmKernel<Isa::Avx2, T> >(m, n, k, a, lda, b, ldb, c, ldc);
+    }
+#endif
+    gemmGeneric(m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+/**
+ * \brief C = A * B, where A is m x k, B is k x n and C is m x n, all row-major.
+ *
+ * "lda", "ldb" and "ldc" are the distances between the starts of consecutive rows, so the
+ * matrices can be parts of larger ones.  C must not overlap A or B.
+ */
+template <class T>
+void gemm(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda,
+          const T *b, std::size_t ldb, T *c, std::size_t ldc) {
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (m * n * k < gemmBlockedMinSize) {
+        return gemmGeneric(m, n, k, a, lda, b, ldb, c, ldc);
+    }
+    gemmDispatch(m, n, k, a, lda, b, ldb, c, ldc, HasGemmKernel<T>());
+}
+
+/**
+ * \brief C = A * B, with tiles of C computed in parallel by the threads of "pool".
+ */
+template <class T>
+void gemm(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda,
+          const T *b, std::size_t ldb, T *c, std::size_t ldc, ThreadPool &pool) {
+    if (pool.size() == 1 || m * n * k < gemmBlockedMinSize) {
+        return gemm(m, n, k, a, lda, b, ldb, c, ldc);
+    }
+    // A few tiles per thread so that work stealing can even out the load, but none smaller
+    // than 32 x 64 so that the packing stays cheap next to the multiplies.  Tiles that are
+    // next to each other in a row share the same rows of A.
+    const std::size_t targetTiles = 4 * pool.size();
+    std::size_t rowTiles = std::min((m + 31) / 32, targetTiles);
+    std::size_t colTiles = std::min((n + 63) / 64, (targetTiles + rowTiles - 1) / rowTiles);
+    std::size_t tileRows = (m + rowTiles - 1) / rowTiles;
+    std::size_t tileCols = ((n + colTiles - 1) / colTiles + 15) / 16 * 16;
+    rowTiles = (m + tileRows - 1) / tileRows;
+    colTiles = (n + tileCols - 1) / tileCols;
+
+    pool.parallelFor(rowTiles * colTiles, [&](std::size_t tile) {
+        std::size_t row = tile / colTiles * tileRows;
+        std::size_t col = tile % colTiles * tileCols;
+        gemm(std::min(tileRows, m - row), std::min(tileCols, n - col), k, a + row * lda, lda,
+             b + col, ldb, c + row * ldc + col, ldc);
+    });
+}
+
+}
+}
+
+#endif /* Gemm_h */
@@ -0,0 +1,457 @@
+//
+//  Gemv.h
+//  MatrixDSP
+//
+//  Matrix-vector products for row-major matrices: y = A x (gemv()) and y = x A
+//  (gemvTransposed(), x a row vector).  A x is a dot product of each row with x, so rows are
+//  done several at a time to share the loads of x.  x A adds multiples of the rows of A to y,
+//  which keeps every access unit stride, and several rows are added per pass over y.
+//
+//  A real matrix times a complex vector is done as two real products, one with the real parts
+//  and one with the imaginary parts of the vector, in the same pass over the matrix.  The
+//  vector is split into real and imaginary parts first, which is cheap next to reading the
+//  matrix, and the matrix is never promoted to complex.
+//
+//  There are AVX2 and AVX-512 kernels for float and double, selected at run time like the ones
+//  in Simd.h.  Other types and CPUs without AVX2 use plain loops with the same access pattern.
+//
+
+#ifndef Gemv_h
+#define Gemv_h
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+#include "ScratchArena.h"
+#include "Simd.h"
+
+namespace MatrixDSP {
+namespace simd {
+
+/**
+ * \brief True if there are GEMV kernels for type "T".
+ */
+template <class T>
+struct HasGemvKernel : std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value> {};
+
+// The kernels do "nx" products with the same matrix at once: y[k] = A x[k] or y[k] = x[k] A for
+// k < nx.  "nx" is 1 for real vectors and 2 (real and imaginary parts) for complex ones.
+
+template <class T, class U, class V>
+void gemvGeneric(std::size_t m, std::size_t n, const T *a, std::size_t lda, const U *const *x, V *const *y, unsigned nx) {
+    for (std::size_t i = 0; i < m; i++) {
+        const T *aRow = a + i * lda;
+        if (nx == 1) {
+            V sum = V();
+            for (std::size_t j = 0; j < n; j++) {
+                sum += aRow[j] * x[0][j];
+            }
+            y[0][i] = sum;
+            continue;
+        }
+        // Both parts in one pass over the row
+        V sum0 = V();
+        V sum1 = V();
+        for (std::size_t j = 0; j < n; j++) {
+            sum0 += aRow[j] * x[0][j];
+            sum1 += aRow[j] * x[1][j];
+        }
+        y[0][i] = sum0;
+        y[1][i] = sum1;
+    }
+}
+
+template <class T, class U, class V>
+void gemvTransposedGeneric(std::size_t m, std::size_t n, const T *a, std::size_t lda, const U *const *x, V *const *y, unsigned nx) {
+    for (unsigned k = 0; k < nx; k++) {
+        std::fill(y[k], y[k] + n, V());
+    }
+    for (std::size_t i = 0; i < m; i++) {
+        const T *aRow = a + i * lda;
+        for (unsigned k = 0; k < nx; k++) {
+            const U coef = x[k][i];
+            for (std::size_t j = 0; j < n; j++) {
+                y[k][j] += coef * aRow[j];
+            }
+        }
+    }
+}
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+/*****************************************************************************************
+                                        Kernels
+*****************************************************************************************/
+// gemvRows*() does rows [0, R) of A x, and gemvAxpy*() adds rows [0, R) of A, times
+// x[k][row], to y.  There is one copy per instruction set because the target attribute has
+// to be a literal.
+
+template <class Tr, unsigned NX, unsigned R, class T>
+MATRIX_DSP_TARGET_AVX2 void gemvRowsAvx2(std::size_t n, const T *a, std::size_t lda, const T *const *x, T *const *y) {
+    typedef typename Tr::Reg Reg;
+    const std::size_t w = Tr::width;
+    Reg acc[R][NX];
+    MATRIX_DSP_UNROLL
+    for (unsigned r = 0; r < R; r++) {
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            acc[r][k] = Tr::set1(0);
+        }
+    }
+    std::size_t j = 0;
+    for (; j + w <= n; j += w) {
+        Reg xv[NX];
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            xv[k] = Tr::load(x[k] + j);
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned r = 0; r < R; r++) {
+            Reg av = Tr::load(a + r * lda + j);
+            MATRIX_DSP_UNROLL
+            for (unsigned k = 0; k < NX; k++) {
+                acc[r][k] = Tr::fmadd(av, xv[k], acc[r][k]);
+            }
+        }
+    }
+    for (unsigned r = 0; r < R; r++) {
+        for (unsigned k = 0; k < NX; k++) {
+            T lanes[Tr::width];
+            Tr::store(lanes, acc[r][k]);
+            T sum = 0;
+            for (std::size_t lane = 0; lane < w; lane++) {
+                sum += lanes[lane];
+            }
+            for (std::size_t jj = j; jj < n; jj++) {
+                sum += a[r * lda + jj] * x[k][jj];
+            }
+            y[k][r] = sum;
+        }
+    }
+}
+
+template <class Tr, unsigned NX, unsigned R, class T>
+MATRIX_DSP_TARGET_AVX2 void gemvAxpyAvx2(std::size_t n, const T *a, std::size_t lda, const T *const *x, std::size_t row,
+                                         T *const *y) {
+    typedef typename Tr::Reg Reg;
+    const std::size_t w = Tr::width;
+    Reg coef[R][NX];
+    MATRIX_DSP_UNROLL
+    for (unsigned r = 0; r < R; r++) {
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            coef[r][k] = Tr::set1(x[k][row + r]);
+        }
+    }
+    std::size_t j = 0;
+    for (; j + w <= n; j += w) {
+        // Even and odd rows go to separate sums to halve the dependency chains
+        Reg even[NX];
+        Reg odd[NX];
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            even[k] = Tr::load(y[k] + j);
+            odd[k] = Tr::set1(0);
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned r = 0; r < R; r++) {
+            Reg av = Tr::load(a + r * lda + j);
+            MATRIX_DSP_UNROLL
+            for (unsigned k = 0; k < NX; k++) {
+                if (r % 2 == 0) {
+                    even[k] = Tr::fmadd(coef[r][k], av, even[k]);
+                }
+                else {
+                    odd[k] = Tr::fmadd(coef[r][k], av, odd[k]);
+                }
+            }
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            Tr::store(y[k] + j, Tr::apply(Add(), even[k], odd[k]));
+        }
+    }
+    for (; j < n; j++) {
+        for (unsigned k = 0; k < NX; k++) {
+            T sum = y[k][j];
+            for (unsigned r = 0; r < R; r++) {
+                sum += x[k][row + r] * a[r * lda + j];
+            }
+            y[k][j] = sum;
+        }
+    }
+}
+
+template <class Tr, unsigned NX, unsigned R, class T>
+MATRIX_DSP_TARGET_AVX512 void gemvRowsAvx512(std::size_t n, const T *a, std::size_t lda, const T *const *x, T *const *y) {
+    typedef typename Tr::Reg Reg;
+    const std::size_t w = Tr::width;
+    Reg acc[R][NX];
+    MATRIX_DSP_UNROLL
+    for (unsigned r = 0; r < R; r++) {
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            acc[r][k] = Tr::set1(0);
+        }
+    }
+    std::size_t j = 0;
+    for (; j + w <= n; j += w) {
+        Reg xv[NX];
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            xv[k] = Tr::load(x[k] + j);
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned r = 0; r < R; r++) {
+            Reg av = Tr::load(a + r * lda + j);
+            MATRIX_DSP_UNROLL
+            for (unsigned k = 0; k < NX; k++) {
+                acc[r][k] = Tr::fmadd(av, xv[k], acc[r][k]);
+            }
+        }
+    }
+    for (unsigned r = 0; r < R; r++) {
+        for (unsigned k = 0; k < NX; k++) {
+            T lanes[Tr::width];
+            Tr::store(lanes, acc[r][k]);
+            T sum = 0;
+            for (std::size_t lane = 0; lane < w; lane++) {
+                sum += lanes[lane];
+            }
+            for (std::size_t jj = j; jj < n; jj++) {
+                sum += a[r * lda + jj] * x[k][jj];
+            }
+            y[k][r] = sum;
+        }
+    }
+}
+
+template <class Tr, unsigned NX, unsigned R, class T>
+MATRIX_DSP_TARGET_AVX512 void gemvAxpyAvx512(std::size_t n, const T *a, std::size_t lda, const T *const *x, std::size_t row,
+                                             T *const *y) {
+    typedef typename Tr::Reg Reg;
+    const std::size_t w = Tr::width;
+    Reg coef[R][NX];
+    MATRIX_DSP_UNROLL
+    for (unsigned r = 0; r < R; r++) {
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            coef[r][k] = Tr::set1(x[k][row + r]);
+        }
+    }
+    std::size_t j = 0;
+    for (; j + w <= n; j += w) {
+        Reg even[NX];
+        Reg odd[NX];
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            even[k] = Tr::load(y[k] + j);
+            odd[k] = Tr::set1(0);
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned r = 0; r < R; r++) {
+            Reg av = Tr::load(a + r * lda + j);
+            MATRIX_DSP_UNROLL
+            for (unsigned k = 0; k < NX; k++) {
+                if (r % 2 == 0) {
+                    even[k] = Tr::fmadd(coef[r][k], av, even[k]);
+                }
+                else {
+                    odd[k] = Tr::fmadd(coef[r][k], av, odd[k]);
+                }
+            }
+        }
+        MATRIX_DSP_UNROLL
+        for (unsigned k = 0; k < NX; k++) {
+            Tr::store(y[k] + j, Tr::apply(Add(), even[k], odd[k]));
+        }
+    }
+    for (; j < n; j++) {
+        for (unsigned k = 0; k < NX; k++) {
+            T sum = y[k][j];
+            for (unsigned r = 0; r < R; r++) {
+                sum += x[k][row + r] * a[r * lda + j];
+            }
+            y[k][j] = sum;
+        }
+    }
+}
+
+/*****************************************************************************************
+                                        Drivers
+*****************************************************************************************/
+// Eight rows (four for complex vectors) per block keeps eight accumulators in flight, and
+// the leftover rows are done one at a time.
+
+template <class T, unsigned NX>
+void gemvVector(std::size_t m, std::size_t n, const T *a, std::size_t lda, const T *const *x, T *const *y, Isa isa) {
+    const std::size_t rows = 8 / NX;
+    std::size_t i = 0;
+    for (; i + rows <= m; i += rows) {
+        T *yBlock[NX];
+        for (unsigned k = 0; k < NX; k++) {
+            yBlock[k] = y[k] + i;
+        }
+        if (isa == Isa::Avx512) {
+            gemvRowsAvx512< Traits<Isa::Avx512, T>, NX, 8 / NX >(n, a + i * lda, lda, x, yBlock);
+        }
+        else {
+            gemvRowsAvx2< Traits<Isa::Avx2, T>, NX, 8 / NX >(n, a + i * lda, lda, x, yBlock);
+        }
+    }
+    for (; i < m; i++) {
+        T *yBlock[NX];
+        for (unsigned k = 0; k < NX; k++) {
+            yBlock[k] = y[k] + i;
+        }
+        if (isa == Isa::Avx512) {
+            gemvRowsAvx512< Traits<Isa::Avx512, T>, NX, 1 >(n, a + i * lda, lda, x, yBlock);
+        }
+        else {
+            gemvRowsAvx2< Traits<Isa::Avx2, T>, NX, 1 >(n, a + i * lda, lda, x, yBlock);
+        }
+    }
+}
+
+template <class T, unsigned NX>
+void gemvTransposedVector(std::size_t m, std::size_t n, const T *a, std::size_t lda, const T *const *x, T *const *y, Isa isa) {
+    for (unsigned k = 0; k < NX; k++) {
+        std::fill(y[k], y[k] + n, T());
+    }
+    const std::size_t rows = 8 / NX;
+    std::size_t i = 0;
+    for (; i + rows <= m; i += rows) {
+        if (isa == Isa::Avx512) {
+            gemvAxpyAvx512< Traits<Isa::Avx512, T>, NX, 8 / NX >(n, a + i * lda, lda, x, i, y);
+        }
+        else {
+            gemvAxpyAvx2< Traits<Isa::Avx2, T>, NX, 8 / NX >(n, a + i * lda, lda, x, i, y);
+        }
+    }
+    for (; i < m; i++) {
+        if (isa == Isa::Avx512) {
+            gemvAxpyAvx512< Traits<Isa::Avx512, T>, NX, 1 >(n, a + i * lda, lda, x, i, y);
+        }
+        else {
+            gemvAxpyAvx2< Traits<Isa::Avx2, T>, NX, 1 >(n, a + i * lda, lda, x, i, y);
+        }
+    }
+}
+
+#endif // MATRIX_DSP_X86_SIMD
+
+/*****************************************************************************************
+                                        Dispatchers
+*****************************************************************************************/
+template <unsigned NX, class T>
+void gemvDispatch(std::size_t m, std::size_t n, const T *a, std::size_t lda, const T *const *x, T *const *y, std::false_type) {
+    gemvGeneric(m, n, a, lda, x, y, NX);
+}
+
+template <unsigned NX, class T>
+void gemvDispatch(std::size_t m, std::size_t n, const T *a, std::size_t lda, const T *const *x, T *const *y, std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && Traits<Isa::Avx512, T>::available()) {
+        return gemvVector<T, NX>(m, n, a, lda, x, y, Isa::Avx512);
+    }
+    if (isa >= Isa::Avx2 && Traits<Isa::Avx2, T>::available()) {
+        return gemvVector<T, NX>(m, n, a, lda, x, y, Isa::Avx2);
+    }
+#endif
+    gemvGeneric(m, n, a, lda, x, y, NX);
+}
+
+template <unsigned NX, class T>
+void gemvTransposedDispatch(std::size_t m, std::size_t n, const T *a, std::size_t lda, const T *const *x, T *const *y,
+                            std::false_type) {
+    gemvTransposedGeneric(m, n, a, lda, x, y, NX);
+}
+
+template <unsigned NX, class T>
+void gemvTransposedDispatch(std::size_t m, std::size_t n, const T *a, std::size_t lda, const T *const *x, T *const *y,
+                            std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && Traits<Isa::Avx512, T>::available()) {
+        return gemvTransposedVector<T, NX>(m, n, a, lda, x, y, Isa::Avx512);
+    }
+    if (isa >= Isa::Avx2 && Traits<Isa::Avx2, T>::available()) {
+        return gemvTransposedVector<T, NX>(m, n, a, lda, x, y, Isa::Avx2);
+    }
+#endif
+    gemvTransposedGeneric(m, n, a, lda, x, y, NX);
+}
+
+/**
+ * \brief y = A x, where A is m x n and row-major, x has n elements and y has m.
+ *
+ * "lda" is the distance between the starts of consecutive rows of A.  y must not overlap A or x.
+ */
+template <class T>
+void gemv(std::size_t m, std::size_t n, const T *a, std::size_t lda, const T *x, T *y) {
+    gemvDispatch<1>(m, n, a, lda, &x, &y, HasGemvKernel<T>());
+}
+
+/**
+ * \brief y = A x for a real matrix A and a complex vector x.
+ */
+template <class T>
+void gemv(std::size_t m, std::size_t n, const T *a, std::size_t lda, const std::complex<T> *x, std::complex<T> *y) {
+    // The real and imaginary parts of x and y
+    ScratchBuffer<T> parts(2 * n + 2 * m);
+    T *xRe = parts.data();
+    T *xIm = xRe + n;
+    T *yRe = xIm + n;
+    T *yIm = yRe + m;
+    for (std::size_t j = 0; j < n; j++) {
+        xRe[j] = x[j].real();
+        xIm[j] = x[j].imag();
+    }
+    const T *xParts[2] = {xRe, xIm};
+    T *yParts[2] = {yRe, yIm};
+    gemvDispatch<2>(m, n, a, lda, xParts, yParts, HasGemvKernel<T>());
+    for (std::size_t i = 0; i < m; i++) {
+        y[i] = std::complex<T>(yRe[i], yIm[i]);
+    }
+}
+
+/**
+ * \brief y = x A, where A is m x n and row-major, x is a row vector with m elements and y has
+ *      n.
+ *
+ * "lda" is the distance between the starts of consecutive rows of A.  y must not overlap A or x.
+ */
+template <class T>
+void gemvTransposed(std::size_t m, std::size_t n, const T *a, std::size_t lda, const T *x, T *y) {
+    gemvTransposedDispatch<1>(m, n, a, lda, &x, &y, HasGemvKernel<T>());
+}
+
+/**
+ * \brief y = x A for a real matrix A and a complex row vector x.
+ */
+template <class T>
+void gemvTransposed(std::size_t m, std::size_t n, const T *a, std::size_t lda, const std::complex<T> *x, std::complex<T> *y) {
+    ScratchBuffer<T> parts(2 * m + 2 * n);
+    T *xRe = parts.data();
+    T *xIm = xRe + m;
+    T *yRe = xIm + m;
+    T *yIm = yRe + n;
+    for (std::size_t i = 0; i < m; i++) {
+        xRe[i] = x[i].real();
+        xIm[i] = x[i].imag();
+    }
+    const T *xParts[2] = {xRe, xIm};
+    T *yParts[2] = {yRe, yIm};
+    gemvTransposedDispatch<2>(m, n, a, lda, xParts, yParts, HasGemvKernel<T>());
+    for (std::size_t j = 0; j < n; j++) {
+        y[j] = std::complex<T>(yRe[j], yIm[j]);
+    }
+}
+
+}
+}
+
+#endif /* Gemv_h */
@@ -13,63 +13,64 @@
 #include <initializer_list>
 #include <cassert>
 #include <utility>
+#include <algorithm>
+#include "AlignedAllocator.h"
+#include "ScratchArena.h"
 #include "RowColIterator.h"
 #include "Matrix2dIterator.h"
 #include "Vector.h"
+#include "Simd.h"
+#include "Transpose.h"
+#include "Expression.h"
+#include "View.h"
 
 
 namespace MatrixDSP {
  
-template <class T>
+template <class T, class Alloc = AlignedAllocator<T> >
 class Matrix2d {
 protected:
-    std::vector<T> vec;
-    std::shared_ptr< std::vector<T> > scratchBuf;
+    std::vector<T, Alloc> vec;
     unsigned numRows;
     unsigned numCols;
-
-    void copyToScratchBuf(std::vector<T> &from) {
-        scratchBuf->resize(from.size());
-        for (unsigned index=0; index<from.size(); index++) {
-            (*scratchBuf)[index] = from[index];
-        }
-    }
-
-    void initializeScratchBuf(std::shared_ptr< std::vector<T> > scratch) {
-        if (scratch == nullptr) {
-            scratchBuf = std::shared_ptr< std::vector<T> >(new std::vector<T>);
-        }
-        else {
-            scratchBuf = scratch;
-        }
-    }
+    unsigned stride;
+    bool paddedRows;
 
     void checkAddr(unsigned row, unsigned col) {
         assert(row < numRows);
         assert(col < numCols);
     }
-    
-    void doTranspose(const std::vector<T> &input) {
-        unsigned newNumRows = numCols;
-        unsigned newNumCols = numRows;
-        for (unsigned from=0, col=0; col<newNumCols; col++) {
-            for (unsigned row=0; row<newNumRows; row++, from++) {
-                vec[row*newNumCols + col] = input[from];
-            }
+
+    /**
+     * \brief The distance between the starts of the rows of a matrix with "cols" columns.
+     *      Padded rows are rounded up to a whole number of cache lines.
+     */
+    unsigned strideFor(unsigned cols) const {
+        const unsigned lineElements = defaultAlignment % sizeof(T) == 0 ? defaultAlignment / sizeof(T) : 1;
+        if (!paddedRows || lineElements <= 1) {
+            return cols;
         }
-        numRows = newNumRows;
-        numCols = newNumCols;
+        return (cols + lineElements - 1) / lineElements * lineElements;
     }
 
-	void doReshape(std::vector<T> &input, unsigned fromRows, unsigned fromCols, unsigned toRows, unsigned toCols) {
-		Matrix2dIterator<T> itFrom = Matrix2dIterator<T>(input, fromRows, fromCols, false, false);
-		Matrix2dIterator<T> itEnd = Matrix2dIterator<T>(input, fromRows, fromCols, true, false);
-		Matrix2dIterator<T> itTo = Matrix2dIterator<T>(vec, toRows, toCols, false, false);
-		for (; itFrom != itEnd; ++itFrom, ++itTo) {
-			*itTo = *itFrom;
+    /**
+     * \brief Copies the rows x cols matrix at "input" (with rows "inputLd" apart) into this
+     *      matrix, which must already have the same number of elements, in column-major
+     *      order, so element k of a column-major walk of "input" becomes element k of a
+     *      column-major walk of this matrix.
+     */
+	void doReshape(const T *input, unsigned inputLd, unsigned fromRows, unsigned fromCols) {
+		unsigned toRow = 0;
+		unsigned toCol = 0;
+		for (unsigned fromCol = 0; fromCol < fromCols; fromCol++) {
+			for (unsigned fromRow = 0; fromRow < fromRows; fromRow++) {
+				vec[toRow * stride + toCol] = input[fromRow * inputLd + fromCol];
+				if (++toRow == numRows) {
+					toRow = 0;
+					toCol++;
+				}
+			}
 		}
-		numRows = toRows;
-		numCols = toCols;
 	}
 
 public:
@@ -78,18 +79,21 @@ public:
     /*****************************************************************************************
                                     Constructors
     *****************************************************************************************/
-    Matrix2d(unsigned row = 0, unsigned col = 0, std::shared_ptr< std::vector<T> > scratch = nullptr) {
+    Matrix2d(unsigned row = 0, unsigned col = 0) {
         vec.resize(row * col);
         numRows = row;
         numCols = col;
-        initializeScratchBuf(scratch);
+        stride = col;
+        paddedRows = false;
     }
 
-    Matrix2d(std::initializer_list< std::initializer_list<T> > initVals, std::shared_ptr< std::vector<T> > scratch = nullptr) {
+    Matrix2d(std::initializer_list< std::initializer_list<T> > initVals) {
         numRows = initVals.size();
         assert(numRows > 0);
         numCols = initVals.begin()->size();
         assert(numCols > 0);
+        stride = numCols;
+        paddedRows = false;
         vec.resize(numRows * numCols);
         
         unsigned vecIndex = 0;
@@ -99,7 +103,39 @@ public:
                 vec[vecIndex++] = element;
             }
         }
-        initializeScratchBuf(scratch);
+    }
+
+    /**
+     * \brief Expression constructor.
+     *
+     * Evaluates an element-wise expression such as "a + b*2" in a single pass.
+     */
+    template <class E>
+    Matrix2d(const MatrixExpression<E> &expr) {
+        numRows = expr.derived().getRows();
+        numCols = expr.derived().getCols();
+        stride = numCols;
+        paddedRows = false;
+        vec.resize(numRows * numCols);
+        evaluateMatrixExpression(vec.data(), stride, matrixOperand(expr.derived()), numRows, numCols);
+    }
+
+    /**
+     * \brief Copy constructor.
+     */
+    Matrix2d(const Matrix2d &other) = default;
+
+    /**
+     * \brief Move constructor.  Takes over the other matrix's data without copying, and leaves
+     *      it empty.
+     */
+    Matrix2d(Matrix2d &&other) noexcept :
+            vec(std::move(other.vec)), numRows(other.numRows), numCols(other.numCols),
+            stride(other.stride), paddedRows(other.paddedRows) {
+        other.vec.clear();
+        other.numRows = 0;
+        other.numCols = 0;
+        other.stride = 0;
     }
 
     /**
@@ -110,27 +146,66 @@ public:
     /*****************************************************************************************
                                         Operators
     *****************************************************************************************/
-    T& operator()(unsigned row, unsigned col) {return vec[row * numCols + col];}
+    T& operator()(unsigned row, unsigned col) {return vec[row * stride + col];}
 
-    const T& operator()(unsigned row, unsigned col) const {return vec[row * numCols + col];}
+    const T& operator()(unsigned row, unsigned col) const {return vec[row * stride + col];}
 
     /**
      * \brief Assignment operator.
      */
-    Matrix2d<T>& operator=(const Matrix2d<T>& rhs) {
+    Matrix2d& operator=(const Matrix2d& rhs) {
         vec = rhs.vec;
-        scratchBuf = rhs.scratchBuf;
         numRows = rhs.numRows;
         numCols = rhs.numCols;
+        stride = rhs.stride;
+        paddedRows = rhs.paddedRows;
+        return *this;
+    }
+
+    /**
+     * \brief Move assignment operator.
+     */
+    Matrix2d& operator=(Matrix2d&& rhs) noexcept {
+        if (&rhs == this) {
+            return *this;
+        }
+        vec = std::move(rhs.vec);
+        numRows = rhs.numRows;
+        numCols = rhs.numCols;
+        stride = rhs.stride;
+        paddedRows = rhs.paddedRows;
+        rhs.vec.clear();
+        rhs.numRows = 0;
+        rhs.numCols = 0;
+        rhs.stride = 0;
+        return *this;
+    }
+    
+    /**
+     * \brief Expression assignment operator.
+     *
+     * Evaluates an element-wise expression in a single pass.  This matrix may appear in the
+     * expression.
+     */
+    template <class E>
+    Matrix2d& operator=(const MatrixExpression<E> &expr) {
+        const E &derivedExpr = expr.derived();
+        numRows = derivedExpr.getRows();
+        numCols = derivedExpr.getCols();
+        stride = strideFor(numCols);
+        vec.resize(numRows * stride);
+        evaluateMatrixExpression(vec.data(), stride, matrixOperand(derivedExpr), numRows, numCols);
         return *this;
     }
     
     /**
      * \brief Unary minus (negation) operator.
      */
-    Matrix2d<T> & operator-() {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = -vec[index];
+    Matrix2d & operator-() {
+        for (unsigned row=0; row<numRows; row++) {
+            for (unsigned col=0; col<numCols; col++) {
+                (*this)(row, col) = -(*this)(row, col);
+            }
         }
         return *this;
     }
@@ -138,66 +213,70 @@ public:
     /**
      * \brief Add Buffer/Assignment operator.
      */
-    template <class U>
-    Matrix2d<T> & operator+=(const Matrix2d<U> &rhs) {
-        assert(size() == rhs.size());
-        
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] += rhs.vec[index];
-        }
+    template <class U, class OtherAlloc>
+    Matrix2d & operator+=(const Matrix2d<U, OtherAlloc> &rhs) {
+        view() += rhs.view();
+        return *this;
+    }
+    
+    /**
+     * \brief Add Expression/Assignment operator.  "rhs" can be a view or an expression such as
+     *      "a + b".
+     */
+    template <class E>
+    Matrix2d & operator+=(const MatrixExpression<E> &rhs) {
+        view() += rhs.derived();
         return *this;
     }
     
     /**
      * \brief Add Scalar/Assignment operator.
      */
-    Matrix2d<T> & operator+=(const T &rhs) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] += rhs;
-        }
+    Matrix2d & operator+=(const T &rhs) {
+        view() += rhs;
         return *this;
     }
     
     /**
      * \brief Subtract Buffer/Assignment operator.
      */
-    template <class U>
-    Matrix2d<T> & operator-=(const Matrix2d<U> &rhs) {
-        assert(size() == rhs.size());
-        
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] -= rhs.vec[index];
-        }
+    template <class U, class OtherAlloc>
+    Matrix2d & operator-=(const Matrix2d<U, OtherAlloc> &rhs) {
+        view() -= rhs.view();
+        return *this;
+    }
+    
+    /**
+     * \brief Subtract Expression/Assignment operator.  "rhs" can be a view or an expression such as
+     *      "a + b".
+     */
+    template <class E>
+    Matrix2d & operator-=(const MatrixExpression<E> &rhs) {
+        view() -= rhs.derived();
         return *this;
     }
     
     /**
      * \brief Subtract Scalar/Assignment operator.
      */
-    Matrix2d<T> & operator-=(const T &rhs) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] -= rhs;
-        }
+    Matrix2d & operator-=(const T &rhs) {
+        view() -= rhs;
         return *this;
     }
     
     /**
      * \brief Multiply Scalar/Assignment operator.
      */
-    Matrix2d<T> & operator*=(const T &rhs) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] *= rhs;
-        }
+    Matrix2d & operator*=(const T &rhs) {
+        view() *= rhs;
         return *this;
     }
 
     /**
      * \brief Divide Scalar/Assignment operator.
      */
-    Matrix2d<T> & operator/=(const T &rhs) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] /= rhs;
-        }
+    Matrix2d & operator/=(const T &rhs) {
+        view() /= rhs;
         return *this;
     }
     
@@ -209,138 +288,249 @@ public:
     unsigned getRows(void) const {return numRows;}
     unsigned getCols(void) const {return numCols;}
 
-	Matrix2dIterator<T> begin(bool horizontalFirst = false) {return Matrix2dIterator<T>(vec, numRows, numCols, false, horizontalFirst);}
-	Matrix2dIterator<T> end(bool horizontalFirst = false) {return Matrix2dIterator<T>(vec, numRows, numCols, true, horizontalFirst);}
+    /**
+     * \brief The distance, in elements, between the starts of neighbouring rows.  The same as
+     *      getCols() unless the rows are padded.
+     */
+    unsigned ld(void) const {return stride;}
+
+    /**
+     * \brief Pointer to the elements, which are stored in row-major order.  Each row is
+     *      contiguous, and row "r" starts at data() + r * ld().  The padding between rows holds
+     *      unspecified values.
+     */
+    T * data(void) {return vec.data();}
+    const T * data(void) const {return vec.data();}
+
+    /**
+     * \brief Pads the rows (or stops padding them) so that every row starts on a cache line.
+     *
+     * Padding keeps aligned SIMD loads aligned from row to row and stops rows from sharing
+     * cache lines, which helps row-wise operations such as GEMM and multi-channel FFTs when
+     * the number of columns isn't a multiple of a cache line.  It costs up to a cache line of
+     * memory per row.  The matrix stays padded through resizes, reshapes and transposes.  Rows
+     * only start on cache lines if the allocator aligns to cache lines, as the default one does.
+     *
+     * \param pad True to pad the rows, false to pack them.  Defaults to true.
+     * \return Reference to "this".
+     */
+    Matrix2d & padRows(bool pad = true) {
+        if (pad == paddedRows) {
+            return *this;
+        }
+        paddedRows = pad;
+        unsigned oldStride = stride;
+        stride = strideFor(numCols);
+        ScratchBuffer<T> old(vec.size());
+        std::copy(vec.begin(), vec.end(), old.begin());
+        vec.assign(numRows * stride, T());
+        for (unsigned row = 0; row < numRows; row++) {
+            std::copy(old.begin() + row * oldStride, old.begin() + row * oldStride + numCols, vec.begin() + row * stride);
+        }
+        return *this;
+    }
+
+    /**
+     * \brief True if the rows are padded.  See padRows().
+     */
+    bool rowsPadded(void) const {return paddedRows;}
 
-    Matrix2d<T> & transpose(void) {
-        *scratchBuf = vec;
-        doTranspose(*scratchBuf);
+    /**
+     * \brief Returns a view of the whole matrix.  The view is invalidated by anything that
+     *      resizes or transposes the matrix.
+     */
+    MatrixView<T> view(void) {return MatrixView<T>(vec.data(), numRows, numCols, stride);}
+    MatrixView<const T> view(void) const {return MatrixView<const T>(vec.data(), numRows, numCols, stride);}
+
+    /**
+     * \brief Returns a view of the "rows" x "cols" block whose top left element is at ("row", "col").
+     */
+    MatrixView<T> view(unsigned row, unsigned col, unsigned rows, unsigned cols) {return view().view(row, col, rows, cols);}
+    MatrixView<const T> view(unsigned row, unsigned col, unsigned rows, unsigned cols) const {return view().view(row, col, rows, cols);}
+
+    /**
+     * \brief Returns a view of row "row".
+     */
+    VectorView<T> rowView(unsigned row) {return view().row(row);}
+    VectorView<const T> rowView(unsigned row) const {return view().row(row);}
+
+	Matrix2dIterator<T> begin(bool horizontalFirst = false) {return Matrix2dIterator<T>(vec, numRows, numCols, false, horizontalFirst, stride);}
+	Matrix2dIterator<T> end(bool horizontalFirst = false) {return Matrix2dIterator<T>(vec, numRows, numCols, true, horizontalFirst, stride);}
+
+    /**
+     * \brief Transposes the matrix.
+     *
+     * Square matrices are transposed in place.  Others are copied to scratch memory and
+     * transposed back.
+     *
+     * \return Reference to "this".
+     */
+    Matrix2d & transpose(void) {
+        if (numRows == numCols) {
+            simd::transposeInPlace(numRows, numCols, vec.data(), stride);
+            return *this;
+        }
+        ScratchBuffer<T> original(vec.size());
+        std::copy(vec.begin(), vec.end(), original.begin());
+        unsigned newStride = strideFor(numRows);
+        vec.resize(numCols * newStride);
+        simd::transpose(numRows, numCols, original.data(), stride, vec.data(), newStride);
+        std::swap(numRows, numCols);
+        stride = newStride;
+        return *this;
+    }
+
+    /**
+     * \brief Sets this matrix to the transpose of "input".
+     *
+     * \param input The matrix to transpose.  May be "this".
+     * \return Reference to "this".
+     */
+    Matrix2d & transpose(const Matrix2d &input) {
+        if (&input == this) {
+            return transpose();
+        }
+        numRows = input.numCols;
+        numCols = input.numRows;
+        stride = strideFor(numCols);
+        vec.resize(numRows * stride);
+        simd::transpose(input.numRows, input.numCols, input.vec.data(), input.stride, vec.data(), stride);
         return *this;
     }
 
-    Matrix2d<T> & transpose(const Matrix2d<T> input) {
-        numRows = input.numRows;
-        numCols = input.numCols;
-        vec.resize(input.vec.size());
-        doTranspose(input.vec);
+    /**
+     * \brief Transposes the matrix without a second buffer.
+     *
+     * The same as transpose() for square matrices.  Other shapes are transposed by following
+     * the cycles of the permutation, which is much slower but only uses a bit of extra memory
+     * per element.  Other shapes with padded rows can't be done that way, and use transpose().
+     *
+     * \return Reference to "this".
+     */
+    Matrix2d & transposeInPlace(void) {
+        if (numRows != numCols && paddedRows) {
+            return transpose();
+        }
+        simd::transposeInPlace(numRows, numCols, vec.data(), stride);
+        std::swap(numRows, numCols);
+        stride = strideFor(numCols);
         return *this;
     }
 
     RowColIterator<T> rowBegin(int rowNum) {
         checkAddr(rowNum, 0);
-        return RowColIterator<T>(vec, numRows, numCols, true, rowNum, false);
+        return RowColIterator<T>(vec, numRows, numCols, true, rowNum, false, stride);
     }
     RowColIterator<T> rowEnd(int rowNum) {
         checkAddr(rowNum, 0);
-        return RowColIterator<T>(vec, numRows, numCols, true, rowNum, true);
+        return RowColIterator<T>(vec, numRows, numCols, true, rowNum, true, stride);
     }
     RowColIterator<T> colBegin(int colNum) {
         checkAddr(0, colNum);
-        return RowColIterator<T>(vec, numRows, numCols, false, colNum, false);
+        return RowColIterator<T>(vec, numRows, numCols, false, colNum, false, stride);
     }
     RowColIterator<T> colEnd(int colNum) {
         checkAddr(0, colNum);
-        return RowColIterator<T>(vec, numRows, numCols, false, colNum, true);
+        return RowColIterator<T>(vec, numRows, numCols, false, colNum, true, stride);
     }
 
-	Matrix2d<T> & resize(unsigned rows, unsigned cols, T val = 0) {
+	Matrix2d & resize(unsigned rows, unsigned cols, T val = 0) {
+		unsigned newStride = strideFor(cols);
 		unsigned minRows = std::min(rows, numRows);
-		if (cols < numCols) {
+		unsigned minCols = std::min(cols, numCols);
+		if (newStride < stride) {
+			// Rows move towards the start, so go forwards
 			for (unsigned row = 1; row < minRows; row++) {
-				for (unsigned to = row * cols, from = row * numCols; to < row * cols + cols; to++, from++) {
-					vec[to] = vec[from];
-				}
+				std::copy(vec.begin() + row * stride, vec.begin() + row * stride + minCols, vec.begin() + row * newStride);
 			}
-			vec.resize(minRows * cols);
 		}
-		else if (cols > numCols) {
-			vec.resize(minRows * cols);
-			unsigned to = minRows * cols - 1;
-			unsigned from = minRows * numCols - 1;
-			unsigned colDiff = cols - numCols;
-			for (unsigned row = minRows - 1; row > 0; row--) {
-				for (unsigned index=0; index<colDiff; to--, index++) {
-					vec[to] = val;
-				}
-				for (unsigned index = 0; index < numCols; index++, to--, from--) {
-					vec[to] = vec[from];
-				}
-			}
-			for (unsigned index = 0; index < colDiff; to--, index++) { // Zero out the end of the first row
-				vec[to] = val;
+		else if (newStride > stride) {
+			// Rows move towards the end, so go backwards
+			vec.resize(std::max((unsigned) vec.size(), minRows * newStride));
+			for (unsigned row = minRows; row > 1; row--) {
+				auto from = vec.begin() + (row - 1) * stride;
+				std::copy_backward(from, from + minCols, vec.begin() + (row - 1) * newStride + minCols);
 			}
 		}
-		vec.resize(rows * cols, val);
+		for (unsigned row = 0; row < minRows; row++) {
+			std::fill(vec.begin() + row * newStride + minCols, vec.begin() + row * newStride + cols, val);
+		}
+		vec.resize(minRows * newStride);
+		vec.resize(rows * newStride, val);
 		numRows = rows;
 		numCols = cols;
+		stride = newStride;
 		return *this;
 	}
 
-	Matrix2d<T> & reshape(unsigned rows, unsigned cols) {
+	Matrix2d & reshape(unsigned rows, unsigned cols) {
 		assert(rows * cols == numRows * numCols);
-		*scratchBuf = vec;
-		doReshape(*scratchBuf, numRows, numCols, rows, cols);
+		ScratchBuffer<T> original(vec.size());
+		std::copy(vec.begin(), vec.end(), original.begin());
+		unsigned fromRows = numRows;
+		unsigned fromCols = numCols;
+		unsigned fromStride = stride;
+		numRows = rows;
+		numCols = cols;
+		stride = strideFor(cols);
+		vec.resize(rows * stride);
+		doReshape(original.data(), fromStride, fromRows, fromCols);
 		return *this;
 	}
 
-	Matrix2d<T> & reshape(Matrix2d<T> & mat, unsigned rows, unsigned cols) {
+	Matrix2d & reshape(Matrix2d & mat, unsigned rows, unsigned cols) {
 		assert(rows * cols == mat.numRows * mat.numCols);
-		doReshape(mat.vec, mat.numRows, mat.numCols, rows, cols);
+		if (&mat == this) {
+			return reshape(rows, cols);
+		}
+		numRows = rows;
+		numCols = cols;
+		stride = strideFor(cols);
+		vec.resize(rows * stride);
+		doReshape(mat.vec.data(), mat.stride, mat.numRows, mat.numCols);
 		return *this;
 	}
 
-	Matrix2d<T> & appendRow(Vector<T> & appendVec) {
+	template <class VectorAlloc>
+	Matrix2d & appendRow(Vector<T, VectorAlloc> & appendVec) {
 		assert(appendVec.size() == numCols);
 
-		vec.reserve(vec.size() + appendVec.size());
-		vec.insert(vec.end(), appendVec.begin(), appendVec.end());
+		vec.resize((numRows + 1) * stride);
+		std::copy(appendVec.begin(), appendVec.end(), vec.begin() + numRows * stride);
 		numRows++;
 		return *this;
 	}
 
-	Matrix2d<T> & appendRows(Matrix2d<T> & appendMat) {
+	Matrix2d & appendRows(Matrix2d & appendMat) {
 		assert(appendMat.getCols() == numCols);
 
-		vec.reserve(vec.size() + appendMat.getRows() * appendMat.getCols());
-		vec.insert(vec.end(), appendMat.begin(true), appendMat.end(true));
+		vec.resize((numRows + appendMat.getRows()) * stride);
+		for (unsigned row = 0; row < appendMat.getRows(); row++) {
+			std::copy(appendMat.rowBegin(row), appendMat.rowEnd(row), vec.begin() + (numRows + row) * stride);
+		}
 		numRows += appendMat.getRows();
 		return *this;
 	}
 
-	Matrix2d<T> & appendCol(Vector<T> & appendVec) {
+	template <class VectorAlloc>
+	Matrix2d & appendCol(Vector<T, VectorAlloc> & appendVec) {
 		assert(appendVec.size() == numRows);
 
-		vec.resize(vec.size() + appendVec.size());
-		for (unsigned from = numRows * numCols - 1, to = numRows * (numCols + 1) - 1, row = numRows - 1; row > 0; row--) {
-			vec[to--] = appendVec[row];
-			for (unsigned col = 0; col < numCols; col++) {
-				vec[to--] = vec[from--];
-			}
+		resize(numRows, numCols + 1);
+		for (unsigned row = 0; row < numRows; row++) {
+			(*this)(row, numCols - 1) = appendVec[row];
 		}
-		vec[numCols] = appendVec[0];
-		numCols++;
 		return *this;
 	}
 
-	Matrix2d<T> & appendCols(Matrix2d<T> & appendMat) {
+	Matrix2d & appendCols(Matrix2d & appendMat) {
 		assert(appendMat.getRows() == numRows);
 
-		vec.resize(vec.size() + appendMat.getRows() * appendMat.getCols());
-		unsigned from = numRows * numCols - 1;
-		unsigned to = numRows * (numCols + appendMat.getCols()) - 1;
-		unsigned fromAppend = appendMat.getRows() * appendMat.getCols() - 1;
-		for (unsigned row = numRows - 1; row > 0; row--) {
-			for (unsigned col = 0; col < appendMat.getCols(); col++) {
-				vec[to--] = appendMat.vec[fromAppend--];
-			}
-			for (unsigned col = 0; col < numCols; col++) {
-				vec[to--] = vec[from--];
-			}
-		}
-		for (unsigned col = 0; col < appendMat.getCols(); col++) {
-			vec[to--] = appendMat.vec[fromAppend--];
+		unsigned oldCols = numCols;
+		resize(numRows, numCols + appendMat.getCols());
+		for (unsigned row = 0; row < numRows; row++) {
+			std::copy(appendMat.rowBegin(row), appendMat.rowEnd(row), vec.begin() + row * stride + oldCols);
 		}
-		numCols += appendMat.getCols();
 		return *this;
 	}
 
@@ -357,50 +547,54 @@ public:
 	}
 };
 
-template <class T, class U>
-Matrix2d<T> operator+(Matrix2d<T> lhs, const Matrix2d<U>& rhs)
+/**
+ * \brief Makes a Matrix2d an operand of an expression.
+ */
+template <class T, class Alloc>
+MatrixOperand<T> matrixOperand(const Matrix2d<T, Alloc> &mat) {return MatrixOperand<T>(mat.data(), mat.getRows(), mat.getCols(), mat.ld());}
+
+/*
+ * The element-wise arithmetic operators build expressions that are evaluated when they are
+ * assigned to a Matrix2d.  See Expression.h.  Matrix multiplication is in VectorMatrix.h.
+ */
+template <class L, class R>
+MatrixBinaryResult<simd::Add, L, R> operator+(const L &lhs, const R &rhs)
 {
-	lhs += rhs;
-	return lhs;
+	return makeMatrixExpression<simd::Add>(lhs, rhs);
 }
 
-template <class T>
-Matrix2d<T> operator+(Matrix2d<T> lhs, const T& rhs)
+template <class L>
+MatrixScalarResult<simd::Add, L> operator+(const L &lhs, const typename MatrixOperandType<L>::value_type &rhs)
 {
-	lhs += rhs;
-	return lhs;
+	return makeMatrixExpression<simd::Add>(lhs, rhs);
 }
 
-template <class T, class U>
-Matrix2d<T> operator-(Matrix2d<T> lhs, const Matrix2d<U>& rhs)
+template <class L, class R>
+MatrixBinaryResult<simd::Sub, L, R> operator-(const L &lhs, const R &rhs)
 {
-	lhs -= rhs;
-	return lhs;
+	return makeMatrixExpression<simd::Sub>(lhs, rhs);
 }
 
-template <class T>
-Matrix2d<T> operator-(Matrix2d<T> lhs, const T& rhs)
+template <class L>
+MatrixScalarResult<simd::Sub, L> operator-(const L &lhs, const typename MatrixOperandType<L>::value_type &rhs)
 {
-	lhs -= rhs;
-	return lhs;
+	return makeMatrixExpression<simd::Sub>(lhs, rhs);
 }
 
-template <class T>
-Matrix2d<T> operator*(Matrix2d<T> lhs, const T& rhs)
+template <class L>
+MatrixScalarResult<simd::Mul, L> operator*(const L &lhs, const typename MatrixOperandType<L>::value_type &rhs)
 {
-	lhs *= rhs;
-	return lhs;
+	return makeMatrixExpression<simd::Mul>(lhs, rhs);
 }
 
-template <class T>
-Matrix2d<T> operator/(Matrix2d<T> lhs, const T& rhs)
+template <class L>
+MatrixScalarResult<simd::Div, L> operator/(const L &lhs, const typename MatrixOperandType<L>::value_type &rhs)
 {
-	lhs /= rhs;
-	return lhs;
+	return makeMatrixExpression<simd::Div>(lhs, rhs);
 }
 
-template <class T>
-Matrix2d<T> operator==(Matrix2d<T> lhs, const T& rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator==(Matrix2d<T, Alloc> lhs, const T& rhs)
 {
 	for (auto it = lhs.begin(true); it != lhs.end(true); ++it) {
 		*it = (T)(*it == rhs);
@@ -408,8 +602,8 @@ Matrix2d<T> operator==(Matrix2d<T> lhs, const T& rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator!=(Matrix2d<T> lhs, const T& rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator!=(Matrix2d<T, Alloc> lhs, const T& rhs)
 {
 	for (auto it = lhs.begin(true); it != lhs.end(true); ++it) {
 		*it = (T)(*it != rhs);
@@ -417,8 +611,8 @@ Matrix2d<T> operator!=(Matrix2d<T> lhs, const T& rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator<=(Matrix2d<T> lhs, const T& rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator<=(Matrix2d<T, Alloc> lhs, const T& rhs)
 {
 	for (auto it = lhs.begin(true); it != lhs.end(true); ++it) {
 		*it = (T)(*it <= rhs);
@@ -426,8 +620,8 @@ Matrix2d<T> operator<=(Matrix2d<T> lhs, const T& rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator<(Matrix2d<T> lhs, const T& rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator<(Matrix2d<T, Alloc> lhs, const T& rhs)
 {
 	for (auto it = lhs.begin(true); it != lhs.end(true); ++it) {
 		*it = (T)(*it < rhs);
@@ -435,8 +629,8 @@ Matrix2d<T> operator<(Matrix2d<T> lhs, const T& rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator>=(Matrix2d<T> lhs, const T& rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator>=(Matrix2d<T, Alloc> lhs, const T& rhs)
 {
 	for (auto it = lhs.begin(true); it != lhs.end(true); ++it) {
 		*it = (T)(*it >= rhs);
@@ -444,8 +638,8 @@ Matrix2d<T> operator>=(Matrix2d<T> lhs, const T& rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator>(Matrix2d<T> lhs, const T& rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator>(Matrix2d<T, Alloc> lhs, const T& rhs)
 {
 	for (auto it = lhs.begin(true); it != lhs.end(true); ++it) {
 		*it = (T)(*it > rhs);
@@ -453,8 +647,8 @@ Matrix2d<T> operator>(Matrix2d<T> lhs, const T& rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator==(Matrix2d<T> lhs, Matrix2d<T> & rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator==(Matrix2d<T, Alloc> lhs, Matrix2d<T, Alloc> & rhs)
 {
     assert(lhs.size() == rhs.size());
     for (auto itLhs = lhs.begin(true), itRhs = rhs.begin(true); itLhs != lhs.end(true); ++itLhs, ++itRhs) {
@@ -463,8 +657,8 @@ Matrix2d<T> operator==(Matrix2d<T> lhs, Matrix2d<T> & rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator!=(Matrix2d<T> lhs, Matrix2d<T> & rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator!=(Matrix2d<T, Alloc> lhs, Matrix2d<T, Alloc> & rhs)
 {
     assert(lhs.size() == rhs.size());
     for (auto itLhs = lhs.begin(true), itRhs = rhs.begin(true); itLhs != lhs.end(true); ++itLhs, ++itRhs) {
@@ -473,8 +667,8 @@ Matrix2d<T> operator!=(Matrix2d<T> lhs, Matrix2d<T> & rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator<=(Matrix2d<T> lhs, Matrix2d<T> & rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator<=(Matrix2d<T, Alloc> lhs, Matrix2d<T, Alloc> & rhs)
 {
     assert(lhs.size() == rhs.size());
     for (auto itLhs = lhs.begin(true), itRhs = rhs.begin(true); itLhs != lhs.end(true); ++itLhs, ++itRhs) {
@@ -483,8 +677,8 @@ Matrix2d<T> operator<=(Matrix2d<T> lhs, Matrix2d<T> & rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator<(Matrix2d<T> lhs, Matrix2d<T> & rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator<(Matrix2d<T, Alloc> lhs, Matrix2d<T, Alloc> & rhs)
 {
     assert(lhs.size() == rhs.size());
     for (auto itLhs = lhs.begin(true), itRhs = rhs.begin(true); itLhs != lhs.end(true); ++itLhs, ++itRhs) {
@@ -493,8 +687,8 @@ Matrix2d<T> operator<(Matrix2d<T> lhs, Matrix2d<T> & rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator>=(Matrix2d<T> lhs, Matrix2d<T> & rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator>=(Matrix2d<T, Alloc> lhs, Matrix2d<T, Alloc> & rhs)
 {
     assert(lhs.size() == rhs.size());
     for (auto itLhs = lhs.begin(true), itRhs = rhs.begin(true); itLhs != lhs.end(true); ++itLhs, ++itRhs) {
@@ -503,8 +697,8 @@ Matrix2d<T> operator>=(Matrix2d<T> lhs, Matrix2d<T> & rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> operator>(Matrix2d<T> lhs, Matrix2d<T> & rhs)
+template <class T, class Alloc>
+Matrix2d<T, Alloc> operator>(Matrix2d<T, Alloc> lhs, Matrix2d<T, Alloc> & rhs)
 {
     assert(lhs.size() == rhs.size());
     for (auto itLhs = lhs.begin(true), itRhs = rhs.begin(true); itLhs != lhs.end(true); ++itLhs, ++itRhs) {
@@ -513,24 +707,82 @@ Matrix2d<T> operator>(Matrix2d<T> lhs, Matrix2d<T> & rhs)
 	return lhs;
 }
 
-template <class T>
-Matrix2d<T> & transpose(Matrix2d<T> & mat) {return mat.transpose();}
+/*
+ * Comparing an expression to a scalar or a matrix evaluates the expression first.
+ */
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator==(const MatrixBinaryExpression<Op, L, R> &lhs,
+        const typename MatrixBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() == rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator!=(const MatrixBinaryExpression<Op, L, R> &lhs,
+        const typename MatrixBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() != rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator<(const MatrixBinaryExpression<Op, L, R> &lhs,
+        const typename MatrixBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() < rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator<=(const MatrixBinaryExpression<Op, L, R> &lhs,
+        const typename MatrixBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() <= rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator>(const MatrixBinaryExpression<Op, L, R> &lhs,
+        const typename MatrixBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() > rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator>=(const MatrixBinaryExpression<Op, L, R> &lhs,
+        const typename MatrixBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() >= rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator==(const MatrixBinaryExpression<Op, L, R> &lhs,
+        typename MatrixBinaryExpression<Op, L, R>::matrix_type &rhs) {return lhs.eval() == rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator!=(const MatrixBinaryExpression<Op, L, R> &lhs,
+        typename MatrixBinaryExpression<Op, L, R>::matrix_type &rhs) {return lhs.eval() != rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator<(const MatrixBinaryExpression<Op, L, R> &lhs,
+        typename MatrixBinaryExpression<Op, L, R>::matrix_type &rhs) {return lhs.eval() < rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator<=(const MatrixBinaryExpression<Op, L, R> &lhs,
+        typename MatrixBinaryExpression<Op, L, R>::matrix_type &rhs) {return lhs.eval() <= rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator>(const MatrixBinaryExpression<Op, L, R> &lhs,
+        typename MatrixBinaryExpression<Op, L, R>::matrix_type &rhs) {return lhs.eval() > rhs;}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type operator>=(const MatrixBinaryExpression<Op, L, R> &lhs,
+        typename MatrixBinaryExpression<Op, L, R>::matrix_type &rhs) {return lhs.eval() >= rhs;}
+
+template <class T, class Alloc>
+Matrix2d<T, Alloc> & transpose(Matrix2d<T, Alloc> & mat) {return mat.transpose();}
+
+template <class T, class Alloc>
+Matrix2d<T, Alloc> & transpose(const Matrix2d<T, Alloc> & input, Matrix2d<T, Alloc> & output) {return output.transpose(input);}
+
+template <class Op, class L, class R>
+typename MatrixBinaryExpression<Op, L, R>::matrix_type & transpose(const MatrixBinaryExpression<Op, L, R> & input,
+        typename MatrixBinaryExpression<Op, L, R>::matrix_type & output) {return output.transpose(input.eval());}
 
-template <class T>
-Matrix2d<T> & transpose(const Matrix2d<T> & input, Matrix2d<T> & output) {return output.transpose(input);}
+template <class T, class Alloc>
+Matrix2d<T, Alloc> & transposeInPlace(Matrix2d<T, Alloc> & mat) {return mat.transposeInPlace();}
 
-template <class T>
-Matrix2d<T> & resize(Matrix2d<T> & mat, unsigned rows, unsigned cols, T val = 0) {
+template <class T, class Alloc>
+Matrix2d<T, Alloc> & resize(Matrix2d<T, Alloc> & mat, unsigned rows, unsigned cols, T val = 0) {
 	return mat.resize(rows, cols, val);
 }
 
-template <class T>
-Matrix2d<T> & reshape(Matrix2d<T> & fromMat, Matrix2d<T> & toMat, unsigned rows, unsigned cols) {
+template <class T, class Alloc>
+Matrix2d<T, Alloc> & reshape(Matrix2d<T, Alloc> & fromMat, Matrix2d<T, Alloc> & toMat, unsigned rows, unsigned cols) {
 	return toMat.reshape(fromMat, rows, cols);
 }
 
-template <class T>
-Matrix2d<T> & reshape(Matrix2d<T> & mat, unsigned rows, unsigned cols) {
+template <class T, class Alloc>
+Matrix2d<T, Alloc> & reshape(Matrix2d<T, Alloc> & mat, unsigned rows, unsigned cols) {
 	return mat.reshape(rows, cols);
 }
 
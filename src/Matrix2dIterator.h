@@ -15,7 +15,7 @@ namespace MatrixDSP {
 template<typename T>
 class Matrix2dIterator {
     private:
-        typename std::vector<T>::iterator iterator;
+        T *iterator;
 		int rowIncrement;
 		int colIncrement;
 		int entireRowIncrement;
@@ -34,13 +34,22 @@ class Matrix2dIterator {
         typedef T &reference;
         typedef std::random_access_iterator_tag iterator_category;
     
-        Matrix2dIterator(typename std::vector<T> &vec, unsigned rows, unsigned cols, bool end = false, bool traverseRowsFirst = false) {
+        /**
+         * \brief Iterates over a rows x cols matrix stored in "vec", whose rows start "ld"
+         *      elements apart (0 means "cols").
+         */
+        template <class Alloc>
+        Matrix2dIterator(std::vector<T, Alloc> &vec, unsigned rows, unsigned cols, bool end = false, bool traverseRowsFirst = false,
+                         unsigned ld = 0) {
+            if (ld == 0) {
+                ld = cols;
+            }
             if (traverseRowsFirst) {
 				numRows = rows;
 				numCols = cols;
-				rowIncrement = 1;
+				rowIncrement = 1 + ld - cols;
 				colIncrement = 1;
-				entireRowIncrement = numCols;
+				entireRowIncrement = ld;
             }
             else {
 				// We're going to traverse columns first.  In order to avoid a bunch of "if" statements in the iterator methods to find out if we're
@@ -48,26 +57,18 @@ class Matrix2dIterator {
 				// change.  Thus, the number of cols becomes "numRows".  It's like we're transposed.
 				numRows = cols;
 				numCols = rows;
-				colIncrement = cols;
-				rowIncrement = 1 - (rows - 1) * cols;
+				colIncrement = ld;
+				rowIncrement = 1 - (rows - 1) * ld;
 				entireRowIncrement = 1;
             }
 
+			iterator = vec.data();
+			row = 0;
+			col = 0;
 			if (end) {
-				iterator = vec.end();
-				if (traverseRowsFirst) {
-					row = numRows;
-					col = 0;
-				}
-				else {
-					row = numRows;
-					col = 0;
-				}
-			}
-			else {
-				iterator = vec.begin();
-				row = 0;
-				col = 0;
+				// One row past the last one, in the order of traversal
+				row = numRows;
+				iterator += (std::ptrdiff_t) numRows * entireRowIncrement;
 			}
         }
 
@@ -0,0 +1,261 @@
+//
+//  MedianFilter.h
+//  MatrixDSP
+//
+//  A sliding window median filter that keeps its state between calls, so a long stream can be
+//  filtered a block at a time.  The window is kept in a double heap (a max-heap of the lower
+//  half and a min-heap of the upper half that meet at the median), so each new sample costs
+//  O(log w) for a window of w samples.
+//
+
+#ifndef MedianFilter_h
+#define MedianFilter_h
+
+#include <cassert>
+#include <vector>
+#include "Vector.h"
+
+namespace MatrixDSP {
+
+/**
+ * \brief Sliding window median filter.
+ *
+ * Each output sample is the median of the latest "windowLen" input samples, including the
+ * current one.  Until that many samples have gone in, it's the median of the samples so far.
+ * Like median(), the median of an even number of samples is the mean of the two middle ones.
+ *
+ * The window is a ring buffer of samples, and a heap array holds indexes into it.  Index 0 of
+ * the heap array is the median, the negative indexes are a max-heap of the samples below it and
+ * the positive ones are a min-heap of the samples above it, and a third array tracks where each
+ * sample is in the heaps.  The new sample replaces the oldest one in place and is sifted up or
+ * down, which keeps both heaps balanced without any allocation.
+ */
+template <class T>
+class MedianFilter {
+    unsigned windowLen;
+    std::vector<T> window;              // The latest samples, in a ring buffer
+    std::vector<int> positions;         // Where each sample of "window" is in the heaps
+    std::vector<unsigned> heapStorage;  // Indexes into "window", ordered as described above
+    int heapOffset;                     // Index of heap position 0 in heapStorage
+    unsigned next;                      // The next sample of "window" to replace
+    unsigned count;                     // The number of samples in the window
+
+    unsigned & heap(int position) {return heapStorage[position + heapOffset];}
+
+    int maxHeapCount() const {return count / 2;}
+    int minHeapCount() const {return (count - 1) / 2;}
+
+    bool less(int i, int j) {return window[heap(i)] < window[heap(j)];}
+
+    /**
+     * \brief Swaps heap positions i and j if the sample at i is less than the one at j.
+     *
+     * \return True if they were swapped.
+     */
+    bool exchangeIfLess(int i, int j) {
+        if (!less(i, j)) {
+            return false;
+        }
+        std::swap(heap(i), heap(j));
+        positions[heap(i)] = i;
+        positions[heap(j)] = j;
+        return true;
+    }
+
+    /**
+     * \brief Moves the sample at position i of the min-heap down to where it belongs.  Position
+     *      1 is the only child of the median, and the others have two children.
+     */
+    void minSortDown(int i) {
+        for (; i <= minHeapCount(); i *= 2) {
+            if (i > 1 && i < minHeapCount() && less(i + 1, i)) {
+                i++;
+            }
+            if (!exchangeIfLess(i, i / 2)) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * \brief Moves the sample at position i of the max-heap down to where it belongs.
+     */
+    void maxSortDown(int i) {
+        for (; i >= -maxHeapCount(); i *= 2) {
+            if (i < -1 && i > -maxHeapCount() && less(i, i - 1)) {
+                i--;
+            }
+            if (!exchangeIfLess(i / 2, i)) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * \brief Restores the min-heap above position i.
+     *
+     * \return True if the sample reached the median.
+     */
+    bool minSortUp(int i) {
+        while (i > 0 && exchangeIfLess(i, i / 2)) {
+            i /= 2;
+        }
+        return i == 0;
+    }
+
+    /**
+     * \brief Restores the max-heap above position i.
+     *
+     * \return True if the sample reached the median.
+     */
+    bool maxSortUp(int i) {
+        while (i < 0 && exchangeIfLess(i / 2, i)) {
+            i /= 2;
+        }
+        return i == 0;
+    }
+
+public:
+    /**
+     * \brief Constructor.
+     *
+     * \param len The number of samples that each output is the median of.
+     */
+    MedianFilter(unsigned len) : windowLen(len) {
+        assert(windowLen > 0);
+        window.resize(windowLen);
+        positions.resize(windowLen);
+        heapStorage.resize(windowLen);
+        heapOffset = windowLen / 2;
+        reset();
+    }
+
+    /**
+     * \brief Empties the window, so the next sample starts a new stream.
+     */
+    void reset() {
+        // The samples go in at the median, then alternately below and above it
+        for (unsigned index=0; index<windowLen; index++) {
+            int position = (int) ((index + 1) / 2);
+            positions[index] = (index & 1) ? -position : position;
+            heap(positions[index]) = index;
+        }
+        next = 0;
+        count = 0;
+    }
+
+    /**
+     * \brief The number of samples that each output is the median of.
+     */
+    unsigned windowLength() const {return windowLen;}
+
+    /**
+     * \brief Adds "sample" to the window and returns the median of the window.
+     */
+    T filter(T sample) {
+        bool filling = count < windowLen;
+        int position = positions[next];
+        T oldest = window[next];
+        window[next] = sample;
+        next = (next + 1) % windowLen;
+        if (filling) {
+            count++;
+        }
+
+        if (position > 0) {
+            // In the min-heap
+            if (!filling && oldest < sample) {
+                minSortDown(position * 2);
+            }
+            else if (minSortUp(position)) {
+                maxSortDown(-1);
+            }
+        }
+        else if (position < 0) {
+            // In the max-heap
+            if (!filling && sample < oldest) {
+                maxSortDown(position * 2);
+            }
+            else if (maxSortUp(position)) {
+                minSortDown(1);
+            }
+        }
+        else {
+            // At the median
+            if (maxHeapCount() > 0 && maxSortUp(-1)) {
+                maxSortDown(-2);
+            }
+            if (minHeapCount() > 0 && minSortUp(1)) {
+                minSortDown(2);
+            }
+        }
+        return median();
+    }
+
+    /**
+     * \brief Returns the median of the window.
+     */
+    T median() {
+        assert(count > 0);
+        T middle = window[heap(0)];
+        if (count & 1) {
+            return middle;
+        }
+        return (middle + window[heap(-1)]) / ((T) 2);
+    }
+
+    /**
+     * \brief Filters "len" samples.
+     *
+     * \param input The samples to filter.
+     * \param output The filtered samples.  May be "input".
+     */
+    void filter(const T *input, T *output, unsigned len) {
+        for (unsigned index=0; index<len; index++) {
+            output[index] = filter(input[index]);
+        }
+    }
+
+    /**
+     * \brief Filters a block of samples, carrying on from the previous block.
+     *
+     * \param input The samples to filter.
+     * \param output The filtered samples.  Resized to the size of "input".  May be "input".
+     * \return Reference to "output".
+     */
+    template <class InputAlloc, class OutputAlloc>
+    Vector<T, OutputAlloc> & filter(const Vector<T, InputAlloc> &input, Vector<T, OutputAlloc> &output) {
+        output.resize(input.size());
+        output.rowVector = input.rowVector;
+        filter(input.vec.data(), output.vec.data(), input.size());
+        return output;
+    }
+
+    /**
+     * \brief Filters a block of samples in place, carrying on from the previous block.
+     *
+     * \return Reference to "data".
+     */
+    template <class Alloc>
+    Vector<T, Alloc> & filter(Vector<T, Alloc> &data) {
+        return filter(data, data);
+    }
+};
+
+/**
+ * \brief Median filters "input" with a fresh filter.
+ *
+ * \param input The samples to filter.
+ * \param output The filtered samples.  May be "input".
+ * \param windowLen The number of samples that each output is the median of.
+ * \return Reference to "output".
+ */
+template <class T, class InputAlloc, class OutputAlloc>
+Vector<T, OutputAlloc> & medianFilter(const Vector<T, InputAlloc> &input, Vector<T, OutputAlloc> &output, unsigned windowLen) {
+    MedianFilter<T> filter(windowLen);
+    return filter.filter(input, output);
+}
+
+}
+
+#endif /* MedianFilter_h */
@@ -0,0 +1,771 @@
+//
+//  Nco.h
+//  MatrixDSP
+//
+//  A numerically controlled oscillator: a complex tone generator that keeps its phase between
+//  calls, so a long stream can be generated, or mixed to another frequency, a block at a time.
+//
+//  The phase is a 64 bit accumulator in which 2^64 is a full cycle.  It wraps for free, never
+//  loses precision however long the NCO runs, and the tone frequency is exact to within
+//  sampleFreq / 2^64.  The sines and cosines come from one of three engines:
+//
+//  Polynomial: the top two bits of the phase pick a quadrant, the rest becomes an angle in
+//      [-pi/4, pi/4), and short Taylor series give its sine and cosine.  Full accuracy for the
+//      type, and vectorized.
+//  Phasor: each lane of a register holds a phasor that's rotated by a complex multiply per
+//      step.  The phasors are set from the phase accumulator at the start of every block, which
+//      keeps their magnitudes at one and their phases from drifting.  The cheapest per sample,
+//      and vectorized.  The error grows with the number of steps each phasor takes in a block:
+//      a few ulps with AVX-512, and a few tens with the one phasor of the scalar code.
+//  Table: a 1024 entry table of sines and cosines is indexed with the top bits of the phase,
+//      and a Taylor series for the remaining angle corrects the entry.  Scalar code, for CPUs
+//      without AVX2.
+//
+//  The engines all advance the same accumulator, so the engine can be changed between blocks
+//  without a phase jump.
+//
+
+#ifndef Nco_h
+#define Nco_h
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "ScratchArena.h"
+#include "Simd.h"
+
+namespace MatrixDSP {
+
+template <class T, class Alloc>
+class Vector;
+
+/**
+ * \brief The ways that Nco can compute its sines and cosines.  See Nco.h.
+ */
+enum class NcoEngine {Polynomial, Phasor, Table};
+
+namespace simd {
+
+/**
+ * \brief The number of samples that Nco generates at a time.  The phasor engine is reset from
+ *      the phase accumulator at the start of each block.
+ */
+const unsigned ncoBlockSize = 256;
+
+/**
+ * \brief The number of entries in the table engine's table.
+ */
+const unsigned ncoTableBits = 10;
+
+/**
+ * \brief The Taylor series coefficients of sin(x)/x and cos(x) in powers of x^2.
+ */
+const double ncoSinCoefficients[] = {1.0, -1.0 / 6, 1.0 / 120, -1.0 / 5040, 1.0 / 362880, -1.0 / 39916800,
+                                     1.0 / 6227020800.0, -1.0 / 1307674368000.0};
+const double ncoCosCoefficients[] = {1.0, -1.0 / 2, 1.0 / 24, -1.0 / 720, 1.0 / 40320, -1.0 / 3628800,
+                                     1.0 / 479001600, -1.0 / 87178291200.0, 1.0 / 20922789888000.0};
+
+/**
+ * \brief How many terms of the series the polynomial engine needs for type T.  The angle is at
+ *      most pi/4, so the first term left out is below the precision of T.
+ */
+template <class T>
+struct NcoTerms {
+    static const unsigned sinTerms = sizeof(T) > 4 ? 8 : 5;
+    static const unsigned cosTerms = sizeof(T) > 4 ? 9 : 5;
+};
+
+/**
+ * \brief True if there are NCO kernels for type "T".
+ */
+template <class T>
+struct HasNcoKernel : std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value> {};
+
+/**
+ * \brief Converts a phase from the accumulator to radians, from -pi to pi.
+ */
+inline double ncoRadians(int64_t phase) {return phase * (2 * M_PI / 18446744073709551616.0);}
+
+/**
+ * \brief Converts a phase from the accumulator to radians, from 0 to 2 pi.
+ */
+inline double ncoRadians(uint64_t phase) {return phase * (2 * M_PI / 18446744073709551616.0);}
+
+/**
+ * \brief Splits "phase" into the nearest quarter cycle and an angle, in radians, from it.
+ *
+ * \return The quadrant, 0 to 3.
+ */
+template <class T>
+uint32_t ncoReduce(uint64_t phase, T *angle) {
+    uint64_t quadrant = (phase + ((uint64_t) 1 << 61)) >> 62;
+    *angle = (T) ncoRadians((int64_t) (phase - (quadrant << 62)));
+    return (uint32_t) quadrant;
+}
+
+/**
+ * \brief Turns the cosine and sine of the angle from ncoReduce() into those of the phase.
+ */
+template <class T>
+void ncoRotateQuadrant(uint32_t quadrant, T &cosine, T &sine) {
+    if (quadrant & 1) {
+        std::swap(cosine, sine);
+    }
+    if ((quadrant ^ (quadrant >> 1)) & 1) {
+        cosine = -cosine;
+    }
+    if (quadrant & 2) {
+        sine = -sine;
+    }
+}
+
+template <class T>
+void ncoPolynomialGeneric(uint64_t phase, uint64_t step, std::size_t n, T *cosOut, T *sinOut) {
+    for (std::size_t i = 0; i < n; i++, phase += step) {
+        T x;
+        uint32_t quadrant = ncoReduce(phase, &x);
+        T x2 = x * x;
+        T sine = (T) ncoSinCoefficients[NcoTerms<T>::sinTerms - 1];
+        for (unsigned term = NcoTerms<T>::sinTerms - 1; term > 0; term--) {
+            sine = sine * x2 + (T) ncoSinCoefficients[term - 1];
+        }
+        sine *= x;
+        T cosine = (T) ncoCosCoefficients[NcoTerms<T>::cosTerms - 1];
+        for (unsigned term = NcoTerms<T>::cosTerms - 1; term > 0; term--) {
+            cosine = cosine * x2 + (T) ncoCosCoefficients[term - 1];
+        }
+        ncoRotateQuadrant(quadrant, cosine, sine);
+        cosOut[i] = cosine;
+        sinOut[i] = sine;
+    }
+}
+
+/**
+ * \brief Rotates "lanes" phasors, which start at (seedCos[k], seedSin[k]), by (rotCos, rotSin)
+ *      per step, and writes them out in turn.  With one lane it's a plain recursive oscillator.
+ */
+template <class T>
+void ncoPhasorGeneric(const T *seedCos, const T *seedSin, T rotCos, T rotSin, std::size_t n, T *cosOut, T *sinOut) {
+    T cosine = seedCos[0];
+    T sine = seedSin[0];
+    for (std::size_t i = 0; i < n; i++) {
+        cosOut[i] = cosine;
+        sinOut[i] = sine;
+        T nextCosine = cosine * rotCos - sine * rotSin;
+        sine = cosine * rotSin + sine * rotCos;
+        cosine = nextCosine;
+    }
+}
+
+/**
+ * \brief Returns the table engine's table: the cosines and sines of 2^ncoTableBits evenly spaced
+ *      angles.
+ */
+template <class T>
+const std::vector< std::complex<T> > & ncoTable() {
+    static const std::vector< std::complex<T> > table = []() {
+        std::vector< std::complex<T> > entries(1u << ncoTableBits);
+        for (unsigned index = 0; index < entries.size(); index++) {
+            entries[index] = std::complex<T>(std::polar(1.0, 2 * M_PI * index / entries.size()));
+        }
+        return entries;
+    }();
+    return table;
+}
+
+template <class T>
+void ncoTableGeneric(uint64_t phase, uint64_t step, std::size_t n, T *cosOut, T *sinOut) {
+    const std::complex<T> *table = ncoTable<T>().data();
+    const unsigned shift = 64 - ncoTableBits;
+    for (std::size_t i = 0; i < n; i++, phase += step) {
+        // The nearest entry, and the angle from it, which is at most half an entry
+        uint64_t index = (phase + ((uint64_t) 1 << (shift - 1))) >> shift;
+        T d = (T) ncoRadians((int64_t) (phase - (index << shift)));
+        T d2 = d * d;
+        T cosD = 1 + d2 * (T) (-1.0 / 2 + d2 / 24);
+        T sinD = d * (1 + d2 * (T) (-1.0 / 6 + d2 / 120));
+        const std::complex<T> &entry = table[index & ((1u << ncoTableBits) - 1)];
+        cosOut[i] = entry.real() * cosD - entry.imag() * sinD;
+        sinOut[i] = entry.imag() * cosD + entry.real() * sinD;
+    }
+}
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+/*****************************************************************************************
+                                        Kernels
+*****************************************************************************************/
+// NcoTraits<isa, T> holds the phases of a register's worth of samples as integers, and does
+// ncoReduce() and ncoRotateQuadrant() on them.  The float versions keep the top 32 bits of each
+// phase, which is plenty for a block of float samples, and the double versions keep all 64.  The
+// AVX-512 versions use the zero masking forms of the shifts and conversions with every lane
+// selected: the plain forms merge into an undefined register, which GCC warns about.
+
+template <Isa isa, class T>
+struct NcoTraits;
+
+template <>
+struct NcoTraits<Isa::Avx2, float> {
+    typedef Traits<Isa::Avx2, float> Tr;
+    typedef __m256 Reg;
+    typedef __m256i Phase;
+    typedef uint32_t PhaseWord;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE PhaseWord lanePhase(uint64_t phase) {return (uint32_t) ((phase + 0x80000000u) >> 32);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Phase loadPhases(const uint32_t *p) {return _mm256_loadu_si256((const __m256i *) p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Phase add(Phase a, uint32_t b) {return _mm256_add_epi32(a, _mm256_set1_epi32((int) b));}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg reduce(Phase phase, Phase &quadrant) {
+        quadrant = _mm256_srli_epi32(_mm256_add_epi32(phase, _mm256_set1_epi32(0x20000000)), 30);
+        Phase offset = _mm256_sub_epi32(phase, _mm256_slli_epi32(quadrant, 30));
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(offset), _mm256_set1_ps((float) (2 * M_PI / 4294967296.0)));
+    }
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void rotateQuadrant(Phase quadrant, Reg &cosine, Reg &sine) {
+        Reg swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+        Reg c = _mm256_blendv_ps(cosine, sine, swap);
+        Reg s = _mm256_blendv_ps(sine, cosine, swap);
+        Phase cosSign = _mm256_slli_epi32(_mm256_xor_si256(quadrant, _mm256_srli_epi32(quadrant, 1)), 31);
+        Phase sinSign = _mm256_slli_epi32(_mm256_srli_epi32(quadrant, 1), 31);
+        cosine = _mm256_xor_ps(c, _mm256_castsi256_ps(cosSign));
+        sine = _mm256_xor_ps(s, _mm256_castsi256_ps(sinSign));
+    }
+};
+
+template <>
+struct NcoTraits<Isa::Avx2, double> {
+    typedef Traits<Isa::Avx2, double> Tr;
+    typedef __m256d Reg;
+    typedef __m256i Phase;
+    typedef uint64_t PhaseWord;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE PhaseWord lanePhase(uint64_t phase) {return phase;}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Phase loadPhases(const uint64_t *p) {return _mm256_loadu_si256((const __m256i *) p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Phase add(Phase a, uint64_t b) {return _mm256_add_epi64(a, _mm256_set1_epi64x((long long) b));}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg reduce(Phase phase, Phase &quadrant) {
+        // There's no 64 bit integer conversion, so the 62 bit offset from the quadrant start is
+        // converted 32 bits at a time by putting each half in the mantissa of 2^52
+        Phase biased = _mm256_add_epi64(phase, _mm256_set1_epi64x(1ll << 61));
+        quadrant = _mm256_srli_epi64(biased, 62);
+        Phase offset = _mm256_and_si256(biased, _mm256_set1_epi64x((1ll << 62) - 1));
+        Reg magic = _mm256_set1_pd(4503599627370496.0);
+        Reg high = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(offset, 32), _mm256_castpd_si256(magic))), magic);
+        Reg low = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(offset, _mm256_set1_epi64x(0xffffffffll)),
+                                                                    _mm256_castpd_si256(magic))), magic);
+        Reg units = _mm256_add_pd(_mm256_fmadd_pd(high, _mm256_set1_pd(4294967296.0), _mm256_set1_pd(-2305843009213693952.0)), low);
+        return _mm256_mul_pd(units, _mm256_set1_pd(2 * M_PI / 18446744073709551616.0));
+    }
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void rotateQuadrant(Phase quadrant, Reg &cosine, Reg &sine) {
+        Reg swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(quadrant, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(1)));
+        Reg c = _mm256_blendv_pd(cosine, sine, swap);
+        Reg s = _mm256_blendv_pd(sine, cosine, swap);
+        __m256i cosSign = _mm256_slli_epi64(_mm256_xor_si256(quadrant, _mm256_srli_epi64(quadrant, 1)), 63);
+        __m256i sinSign = _mm256_slli_epi64(_mm256_srli_epi64(quadrant, 1), 63);
+        cosine = _mm256_xor_pd(c, _mm256_castsi256_pd(cosSign));
+        sine = _mm256_xor_pd(s, _mm256_castsi256_pd(sinSign));
+    }
+};
+
+template <>
+struct NcoTraits<Isa::Avx512, float> {
+    typedef Traits<Isa::Avx512, float> Tr;
+    typedef __m512 Reg;
+    typedef __m512i Phase;
+    typedef uint32_t PhaseWord;
+    static const __mmask16 all = (__mmask16) -1;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE PhaseWord lanePhase(uint64_t phase) {return (uint32_t) ((phase + 0x80000000u) >> 32);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Phase loadPhases(const uint32_t *p) {return _mm512_loadu_si512((const void *) p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Phase add(Phase a, uint32_t b) {return _mm512_add_epi32(a, _mm512_set1_epi32((int) b));}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg reduce(Phase phase, Phase &quadrant) {
+        quadrant = _mm512_maskz_srli_epi32(all, _mm512_add_epi32(phase, _mm512_set1_epi32(0x20000000)), 30);
+        Phase offset = _mm512_sub_epi32(phase, _mm512_maskz_slli_epi32(all, quadrant, 30));
+        return _mm512_mul_ps(_mm512_maskz_cvtepi32_ps(all, offset), _mm512_set1_ps((float) (2 * M_PI / 4294967296.0)));
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void rotateQuadrant(Phase quadrant, Reg &cosine, Reg &sine) {
+        __mmask16 swap = _mm512_test_epi32_mask(quadrant, _mm512_set1_epi32(1));
+        Reg c = _mm512_mask_blend_ps(swap, cosine, sine);
+        Reg s = _mm512_mask_blend_ps(swap, sine, cosine);
+        Phase half = _mm512_maskz_srli_epi32(all, quadrant, 1);
+        Phase cosSign = _mm512_maskz_slli_epi32(all, _mm512_xor_si512(quadrant, half), 31);
+        Phase sinSign = _mm512_maskz_slli_epi32(all, half, 31);
+        cosine = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(c), cosSign));
+        sine = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(s), sinSign));
+    }
+};
+
+template <>
+struct NcoTraits<Isa::Avx512, double> {
+    typedef Traits<Isa::Avx512, double> Tr;
+    typedef __m512d Reg;
+    typedef __m512i Phase;
+    typedef uint64_t PhaseWord;
+    static const __mmask8 all = (__mmask8) -1;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE PhaseWord lanePhase(uint64_t phase) {return phase;}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Phase loadPhases(const uint64_t *p) {return _mm512_loadu_si512((const void *) p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Phase add(Phase a, uint64_t b) {return _mm512_add_epi64(a, _mm512_set1_epi64((long long) b));}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg reduce(Phase phase, Phase &quadrant) {
+        // As for AVX2: AVX-512F has no 64 bit integer conversion either
+        Phase biased = _mm512_add_epi64(phase, _mm512_set1_epi64(1ll << 61));
+        quadrant = _mm512_maskz_srli_epi64(all, biased, 62);
+        Phase offset = _mm512_and_si512(biased, _mm512_set1_epi64((1ll << 62) - 1));
+        Reg magic = _mm512_set1_pd(4503599627370496.0);
+        Reg high = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_maskz_srli_epi64(all, offset, 32), _mm512_castpd_si512(magic))), magic);
+        Reg low = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(offset, _mm512_set1_epi64(0xffffffffll)),
+                                                                    _mm512_castpd_si512(magic))), magic);
+        Reg units = _mm512_add_pd(_mm512_fmadd_pd(high, _mm512_set1_pd(4294967296.0), _mm512_set1_pd(-2305843009213693952.0)), low);
+        return _mm512_mul_pd(units, _mm512_set1_pd(2 * M_PI / 18446744073709551616.0));
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void rotateQuadrant(Phase quadrant, Reg &cosine, Reg &sine) {
+        __mmask8 swap = _mm512_test_epi64_mask(quadrant, _mm512_set1_epi64(1));
+        Reg c = _mm512_mask_blend_pd(swap, cosine, sine);
+        Reg s = _mm512_mask_blend_pd(swap, sine, cosine);
+        __m512i half = _mm512_maskz_srli_epi64(all, quadrant, 1);
+        __m512i cosSign = _mm512_maskz_slli_epi64(all, _mm512_xor_si512(quadrant, half), 63);
+        __m512i sinSign = _mm512_maskz_slli_epi64(all, half, 63);
+        cosine = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(c), cosSign));
+        sine = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(s), sinSign));
+    }
+};
+
+// ncoPolynomial*() is ncoPolynomialGeneric() a register at a time, and ncoPhasor*() is
+// ncoPhasorGeneric() with one phasor per lane.  A partial last register goes through a buffer,
+// so there is no scalar tail.  There is one copy per instruction set because the target
+// attribute has to be a literal.
+
+template <class Nt, class T>
+MATRIX_DSP_TARGET_AVX2 void ncoPolynomialAvx2(uint64_t phase, uint64_t step, std::size_t n, T *cosOut, T *sinOut) {
+    typedef typename Nt::Tr Tr;
+    typedef typename Nt::Reg Reg;
+    typedef typename Nt::Phase Phase;
+    const std::size_t w = Tr::width;
+    typename Nt::PhaseWord lanes[Tr::width];
+    for (std::size_t lane = 0; lane < w; lane++) {
+        lanes[lane] = Nt::lanePhase(phase + (uint64_t) lane * step);
+    }
+    Phase phases = Nt::loadPhases(lanes);
+    for (std::size_t i = 0; i < n; i += w) {
+        Phase quadrant;
+        Reg x = Nt::reduce(phases, quadrant);
+        Reg x2 = Tr::apply(Mul(), x, x);
+        Reg sine = Tr::set1((T) ncoSinCoefficients[NcoTerms<T>::sinTerms - 1]);
+        MATRIX_DSP_UNROLL
+        for (unsigned term = NcoTerms<T>::sinTerms - 1; term > 0; term--) {
+            sine = Tr::fmadd(sine, x2, Tr::set1((T) ncoSinCoefficients[term - 1]));
+        }
+        sine = Tr::apply(Mul(), sine, x);
+        Reg cosine = Tr::set1((T) ncoCosCoefficients[NcoTerms<T>::cosTerms - 1]);
+        MATRIX_DSP_UNROLL
+        for (unsigned term = NcoTerms<T>::cosTerms - 1; term > 0; term--) {
+            cosine = Tr::fmadd(cosine, x2, Tr::set1((T) ncoCosCoefficients[term - 1]));
+        }
+        Nt::rotateQuadrant(quadrant, cosine, sine);
+        phases = Nt::add(phases, Nt::lanePhase((uint64_t) w * step));
+        if (i + w <= n) {
+            Tr::store(cosOut + i, cosine);
+            Tr::store(sinOut + i, sine);
+        }
+        else {
+            T cosLanes[Tr::width];
+            T sinLanes[Tr::width];
+            Tr::store(cosLanes, cosine);
+            Tr::store(sinLanes, sine);
+            for (std::size_t lane = 0; i + lane < n; lane++) {
+                cosOut[i + lane] = cosLanes[lane];
+                sinOut[i + lane] = sinLanes[lane];
+            }
+        }
+    }
+}
+
+template <class Nt, class T>
+MATRIX_DSP_TARGET_AVX512 void ncoPolynomialAvx512(uint64_t phase, uint64_t step, std::size_t n, T *cosOut, T *sinOut) {
+    typedef typename Nt::Tr Tr;
+    typedef typename Nt::Reg Reg;
+    typedef typename Nt::Phase Phase;
+    const std::size_t w = Tr::width;
+    typename Nt::PhaseWord lanes[Tr::width];
+    for (std::size_t lane = 0; lane < w; lane++) {
+        lanes[lane] = Nt::lanePhase(phase + (uint64_t) lane * step);
+    }
+    Phase phases = Nt::loadPhases(lanes);
+    for (std::size_t i = 0; i < n; i += w) {
+        Phase quadrant;
+        Reg x = Nt::reduce(phases, quadrant);
+        Reg x2 = Tr::apply(Mul(), x, x);
+        Reg sine = Tr::set1((T) ncoSinCoefficients[NcoTerms<T>::sinTerms - 1]);
+        MATRIX_DSP_UNROLL
+        for (unsigned term = NcoTerms<T>::sinTerms - 1; term > 0; term--) {
+            sine = Tr::fmadd(sine, x2, Tr::set1((T) ncoSinCoefficients[term - 1]));
+        }
+        sine = Tr::apply(Mul(), sine, x);
+        Reg cosine = Tr::set1((T) ncoCosCoefficients[NcoTerms<T>::cosTerms - 1]);
+        MATRIX_DSP_UNROLL
+        for (unsigned term = NcoTerms<T>::cosTerms - 1; term > 0; term--) {
+            cosine = Tr::fmadd(cosine, x2, Tr::set1((T) ncoCosCoefficients[term - 1]));
+        }
+        Nt::rotateQuadrant(quadrant, cosine, sine);
+        phases = Nt::add(phases, Nt::lanePhase((uint64_t) w * step));
+        if (i + w <= n) {
+            Tr::store(cosOut + i, cosine);
+            Tr::store(sinOut + i, sine);
+        }
+        else {
+            T cosLanes[Tr::width];
+            T sinLanes[Tr::width];
+            Tr::store(cosLanes, cosine);
+            Tr::store(sinLanes, sine);
+            for (std::size_t lane = 0; i + lane < n; lane++) {
+                cosOut[i + lane] = cosLanes[lane];
+                sinOut[i + lane] = sinLanes[lane];
+            }
+        }
+    }
+}
+
+template <class Tr, class T>
+MATRIX_DSP_TARGET_AVX2 void ncoPhasorAvx2(const T *seedCos, const T *seedSin, T rotCos, T rotSin, std::size_t n, T *cosOut,
+                                          T *sinOut) {
+    typedef typename Tr::Reg Reg;
+    const std::size_t w = Tr::width;
+    Reg cosine = Tr::load(seedCos);
+    Reg sine = Tr::load(seedSin);
+    Reg rc = Tr::set1(rotCos);
+    Reg rs = Tr::set1(rotSin);
+    std::size_t i = 0;
+    for (; i + w <= n; i += w) {
+        Tr::store(cosOut + i, cosine);
+        Tr::store(sinOut + i, sine);
+        Reg nextCosine = Tr::fmadd(cosine, rc, Tr::apply(Mul(), Tr::apply(Sub(), Tr::set1(0), sine), rs));
+        sine = Tr::fmadd(cosine, rs, Tr::apply(Mul(), sine, rc));
+        cosine = nextCosine;
+    }
+    if (i < n) {
+        T cosLanes[Tr::width];
+        T sinLanes[Tr::width];
+        Tr::store(cosLanes, cosine);
+        Tr::store(sinLanes, sine);
+        for (std::size_t lane = 0; i + lane < n; lane++) {
+            cosOut[i + lane] = cosLanes[lane];
+            sinOut[i + lane] = sinLanes[lane];
+        }
+    }
+}
+
+template <class Tr, class T>
+MATRIX_DSP_TARGET_AVX512 void ncoPhasorAvx512(const T *seedCos, const T *seedSin, T rotCos, T rotSin, std::size_t n, T *cosOut,
+                                              T *sinOut) {
+    typedef typename Tr::Reg Reg;
+    const std::size_t w = Tr::width;
+    Reg cosine = Tr::load(seedCos);
+    Reg sine = Tr::load(seedSin);
+    Reg rc = Tr::set1(rotCos);
+    Reg rs = Tr::set1(rotSin);
+    std::size_t i = 0;
+    for (; i + w <= n; i += w) {
+        Tr::store(cosOut + i, cosine);
+        Tr::store(sinOut + i, sine);
+        Reg nextCosine = Tr::fmadd(cosine, rc, Tr::apply(Mul(), Tr::apply(Sub(), Tr::set1(0), sine), rs));
+        sine = Tr::fmadd(cosine, rs, Tr::apply(Mul(), sine, rc));
+        cosine = nextCosine;
+    }
+    if (i < n) {
+        T cosLanes[Tr::width];
+        T sinLanes[Tr::width];
+        Tr::store(cosLanes, cosine);
+        Tr::store(sinLanes, sine);
+        for (std::size_t lane = 0; i + lane < n; lane++) {
+            cosOut[i + lane] = cosLanes[lane];
+            sinOut[i + lane] = sinLanes[lane];
+        }
+    }
+}
+
+#endif // MATRIX_DSP_X86_SIMD
+
+/*****************************************************************************************
+                                        Dispatchers
+*****************************************************************************************/
+template <class T>
+void ncoPolynomialDispatch(uint64_t phase, uint64_t step, std::size_t n, T *cosOut, T *sinOut, std::false_type) {
+    ncoPolynomialGeneric(phase, step, n, cosOut, sinOut);
+}
+
+template <class T>
+void ncoPolynomialDispatch(uint64_t phase, uint64_t step, std::size_t n, T *cosOut, T *sinOut, std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && Traits<Isa::Avx512, T>::available()) {
+        return ncoPolynomialAvx512<NcoTraits<Isa::Avx512, T> >(phase, step, n, cosOut, sinOut);
+    }
+    if (isa >= Isa::Avx2 && Traits<Isa::Avx2, T>::available()) {
+        return ncoPolynomialAvx2<NcoTraits<Isa::Avx2, T> >(phase, step, n, cosOut, sinOut);
+    }
+#endif
+    ncoPolynomialGeneric(phase, step, n, cosOut, sinOut);
+}
+
+/**
+ * \brief Starts "lanes" phasors at "phase", "phase" + one step, and so on.
+ *
+ * \param rotations e^(j k w) for k from 0 to at least "lanes", where w is the phase step.
+ */
+template <class T>
+void ncoPhasorSeeds(uint64_t phase, const std::complex<double> *rotations, unsigned lanes, T *seedCos, T *seedSin) {
+    std::complex<double> start = std::polar(1.0, ncoRadians(phase));
+    for (unsigned lane = 0; lane < lanes; lane++) {
+        std::complex<double> seed = start * rotations[lane];
+        seedCos[lane] = (T) seed.real();
+        seedSin[lane] = (T) seed.imag();
+    }
+}
+
+template <class T>
+void ncoPhasorDispatch(uint64_t phase, const std::complex<double> *rotations, std::size_t n, T *cosOut, T *sinOut,
+                       std::false_type) {
+    T seedCos[1];
+    T seedSin[1];
+    ncoPhasorSeeds(phase, rotations, 1, seedCos, seedSin);
+    ncoPhasorGeneric(seedCos, seedSin, (T) rotations[1].real(), (T) rotations[1].imag(), n, cosOut, sinOut);
+}
+
+template <class T>
+void ncoPhasorDispatch(uint64_t phase, const std::complex<double> *rotations, std::size_t n, T *cosOut, T *sinOut,
+                       std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && Traits<Isa::Avx512, T>::available()) {
+        typedef Traits<Isa::Avx512, T> Tr;
+        T seedCos[Tr::width];
+        T seedSin[Tr::width];
+        ncoPhasorSeeds(phase, rotations, Tr::width, seedCos, seedSin);
+        return ncoPhasorAvx512<Tr>(seedCos, seedSin, (T) rotations[Tr::width].real(), (T) rotations[Tr::width].imag(), n,
+                                   cosOut, sinOut);
+    }
+    if (isa >= Isa::Avx2 && Traits<Isa::Avx2, T>::available()) {
+        typedef Traits<Isa::Avx2, T> Tr;
+        T seedCos[Tr::width];
+        T seedSin[Tr::width];
+        ncoPhasorSeeds(phase, rotations, Tr::width, seedCos, seedSin);
+        return ncoPhasorAvx2<Tr>(seedCos, seedSin, (T) rotations[Tr::width].real(), (T) rotations[Tr::width].imag(), n,
+                                 cosOut, sinOut);
+    }
+#endif
+    ncoPhasorDispatch(phase, rotations, n, cosOut, sinOut, std::false_type());
+}
+
+}
+
+/**
+ * \brief Numerically controlled oscillator.  Generates e^(j phase) while the phase goes up by
+ *      2 pi freq / sampleFreq per sample, and carries on from where it left off on the next
+ *      call.  See Nco.h for the engines.
+ */
+template <class T>
+class Nco {
+    uint64_t phaseWord;
+    uint64_t step;
+    // 2 pi freq / sampleFreq as requested, before it's rounded to "step"
+    double increment;
+    NcoEngine ncoEngine;
+    // e^(j k w) for k = 0 to 16, the widest register, where w is the phase step.  For the
+    // phasor engine.
+    std::complex<double> rotations[17];
+
+    /**
+     * \brief Writes the cosines and sines of the next "n" phases, at most simd::ncoBlockSize, and
+     *      advances the phase.
+     */
+    void nextBlock(unsigned n, T *cosOut, T *sinOut) {
+        switch (ncoEngine) {
+            case NcoEngine::Polynomial:
+                simd::ncoPolynomialDispatch(phaseWord, step, n, cosOut, sinOut, simd::HasNcoKernel<T>());
+                break;
+            case NcoEngine::Phasor:
+                simd::ncoPhasorDispatch(phaseWord, rotations, n, cosOut, sinOut, simd::HasNcoKernel<T>());
+                break;
+            case NcoEngine::Table:
+                simd::ncoTableGeneric(phaseWord, step, n, cosOut, sinOut);
+                break;
+        }
+        phaseWord += (uint64_t) n * step;
+    }
+
+    static uint64_t toPhaseWord(double cycles) {
+        cycles -= std::floor(cycles);
+        // A tiny negative number of cycles rounds up to a whole one
+        if (cycles >= 1) {
+            cycles = 0;
+        }
+        return (uint64_t) (cycles * 18446744073709551616.0);
+    }
+
+public:
+    /**
+     * \brief Constructor.
+     *
+     * \param freq The tone frequency.  Negative frequencies are fine.
+     * \param sampleFreq The sample frequency.  Defaults to 1 Hz.
+     * \param phase The starting phase, in radians.  Defaults to 0.
+     * \param engine How the sines and cosines are computed.  Defaults to NcoEngine::Polynomial.
+     */
+    Nco(T freq, T sampleFreq = 1, T phase = 0, NcoEngine engine = NcoEngine::Polynomial) : phaseWord(0), step(0), increment(0), ncoEngine(engine) {
+        setFrequency(freq, sampleFreq);
+        setPhase(phase);
+    }
+
+    /**
+     * \brief Changes the frequency without changing the phase.
+     */
+    void setFrequency(T freq, T sampleFreq = 1) {
+        assert(sampleFreq > 0);
+        step = toPhaseWord((double) freq / sampleFreq);
+        increment = 2 * M_PI * freq / sampleFreq;
+        for (unsigned k = 0; k < 17; k++) {
+            rotations[k] = std::polar(1.0, simd::ncoRadians((int64_t) (k * step)));
+        }
+    }
+
+    /**
+     * \brief Returns the frequency that is actually generated, which is the requested one rounded
+     *      to a multiple of sampleFreq / 2^64.
+     */
+    T frequency(T sampleFreq = 1) const {return (T) ((int64_t) step / 18446744073709551616.0 * sampleFreq);}
+
+    /**
+     * \brief Sets the phase of the next sample, in radians.
+     */
+    void setPhase(T phase) {phaseWord = toPhaseWord(phase / (2 * M_PI));}
+
+    /**
+     * \brief Returns the phase of the next sample, in radians from 0 to 2 pi.
+     */
+    T phase() const {return (T) simd::ncoRadians(phaseWord);}
+
+    /**
+     * \brief Returns the phase step per sample, 2 pi freq / sampleFreq radians.  It isn't wrapped,
+     *      so phase + n * phaseIncrement() carries on from "phase" the way the tone does.
+     */
+    T phaseIncrement() const {return (T) increment;}
+
+    NcoEngine engine() const {return ncoEngine;}
+
+    /**
+     * \brief Changes the engine.  The phase carries on from where it was.
+     */
+    void setEngine(NcoEngine engine) {ncoEngine = engine;}
+
+    /**
+     * \brief Writes the next "n" samples of the tone to "output".
+     */
+    void generate(std::complex<T> *output, unsigned n) {
+        ScratchBuffer<T> parts(2 * simd::ncoBlockSize);
+        T *cosine = parts.data();
+        T *sine = cosine + simd::ncoBlockSize;
+        for (unsigned start = 0; start < n; start += simd::ncoBlockSize) {
+            unsigned len = std::min(n - start, simd::ncoBlockSize);
+            nextBlock(len, cosine, sine);
+            for (unsigned index = 0; index < len; index++) {
+                output[start + index] = std::complex<T>(cosine[index], sine[index]);
+            }
+        }
+    }
+
+    /**
+     * \brief Multiplies "n" samples of "data" by the next "n" samples of the tone, which shifts
+     *      them up by the tone frequency.  Use a negative frequency to shift down.
+     */
+    void mix(std::complex<T> *data, unsigned n) {
+        ScratchBuffer<T> parts(2 * simd::ncoBlockSize);
+        T *cosine = parts.data();
+        T *sine = cosine + simd::ncoBlockSize;
+        for (unsigned start = 0; start < n; start += simd::ncoBlockSize) {
+            unsigned len = std::min(n - start, simd::ncoBlockSize);
+            nextBlock(len, cosine, sine);
+            std::complex<T> *block = data + start;
+            // Written out, because std::complex's operator* checks for infinities and NaNs
+            for (unsigned index = 0; index < len; index++) {
+                T re = block[index].real();
+                T im = block[index].imag();
+                block[index] = std::complex<T>(re * cosine[index] - im * sine[index], re * sine[index] + im * cosine[index]);
+            }
+        }
+    }
+
+    /**
+     * \brief Multiplies "n" real samples by the next "n" samples of the tone.  "output" may not
+     *      overlap "input".
+     */
+    void mix(const T *input, std::complex<T> *output, unsigned n) {
+        ScratchBuffer<T> parts(2 * simd::ncoBlockSize);
+        T *cosine = parts.data();
+        T *sine = cosine + simd::ncoBlockSize;
+        for (unsigned start = 0; start < n; start += simd::ncoBlockSize) {
+            unsigned len = std::min(n - start, simd::ncoBlockSize);
+            nextBlock(len, cosine, sine);
+            for (unsigned index = 0; index < len; index++) {
+                output[start + index] = std::complex<T>(input[start + index] * cosine[index], input[start + index] * sine[index]);
+            }
+        }
+    }
+
+    /**
+     * \brief Writes the cosines (real parts) of the next "n" samples of the tone to "output".
+     */
+    void cos(T *output, unsigned n) {
+        ScratchBuffer<T> sine(simd::ncoBlockSize);
+        for (unsigned start = 0; start < n; start += simd::ncoBlockSize) {
+            nextBlock(std::min(n - start, simd::ncoBlockSize), output + start, sine.data());
+        }
+    }
+
+    /**
+     * \brief Writes the sines (imaginary parts) of the next "n" samples of the tone to "output".
+     */
+    void sin(T *output, unsigned n) {
+        ScratchBuffer<T> cosine(simd::ncoBlockSize);
+        for (unsigned start = 0; start < n; start += simd::ncoBlockSize) {
+            nextBlock(std::min(n - start, simd::ncoBlockSize), cosine.data(), output + start);
+        }
+    }
+
+    /**
+     * \brief Fills "output" with the next samples of the tone.
+     *
+     * \return Reference to "output".
+     */
+    template <class Alloc>
+    Vector<std::complex<T>, Alloc> & generate(Vector<std::complex<T>, Alloc> &output) {
+        generate(output.vec.data(), output.size());
+        return output;
+    }
+
+    /**
+     * \brief Multiplies "data" by the next samples of the tone.
+     *
+     * \return Reference to "data".
+     */
+    template <class Alloc>
+    Vector<std::complex<T>, Alloc> & mix(Vector<std::complex<T>, Alloc> &data) {
+        mix(data.vec.data(), data.size());
+        return data;
+    }
+
+    /**
+     * \brief Multiplies real "input" by the next samples of the tone.
+     *
+     * \param output The complex result.  Resized to the size of "input".
+     * \return Reference to "output".
+     */
+    template <class InputAlloc, class OutputAlloc>
+    Vector<std::complex<T>, OutputAlloc> & mix(const Vector<T, InputAlloc> &input, Vector<std::complex<T>, OutputAlloc> &output) {
+        output.resize(input.size());
+        output.rowVector = input.rowVector;
+        mix(input.vec.data(), output.vec.data(), input.size());
+        return output;
+    }
+};
+
+}
+
+#endif /* Nco_h */
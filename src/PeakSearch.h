@@ -0,0 +1,313 @@
+//
+//  PeakSearch.h
+//  MatrixDSP
+//
+//  Searches of complex data, such as FFT outputs, by magnitude.  Magnitudes are compared as
+//  squared magnitudes (re^2 + im^2), which orders them the same way without a square root per
+//  element, so the search runs at the speed of the loads.
+//
+//  The argmax/argmin kernels keep the best squared magnitude seen in each lane of a register
+//  along with its index, and pick between the lanes at the end, so the data is read once.
+//  There are AVX2 and AVX-512 kernels for float and double, selected at run time like the ones
+//  in Simd.h.  Other types and CPUs without AVX2 use a plain loop.
+//
+
+#ifndef PeakSearch_h
+#define PeakSearch_h
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "Simd.h"
+
+namespace MatrixDSP {
+namespace simd {
+
+/**
+ * \brief Returns the squared magnitude of "val", computed the way the kernels compute it.
+ *      std::norm() may scale the parts, or take the square of std::abs().
+ */
+template <class T>
+inline T squaredMagnitude(const std::complex<T> &val) {
+    return val.real() * val.real() + val.imag() * val.imag();
+}
+
+/**
+ * \brief Orders for the searches: the element with the largest or the smallest magnitude.
+ */
+struct LargerNorm {
+    template <class T>
+    static bool better(T a, T b) {return b < a;}
+};
+
+struct SmallerNorm {
+    template <class T>
+    static bool better(T a, T b) {return a < b;}
+};
+
+/**
+ * \brief True if there are search kernels for type "T".
+ */
+template <class T>
+struct HasNormSearchKernel : std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value> {};
+
+template <class Better, class T>
+std::size_t normSearchGeneric(const std::complex<T> *data, std::size_t n) {
+    std::size_t bestIndex = 0;
+    T best = squaredMagnitude(data[0]);
+    for (std::size_t index = 1; index < n; index++) {
+        T norm = squaredMagnitude(data[index]);
+        if (Better::better(norm, best)) {
+            best = norm;
+            bestIndex = index;
+        }
+    }
+    return bestIndex;
+}
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+/*****************************************************************************************
+                                        Kernels
+*****************************************************************************************/
+// NormTraits<isa, T> computes the squared magnitudes of "width" complex values at a time.
+// They don't come out in order, so firstIndexes() holds the matching indexes.  keep<P>()
+// replaces the lanes of "best" for which comparison P of "norms" and "best" is true, and their
+// indexes.  The ordered, non-signalling comparisons are false for NaNs, so NaNs are skipped.
+
+template <class Better>
+struct ComparePredicate;
+
+template <>
+struct ComparePredicate<LargerNorm> {static const int value = _CMP_GT_OQ;};
+
+template <>
+struct ComparePredicate<SmallerNorm> {static const int value = _CMP_LT_OQ;};
+
+template <Isa isa, class T>
+struct NormTraits;
+
+template <>
+struct NormTraits<Isa::Avx2, float> {
+    typedef Traits<Isa::Avx2, float> Tr;
+    typedef __m256 Reg;
+    typedef __m256i Index;
+    typedef int32_t IndexScalar;
+    static const unsigned width = 8;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg norms(const std::complex<float> *p) {
+        Reg a = _mm256_loadu_ps((const float *) p);
+        Reg b = _mm256_loadu_ps((const float *) (p + 4));
+        // Elements 0, 1, 4, 5, 2, 3, 6, 7
+        return _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+    }
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Index firstIndexes() {return _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Index zeroIndexes() {return _mm256_setzero_si256();}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Index step(Index a) {return _mm256_add_epi32(a, _mm256_set1_epi32(width));}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void storeIndexes(IndexScalar *p, Index a) {_mm256_storeu_si256((__m256i *) p, a);}
+    template <int P>
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void keep(Reg norms, Index indexes, Reg &best, Index &bestIndexes) {
+        Reg mask = _mm256_cmp_ps(norms, best, P);
+        best = _mm256_blendv_ps(best, norms, mask);
+        bestIndexes = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndexes), _mm256_castsi256_ps(indexes), mask));
+    }
+};
+
+template <>
+struct NormTraits<Isa::Avx2, double> {
+    typedef Traits<Isa::Avx2, double> Tr;
+    typedef __m256d Reg;
+    typedef __m256i Index;
+    typedef int64_t IndexScalar;
+    static const unsigned width = 4;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg norms(const std::complex<double> *p) {
+        Reg a = _mm256_loadu_pd((const double *) p);
+        Reg b = _mm256_loadu_pd((const double *) (p + 2));
+        // Elements 0, 2, 1, 3
+        return _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+    }
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Index firstIndexes() {return _mm256_setr_epi64x(0, 2, 1, 3);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Index zeroIndexes() {return _mm256_setzero_si256();}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Index step(Index a) {return _mm256_add_epi64(a, _mm256_set1_epi64x(width));}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void storeIndexes(IndexScalar *p, Index a) {_mm256_storeu_si256((__m256i *) p, a);}
+    template <int P>
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void keep(Reg norms, Index indexes, Reg &best, Index &bestIndexes) {
+        Reg mask = _mm256_cmp_pd(norms, best, P);
+        best = _mm256_blendv_pd(best, norms, mask);
+        bestIndexes = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(bestIndexes), _mm256_castsi256_pd(indexes), mask));
+    }
+};
+
+template <>
+struct NormTraits<Isa::Avx512, float> {
+    typedef Traits<Isa::Avx512, float> Tr;
+    typedef __m512 Reg;
+    typedef __m512i Index;
+    typedef int32_t IndexScalar;
+    static const unsigned width = 16;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg norms(const std::complex<float> *p) {
+        Reg a = _mm512_loadu_ps((const float *) p);
+        Reg b = _mm512_loadu_ps((const float *) (p + 8));
+        Reg re = _mm512_permutex2var_ps(a, _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30), b);
+        Reg im = _mm512_permutex2var_ps(a, _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31), b);
+        return _mm512_add_ps(_mm512_mul_ps(re, re), _mm512_mul_ps(im, im));
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Index firstIndexes() {
+        return _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Index zeroIndexes() {return _mm512_setzero_si512();}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Index step(Index a) {return _mm512_add_epi32(a, _mm512_set1_epi32(width));}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void storeIndexes(IndexScalar *p, Index a) {_mm512_storeu_si512((void *) p, a);}
+    template <int P>
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void keep(Reg norms, Index indexes, Reg &best, Index &bestIndexes) {
+        __mmask16 mask = _mm512_cmp_ps_mask(norms, best, P);
+        best = _mm512_mask_blend_ps(mask, best, norms);
+        bestIndexes = _mm512_mask_blend_epi32(mask, bestIndexes, indexes);
+    }
+};
+
+template <>
+struct NormTraits<Isa::Avx512, double> {
+    typedef Traits<Isa::Avx512, double> Tr;
+    typedef __m512d Reg;
+    typedef __m512i Index;
+    typedef int64_t IndexScalar;
+    static const unsigned width = 8;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg norms(const std::complex<double> *p) {
+        Reg a = _mm512_loadu_pd((const double *) p);
+        Reg b = _mm512_loadu_pd((const double *) (p + 4));
+        Reg re = _mm512_permutex2var_pd(a, _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14), b);
+        Reg im = _mm512_permutex2var_pd(a, _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15), b);
+        return _mm512_add_pd(_mm512_mul_pd(re, re), _mm512_mul_pd(im, im));
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Index firstIndexes() {return _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Index zeroIndexes() {return _mm512_setzero_si512();}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Index step(Index a) {return _mm512_add_epi64(a, _mm512_set1_epi64(width));}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void storeIndexes(IndexScalar *p, Index a) {_mm512_storeu_si512((void *) p, a);}
+    template <int P>
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void keep(Reg norms, Index indexes, Reg &best, Index &bestIndexes) {
+        __mmask8 mask = _mm512_cmp_pd_mask(norms, best, P);
+        best = _mm512_mask_blend_pd(mask, best, norms);
+        bestIndexes = _mm512_mask_blend_epi64(mask, bestIndexes, indexes);
+    }
+};
+
+/**
+ * \brief Picks the best of the lanes, and of the elements from "tail" on, which the kernels
+ *      didn't cover.  Equal lanes go to the lowest index, so the result is the first best
+ *      element like the scalar search finds.
+ */
+template <class Better, unsigned W, class T, class IndexScalar>
+std::size_t normSearchFinish(const std::complex<T> *data, std::size_t n, std::size_t tail, const T *lanes,
+                             const IndexScalar *laneIndexes) {
+    T best = lanes[0];
+    std::size_t bestIndex = (std::size_t) laneIndexes[0];
+    for (unsigned lane = 1; lane < W; lane++) {
+        if (Better::better(lanes[lane], best) || (lanes[lane] == best && (std::size_t) laneIndexes[lane] < bestIndex)) {
+            best = lanes[lane];
+            bestIndex = (std::size_t) laneIndexes[lane];
+        }
+    }
+    for (std::size_t index = tail; index < n; index++) {
+        T norm = squaredMagnitude(data[index]);
+        if (Better::better(norm, best)) {
+            best = norm;
+            bestIndex = index;
+        }
+    }
+    return bestIndex;
+}
+
+// There is one copy per instruction set because the target attribute has to be a literal.
+// The lanes all start out with element 0.
+
+template <class Nt, class Better, class T>
+MATRIX_DSP_TARGET_AVX2 std::size_t normSearchAvx2(const std::complex<T> *data, std::size_t n) {
+    typedef typename Nt::Reg Reg;
+    typedef typename Nt::Index Index;
+    const std::size_t w = Nt::width;
+    Reg best = Nt::Tr::set1(squaredMagnitude(data[0]));
+    Index bestIndexes = Nt::zeroIndexes();
+    Index indexes = Nt::firstIndexes();
+    std::size_t j = 0;
+    for (; j + w <= n; j += w) {
+        Nt::template keep<ComparePredicate<Better>::value>(Nt::norms(data + j), indexes, best, bestIndexes);
+        indexes = Nt::step(indexes);
+    }
+    T lanes[Nt::width];
+    typename Nt::IndexScalar laneIndexes[Nt::width];
+    Nt::Tr::store(lanes, best);
+    Nt::storeIndexes(laneIndexes, bestIndexes);
+    return normSearchFinish<Better, Nt::width>(data, n, j, lanes, laneIndexes);
+}
+
+template <class Nt, class Better, class T>
+MATRIX_DSP_TARGET_AVX512 std::size_t normSearchAvx512(const std::complex<T> *data, std::size_t n) {
+    typedef typename Nt::Reg Reg;
+    typedef typename Nt::Index Index;
+    const std::size_t w = Nt::width;
+    Reg best = Nt::Tr::set1(squaredMagnitude(data[0]));
+    Index bestIndexes = Nt::zeroIndexes();
+    Index indexes = Nt::firstIndexes();
+    std::size_t j = 0;
+    for (; j + w <= n; j += w) {
+        Nt::template keep<ComparePredicate<Better>::value>(Nt::norms(data + j), indexes, best, bestIndexes);
+        indexes = Nt::step(indexes);
+    }
+    T lanes[Nt::width];
+    typename Nt::IndexScalar laneIndexes[Nt::width];
+    Nt::Tr::store(lanes, best);
+    Nt::storeIndexes(laneIndexes, bestIndexes);
+    return normSearchFinish<Better, Nt::width>(data, n, j, lanes, laneIndexes);
+}
+
+#endif // MATRIX_DSP_X86_SIMD
+
+/*****************************************************************************************
+                                        Dispatchers
+*****************************************************************************************/
+template <class Better, class T>
+std::size_t normSearchDispatch(const std::complex<T> *data, std::size_t n, std::false_type) {
+    return normSearchGeneric<Better>(data, n);
+}
+
+template <class Better, class T>
+std::size_t normSearchDispatch(const std::complex<T> *data, std::size_t n, std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    // The lanes count in 32 bit integers for float
+    if (n <= (std::size_t) std::numeric_limits<int32_t>::max()) {
+        Isa isa = activeIsa();
+        if (isa >= Isa::Avx512 && Traits<Isa::Avx512, T>::available()) {
+            return normSearchAvx512<NormTraits<Isa::Avx512, T>, Better>(data, n);
+        }
+        if (isa >= Isa::Avx2 && Traits<Isa::Avx2, T>::available()) {
+            return normSearchAvx2<NormTraits<Isa::Avx2, T>, Better>(data, n);
+        }
+    }
+#endif
+    return normSearchGeneric<Better>(data, n);
+}
+
+/**
+ * \brief Returns the index of the first of the "n" elements of "data" with the largest
+ *      magnitude.  "n" must be at least 1.
+ */
+template <class T>
+std::size_t maxNormIndex(const std::complex<T> *data, std::size_t n) {
+    return normSearchDispatch<LargerNorm>(data, n, HasNormSearchKernel<T>());
+}
+
+/**
+ * \brief Returns the index of the first of the "n" elements of "data" with the smallest
+ *      magnitude.  "n" must be at least 1.
+ */
+template <class T>
+std::size_t minNormIndex(const std::complex<T> *data, std::size_t n) {
+    return normSearchDispatch<SmallerNorm>(data, n, HasNormSearchKernel<T>());
+}
+
+}
+}
+
+#endif /* PeakSearch_h */
@@ -0,0 +1,342 @@
+//
+//  Resampler.h
+//  MatrixDSP
+//
+//  Polyphase FIR interpolation, decimation and rational (L/M) resampling that keep their state
+//  between calls, so a long stream can be resampled a block at a time.
+//
+//  Resampling by L/M is the same as inserting L - 1 zeros after each sample (upsample()),
+//  filtering with the taps and keeping every M-th sample (downsample()), but the filter only
+//  runs where it's needed: the zeros are never multiplied, and nor are the outputs that would be
+//  thrown away.  The taps are split into L branches, branch p holding taps p, p + L, p + 2L and
+//  so on, and each output is one branch's dot product with the latest input samples.  The
+//  outputs that use the same branch read windows of the input a fixed distance apart, so each
+//  branch's outputs for a block are one matrix-vector product (see Gemv.h) with the windows as
+//  the overlapping rows of the matrix.
+//
+//  The samples can be real or complex, and the taps are real.  Complex samples are split into
+//  their real and imaginary parts, which are filtered separately.
+//
+
+#ifndef Resampler_h
+#define Resampler_h
+
+#include <algorithm>
+#include <cassert>
+#include <complex>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "Gemv.h"
+#include "ScratchArena.h"
+#include "Vector.h"
+
+namespace MatrixDSP {
+
+/**
+ * \brief The type of the taps for samples of type "T": "T" itself, or the real type of complex
+ *      samples.
+ */
+template <class T>
+struct ResamplerTap {
+    typedef T type;
+};
+
+template <class T>
+struct ResamplerTap< std::complex<T> > {
+    typedef T type;
+};
+
+/**
+ * \brief Rational polyphase resampler.  Changes the sample rate by "interpolation" /
+ *      "decimation".
+ *
+ * The output is what upsampling by "interpolation", filtering with the taps and downsampling
+ * by "decimation" would give, with the first output at the same time as the first input.  The
+ * taps are used as they are, so to keep the amplitude of the signal the filter should have a
+ * passband gain of "interpolation".  The filter starts with zeros in its history.
+ */
+template <class T>
+class Resampler {
+public:
+    typedef typename ResamplerTap<T>::type tap_type;
+
+private:
+    unsigned interpolation;
+    unsigned decimation;
+    unsigned tapCount;
+    unsigned branchLen;             // Taps per branch, rounded up
+    unsigned phases;                // The number of branches that the outputs cycle through
+    std::vector<tap_type> branches; // Branch p at p * branchLen, in reverse order
+    std::vector<T> history;         // The latest branchLen - 1 input samples
+    uint64_t offset;                // Time of the next output from the start of the next block, in 1/interpolation samples
+
+    const tap_type * branch(unsigned p) const {return branches.data() + (std::size_t) p * branchLen;}
+
+    /**
+     * \brief Computes the outputs of one branch: "count" windows of "line", starting at "start"
+     *      and "stride" apart, dotted with the branch.  For real samples.
+     */
+    void branchProducts(const T *line, std::size_t, std::size_t start, std::size_t stride, unsigned p, std::size_t count,
+                        T *output, std::false_type) const {
+        simd::gemv(count, branchLen, line + start, stride, branch(p), output);
+    }
+
+    /**
+     * \brief As above for complex samples.  "line" has the real parts of the samples followed by
+     *      the imaginary parts, "lineLen" of each.
+     */
+    void branchProducts(const tap_type *line, std::size_t lineLen, std::size_t start, std::size_t stride, unsigned p,
+                        std::size_t count, tap_type *output, std::true_type) const {
+        simd::gemv(count, branchLen, line + start, stride, branch(p), output);
+        simd::gemv(count, branchLen, line + lineLen + start, stride, branch(p), output + count);
+    }
+
+    /**
+     * \brief Runs the branches over "line", the history followed by the new samples.
+     *
+     * \param line The samples, or for complex samples their real and imaginary parts.
+     */
+    template <class LineType, class IsComplex>
+    void run(const LineType *line, std::size_t lineLen, std::size_t count, T *output, IsComplex isComplex) {
+        const std::size_t perBranch = (count + phases - 1) / phases;
+        const std::size_t parts = IsComplex::value ? 2 : 1;
+        ScratchBuffer<LineType> products(phases > 1 || IsComplex::value ? parts * perBranch : 0);
+        for (std::size_t first = 0; first < std::min<std::size_t>(phases, count); first++) {
+            uint64_t time = offset + first * decimation;
+            std::size_t branchCount = (count - first + phases - 1) / phases;
+            LineType *branchOutput = products.size() ? products.data() : (LineType *) (output + first);
+            // The outputs that use this branch are "phases" apart, and their windows are
+            // decimation / gcd apart
+            branchProducts(line, lineLen, (std::size_t) (time / interpolation), (std::size_t) phases * decimation / interpolation,
+                           (unsigned) (time % interpolation), branchCount, branchOutput, isComplex);
+            if (products.size()) {
+                scatter(products.data(), branchCount, output + first, isComplex);
+            }
+        }
+    }
+
+    void scatter(const T *products, std::size_t count, T *output, std::false_type) const {
+        for (std::size_t index = 0; index < count; index++) {
+            output[index * phases] = products[index];
+        }
+    }
+
+    void scatter(const tap_type *products, std::size_t count, T *output, std::true_type) const {
+        for (std::size_t index = 0; index < count; index++) {
+            output[index * phases] = T(products[index], products[count + index]);
+        }
+    }
+
+    /**
+     * \brief Filters "line", which is the history followed by "len" new samples.
+     */
+    void filterLine(const T *line, std::size_t lineLen, std::size_t count, T *output, std::false_type) {
+        run(line, lineLen, count, output, std::false_type());
+    }
+
+    void filterLine(const T *line, std::size_t lineLen, std::size_t count, T *output, std::true_type) {
+        ScratchBuffer<tap_type> parts(2 * lineLen);
+        for (std::size_t index = 0; index < lineLen; index++) {
+            parts[index] = line[index].real();
+            parts[lineLen + index] = line[index].imag();
+        }
+        run(parts.data(), lineLen, count, output, std::true_type());
+    }
+
+    static unsigned gcd(unsigned a, unsigned b) {
+        while (b) {
+            unsigned r = a % b;
+            a = b;
+            b = r;
+        }
+        return a;
+    }
+
+public:
+    /**
+     * \brief Constructor.
+     *
+     * \param taps The filter taps, at the upsampled rate.
+     * \param numTaps The number of taps.
+     * \param interpolation The factor to upsample by.
+     * \param decimation The factor to downsample by.
+     */
+    Resampler(const tap_type *taps, unsigned numTaps, unsigned interpolation, unsigned decimation) :
+            interpolation(interpolation), decimation(decimation), tapCount(numTaps) {
+        assert(numTaps > 0);
+        assert(interpolation > 0 && decimation > 0);
+        branchLen = (numTaps + interpolation - 1) / interpolation;
+        phases = interpolation / gcd(interpolation, decimation);
+        branches.assign((std::size_t) interpolation * branchLen, tap_type());
+        for (unsigned p = 0; p < interpolation; p++) {
+            for (unsigned index = 0; index < branchLen; index++) {
+                std::size_t tap = p + (std::size_t) (branchLen - 1 - index) * interpolation;
+                if (tap < numTaps) {
+                    branches[(std::size_t) p * branchLen + index] = taps[tap];
+                }
+            }
+        }
+        history.resize(branchLen - 1);
+        reset();
+    }
+
+    /**
+     * \brief Constructor.
+     *
+     * \param taps The filter taps, at the upsampled rate.
+     * \param interpolation The factor to upsample by.
+     * \param decimation The factor to downsample by.
+     */
+    template <class Alloc>
+    Resampler(const Vector<tap_type, Alloc> &taps, unsigned interpolation, unsigned decimation) :
+            Resampler(taps.vec.data(), taps.size(), interpolation, decimation) {}
+
+    /**
+     * \brief Clears the history, so the next sample starts a new stream.
+     */
+    void reset() {
+        std::fill(history.begin(), history.end(), T());
+        offset = 0;
+    }
+
+    unsigned interpolationRate() const {return interpolation;}
+    unsigned decimationRate() const {return decimation;}
+    unsigned numTaps() const {return tapCount;}
+
+    /**
+     * \brief Returns the number of samples that the next call to filter() will output for
+     *      "inputLen" input samples.
+     */
+    unsigned outputLength(unsigned inputLen) const {
+        uint64_t end = (uint64_t) inputLen * interpolation;
+        return offset < end ? (unsigned) ((end - offset + decimation - 1) / decimation) : 0;
+    }
+
+    /**
+     * \brief Resamples a block of samples, carrying on from the previous block.
+     *
+     * \param input The samples to resample.
+     * \param len The number of input samples.
+     * \param output The resampled samples, outputLength(len) of them.  Must not overlap "input".
+     * \return The number of output samples.
+     */
+    unsigned filter(const T *input, unsigned len, T *output) {
+        unsigned count = outputLength(len);
+        std::size_t lineLen = history.size() + len;
+        ScratchBuffer<T> line(lineLen);
+        std::copy(history.begin(), history.end(), line.data());
+        std::copy(input, input + len, line.data() + history.size());
+        if (count) {
+            filterLine(line.data(), lineLen, count, output, std::integral_constant<bool, !std::is_same<T, tap_type>::value>());
+        }
+        std::copy(line.data() + len, line.data() + lineLen, history.begin());
+        offset = offset + (uint64_t) count * decimation - (uint64_t) len * interpolation;
+        return count;
+    }
+
+    /**
+     * \brief Resamples a block of samples, carrying on from the previous block.
+     *
+     * \param input The samples to resample.
+     * \param output The resampled samples.  Resized to the number of outputs.  Must not be
+     *      "input".
+     * \return Reference to "output".
+     */
+    template <class InputAlloc, class OutputAlloc>
+    Vector<T, OutputAlloc> & filter(const Vector<T, InputAlloc> &input, Vector<T, OutputAlloc> &output) {
+        output.resize(outputLength(input.size()));
+        output.rowVector = input.rowVector;
+        filter(input.vec.data(), input.size(), output.vec.data());
+        return output;
+    }
+};
+
+/**
+ * \brief Polyphase interpolator.  Raises the sample rate by "rate" and filters, without
+ *      multiplying the zeros that upsample() would insert.
+ */
+template <class T>
+class Interpolator : public Resampler<T> {
+public:
+    typedef typename Resampler<T>::tap_type tap_type;
+
+    /**
+     * \brief Constructor.
+     *
+     * \param taps The filter taps, at the output rate.  For unity gain the passband gain
+     *      should be "rate".
+     * \param numTaps The number of taps.
+     * \param rate The factor to upsample by.
+     */
+    Interpolator(const tap_type *taps, unsigned numTaps, unsigned rate) : Resampler<T>(taps, numTaps, rate, 1) {}
+
+    template <class Alloc>
+    Interpolator(const Vector<tap_type, Alloc> &taps, unsigned rate) : Resampler<T>(taps, rate, 1) {}
+};
+
+/**
+ * \brief Polyphase decimator.  Filters and lowers the sample rate by "rate", computing only
+ *      the outputs that are kept.
+ */
+template <class T>
+class Decimator : public Resampler<T> {
+public:
+    typedef typename Resampler<T>::tap_type tap_type;
+
+    /**
+     * \brief Constructor.
+     *
+     * \param taps The filter taps, at the input rate.
+     * \param numTaps The number of taps.
+     * \param rate The factor to downsample by.
+     */
+    Decimator(const tap_type *taps, unsigned numTaps, unsigned rate) : Resampler<T>(taps, numTaps, 1, rate) {}
+
+    template <class Alloc>
+    Decimator(const Vector<tap_type, Alloc> &taps, unsigned rate) : Resampler<T>(taps, 1, rate) {}
+};
+
+/**
+ * \brief Interpolates "input" by "rate" with a fresh Interpolator.
+ *
+ * \param output The interpolated samples.  Must not be "input".
+ * \return Reference to "output".
+ */
+template <class T, class TapAlloc, class InputAlloc, class OutputAlloc>
+Vector<T, OutputAlloc> & interpolate(const Vector<T, InputAlloc> &input, Vector<T, OutputAlloc> &output,
+                                     const Vector<typename ResamplerTap<T>::type, TapAlloc> &taps, unsigned rate) {
+    Interpolator<T> interpolator(taps, rate);
+    return interpolator.filter(input, output);
+}
+
+/**
+ * \brief Decimates "input" by "rate" with a fresh Decimator.
+ *
+ * \param output The decimated samples.  Must not be "input".
+ * \return Reference to "output".
+ */
+template <class T, class TapAlloc, class InputAlloc, class OutputAlloc>
+Vector<T, OutputAlloc> & decimate(const Vector<T, InputAlloc> &input, Vector<T, OutputAlloc> &output,
+                                  const Vector<typename ResamplerTap<T>::type, TapAlloc> &taps, unsigned rate) {
+    Decimator<T> decimator(taps, rate);
+    return decimator.filter(input, output);
+}
+
+/**
+ * \brief Resamples "input" by "interpolation" / "decimation" with a fresh Resampler.
+ *
+ * \param output The resampled samples.  Must not be "input".
+ * \return Reference to "output".
+ */
+template <class T, class TapAlloc, class InputAlloc, class OutputAlloc>
+Vector<T, OutputAlloc> & resample(const Vector<T, InputAlloc> &input, Vector<T, OutputAlloc> &output,
+                                  const Vector<typename ResamplerTap<T>::type, TapAlloc> &taps, unsigned interpolation,
+                                  unsigned decimation) {
+    Resampler<T> resampler(taps, interpolation, decimation);
+    return resampler.filter(input, output);
+}
+
+}
+
+#endif /* Resampler_h */
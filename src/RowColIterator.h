@@ -16,7 +16,7 @@ namespace MatrixDSP {
 template<typename T>
 class RowColIterator {
     private:
-        typename std::vector<T>::iterator iterator;
+        T *iterator;
         int increment;
     
     public:
@@ -26,17 +26,26 @@ class RowColIterator {
         typedef T &reference;
         typedef std::random_access_iterator_tag iterator_category;
     
-        RowColIterator(typename std::vector<T> &vec, unsigned numRows, unsigned numCols, bool row, int rowColNum, bool end = false) {
-            iterator = vec.begin();
+        /**
+         * \brief Iterates over a row or a column of a numRows x numCols matrix stored in "vec",
+         *      whose rows start "ld" elements apart (0 means "numCols").
+         */
+        template <class Alloc>
+        RowColIterator(std::vector<T, Alloc> &vec, unsigned numRows, unsigned numCols, bool row, int rowColNum, bool end = false,
+                       unsigned ld = 0) {
+            if (ld == 0) {
+                ld = numCols;
+            }
+            iterator = vec.data();
             int numElements;
             if (row) {
-                iterator += rowColNum * numCols;
+                iterator += rowColNum * ld;
                 increment = 1;
                 numElements = numCols;
             }
             else {
                 iterator += rowColNum;
-                increment = numCols;
+                increment = ld;
                 numElements = numRows;
             }
             
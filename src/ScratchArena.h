@@ -0,0 +1,209 @@
+//
+//  ScratchArena.h
+//  MatrixDSP
+//
+//  A per-thread bump allocator for the temporary buffers that methods such as median(),
+//  transpose() and the real FFTs need while they run.  Taking memory from it is a pointer
+//  increment, and it's given back by rewinding to a checkpoint, so the containers no longer
+//  carry scratch buffers around and don't allocate anything they don't keep.
+//
+
+#ifndef ScratchArena_h
+#define ScratchArena_h
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include "AlignedAllocator.h"
+
+namespace MatrixDSP {
+
+/**
+ * \brief The size of the first block of a ScratchArena.  Later blocks double in size, or are as
+ *      big as the request that needed them.
+ */
+const std::size_t scratchFirstBlockSize = 64 * 1024;
+
+/**
+ * \brief A stack of memory blocks that hands out memory by bumping a pointer.
+ *
+ * Memory is given back by rewinding to a checkpoint taken earlier, which frees everything
+ * allocated since in one go.  Checkpoints must be rewound in the reverse order that they were
+ * taken, which the scoped helpers ScratchArena::Scope and ScratchBuffer take care of.  Blocks
+ * are kept once they've been allocated, so after the first few calls a method that uses
+ * scratch space doesn't call malloc at all.
+ *
+ * An arena isn't thread safe.  Use scratchArena() to get the calling thread's one.
+ */
+class ScratchArena {
+    struct Block {
+        std::unique_ptr<char[], void (*)(char *)> data;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks;
+    std::size_t block;
+    std::size_t offset;
+
+    static void freeBlock(char *ptr) {AlignedAllocator<char>().deallocate(ptr, 0);}
+
+public:
+    /**
+     * \brief Where the top of the arena was.  See checkpoint() and rewind().
+     */
+    struct Checkpoint {
+        std::size_t block;
+        std::size_t offset;
+    };
+
+    /**
+     * \brief Rewinds the arena to where it was when the scope was entered.
+     */
+    class Scope {
+        ScratchArena &arena;
+        Checkpoint mark;
+
+    public:
+        explicit Scope(ScratchArena &scopeArena) : arena(scopeArena), mark(scopeArena.checkpoint()) {}
+        ~Scope() {arena.rewind(mark);}
+        Scope(const Scope &) = delete;
+        Scope & operator=(const Scope &) = delete;
+    };
+
+    ScratchArena() : block(0), offset(0) {}
+    ScratchArena(const ScratchArena &) = delete;
+    ScratchArena & operator=(const ScratchArena &) = delete;
+
+    /**
+     * \brief Returns "bytes" bytes of memory aligned to defaultAlignment.  The memory is valid
+     *      until the arena is rewound past it.
+     */
+    void * allocate(std::size_t bytes) {
+        bytes = (bytes + defaultAlignment - 1) / defaultAlignment * defaultAlignment;
+        if (block < blocks.size() && blocks[block].size - offset >= bytes) {
+            void *ptr = blocks[block].data.get() + offset;
+            offset += bytes;
+            return ptr;
+        }
+        // Move up to the next block.  Anything past the top is free, so a next block that's too
+        // small is replaced by a bigger one.
+        std::size_t next = block < blocks.size() && offset > 0 ? block + 1 : block;
+        if (next < blocks.size() && blocks[next].size < bytes) {
+            blocks.erase(blocks.begin() + next, blocks.end());
+        }
+        if (next == blocks.size()) {
+            std::size_t size = blocks.empty() ? scratchFirstBlockSize : 2 * blocks.back().size;
+            if (size < bytes) {
+                size = bytes;
+            }
+            char *data = AlignedAllocator<char>().allocate(size);
+            blocks.push_back(Block{std::unique_ptr<char[], void (*)(char *)>(data, freeBlock), size});
+        }
+        block = next;
+        offset = bytes;
+        return blocks[block].data.get();
+    }
+
+    /**
+     * \brief Returns uninitialized room for "count" elements of type T.
+     */
+    template <class T>
+    T * allocate(std::size_t count) {
+        static_assert(alignof(T) <= defaultAlignment, "Scratch memory isn't aligned enough for this type");
+        return static_cast<T *>(allocate(count * sizeof(T)));
+    }
+
+    /**
+     * \brief Returns the current top of the arena.
+     */
+    Checkpoint checkpoint() const {return Checkpoint{block, offset};}
+
+    /**
+     * \brief Frees everything allocated since "mark" was taken.
+     */
+    void rewind(Checkpoint mark) {
+        assert(mark.block < block || (mark.block == block && mark.offset <= offset));
+        block = mark.block;
+        offset = mark.offset;
+    }
+
+    /**
+     * \brief The number of bytes in use, counting the unused ends of blocks that were skipped.
+     */
+    std::size_t used() const {
+        std::size_t total = offset;
+        for (std::size_t index=0; index<block && index<blocks.size(); index++) {
+            total += blocks[index].size;
+        }
+        return total;
+    }
+
+    /**
+     * \brief The number of bytes that the arena holds.
+     */
+    std::size_t capacity() const {
+        std::size_t total = 0;
+        for (const Block &b : blocks) {
+            total += b.size;
+        }
+        return total;
+    }
+
+    /**
+     * \brief Gives the blocks back to the system.  Nothing may be allocated from the arena.
+     */
+    void release() {
+        assert(block == 0 && offset == 0);
+        blocks.clear();
+    }
+};
+
+/**
+ * \brief Returns the calling thread's scratch arena.
+ */
+inline ScratchArena & scratchArena() {
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+/**
+ * \brief A buffer of "size" elements from the calling thread's scratch arena, which is given
+ *      back when the buffer goes out of scope.
+ *
+ * The elements are default initialized, so numbers start out with unspecified values.  Buffers
+ * must be destroyed in the reverse order that they were made, which local variables are.
+ */
+template <class T>
+class ScratchBuffer {
+    static_assert(std::is_trivially_destructible<T>::value, "Scratch buffers don't run destructors");
+
+    ScratchArena::Scope scope;
+    T *ptr;
+    std::size_t len;
+
+public:
+    explicit ScratchBuffer(std::size_t size) : scope(scratchArena()), ptr(scratchArena().allocate<T>(size)), len(size) {
+        for (std::size_t index=0; index<len; index++) {
+            new (ptr + index) T;
+        }
+    }
+
+    ScratchBuffer(const ScratchBuffer &) = delete;
+    ScratchBuffer & operator=(const ScratchBuffer &) = delete;
+
+    T & operator[](std::size_t index) {return ptr[index];}
+    const T & operator[](std::size_t index) const {return ptr[index];}
+
+    T * data() {return ptr;}
+    const T * data() const {return ptr;}
+    std::size_t size() const {return len;}
+    T * begin() {return ptr;}
+    T * end() {return ptr + len;}
+};
+
+}
+
+#endif /* ScratchArena_h */
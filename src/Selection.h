@@ -0,0 +1,113 @@
+//
+//  Selection.h
+//  MatrixDSP
+//
+//  Order statistics without sorting.  multiSelect() puts several ranks of a sequence in their
+//  sorted places with a handful of std::nth_element() partitions, which is O(n log k) for k
+//  ranks instead of the O(n log n) of a full sort.  The median and quantile methods are built
+//  on it.
+//
+
+#ifndef Selection_h
+#define Selection_h
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace MatrixDSP {
+
+/**
+ * \brief Partially sorts [first, last) so that each of the ranks in [firstRank, lastRank) holds
+ *      the element that would be there if the range were sorted.
+ *
+ * The middle rank is selected first, which splits the range and the remaining ranks in two, so
+ * each partitioning pass only covers the part of the data that can still hold its ranks.
+ *
+ * \param ranks Sorted, distinct offsets from "first".
+ * \param offset The rank of "first" in the original range.  Used by the recursion.
+ */
+template <class RandomIt>
+void multiSelect(RandomIt first, RandomIt last, const std::size_t *firstRank, const std::size_t *lastRank, std::size_t offset = 0) {
+    while (firstRank != lastRank) {
+        const std::size_t *midRank = firstRank + (lastRank - firstRank) / 2;
+        RandomIt nth = first + (*midRank - offset);
+        std::nth_element(first, nth, last);
+        multiSelect(first, nth, firstRank, midRank, offset);
+        // Carry on with the upper half in this call
+        offset = *midRank + 1;
+        first = nth + 1;
+        firstRank = midRank + 1;
+    }
+}
+
+/**
+ * \brief Where quantile "p" of "n" sorted samples lies.
+ *
+ * Uses MATLAB's definition: the sorted samples are the quantiles at (i + 0.5)/n, quantiles in
+ * between are linearly interpolated, and those outside that range are the smallest or largest
+ * sample.
+ *
+ * \param lower Set to the index of the sample at or just below the quantile.
+ * \param fraction Set to how far the quantile is from sample "lower" towards sample "lower" + 1.
+ */
+inline void quantilePosition(std::size_t n, double p, std::size_t *lower, double *fraction) {
+    assert(n > 0);
+    assert(p >= 0 && p <= 1);
+    double position = n * p - 0.5;
+    if (position <= 0) {
+        *lower = 0;
+        *fraction = 0;
+    }
+    else if (position >= n - 1) {
+        *lower = n - 1;
+        *fraction = 0;
+    }
+    else {
+        *lower = (std::size_t) position;
+        *fraction = position - *lower;
+    }
+}
+
+/**
+ * \brief Computes the quantiles "probabilities" of [first, last), which is reordered, with one
+ *      multiSelect() for all of them.
+ *
+ * \param quantiles Where the quantiles are written, in the order of "probabilities".
+ */
+template <class RandomIt, class T>
+void selectQuantiles(RandomIt first, RandomIt last, const std::vector<double> &probabilities, T *quantiles) {
+    std::size_t n = last - first;
+    std::vector<std::size_t> ranks;
+    ranks.reserve(2 * probabilities.size());
+    for (double p : probabilities) {
+        std::size_t lower;
+        double fraction;
+        quantilePosition(n, p, &lower, &fraction);
+        ranks.push_back(lower);
+        if (fraction > 0) {
+            ranks.push_back(lower + 1);
+        }
+    }
+    std::sort(ranks.begin(), ranks.end());
+    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+    multiSelect(first, last, ranks.data(), ranks.data() + ranks.size());
+
+    for (std::size_t index=0; index<probabilities.size(); index++) {
+        std::size_t lower;
+        double fraction;
+        quantilePosition(n, probabilities[index], &lower, &fraction);
+        if (fraction > 0) {
+            quantiles[index] = (T) (first[lower] + fraction * (first[lower + 1] - first[lower]));
+        }
+        else {
+            quantiles[index] = first[lower];
+        }
+    }
+}
+
+}
+
+#endif /* Selection_h */
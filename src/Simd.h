@@ -0,0 +1,848 @@
+//
+//  Simd.h
+//  MatrixDSP
+//
+//  Runtime-dispatched SIMD kernels.  Each kernel is compiled for SSE2, AVX2 and AVX-512 using
+//  per-function target attributes, so the library doesn't need any special compiler flags, and
+//  the widest instruction set that the CPU supports is picked at run time.  Types and operations
+//  that don't have a vector implementation fall back to a plain scalar loop.
+//
+
+#ifndef Simd_h
+#define Simd_h
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <atomic>
+#include <complex>
+
+#if !defined(MATRIX_DSP_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define MATRIX_DSP_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MATRIX_DSP_TARGET(isa) __attribute__((target(isa)))
+#define MATRIX_DSP_ALWAYS_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define MATRIX_DSP_TARGET(isa)
+#define MATRIX_DSP_ALWAYS_INLINE __forceinline
+#else
+#define MATRIX_DSP_TARGET(isa)
+#define MATRIX_DSP_ALWAYS_INLINE inline
+#endif
+
+// Fully unrolls the next loop, which must have a constant trip count.  Used where an array of
+// registers has to stay in registers (GCC only unrolls loops like that by itself at -O3).
+#if defined(__clang__)
+#define MATRIX_DSP_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__) && __GNUC__ >= 8
+#define MATRIX_DSP_UNROLL _Pragma("GCC unroll 16")
+#else
+#define MATRIX_DSP_UNROLL
+#endif
+
+// Each of these must match the CPU check of the same name below (hasSse2() etc.), which is
+// what makes it safe to call code that's compiled for them.
+#define MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_TARGET("sse2")
+#define MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_TARGET("avx2,fma")
+#define MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_TARGET("avx512f,avx512bw,avx2,fma")
+
+namespace MatrixDSP {
+namespace simd {
+
+/**
+ * \brief Instruction set levels, in increasing order of width.
+ */
+enum class Isa {Scalar = 0, Sse2 = 1, Avx2 = 2, Avx512 = 3};
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+};
+
+inline CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+#if defined(MATRIX_DSP_X86_SIMD)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    int maxLeaf = regs[0];
+    __cpuid(regs, 1);
+    features.sse2 = (regs[3] & (1 << 26)) != 0;
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    features.fma = (regs[2] & (1 << 12)) != 0;
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool osAvx = (xcr0 & 0x6) == 0x6;
+    bool osAvx512 = (xcr0 & 0xe6) == 0xe6;
+    if (maxLeaf >= 7) {
+        __cpuidex(regs, 7, 0);
+        features.avx2 = osAvx && (regs[1] & (1 << 5)) != 0;
+        features.avx512f = osAvx512 && (regs[1] & (1 << 16)) != 0;
+        features.avx512bw = osAvx512 && (regs[1] & (1 << 30)) != 0;
+    }
+    features.fma = features.fma && osAvx;
+#else
+    __builtin_cpu_init();
+    features.sse2 = __builtin_cpu_supports("sse2");
+    features.avx2 = __builtin_cpu_supports("avx2");
+    features.fma = __builtin_cpu_supports("fma");
+    features.avx512f = __builtin_cpu_supports("avx512f");
+    features.avx512bw = __builtin_cpu_supports("avx512bw");
+#endif
+#endif
+    return features;
+}
+
+/**
+ * \brief Returns the features of the CPU that we're running on.  Detection is only done once.
+ */
+inline const CpuFeatures & cpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+/**
+ * \brief True if the CPU has every feature that MATRIX_DSP_TARGET_SSE2 code may use.
+ */
+inline bool hasSse2() {return cpuFeatures().sse2;}
+
+/**
+ * \brief True if the CPU has every feature that MATRIX_DSP_TARGET_AVX2 code may use.
+ */
+inline bool hasAvx2() {return cpuFeatures().avx2 && cpuFeatures().fma;}
+
+/**
+ * \brief True if the CPU has every feature that MATRIX_DSP_TARGET_AVX512 code may use.  The
+ *      compiler is free to use AVX-512BW instructions in any of it, not just in the int16_t
+ *      kernels, so an AVX-512F only CPU doesn't count.
+ */
+inline bool hasAvx512() {
+    const CpuFeatures &features = cpuFeatures();
+    return features.avx512f && features.avx512bw && hasAvx2();
+}
+
+/**
+ * \brief Returns the widest instruction set that the CPU supports.
+ */
+inline Isa detectedIsa() {
+    if (hasAvx512()) {
+        return Isa::Avx512;
+    }
+    if (hasAvx2()) {
+        return Isa::Avx2;
+    }
+    if (hasSse2()) {
+        return Isa::Sse2;
+    }
+    return Isa::Scalar;
+}
+
+inline std::atomic<int> & maxIsaSetting() {
+    static std::atomic<int> setting((int) Isa::Avx512);
+    return setting;
+}
+
+/**
+ * \brief Limits the instruction set that the kernels are allowed to use.
+ *
+ * Mostly useful for testing and benchmarking the narrower kernels on a machine that supports
+ * the wider ones.  Setting a level that the CPU doesn't support has no effect beyond the
+ * CPU's own limit.
+ */
+inline void setMaxIsa(Isa isa) {maxIsaSetting().store((int) isa, std::memory_order_relaxed);}
+
+/**
+ * \brief Returns the limit set by setMaxIsa(), which may be above what the CPU supports.
+ */
+inline Isa maxIsa() {return (Isa) maxIsaSetting().load(std::memory_order_relaxed);}
+
+/**
+ * \brief Returns the instruction set that the kernels will actually use.
+ */
+inline Isa activeIsa() {
+    int detected = (int) detectedIsa();
+    int limit = maxIsaSetting().load(std::memory_order_relaxed);
+    return (Isa) (detected < limit ? detected : limit);
+}
+
+/*****************************************************************************************
+                                    Element-wise operations
+*****************************************************************************************/
+struct Add {
+    template <class T, class U>
+    static void apply(T &acc, const U &val) {acc += val;}
+    template <class T, class U>
+    static auto eval(const T &lhs, const U &rhs) -> decltype(lhs + rhs) {return lhs + rhs;}
+};
+
+struct Sub {
+    template <class T, class U>
+    static void apply(T &acc, const U &val) {acc -= val;}
+    template <class T, class U>
+    static auto eval(const T &lhs, const U &rhs) -> decltype(lhs - rhs) {return lhs - rhs;}
+};
+
+struct Mul {
+    template <class T, class U>
+    static void apply(T &acc, const U &val) {acc *= val;}
+    template <class T, class U>
+    static auto eval(const T &lhs, const U &rhs) -> decltype(lhs * rhs) {return lhs * rhs;}
+};
+
+struct Div {
+    template <class T, class U>
+    static void apply(T &acc, const U &val) {acc /= val;}
+    template <class T, class U>
+    static auto eval(const T &lhs, const U &rhs) -> decltype(lhs / rhs) {return lhs / rhs;}
+};
+
+/**
+ * \brief True if there is a vector kernel for operation "Op" on type "T".
+ *
+ * Floating point types support all four operations.  16 and 32 bit integers support everything
+ * but division, which doesn't have a SIMD instruction.
+ */
+template <class T, class Op>
+struct HasKernel : std::integral_constant<bool,
+        std::is_same<T, float>::value || std::is_same<T, double>::value ||
+        ((std::is_same<T, int16_t>::value || std::is_same<T, int32_t>::value) && !std::is_same<Op, Div>::value)> {};
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+template <Isa isa, class T>
+struct Traits;
+
+/*****************************************************************************************
+                                            SSE2
+*****************************************************************************************/
+template <>
+struct Traits<Isa::Sse2, float> {
+    typedef float Scalar;
+    typedef __m128 Reg;
+    static const unsigned width = 4;
+    static bool available() {return hasSse2();}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm_loadu_ps(p);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm_storeu_ps(p, a);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm_set1_ps(a);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm_add_ps(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm_sub_ps(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm_mul_ps(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Div, Reg a, Reg b) {return _mm_div_ps(a, b);}
+};
+
+template <>
+struct Traits<Isa::Sse2, double> {
+    typedef double Scalar;
+    typedef __m128d Reg;
+    static const unsigned width = 2;
+    static bool available() {return hasSse2();}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm_loadu_pd(p);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm_storeu_pd(p, a);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm_set1_pd(a);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm_add_pd(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm_sub_pd(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm_mul_pd(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Div, Reg a, Reg b) {return _mm_div_pd(a, b);}
+};
+
+template <>
+struct Traits<Isa::Sse2, int16_t> {
+    typedef int16_t Scalar;
+    typedef __m128i Reg;
+    static const unsigned width = 8;
+    static bool available() {return hasSse2();}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm_loadu_si128((const __m128i *) p);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm_storeu_si128((__m128i *) p, a);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm_set1_epi16(a);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm_add_epi16(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm_sub_epi16(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm_mullo_epi16(a, b);}
+};
+
+template <>
+struct Traits<Isa::Sse2, int32_t> {
+    typedef int32_t Scalar;
+    typedef __m128i Reg;
+    static const unsigned width = 4;
+    static bool available() {return hasSse2();}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm_loadu_si128((const __m128i *) p);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm_storeu_si128((__m128i *) p, a);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm_set1_epi32(a);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm_add_epi32(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm_sub_epi32(a, b);}
+    static MATRIX_DSP_TARGET_SSE2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {
+        // SSE2 doesn't have a 32 bit low multiply (that came with SSE4.1), so multiply the even
+        // and odd lanes separately and interleave the low halves of the 64 bit products.
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+};
+
+/*****************************************************************************************
+                                            AVX2
+*****************************************************************************************/
+template <>
+struct Traits<Isa::Avx2, float> {
+    typedef float Scalar;
+    typedef __m256 Reg;
+    static const unsigned width = 8;
+    static bool available() {return hasAvx2();}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm256_loadu_ps(p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm256_storeu_ps(p, a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm256_set1_ps(a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm256_add_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm256_sub_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm256_mul_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Div, Reg a, Reg b) {return _mm256_div_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg fmadd(Reg a, Reg b, Reg c) {return _mm256_fmadd_ps(a, b, c);}
+};
+
+template <>
+struct Traits<Isa::Avx2, double> {
+    typedef double Scalar;
+    typedef __m256d Reg;
+    static const unsigned width = 4;
+    static bool available() {return hasAvx2();}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm256_loadu_pd(p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm256_storeu_pd(p, a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm256_set1_pd(a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm256_add_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm256_sub_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm256_mul_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Div, Reg a, Reg b) {return _mm256_div_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg fmadd(Reg a, Reg b, Reg c) {return _mm256_fmadd_pd(a, b, c);}
+};
+
+template <>
+struct Traits<Isa::Avx2, int16_t> {
+    typedef int16_t Scalar;
+    typedef __m256i Reg;
+    static const unsigned width = 16;
+    static bool available() {return hasAvx2();}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm256_loadu_si256((const __m256i *) p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm256_storeu_si256((__m256i *) p, a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm256_set1_epi16(a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm256_add_epi16(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm256_sub_epi16(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm256_mullo_epi16(a, b);}
+};
+
+template <>
+struct Traits<Isa::Avx2, int32_t> {
+    typedef int32_t Scalar;
+    typedef __m256i Reg;
+    static const unsigned width = 8;
+    static bool available() {return hasAvx2();}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm256_loadu_si256((const __m256i *) p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm256_storeu_si256((__m256i *) p, a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm256_set1_epi32(a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm256_add_epi32(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm256_sub_epi32(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm256_mullo_epi32(a, b);}
+};
+
+/*****************************************************************************************
+                                            AVX-512
+*****************************************************************************************/
+template <>
+struct Traits<Isa::Avx512, float> {
+    typedef float Scalar;
+    typedef __m512 Reg;
+    static const unsigned width = 16;
+    static bool available() {return hasAvx512();}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm512_loadu_ps(p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm512_storeu_ps(p, a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm512_set1_ps(a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm512_add_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm512_sub_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm512_mul_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Div, Reg a, Reg b) {return _mm512_div_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg fmadd(Reg a, Reg b, Reg c) {return _mm512_fmadd_ps(a, b, c);}
+};
+
+template <>
+struct Traits<Isa::Avx512, double> {
+    typedef double Scalar;
+    typedef __m512d Reg;
+    static const unsigned width = 8;
+    static bool available() {return hasAvx512();}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm512_loadu_pd(p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm512_storeu_pd(p, a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm512_set1_pd(a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm512_add_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm512_sub_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm512_mul_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Div, Reg a, Reg b) {return _mm512_div_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg fmadd(Reg a, Reg b, Reg c) {return _mm512_fmadd_pd(a, b, c);}
+};
+
+template <>
+struct Traits<Isa::Avx512, int16_t> {
+    typedef int16_t Scalar;
+    typedef __m512i Reg;
+    static const unsigned width = 32;
+    static bool available() {return hasAvx512();}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm512_loadu_si512((const void *) p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm512_storeu_si512((void *) p, a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm512_set1_epi16(a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm512_add_epi16(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm512_sub_epi16(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm512_mullo_epi16(a, b);}
+};
+
+template <>
+struct Traits<Isa::Avx512, int32_t> {
+    typedef int32_t Scalar;
+    typedef __m512i Reg;
+    static const unsigned width = 16;
+    static bool available() {return hasAvx512();}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg load(const Scalar *p) {return _mm512_loadu_si512((const void *) p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void store(Scalar *p, Reg a) {_mm512_storeu_si512((void *) p, a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm512_set1_epi32(a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Add, Reg a, Reg b) {return _mm512_add_epi32(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Sub, Reg a, Reg b) {return _mm512_sub_epi32(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg apply(Mul, Reg a, Reg b) {return _mm512_mullo_epi32(a, b);}
+};
+
+/*****************************************************************************************
+                                    Interleaved complex
+*****************************************************************************************/
+// Registers of std::complex values in their natural (re, im, re, im, ...) layout.  "width" is
+// the number of complex values per register.  set1() puts a real value in every real and
+// imaginary part, and broadcast() puts a complex value in every element.  The complex
+// multiply is the usual moveldup/movehdup/fmaddsub sequence.  fmadd() scales by a real
+// register, swap() exchanges the real and imaginary parts, and addsub() subtracts in the real
+// parts and adds in the imaginary ones.
+
+template <Isa isa, class T>
+struct ComplexTraits;
+
+template <>
+struct ComplexTraits<Isa::Avx2, float> {
+    typedef float Scalar;
+    typedef std::complex<float> Complex;
+    typedef __m256 Reg;
+    static const unsigned width = 4;
+    static bool available() {return hasAvx2();}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Complex *p) {return _mm256_loadu_ps((const float *) p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void store(Complex *p, Reg a) {_mm256_storeu_ps((float *) p, a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm256_set1_ps(a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg broadcast(const Complex &a) {return _mm256_setr_ps(a.real(), a.imag(), a.real(), a.imag(), a.real(), a.imag(), a.real(), a.imag());}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg add(Reg a, Reg b) {return _mm256_add_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg sub(Reg a, Reg b) {return _mm256_sub_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg scale(Reg a, Reg s) {return _mm256_mul_ps(a, s);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg fmadd(Reg a, Reg s, Reg c) {return _mm256_fmadd_ps(a, s, c);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg swap(Reg a) {return _mm256_permute_ps(a, 0xb1);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg addsub(Reg a, Reg b) {return _mm256_addsub_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg mul(Reg a, Reg b) {
+        Reg swapped = _mm256_permute_ps(a, 0xb1);
+        return _mm256_fmaddsub_ps(a, _mm256_moveldup_ps(b), _mm256_mul_ps(swapped, _mm256_movehdup_ps(b)));
+    }
+    // a * j and a * -j
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg mulJ(Reg a) {return _mm256_addsub_ps(_mm256_setzero_ps(), _mm256_permute_ps(a, 0xb1));}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg mulMinusJ(Reg a) {return _mm256_sub_ps(_mm256_setzero_ps(), mulJ(a));}
+};
+
+template <>
+struct ComplexTraits<Isa::Avx2, double> {
+    typedef double Scalar;
+    typedef std::complex<double> Complex;
+    typedef __m256d Reg;
+    static const unsigned width = 2;
+    static bool available() {return hasAvx2();}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg load(const Complex *p) {return _mm256_loadu_pd((const double *) p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void store(Complex *p, Reg a) {_mm256_storeu_pd((double *) p, a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm256_set1_pd(a);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg broadcast(const Complex &a) {return _mm256_setr_pd(a.real(), a.imag(), a.real(), a.imag());}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg add(Reg a, Reg b) {return _mm256_add_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg sub(Reg a, Reg b) {return _mm256_sub_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg scale(Reg a, Reg s) {return _mm256_mul_pd(a, s);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg fmadd(Reg a, Reg s, Reg c) {return _mm256_fmadd_pd(a, s, c);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg swap(Reg a) {return _mm256_permute_pd(a, 0x5);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg addsub(Reg a, Reg b) {return _mm256_addsub_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg mul(Reg a, Reg b) {
+        Reg swapped = _mm256_permute_pd(a, 0x5);
+        return _mm256_fmaddsub_pd(a, _mm256_movedup_pd(b), _mm256_mul_pd(swapped, _mm256_permute_pd(b, 0xf)));
+    }
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg mulJ(Reg a) {return _mm256_addsub_pd(_mm256_setzero_pd(), _mm256_permute_pd(a, 0x5));}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg mulMinusJ(Reg a) {return _mm256_sub_pd(_mm256_setzero_pd(), mulJ(a));}
+};
+
+template <>
+struct ComplexTraits<Isa::Avx512, float> {
+    typedef float Scalar;
+    typedef std::complex<float> Complex;
+    typedef __m512 Reg;
+    static const unsigned width = 8;
+    static bool available() {return hasAvx512();}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg load(const Complex *p) {return _mm512_loadu_ps((const float *) p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void store(Complex *p, Reg a) {_mm512_storeu_ps((float *) p, a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm512_set1_ps(a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg broadcast(const Complex &a) {return _mm512_setr4_ps(a.real(), a.imag(), a.real(), a.imag());}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg add(Reg a, Reg b) {return _mm512_add_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg sub(Reg a, Reg b) {return _mm512_sub_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg scale(Reg a, Reg s) {return _mm512_mul_ps(a, s);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg fmadd(Reg a, Reg s, Reg c) {return _mm512_fmadd_ps(a, s, c);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg swap(Reg a) {return _mm512_shuffle_ps(a, a, 0xb1);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg addsub(Reg a, Reg b) {return _mm512_mask_add_ps(_mm512_sub_ps(a, b), 0xaaaa, a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg mul(Reg a, Reg b) {
+        // shuffle rather than permute/moveldup/movehdup, which trip a bogus uninitialized
+        // warning in some versions of GCC
+        Reg swapped = _mm512_shuffle_ps(a, a, 0xb1);
+        return _mm512_fmaddsub_ps(a, _mm512_shuffle_ps(b, b, 0xa0), _mm512_mul_ps(swapped, _mm512_shuffle_ps(b, b, 0xf5)));
+    }
+    // Negate the real (even) or imaginary (odd) lanes of the swapped value
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg mulJ(Reg a) {
+        Reg swapped = _mm512_shuffle_ps(a, a, 0xb1);
+        return _mm512_mask_sub_ps(swapped, 0x5555, _mm512_setzero_ps(), swapped);
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg mulMinusJ(Reg a) {
+        Reg swapped = _mm512_shuffle_ps(a, a, 0xb1);
+        return _mm512_mask_sub_ps(swapped, 0xaaaa, _mm512_setzero_ps(), swapped);
+    }
+};
+
+template <>
+struct ComplexTraits<Isa::Avx512, double> {
+    typedef double Scalar;
+    typedef std::complex<double> Complex;
+    typedef __m512d Reg;
+    static const unsigned width = 4;
+    static bool available() {return hasAvx512();}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg load(const Complex *p) {return _mm512_loadu_pd((const double *) p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void store(Complex *p, Reg a) {_mm512_storeu_pd((double *) p, a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg set1(Scalar a) {return _mm512_set1_pd(a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg broadcast(const Complex &a) {return _mm512_setr4_pd(a.real(), a.imag(), a.real(), a.imag());}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg add(Reg a, Reg b) {return _mm512_add_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg sub(Reg a, Reg b) {return _mm512_sub_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg scale(Reg a, Reg s) {return _mm512_mul_pd(a, s);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg fmadd(Reg a, Reg s, Reg c) {return _mm512_fmadd_pd(a, s, c);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg swap(Reg a) {return _mm512_shuffle_pd(a, a, 0x55);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg addsub(Reg a, Reg b) {return _mm512_mask_add_pd(_mm512_sub_pd(a, b), 0xaa, a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg mul(Reg a, Reg b) {
+        Reg swapped = _mm512_shuffle_pd(a, a, 0x55);
+        return _mm512_fmaddsub_pd(a, _mm512_shuffle_pd(b, b, 0x00), _mm512_mul_pd(swapped, _mm512_shuffle_pd(b, b, 0xff)));
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg mulJ(Reg a) {
+        Reg swapped = _mm512_shuffle_pd(a, a, 0x55);
+        return _mm512_mask_sub_pd(swapped, 0x55, _mm512_setzero_pd(), swapped);
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg mulMinusJ(Reg a) {
+        Reg swapped = _mm512_shuffle_pd(a, a, 0x55);
+        return _mm512_mask_sub_pd(swapped, 0xaa, _mm512_setzero_pd(), swapped);
+    }
+};
+
+/*****************************************************************************************
+                                        Kernel loops
+*****************************************************************************************/
+// The loops are the same for every instruction set, but the target attribute has to be a
+// literal, so there is one copy per instruction set.  Unrolling by two keeps two independent
+// load/op/store chains in flight, which is enough to saturate memory bandwidth on long vectors.
+
+template <class Tr, class Op, class T>
+MATRIX_DSP_TARGET_SSE2 void binarySse2(T *out, const T *a, const T *b, std::size_t n) {
+    const std::size_t w = Tr::width;
+    std::size_t i = 0;
+    for (; i + 2*w <= n; i += 2*w) {
+        typename Tr::Reg r0 = Tr::apply(Op(), Tr::load(a + i), Tr::load(b + i));
+        typename Tr::Reg r1 = Tr::apply(Op(), Tr::load(a + i + w), Tr::load(b + i + w));
+        Tr::store(out + i, r0);
+        Tr::store(out + i + w, r1);
+    }
+    for (; i + w <= n; i += w) {
+        Tr::store(out + i, Tr::apply(Op(), Tr::load(a + i), Tr::load(b + i)));
+    }
+    for (; i < n; i++) {
+        T val = a[i];
+        Op::apply(val, b[i]);
+        out[i] = val;
+    }
+}
+
+template <class Tr, class Op, class T>
+MATRIX_DSP_TARGET_SSE2 void binaryScalarSse2(T *out, const T *a, T b, std::size_t n) {
+    const std::size_t w = Tr::width;
+    typename Tr::Reg scalar = Tr::set1(b);
+    std::size_t i = 0;
+    for (; i + 2*w <= n; i += 2*w) {
+        typename Tr::Reg r0 = Tr::apply(Op(), Tr::load(a + i), scalar);
+        typename Tr::Reg r1 = Tr::apply(Op(), Tr::load(a + i + w), scalar);
+        Tr::store(out + i, r0);
+        Tr::store(out + i + w, r1);
+    }
+    for (; i + w <= n; i += w) {
+        Tr::store(out + i, Tr::apply(Op(), Tr::load(a + i), scalar));
+    }
+    for (; i < n; i++) {
+        T val = a[i];
+        Op::apply(val, b);
+        out[i] = val;
+    }
+}
+
+template <class Tr, class Op, class T>
+MATRIX_DSP_TARGET_AVX2 void binaryAvx2(T *out, const T *a, const T *b, std::size_t n) {
+    const std::size_t w = Tr::width;
+    std::size_t i = 0;
+    for (; i + 2*w <= n; i += 2*w) {
+        typename Tr::Reg r0 = Tr::apply(Op(), Tr::load(a + i), Tr::load(b + i));
+        typename Tr::Reg r1 = Tr::apply(Op(), Tr::load(a + i + w), Tr::load(b + i + w));
+        Tr::store(out + i, r0);
+        Tr::store(out + i + w, r1);
+    }
+    for (; i + w <= n; i += w) {
+        Tr::store(out + i, Tr::apply(Op(), Tr::load(a + i), Tr::load(b + i)));
+    }
+    for (; i < n; i++) {
+        T val = a[i];
+        Op::apply(val, b[i]);
+        out[i] = val;
+    }
+}
+
+template <class Tr, class Op, class T>
+MATRIX_DSP_TARGET_AVX2 void binaryScalarAvx2(T *out, const T *a, T b, std::size_t n) {
+    const std::size_t w = Tr::width;
+    typename Tr::Reg scalar = Tr::set1(b);
+    std::size_t i = 0;
+    for (; i + 2*w <= n; i += 2*w) {
+        typename Tr::Reg r0 = Tr::apply(Op(), Tr::load(a + i), scalar);
+        typename Tr::Reg r1 = Tr::apply(Op(), Tr::load(a + i + w), scalar);
+        Tr::store(out + i, r0);
+        Tr::store(out + i + w, r1);
+    }
+    for (; i + w <= n; i += w) {
+        Tr::store(out + i, Tr::apply(Op(), Tr::load(a + i), scalar));
+    }
+    for (; i < n; i++) {
+        T val = a[i];
+        Op::apply(val, b);
+        out[i] = val;
+    }
+}
+
+template <class Tr, class Op, class T>
+MATRIX_DSP_TARGET_AVX512 void binaryAvx512(T *out, const T *a, const T *b, std::size_t n) {
+    const std::size_t w = Tr::width;
+    std::size_t i = 0;
+    for (; i + 2*w <= n; i += 2*w) {
+        typename Tr::Reg r0 = Tr::apply(Op(), Tr::load(a + i), Tr::load(b + i));
+        typename Tr::Reg r1 = Tr::apply(Op(), Tr::load(a + i + w), Tr::load(b + i + w));
+        Tr::store(out + i, r0);
+        Tr::store(out + i + w, r1);
+    }
+    for (; i + w <= n; i += w) {
+        Tr::store(out + i, Tr::apply(Op(), Tr::load(a + i), Tr::load(b + i)));
+    }
+    for (; i < n; i++) {
+        T val = a[i];
+        Op::apply(val, b[i]);
+        out[i] = val;
+    }
+}
+
+template <class Tr, class Op, class T>
+MATRIX_DSP_TARGET_AVX512 void binaryScalarAvx512(T *out, const T *a, T b, std::size_t n) {
+    const std::size_t w = Tr::width;
+    typename Tr::Reg scalar = Tr::set1(b);
+    std::size_t i = 0;
+    for (; i + 2*w <= n; i += 2*w) {
+        typename Tr::Reg r0 = Tr::apply(Op(), Tr::load(a + i), scalar);
+        typename Tr::Reg r1 = Tr::apply(Op(), Tr::load(a + i + w), scalar);
+        Tr::store(out + i, r0);
+        Tr::store(out + i + w, r1);
+    }
+    for (; i + w <= n; i += w) {
+        Tr::store(out + i, Tr::apply(Op(), Tr::load(a + i), scalar));
+    }
+    for (; i < n; i++) {
+        T val = a[i];
+        Op::apply(val, b);
+        out[i] = val;
+    }
+}
+
+#endif // MATRIX_DSP_X86_SIMD
+
+/*****************************************************************************************
+                                        Dispatchers
+*****************************************************************************************/
+template <class Op, class T, class U>
+void binaryGeneric(T *out, const T *a, const U *b, std::size_t n) {
+    for (std::size_t i=0; i<n; i++) {
+        T val = a[i];
+        Op::apply(val, b[i]);
+        out[i] = val;
+    }
+}
+
+template <class Op, class T, class U>
+void binaryScalarGeneric(T *out, const T *a, const U &b, std::size_t n) {
+    for (std::size_t i=0; i<n; i++) {
+        T val = a[i];
+        Op::apply(val, b);
+        out[i] = val;
+    }
+}
+
+template <class Op, class T>
+void binaryDispatch(T *out, const T *a, const T *b, std::size_t n, std::false_type) {
+    binaryGeneric<Op>(out, a, b, n);
+}
+
+template <class Op, class T>
+void binaryDispatch(T *out, const T *a, const T *b, std::size_t n, std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && Traits<Isa::Avx512, T>::available()) {
+        return binaryAvx512< Traits<Isa::Avx512, T>, Op >(out, a, b, n);
+    }
+    if (isa >= Isa::Avx2 && Traits<Isa::Avx2, T>::available()) {
+        return binaryAvx2< Traits<Isa::Avx2, T>, Op >(out, a, b, n);
+    }
+    if (isa >= Isa::Sse2 && Traits<Isa::Sse2, T>::available()) {
+        return binarySse2< Traits<Isa::Sse2, T>, Op >(out, a, b, n);
+    }
+#endif
+    binaryGeneric<Op>(out, a, b, n);
+}
+
+template <class Op, class T>
+void binaryScalarDispatch(T *out, const T *a, const T &b, std::size_t n, std::false_type) {
+    binaryScalarGeneric<Op>(out, a, b, n);
+}
+
+template <class Op, class T>
+void binaryScalarDispatch(T *out, const T *a, const T &b, std::size_t n, std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && Traits<Isa::Avx512, T>::available()) {
+        return binaryScalarAvx512< Traits<Isa::Avx512, T>, Op >(out, a, b, n);
+    }
+    if (isa >= Isa::Avx2 && Traits<Isa::Avx2, T>::available()) {
+        return binaryScalarAvx2< Traits<Isa::Avx2, T>, Op >(out, a, b, n);
+    }
+    if (isa >= Isa::Sse2 && Traits<Isa::Sse2, T>::available()) {
+        return binaryScalarSse2< Traits<Isa::Sse2, T>, Op >(out, a, b, n);
+    }
+#endif
+    binaryScalarGeneric<Op>(out, a, b, n);
+}
+
+/**
+ * \brief out[i] = a[i] op b[i], with the same conversions as "a[i] op= b[i]".
+ *
+ * "out" may be the same as "a" or "b".  Mixed types always use the scalar loop.
+ */
+template <class Op, class T, class U>
+void binary(T *out, const T *a, const U *b, std::size_t n) {
+    binaryGeneric<Op>(out, a, b, n);
+}
+
+template <class Op, class T>
+void binary(T *out, const T *a, const T *b, std::size_t n) {
+    binaryDispatch<Op>(out, a, b, n, HasKernel<T, Op>());
+}
+
+/**
+ * \brief out[i] = a[i] op b, with the same conversions as "a[i] op= b".
+ *
+ * "out" may be the same as "a".
+ */
+template <class Op, class T, class U>
+void binaryScalar(T *out, const T *a, const U &b, std::size_t n) {
+    binaryScalarGeneric<Op>(out, a, b, n);
+}
+
+template <class Op, class T>
+void binaryScalar(T *out, const T *a, const T &b, std::size_t n) {
+    binaryScalarDispatch<Op>(out, a, b, n, HasKernel<T, Op>());
+}
+
+/*****************************************************************************************
+                                    Spectrum multiply
+*****************************************************************************************/
+/**
+ * \brief True if there is a vector kernel for multiplying spectra of std::complex<T>.
+ */
+template <class T>
+struct HasSpectrumKernel : std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value> {};
+
+// x[k] *= h[k] for k < n.  The products are written out in real arithmetic because
+// std::complex multiplication checks for infinities and NaNs, which is several times slower.
+
+template <class T>
+void multiplySpectrumGeneric(std::complex<T> *x, const std::complex<T> *h, std::size_t n) {
+    for (std::size_t k = 0; k < n; k++) {
+        T re = x[k].real() * h[k].real() - x[k].imag() * h[k].imag();
+        T im = x[k].real() * h[k].imag() + x[k].imag() * h[k].real();
+        x[k] = std::complex<T>(re, im);
+    }
+}
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+template <class Tr, class T>
+MATRIX_DSP_TARGET_AVX2 void multiplySpectrumAvx2(std::complex<T> *x, const std::complex<T> *h, std::size_t n) {
+    const std::size_t w = Tr::width;
+    std::size_t k = 0;
+    for (; k + w <= n; k += w) {
+        Tr::store(x + k, Tr::mul(Tr::load(x + k), Tr::load(h + k)));
+    }
+    multiplySpectrumGeneric(x + k, h + k, n - k);
+}
+
+template <class Tr, class T>
+MATRIX_DSP_TARGET_AVX512 void multiplySpectrumAvx512(std::complex<T> *x, const std::complex<T> *h, std::size_t n) {
+    const std::size_t w = Tr::width;
+    std::size_t k = 0;
+    for (; k + w <= n; k += w) {
+        Tr::store(x + k, Tr::mul(Tr::load(x + k), Tr::load(h + k)));
+    }
+    multiplySpectrumGeneric(x + k, h + k, n - k);
+}
+
+#endif // MATRIX_DSP_X86_SIMD
+
+template <class T>
+void multiplySpectrumDispatch(std::complex<T> *x, const std::complex<T> *h, std::size_t n, std::false_type) {
+    multiplySpectrumGeneric(x, h, n);
+}
+
+template <class T>
+void multiplySpectrumDispatch(std::complex<T> *x, const std::complex<T> *h, std::size_t n, std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && ComplexTraits<Isa::Avx512, T>::available()) {
+        return multiplySpectrumAvx512< ComplexTraits<Isa::Avx512, T> >(x, h, n);
+    }
+    if (isa >= Isa::Avx2 && ComplexTraits<Isa::Avx2, T>::available()) {
+        return multiplySpectrumAvx2< ComplexTraits<Isa::Avx2, T> >(x, h, n);
+    }
+#endif
+    multiplySpectrumGeneric(x, h, n);
+}
+
+/**
+ * \brief x[k] *= h[k] for k < n.
+ */
+template <class T>
+void multiplySpectrum(std::complex<T> *x, const std::complex<T> *h, std::size_t n) {
+    multiplySpectrumDispatch(x, h, n, HasSpectrumKernel<T>());
+}
+
+}
+}
+
+#endif /* Simd_h */
@@ -0,0 +1,561 @@
+//
+//  Statistics.h
+//  MatrixDSP
+//
+//  Summary statistics of a block of samples in one pass over memory.  The samples are taken
+//  in L1 sized blocks.  Each block is summed (and its minimum and maximum found) with SIMD,
+//  then its squared deviations from its own mean are summed while it's still in cache.  The
+//  blocks are combined with Chan's parallel update for the variance and a compensated
+//  (Neumaier) sum of the block sums, so the error doesn't grow with the length of the data the
+//  way a running sum's does, and the variance doesn't suffer the cancellation of the
+//  sum-of-squares formula.
+//
+//  The accumulator type "Acc" may be wider than the samples, e.g. float samples with double
+//  sums.  There are AVX2 and AVX-512 kernels for float and double samples with float or double
+//  accumulators (float samples can be widened to double), selected at run time like the ones
+//  in Simd.h.  Other types use plain loops in the same blocks.
+//
+
+#ifndef Statistics_h
+#define Statistics_h
+
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <type_traits>
+#include "Simd.h"
+
+namespace MatrixDSP {
+
+/**
+ * \brief Statistics of real samples, as returned by stats().
+ *
+ * "var" and "stdDev" are normalized by N - 1 or N depending on the "subset" argument, like
+ * var().  "min" and "max" are in the type of the samples, and "minLoc" and "maxLoc" are the
+ * indexes of their first occurrences, like min() and max().
+ */
+template <class T, class Acc = T>
+struct Stats {
+    Acc sum;
+    Acc mean;
+    Acc var;
+    Acc stdDev;
+    T min;
+    T max;
+    unsigned minLoc;
+    unsigned maxLoc;
+};
+
+/**
+ * \brief Statistics of complex samples, as returned by stats().
+ *
+ * "var" is the mean squared magnitude of the deviations from the mean, normalized by N - 1 or
+ * N depending on the "subset" argument, and "power" is the mean squared magnitude of the
+ * samples.
+ */
+template <class T, class Acc = T>
+struct ComplexStats {
+    std::complex<Acc> sum;
+    std::complex<Acc> mean;
+    Acc var;
+    Acc stdDev;
+    Acc power;
+};
+
+/**
+ * \brief The default accumulator type for samples of type T: T itself for floating point
+ *      samples and double for integers.
+ */
+template <class T>
+struct StatsAccumulator {
+    typedef typename std::conditional<std::is_floating_point<T>::value, T, double>::type type;
+};
+
+template <class T>
+struct StatsAccumulator< std::complex<T> > {
+    typedef typename StatsAccumulator<T>::type type;
+};
+
+/**
+ * \brief What stats() returns for samples of type T.
+ */
+template <class T, class Acc>
+struct StatsResult {
+    typedef Stats<T, Acc> type;
+};
+
+template <class T, class Acc>
+struct StatsResult<std::complex<T>, Acc> {
+    typedef ComplexStats<T, Acc> type;
+};
+
+namespace simd {
+
+/**
+ * \brief The number of real values (real and imaginary parts for complex samples) in each block.
+ */
+const std::size_t statsBlockSize = 1024;
+
+/**
+ * \brief True if there are statistics kernels for samples of type T with accumulators of type
+ *      Acc.
+ */
+template <class T, class Acc>
+struct HasStatsKernel : std::integral_constant<bool,
+    (std::is_same<T, float>::value && (std::is_same<Acc, float>::value || std::is_same<Acc, double>::value)) ||
+    (std::is_same<T, double>::value && std::is_same<Acc, double>::value)> {};
+
+/**
+ * \brief The sums of one block.  The samples are NP interleaved parts, i.e. 1 for real samples
+ *      and 2 (real and imaginary) for complex ones.  "sumSquares" is only found for complex
+ *      samples, and "min" and "max" only for real ones.  The block kernels take "min" and "max"
+ *      in as the extremes so far and update them, so a NaN at the start of a block is skipped
+ *      like any other.
+ */
+template <class Acc>
+struct StatsPartials {
+    Acc sum[2];
+    Acc m2;             // Sum of the squared deviations from the block mean
+    Acc sumSquares;
+    Acc min;
+    Acc max;
+};
+
+/**
+ * \brief The number of separate sums that statsBlockGeneric() keeps, like the lanes of a
+ *      register, so that each one only gets a fraction of the block.
+ */
+const unsigned statsGenericLanes = 8;
+
+template <unsigned NP, class T, class Acc>
+void statsBlockGeneric(const T *data, std::size_t n, StatsPartials<Acc> &out) {
+    Acc lanes[statsGenericLanes] = {};
+    Acc sumSquares = 0;
+    Acc low = out.min;
+    Acc high = out.max;
+    for (std::size_t j = 0; j < n; j++) {
+        Acc x = (Acc) data[j];
+        lanes[j % statsGenericLanes] += x;
+        if (NP == 1) {
+            low = x < low ? x : low;
+            high = high < x ? x : high;
+        }
+        else {
+            sumSquares += x * x;
+        }
+    }
+    Acc sums[2] = {0, 0};
+    for (unsigned lane = 0; lane < statsGenericLanes; lane++) {
+        sums[lane % NP] += lanes[lane];
+    }
+    Acc count = (Acc) (n / NP);
+    Acc means[2] = {sums[0] / count, sums[1] / count};
+    Acc m2 = 0;
+    for (std::size_t j = 0; j < n; j++) {
+        Acc dev = (Acc) data[j] - means[j % NP];
+        m2 += dev * dev;
+    }
+    out.sum[0] = sums[0];
+    out.sum[1] = sums[1];
+    out.m2 = m2;
+    out.sumSquares = sumSquares;
+    out.min = low;
+    out.max = high;
+}
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+/*****************************************************************************************
+                                        Kernels
+*****************************************************************************************/
+// StatsTraits<isa, T, Acc> loads samples of type T into registers of type Acc, and has the
+// element-wise minimum and maximum.  min() and max() return their second argument if the first
+// is a NaN, so NaNs are skipped like they are by the scalar comparisons.  The AVX-512 ones use the
+// zero-masking intrinsics with every lane set, because GCC's unmasked ones merge into an
+// undefined register, which -Wmaybe-uninitialized warns about wherever they are inlined.
+
+template <Isa isa, class T, class Acc>
+struct StatsTraits;
+
+template <>
+struct StatsTraits<Isa::Avx2, float, float> {
+    typedef Traits<Isa::Avx2, float> Tr;
+    typedef Tr::Reg Reg;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg load(const float *p) {return _mm256_loadu_ps(p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm256_min_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm256_max_ps(a, b);}
+};
+
+template <>
+struct StatsTraits<Isa::Avx2, float, double> {
+    typedef Traits<Isa::Avx2, double> Tr;
+    typedef Tr::Reg Reg;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg load(const float *p) {return _mm256_cvtps_pd(_mm_loadu_ps(p));}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm256_min_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm256_max_pd(a, b);}
+};
+
+template <>
+struct StatsTraits<Isa::Avx2, double, double> {
+    typedef Traits<Isa::Avx2, double> Tr;
+    typedef Tr::Reg Reg;
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg load(const double *p) {return _mm256_loadu_pd(p);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm256_min_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm256_max_pd(a, b);}
+};
+
+template <>
+struct StatsTraits<Isa::Avx512, float, float> {
+    typedef Traits<Isa::Avx512, float> Tr;
+    typedef Tr::Reg Reg;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg load(const float *p) {return _mm512_loadu_ps(p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm512_maskz_min_ps((__mmask16) -1, a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm512_maskz_max_ps((__mmask16) -1, a, b);}
+};
+
+template <>
+struct StatsTraits<Isa::Avx512, float, double> {
+    typedef Traits<Isa::Avx512, double> Tr;
+    typedef Tr::Reg Reg;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg load(const float *p) {return _mm512_maskz_cvtps_pd((__mmask8) -1, _mm256_loadu_ps(p));}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm512_maskz_min_pd((__mmask8) -1, a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm512_maskz_max_pd((__mmask8) -1, a, b);}
+};
+
+template <>
+struct StatsTraits<Isa::Avx512, double, double> {
+    typedef Traits<Isa::Avx512, double> Tr;
+    typedef Tr::Reg Reg;
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg load(const double *p) {return _mm512_loadu_pd(p);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm512_maskz_min_pd((__mmask8) -1, a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm512_maskz_max_pd((__mmask8) -1, a, b);}
+};
+
+// statsBlock*() is statsBlockGeneric() with two registers per sum.  The register width is
+// even, so lane "l" always holds part l % NP.  Only the register loops are in the kernels,
+// which are the same for every instruction set but have one copy per instruction set because
+// the target attribute has to be a literal.  They store their registers, and statsFinishSums()
+// and statsFinishDeviations() combine the lanes and do the samples after the last pair of
+// registers (a block is usually a whole number of pairs).
+
+/**
+ * \brief Finishes the first pass over a block: combines the register lanes of the sums and of
+ *      the minimums and maximums (real samples) or sums of squares (complex samples), then adds
+ *      data[j] to data[n - 1].
+ */
+template <unsigned NP, class T, class Acc>
+void statsFinishSums(const T *data, std::size_t j, std::size_t n, std::size_t w, const Acc *sumLanes,
+        const Acc *lowOrSquareLanes, const Acc *highLanes, StatsPartials<Acc> &out) {
+    Acc sums[2] = {0, 0};
+    for (std::size_t lane = 0; lane < w; lane++) {
+        sums[lane % NP] += sumLanes[lane];
+    }
+    Acc sumSquares = 0;
+    Acc blockMin = out.min;
+    Acc blockMax = out.max;
+    for (std::size_t lane = 0; lane < w; lane++) {
+        if (NP == 1) {
+            blockMin = lowOrSquareLanes[lane] < blockMin ? lowOrSquareLanes[lane] : blockMin;
+            blockMax = blockMax < highLanes[lane] ? highLanes[lane] : blockMax;
+        }
+        else {
+            sumSquares += lowOrSquareLanes[lane];
+        }
+    }
+    for (; j < n; j++) {
+        Acc x = (Acc) data[j];
+        sums[j % NP] += x;
+        if (NP == 1) {
+            blockMin = x < blockMin ? x : blockMin;
+            blockMax = blockMax < x ? x : blockMax;
+        }
+        else {
+            sumSquares += x * x;
+        }
+    }
+    out.sum[0] = sums[0];
+    out.sum[1] = sums[1];
+    out.sumSquares = sumSquares;
+    out.min = blockMin;
+    out.max = blockMax;
+}
+
+/**
+ * \brief Fills the "w" lanes of "meanLanes" with the block means that the second pass subtracts.
+ */
+template <unsigned NP, class Acc>
+void statsMeanLanes(const StatsPartials<Acc> &partials, std::size_t n, std::size_t w, Acc *meanLanes) {
+    Acc count = (Acc) (n / NP);
+    for (std::size_t lane = 0; lane < w; lane++) {
+        meanLanes[lane] = partials.sum[lane % NP] / count;
+    }
+}
+
+/**
+ * \brief Finishes the second pass over a block: adds up the register lanes of the squared
+ *      deviations, then the ones of data[j] to data[n - 1].
+ */
+template <unsigned NP, class T, class Acc>
+void statsFinishDeviations(const T *data, std::size_t j, std::size_t n, std::size_t w, const Acc *devLanes,
+        const Acc *meanLanes, StatsPartials<Acc> &out) {
+    Acc m2 = 0;
+    for (std::size_t lane = 0; lane < w; lane++) {
+        m2 += devLanes[lane];
+    }
+    for (; j < n; j++) {
+        Acc dev = (Acc) data[j] - meanLanes[j % NP];
+        m2 += dev * dev;
+    }
+    out.m2 = m2;
+}
+
+template <class St, unsigned NP, class T, class Acc>
+MATRIX_DSP_TARGET_AVX2 void statsBlockAvx2(const T *data, std::size_t n, StatsPartials<Acc> &out) {
+    typedef typename St::Tr Tr;
+    typedef typename Tr::Reg Reg;
+    const std::size_t w = Tr::width;
+    Reg sum0 = Tr::set1(0);
+    Reg sum1 = Tr::set1(0);
+    Reg squares = Tr::set1(0);
+    Reg low = Tr::set1(out.min);
+    Reg high = Tr::set1(out.max);
+    std::size_t j = 0;
+    for (; j + 2 * w <= n; j += 2 * w) {
+        Reg x0 = St::load(data + j);
+        Reg x1 = St::load(data + j + w);
+        sum0 = Tr::apply(Add(), sum0, x0);
+        sum1 = Tr::apply(Add(), sum1, x1);
+        if (NP == 1) {
+            low = St::min(x1, St::min(x0, low));
+            high = St::max(x1, St::max(x0, high));
+        }
+        else {
+            squares = Tr::fmadd(x1, x1, Tr::fmadd(x0, x0, squares));
+        }
+    }
+    Acc lanes[3][Tr::width];
+    Tr::store(lanes[0], Tr::apply(Add(), sum0, sum1));
+    Tr::store(lanes[1], NP == 1 ? low : squares);
+    Tr::store(lanes[2], high);
+    statsFinishSums<NP>(data, j, n, w, lanes[0], lanes[1], lanes[2], out);
+
+    statsMeanLanes<NP>(out, n, w, lanes[1]);
+    Reg mean = Tr::load(lanes[1]);
+    Reg dev0 = Tr::set1(0);
+    Reg dev1 = Tr::set1(0);
+    for (j = 0; j + 2 * w <= n; j += 2 * w) {
+        Reg d0 = Tr::apply(Sub(), St::load(data + j), mean);
+        Reg d1 = Tr::apply(Sub(), St::load(data + j + w), mean);
+        dev0 = Tr::fmadd(d0, d0, dev0);
+        dev1 = Tr::fmadd(d1, d1, dev1);
+    }
+    Tr::store(lanes[0], Tr::apply(Add(), dev0, dev1));
+    statsFinishDeviations<NP>(data, j, n, w, lanes[0], lanes[1], out);
+}
+
+template <class St, unsigned NP, class T, class Acc>
+MATRIX_DSP_TARGET_AVX512 void statsBlockAvx512(const T *data, std::size_t n, StatsPartials<Acc> &out) {
+    typedef typename St::Tr Tr;
+    typedef typename Tr::Reg Reg;
+    const std::size_t w = Tr::width;
+    Reg sum0 = Tr::set1(0);
+    Reg sum1 = Tr::set1(0);
+    Reg squares = Tr::set1(0);
+    Reg low = Tr::set1(out.min);
+    Reg high = Tr::set1(out.max);
+    std::size_t j = 0;
+    for (; j + 2 * w <= n; j += 2 * w) {
+        Reg x0 = St::load(data + j);
+        Reg x1 = St::load(data + j + w);
+        sum0 = Tr::apply(Add(), sum0, x0);
+        sum1 = Tr::apply(Add(), sum1, x1);
+        if (NP == 1) {
+            low = St::min(x1, St::min(x0, low));
+            high = St::max(x1, St::max(x0, high));
+        }
+        else {
+            squares = Tr::fmadd(x1, x1, Tr::fmadd(x0, x0, squares));
+        }
+    }
+    Acc lanes[3][Tr::width];
+    Tr::store(lanes[0], Tr::apply(Add(), sum0, sum1));
+    Tr::store(lanes[1], NP == 1 ? low : squares);
+    Tr::store(lanes[2], high);
+    statsFinishSums<NP>(data, j, n, w, lanes[0], lanes[1], lanes[2], out);
+
+    statsMeanLanes<NP>(out, n, w, lanes[1]);
+    Reg mean = Tr::load(lanes[1]);
+    Reg dev0 = Tr::set1(0);
+    Reg dev1 = Tr::set1(0);
+    for (j = 0; j + 2 * w <= n; j += 2 * w) {
+        Reg d0 = Tr::apply(Sub(), St::load(data + j), mean);
+        Reg d1 = Tr::apply(Sub(), St::load(data + j + w), mean);
+        dev0 = Tr::fmadd(d0, d0, dev0);
+        dev1 = Tr::fmadd(d1, d1, dev1);
+    }
+    Tr::store(lanes[0], Tr::apply(Add(), dev0, dev1));
+    statsFinishDeviations<NP>(data, j, n, w, lanes[0], lanes[1], out);
+}
+
+#endif // MATRIX_DSP_X86_SIMD
+
+/*****************************************************************************************
+                                        Dispatchers
+*****************************************************************************************/
+template <unsigned NP, class T, class Acc>
+using StatsBlockFunction = void (*)(const T *, std::size_t, StatsPartials<Acc> &);
+
+template <unsigned NP, class T, class Acc>
+StatsBlockFunction<NP, T, Acc> statsBlockKernel(std::false_type) {
+    return statsBlockGeneric<NP, T, Acc>;
+}
+
+template <unsigned NP, class T, class Acc>
+StatsBlockFunction<NP, T, Acc> statsBlockKernel(std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && Traits<Isa::Avx512, Acc>::available()) {
+        return statsBlockAvx512<StatsTraits<Isa::Avx512, T, Acc>, NP, T, Acc>;
+    }
+    if (isa >= Isa::Avx2 && Traits<Isa::Avx2, Acc>::available()) {
+        return statsBlockAvx2<StatsTraits<Isa::Avx2, T, Acc>, NP, T, Acc>;
+    }
+#endif
+    return statsBlockGeneric<NP, T, Acc>;
+}
+
+/**
+ * \brief Combines the partial sums of the blocks.
+ */
+template <unsigned NP, class Acc>
+struct RunningStats {
+    std::size_t count;          // Samples so far
+    Acc sum[2];
+    Acc compensation[2];        // The low order bits that "sum" has lost
+    Acc mean[2];
+    Acc m2;
+    Acc sumSquares;
+
+    RunningStats() : count(0), sum{0, 0}, compensation{0, 0}, mean{0, 0}, m2(0), sumSquares(0) {}
+
+    void add(std::size_t blockCount, const StatsPartials<Acc> &block) {
+        std::size_t total = count + blockCount;
+        Acc deltaSquared = 0;
+        for (unsigned part = 0; part < NP; part++) {
+            // Neumaier's version of Kahan summation, which also copes with terms bigger than
+            // the sum so far
+            Acc newSum = sum[part] + block.sum[part];
+            if (std::abs(sum[part]) >= std::abs(block.sum[part])) {
+                compensation[part] += (sum[part] - newSum) + block.sum[part];
+            }
+            else {
+                compensation[part] += (block.sum[part] - newSum) + sum[part];
+            }
+            sum[part] = newSum;
+
+            Acc delta = block.sum[part] / (Acc) blockCount - mean[part];
+            mean[part] += delta * ((Acc) blockCount / (Acc) total);
+            deltaSquared += delta * delta;
+        }
+        m2 += block.m2 + deltaSquared * ((Acc) count * (Acc) blockCount / (Acc) total);
+        sumSquares += block.sumSquares;
+        count = total;
+    }
+
+    Acc totalSum(unsigned part) const {return sum[part] + compensation[part];}
+
+    Acc variance(bool subset) const {return m2 / (Acc) (subset ? count - 1 : count);}
+};
+
+/**
+ * \brief Returns the index of the first of "n" samples that's equal to "value", which must be
+ *      one of them.  A NaN can only be the minimum or maximum if it's the first sample.
+ */
+template <class T, class Acc>
+std::size_t firstIndexOf(const T *data, std::size_t n, Acc value) {
+    if (value != value) {
+        return 0;
+    }
+    std::size_t index = 0;
+    while (index + 1 < n && (Acc) data[index] != value) {
+        index++;
+    }
+    return index;
+}
+
+/**
+ * \brief Returns the statistics of "n" real samples.  See Stats.
+ *
+ * \param subset Normalize the variance by N - 1 rather than N.
+ */
+template <class Acc, class T>
+Stats<T, Acc> stats(const T *data, std::size_t n, bool subset = true) {
+    assert(n > 0);
+    StatsBlockFunction<1, T, Acc> kernel = statsBlockKernel<1, T, Acc>(HasStatsKernel<T, Acc>());
+    RunningStats<1, Acc> running;
+    Stats<T, Acc> result;
+    Acc low = (Acc) data[0];
+    Acc high = low;
+    for (std::size_t start = 0; start < n; start += statsBlockSize) {
+        const T *block = data + start;
+        std::size_t count = n - start < statsBlockSize ? n - start : statsBlockSize;
+        StatsPartials<Acc> partials;
+        partials.min = low;
+        partials.max = high;
+        kernel(block, count, partials);
+
+        // Only a block with a new minimum or maximum is searched for its index, so the common
+        // case costs nothing, and "<" keeps the first occurrence
+        if (start == 0 || partials.min < low) {
+            low = partials.min;
+            result.minLoc = (unsigned) (start + firstIndexOf(block, count, low));
+        }
+        if (start == 0 || high < partials.max) {
+            high = partials.max;
+            result.maxLoc = (unsigned) (start + firstIndexOf(block, count, high));
+        }
+        running.add(count, partials);
+    }
+    result.sum = running.totalSum(0);
+    result.mean = result.sum / (Acc) n;
+    result.var = running.variance(subset);
+    result.stdDev = std::sqrt(result.var);
+    result.min = data[result.minLoc];
+    result.max = data[result.maxLoc];
+    return result;
+}
+
+/**
+ * \brief Returns the statistics of "n" complex samples.  See ComplexStats.
+ *
+ * \param subset Normalize the variance by N - 1 rather than N.
+ */
+template <class Acc, class T>
+ComplexStats<T, Acc> stats(const std::complex<T> *data, std::size_t n, bool subset = true) {
+    assert(n > 0);
+    // std::complex is laid out as an array of its real and imaginary parts
+    const T *parts = reinterpret_cast<const T *>(data);
+    StatsBlockFunction<2, T, Acc> kernel = statsBlockKernel<2, T, Acc>(HasStatsKernel<T, Acc>());
+    RunningStats<2, Acc> running;
+    for (std::size_t start = 0; start < 2 * n; start += statsBlockSize) {
+        std::size_t count = 2 * n - start < statsBlockSize ? 2 * n - start : statsBlockSize;
+        StatsPartials<Acc> partials;
+        partials.min = 0;
+        partials.max = 0;
+        kernel(parts + start, count, partials);
+        running.add(count / 2, partials);
+    }
+    ComplexStats<T, Acc> result;
+    result.sum = std::complex<Acc>(running.totalSum(0), running.totalSum(1));
+    result.mean = result.sum / (Acc) n;
+    result.var = running.variance(subset);
+    result.stdDev = std::sqrt(result.var);
+    result.power = running.sumSquares / (Acc) n;
+    return result;
+}
+
+}
+}
+
+#endif /* Statistics_h */
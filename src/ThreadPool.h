@@ -0,0 +1,246 @@
+//
+//  ThreadPool.h
+//  MatrixDSP
+//
+//  A persistent pool of worker threads for splitting large operations (for example the
+//  multiplication of big matrices) into independent tasks.  Every worker has its own queue of
+//  tasks.  A worker runs the tasks in its own queue from the front and, when it runs out,
+//  steals from the back of the other queues, so a worker that gets cheap tasks helps the ones
+//  that got expensive ones.  The thread that starts the work runs tasks too, so a pool with N
+//  threads has N - 1 workers, and starting work from inside a task doesn't deadlock.
+//
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace MatrixDSP {
+
+class ThreadPool {
+    private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque< std::function<void()> > tasks;
+    };
+
+    // One parallelFor() call
+    struct Batch {
+        std::atomic<std::size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+
+    std::vector< std::unique_ptr<TaskQueue> > queues;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queuedTasks;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    bool popTask(std::size_t queueIndex, bool steal, std::function<void()> &task) {
+        TaskQueue &queue = *queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        if (steal) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * \brief Runs one task, from queue "home" if it has one and stolen from another queue if
+     *      not.  Returns false if there weren't any tasks.
+     */
+    bool runTask(std::size_t home) {
+        std::function<void()> task;
+        bool found = home < queues.size() && popTask(home, false, task);
+        for (std::size_t offset = 1; !found && offset <= queues.size(); offset++) {
+            found = popTask((home + offset) % queues.size(), true, task);
+        }
+        if (found) {
+            task();
+        }
+        return found;
+    }
+
+    void workerLoop(std::size_t index) {
+        while (true) {
+            if (runTask(index)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] {return stopping || queuedTasks.load(std::memory_order_relaxed) > 0;});
+            if (stopping && queuedTasks.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+        }
+    }
+
+    static void pinToCpu(std::thread &thread, int cpu) {
+#if defined(__linux__)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#else
+        (void) thread;
+        (void) cpu;
+#endif
+    }
+
+    public:
+    /**
+     * \brief Returns the number of threads that the hardware can run at once (at least 1).
+     */
+    static unsigned hardwareThreads() {
+        unsigned threads = std::thread::hardware_concurrency();
+        return threads == 0 ? 1 : threads;
+    }
+
+    /**
+     * \brief Constructor.
+     *
+     * \param numThreads The number of threads that work on each parallelFor(), including the
+     *      thread that calls it.  So numThreads - 1 workers are started.  Defaults to the
+     *      number of hardware threads.
+     * \param cpus If not empty, worker i is pinned to CPU cpus[i % cpus.size()].  Only supported
+     *      on Linux, and ignored elsewhere.
+     */
+    explicit ThreadPool(unsigned numThreads = hardwareThreads(), const std::vector<int> &cpus = std::vector<int>())
+            : queuedTasks(0), stopping(false) {
+        unsigned numWorkers = numThreads > 1 ? numThreads - 1 : 0;
+        for (unsigned index = 0; index < numWorkers; index++) {
+            queues.emplace_back(new TaskQueue());
+        }
+        for (unsigned index = 0; index < numWorkers; index++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, (std::size_t) index);
+            if (!cpus.empty()) {
+                pinToCpu(workers.back(), cpus[index % cpus.size()]);
+            }
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    /**
+     * \brief The number of threads that work on a parallelFor(), including the caller.
+     */
+    unsigned size() const {return (unsigned) workers.size() + 1;}
+
+    /**
+     * \brief Calls func(index) for every index in [0, numTasks) and returns when all of the
+     *      calls are done.
+     *
+     * The calls are spread over the pool and may run in any order and at the same time, so
+     * "func" must be safe to call concurrently with different indexes.  It must not throw.
+     */
+    template <class F>
+    void parallelFor(std::size_t numTasks, F func) {
+        if (workers.empty() || numTasks <= 1) {
+            for (std::size_t index = 0; index < numTasks; index++) {
+                func(index);
+            }
+            return;
+        }
+
+        Batch batch;
+        batch.remaining.store(numTasks, std::memory_order_relaxed);
+        // Contiguous runs of indexes go to each queue, so neighbouring tasks (which often
+        // share data) tend to run on the same thread
+        for (std::size_t queueIndex = 0; queueIndex < queues.size(); queueIndex++) {
+            std::size_t begin = queueIndex * numTasks / queues.size();
+            std::size_t end = (queueIndex + 1) * numTasks / queues.size();
+            std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+            for (std::size_t index = begin; index < end; index++) {
+                queues[queueIndex]->tasks.emplace_back([&batch, &func, index] {
+                    func(index);
+                    // Under the lock so that the caller can't return (and destroy "batch")
+                    // until this task is finished with it
+                    std::lock_guard<std::mutex> batchLock(batch.mutex);
+                    if (batch.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        batch.done.notify_all();
+                    }
+                });
+            }
+            queuedTasks.fetch_add(end - begin, std::memory_order_relaxed);
+        }
+        {
+            // A worker that saw no tasks is either already waiting or will see them
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_all();
+
+        // Help out until there is nothing left to steal, then wait for the tasks that are
+        // still running
+        while (batch.remaining.load(std::memory_order_acquire) > 0 && runTask(queues.size())) {
+        }
+        std::unique_lock<std::mutex> lock(batch.mutex);
+        batch.done.wait(lock, [&batch] {return batch.remaining.load(std::memory_order_acquire) == 0;});
+    }
+};
+
+inline std::atomic<ThreadPool *> & defaultThreadPoolSetting() {
+    static std::atomic<ThreadPool *> setting(nullptr);
+    return setting;
+}
+
+/**
+ * \brief Makes "pool" the pool that the library uses for its own parallel operations, such as
+ *      Matrix2d multiplication.  Passing nullptr goes back to the library's own pool.
+ *
+ * The pool must outlive its use by the library.
+ */
+inline void setDefaultThreadPool(ThreadPool *pool) {
+    defaultThreadPoolSetting().store(pool, std::memory_order_release);
+}
+
+/**
+ * \brief Returns the pool that the library uses for its own parallel operations.  Unless
+ *      setDefaultThreadPool() has been called, that is a pool with one thread per hardware
+ *      thread, which is started the first time that it's needed.
+ */
+inline ThreadPool & defaultThreadPool() {
+    ThreadPool *pool = defaultThreadPoolSetting().load(std::memory_order_acquire);
+    if (pool != nullptr) {
+        return *pool;
+    }
+    static ThreadPool libraryPool;
+    return libraryPool;
+}
+
+}
+
+#endif /* ThreadPool_h */
@@ -0,0 +1,732 @@
+//
+//  Transcendental.h
+//  MatrixDSP
+//
+//  Vectorized exp(), log(), log10(), pow() and abs() of arrays of floats and doubles, and the
+//  power of complex samples in dB, 10 log10(|x|^2), in one pass.
+//
+//  exp(x) splits x into n ln2 + r, with |r| <= ln2 / 2, using ln2 in two parts so that r is
+//  exact, sums the Taylor series of e^r (degree 7 for float, 13 for double) and scales by 2^n
+//  in the exponent bits.  log(x) splits x into 2^e m, with m in [sqrt(1/2), sqrt(2)), and uses
+//  the series of log(1 + f) = 2 atanh(f / (2 + f)) in the form that fdlibm uses, which keeps
+//  the largest terms exact.  Measured over the whole range of each type the errors are:
+//
+//      exp     float 1 ulp, double 1 ulp
+//      log     float 1 ulp, double 1 ulp
+//      log10   float 2 ulps, double 2 ulps
+//      pow     float 1 ulp (computed in double), double uses std::pow
+//      abs     exact
+//
+//  10 log10(|x|^2) in dB is within 2e-5 dB for floats and 2e-14 dB for doubles, which is the
+//  error that rounding |x|^2 to the type already causes.  Double pow() stays with std::pow
+//  because exp(y log x) would need log x to more than double precision.
+//
+//  Special values match the standard library: exp() overflows to infinity and underflows
+//  through the subnormals to zero, log() gives -infinity for zero and NaN for negative numbers,
+//  NaN in gives NaN out, and pow() hands the cases that exp(y log x) doesn't cover (x <= 0,
+//  infinities, NaNs) to std::pow.
+//
+//  There are AVX2 and AVX-512 kernels, selected at run time like the ones in Simd.h.  Without
+//  them, and for other types, the standard library functions are used.
+//
+
+#ifndef Transcendental_h
+#define Transcendental_h
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "PeakSearch.h"
+#include "Simd.h"
+
+namespace MatrixDSP {
+
+namespace simd {
+
+/**
+ * \brief 1 / k!, the Taylor series coefficients of e^x.
+ */
+const double expCoefficients[] = {1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320,
+                                  1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600, 1.0 / 6227020800.0};
+
+/**
+ * \brief 2 / (2k + 1) for k from 1 up: the series of log(1 + f) in terms of s = f / (2 + f),
+ *      after the first term, 2s, and in powers of s^2.
+ */
+const double logCoefficients[] = {2.0 / 3, 2.0 / 5, 2.0 / 7, 2.0 / 9, 2.0 / 11, 2.0 / 13, 2.0 / 15, 2.0 / 17, 2.0 / 19,
+                                  2.0 / 21};
+
+/**
+ * \brief The type-specific constants of the kernels.
+ */
+template <class T>
+struct MathConstants;
+
+template <>
+struct MathConstants<float> {
+    static const unsigned expTerms = 8;
+    static const unsigned logTerms = 4;
+    static const int subnormalShift = 25;
+    // Above this exp() overflows, and below this it underflows to 0
+    static float maxExp() {return 88.72283935546875f;}
+    static float minExp() {return -103.972084045410f;}
+    // Adding this rounds to an integer, which is left in the low mantissa bits
+    static float roundMagic() {return 12582912.0f;}
+    static float ln2Hi() {return 6.9314575195e-01f;}
+    static float ln2Lo() {return 1.4286067653e-06f;}
+    static float logLn2Hi() {return 6.9313812256e-01f;}
+    static float logLn2Lo() {return 9.0580006145e-06f;}
+};
+
+template <>
+struct MathConstants<double> {
+    static const unsigned expTerms = 14;
+    static const unsigned logTerms = 10;
+    static const int subnormalShift = 54;
+    static double maxExp() {return 709.782712893384;}
+    static double minExp() {return -745.1332191019412;}
+    static double roundMagic() {return 6755399441055744.0;}
+    static double ln2Hi() {return 6.93147180369123816490e-01;}
+    static double ln2Lo() {return 1.90821492927058770002e-10;}
+    static double logLn2Hi() {return 6.93147180369123816490e-01;}
+    static double logLn2Lo() {return 1.90821492927058770002e-10;}
+};
+
+/**
+ * \brief The terms of the double precision series that pow() of floats uses.  The result only
+ *      needs to be accurate to a float, and for the range of y log x that doesn't overflow a
+ *      float these leave errors below a tenth of a float ulp.
+ */
+const unsigned powExpTerms = 10;
+const unsigned powLogTerms = 5;
+
+/**
+ * \brief True if there are kernels for type "T".
+ */
+template <class T>
+struct HasMathKernel : std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value> {};
+
+// The operations, with the scalar versions that the generic code uses.
+
+struct ExpOp {
+    template <class T>
+    static T scalar(T x) {return std::exp(x);}
+};
+
+struct LogOp {
+    template <class T>
+    static T scalar(T x) {return std::log(x);}
+};
+
+struct Log10Op {
+    template <class T>
+    static T scalar(T x) {return std::log10(x);}
+};
+
+struct AbsOp {
+    template <class T>
+    static T scalar(T x) {return std::abs(x);}
+};
+
+template <class Op, class T>
+void mathGeneric(const T *input, T *output, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        output[i] = Op::template scalar<T>(input[i]);
+    }
+}
+
+template <class T>
+void powGeneric(const T *input, T *output, std::size_t n, T exponent) {
+    for (std::size_t i = 0; i < n; i++) {
+        output[i] = std::pow(input[i], exponent);
+    }
+}
+
+template <class T>
+void powerDbGeneric(const std::complex<T> *input, T *output, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        output[i] = 10 * std::log10(squaredMagnitude(input[i]));
+    }
+}
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+/*****************************************************************************************
+                                        Kernels
+*****************************************************************************************/
+// MathTraits<isa, T> adds comparisons, selects and the exponent bit manipulation to Traits.
+// AVX2 comparisons give a register of all-ones lanes and AVX-512 ones a mask register.
+
+template <Isa isa, class T>
+struct MathTraits;
+
+template <>
+struct MathTraits<Isa::Avx2, float> {
+    typedef Traits<Isa::Avx2, float> Tr;
+    typedef float Scalar;
+    typedef __m256 Reg;
+    typedef __m256 Mask;
+    template <int P>
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Mask compare(Reg a, Reg b) {return _mm256_cmp_ps(a, b, P);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE bool any(Mask m) {return _mm256_movemask_ps(m) != 0;}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg select(Mask m, Reg a, Reg b) {return _mm256_blendv_ps(b, a, m);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm256_min_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm256_max_ps(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg abs(Reg a) {return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);}
+    // "rounded" is n + roundMagic().  Returns a * 2^n, as a * 2^floor(n/2) * 2^(n - floor(n/2))
+    // so that both factors are normal numbers over the whole range of exp().
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg scale(Reg a, Reg rounded) {
+        __m256i n = _mm256_sub_epi32(_mm256_castps_si256(rounded), _mm256_castps_si256(_mm256_set1_ps(MathConstants<float>::roundMagic())));
+        __m256i n1 = _mm256_srai_epi32(n, 1);
+        __m256i n2 = _mm256_sub_epi32(n, n1);
+        Reg s1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n1, _mm256_set1_epi32(127)), 23));
+        Reg s2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n2, _mm256_set1_epi32(127)), 23));
+        return _mm256_mul_ps(_mm256_mul_ps(a, s1), s2);
+    }
+    // Splits a positive normal number into its exponent and a mantissa in [1, 2)
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg exponent(Reg a, Reg &mantissa) {
+        __m256i bits = _mm256_castps_si256(a);
+        mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+        return _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    }
+    // The squared magnitudes of a register's worth of complex samples, in order
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg norms(const std::complex<float> *p) {
+        Reg n = NormTraits<Isa::Avx2, float>::norms(p);
+        return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(n), 0xd8));
+    }
+};
+
+template <>
+struct MathTraits<Isa::Avx2, double> {
+    typedef Traits<Isa::Avx2, double> Tr;
+    typedef double Scalar;
+    typedef __m256d Reg;
+    typedef __m256d Mask;
+    template <int P>
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Mask compare(Reg a, Reg b) {return _mm256_cmp_pd(a, b, P);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE bool any(Mask m) {return _mm256_movemask_pd(m) != 0;}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg select(Mask m, Reg a, Reg b) {return _mm256_blendv_pd(b, a, m);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm256_min_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm256_max_pd(a, b);}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg abs(Reg a) {return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);}
+    // AVX2 has no 64 bit arithmetic shift, so floor(n/2) is done on n + 2048
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg scale(Reg a, Reg rounded) {
+        __m256i n = _mm256_sub_epi64(_mm256_castpd_si256(rounded), _mm256_castpd_si256(_mm256_set1_pd(MathConstants<double>::roundMagic())));
+        __m256i n1 = _mm256_sub_epi64(_mm256_srli_epi64(_mm256_add_epi64(n, _mm256_set1_epi64x(2048)), 1), _mm256_set1_epi64x(1024));
+        __m256i n2 = _mm256_sub_epi64(n, n1);
+        Reg s1 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(n1, _mm256_set1_epi64x(1023)), 52));
+        Reg s2 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(n2, _mm256_set1_epi64x(1023)), 52));
+        return _mm256_mul_pd(_mm256_mul_pd(a, s1), s2);
+    }
+    // AVX2 can't convert 64 bit integers, so the exponent field goes in the mantissa of 2^52
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg exponent(Reg a, Reg &mantissa) {
+        __m256i bits = _mm256_castpd_si256(a);
+        mantissa = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000fffffffffffffLL)),
+                                                       _mm256_set1_epi64x(0x3ff0000000000000LL)));
+        Reg biased = _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x4330000000000000LL)));
+        return _mm256_sub_pd(biased, _mm256_set1_pd(4503599627370496.0 + 1023));
+    }
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg norms(const std::complex<double> *p) {
+        Reg n = NormTraits<Isa::Avx2, double>::norms(p);
+        return _mm256_permute4x64_pd(n, 0xd8);
+    }
+    // Floats widened to doubles and back, for pow() of floats
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE Reg loadFloats(const float *p) {return _mm256_cvtps_pd(_mm_loadu_ps(p));}
+    static MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE void storeFloats(float *p, Reg a) {_mm_storeu_ps(p, _mm256_cvtpd_ps(a));}
+};
+
+// The AVX-512 traits use the zero-masking forms of the intrinsics whose unmasked forms GCC
+// writes as a merge into an undefined register, with every lane ("all") set.  They compile to
+// the same instructions without the -Wmaybe-uninitialized warnings.
+
+template <>
+struct MathTraits<Isa::Avx512, float> {
+    typedef Traits<Isa::Avx512, float> Tr;
+    typedef float Scalar;
+    typedef __m512 Reg;
+    typedef __mmask16 Mask;
+    static const Mask all = (Mask) -1;
+    template <int P>
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Mask compare(Reg a, Reg b) {return _mm512_cmp_ps_mask(a, b, P);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE bool any(Mask m) {return m != 0;}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg select(Mask m, Reg a, Reg b) {return _mm512_mask_blend_ps(m, b, a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm512_maskz_min_ps(all, a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm512_maskz_max_ps(all, a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg abs(Reg a) {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff)));
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg scale(Reg a, Reg rounded) {
+        __m512i n = _mm512_sub_epi32(_mm512_castps_si512(rounded), _mm512_castps_si512(_mm512_set1_ps(MathConstants<float>::roundMagic())));
+        __m512i n1 = _mm512_maskz_srai_epi32(all, n, 1);
+        __m512i n2 = _mm512_sub_epi32(n, n1);
+        Reg s1 = _mm512_castsi512_ps(_mm512_maskz_slli_epi32(all, _mm512_add_epi32(n1, _mm512_set1_epi32(127)), 23));
+        Reg s2 = _mm512_castsi512_ps(_mm512_maskz_slli_epi32(all, _mm512_add_epi32(n2, _mm512_set1_epi32(127)), 23));
+        return _mm512_mul_ps(_mm512_mul_ps(a, s1), s2);
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg exponent(Reg a, Reg &mantissa) {
+        __m512i bits = _mm512_castps_si512(a);
+        mantissa = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f800000)));
+        return _mm512_maskz_cvtepi32_ps(all, _mm512_sub_epi32(_mm512_maskz_srli_epi32(all, bits, 23), _mm512_set1_epi32(127)));
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg norms(const std::complex<float> *p) {
+        return NormTraits<Isa::Avx512, float>::norms(p);
+    }
+};
+
+template <>
+struct MathTraits<Isa::Avx512, double> {
+    typedef Traits<Isa::Avx512, double> Tr;
+    typedef double Scalar;
+    typedef __m512d Reg;
+    typedef __mmask8 Mask;
+    static const Mask all = (Mask) -1;
+    template <int P>
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Mask compare(Reg a, Reg b) {return _mm512_cmp_pd_mask(a, b, P);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE bool any(Mask m) {return m != 0;}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg select(Mask m, Reg a, Reg b) {return _mm512_mask_blend_pd(m, b, a);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg min(Reg a, Reg b) {return _mm512_maskz_min_pd(all, a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg max(Reg a, Reg b) {return _mm512_maskz_max_pd(all, a, b);}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg abs(Reg a) {
+        return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a), _mm512_set1_epi64(0x7fffffffffffffffLL)));
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg scale(Reg a, Reg rounded) {
+        __m512i n = _mm512_sub_epi64(_mm512_castpd_si512(rounded), _mm512_castpd_si512(_mm512_set1_pd(MathConstants<double>::roundMagic())));
+        __m512i n1 = _mm512_maskz_srai_epi64(all, n, 1);
+        __m512i n2 = _mm512_sub_epi64(n, n1);
+        Reg s1 = _mm512_castsi512_pd(_mm512_maskz_slli_epi64(all, _mm512_add_epi64(n1, _mm512_set1_epi64(1023)), 52));
+        Reg s2 = _mm512_castsi512_pd(_mm512_maskz_slli_epi64(all, _mm512_add_epi64(n2, _mm512_set1_epi64(1023)), 52));
+        return _mm512_mul_pd(_mm512_mul_pd(a, s1), s2);
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg exponent(Reg a, Reg &mantissa) {
+        __m512i bits = _mm512_castpd_si512(a);
+        mantissa = _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi64(0x000fffffffffffffLL)),
+                                                       _mm512_set1_epi64(0x3ff0000000000000LL)));
+        Reg biased = _mm512_castsi512_pd(_mm512_or_si512(_mm512_maskz_srli_epi64(all, bits, 52), _mm512_set1_epi64(0x4330000000000000LL)));
+        return _mm512_sub_pd(biased, _mm512_set1_pd(4503599627370496.0 + 1023));
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg norms(const std::complex<double> *p) {
+        return NormTraits<Isa::Avx512, double>::norms(p);
+    }
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE Reg loadFloats(const float *p) {return _mm512_maskz_cvtps_pd(all, _mm256_loadu_ps(p));}
+    static MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE void storeFloats(float *p, Reg a) {_mm256_storeu_ps(p, _mm512_maskz_cvtpd_ps(all, a));}
+};
+
+// The register functions, and the array kernels that apply them.  There is one copy of each
+// per instruction set because the target attribute has to be a literal.
+
+template <class Mt, unsigned terms = MathConstants<typename Mt::Scalar>::expTerms>
+MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg expAvx2(typename Mt::Reg x) {
+    typedef typename Mt::Tr Tr;
+    typedef typename Mt::Reg Reg;
+    typedef typename Mt::Scalar T;
+    typedef MathConstants<T> C;
+    Reg clamped = Mt::min(Mt::max(x, Tr::set1(C::minExp())), Tr::set1(C::maxExp()));
+    Reg rounded = Tr::fmadd(clamped, Tr::set1((T) M_LOG2E), Tr::set1(C::roundMagic()));
+    Reg n = Tr::apply(Sub(), rounded, Tr::set1(C::roundMagic()));
+    Reg r = Tr::fmadd(n, Tr::set1(-C::ln2Hi()), clamped);
+    r = Tr::fmadd(n, Tr::set1(-C::ln2Lo()), r);
+    Reg p = Tr::set1((T) expCoefficients[terms - 1]);
+    MATRIX_DSP_UNROLL
+    for (unsigned term = terms - 1; term > 0; term--) {
+        p = Tr::fmadd(p, r, Tr::set1((T) expCoefficients[term - 1]));
+    }
+    p = Mt::scale(p, rounded);
+    p = Mt::select(Mt::template compare<_CMP_GT_OQ>(x, Tr::set1(C::maxExp())), Tr::set1(std::numeric_limits<T>::infinity()), p);
+    p = Mt::select(Mt::template compare<_CMP_LT_OQ>(x, Tr::set1(C::minExp())), Tr::set1(0), p);
+    return Mt::select(Mt::template compare<_CMP_UNORD_Q>(x, x), x, p);
+}
+
+template <class Mt, unsigned terms = MathConstants<typename Mt::Scalar>::logTerms>
+MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg logAvx2(typename Mt::Reg x) {
+    typedef typename Mt::Tr Tr;
+    typedef typename Mt::Reg Reg;
+    typedef typename Mt::Mask Mask;
+    typedef typename Mt::Scalar T;
+    typedef MathConstants<T> C;
+    // Subnormals are scaled up to normal numbers first
+    Mask subnormal = Mt::template compare<_CMP_LT_OQ>(x, Tr::set1(std::numeric_limits<T>::min()));
+    Reg normal = Mt::select(subnormal, Tr::apply(Mul(), x, Tr::set1((T) (1LL << C::subnormalShift))), x);
+    Reg m;
+    Reg e = Mt::exponent(normal, m);
+    e = Tr::apply(Sub(), e, Mt::select(subnormal, Tr::set1((T) C::subnormalShift), Tr::set1(0)));
+    Mask big = Mt::template compare<_CMP_GT_OQ>(m, Tr::set1((T) M_SQRT2));
+    m = Mt::select(big, Tr::apply(Mul(), m, Tr::set1((T) 0.5)), m);
+    e = Mt::select(big, Tr::apply(Add(), e, Tr::set1(1)), e);
+    Reg f = Tr::apply(Sub(), m, Tr::set1(1));
+    Reg s = Tr::apply(Div(), f, Tr::apply(Add(), f, Tr::set1(2)));
+    Reg z = Tr::apply(Mul(), s, s);
+    Reg r = Tr::set1((T) logCoefficients[terms - 1]);
+    MATRIX_DSP_UNROLL
+    for (unsigned term = terms - 1; term > 0; term--) {
+        r = Tr::fmadd(r, z, Tr::set1((T) logCoefficients[term - 1]));
+    }
+    r = Tr::apply(Mul(), r, z);
+    Reg halfSquare = Tr::apply(Mul(), Tr::apply(Mul(), f, f), Tr::set1((T) 0.5));
+    // e ln2Hi - ((halfSquare - (s (halfSquare + r) + e ln2Lo)) - f)
+    Reg correction = Tr::fmadd(s, Tr::apply(Add(), halfSquare, r), Tr::apply(Mul(), e, Tr::set1(C::logLn2Lo())));
+    Reg result = Tr::fmadd(e, Tr::set1(C::logLn2Hi()), Tr::apply(Sub(), f, Tr::apply(Sub(), halfSquare, correction)));
+    result = Mt::select(Mt::template compare<_CMP_EQ_OQ>(x, Tr::set1(std::numeric_limits<T>::infinity())), x, result);
+    result = Mt::select(Mt::template compare<_CMP_EQ_OQ>(x, Tr::set1(0)), Tr::set1(-std::numeric_limits<T>::infinity()), result);
+    return Mt::select(Mt::template compare<_CMP_NGE_UQ>(x, Tr::set1(0)), Tr::set1(std::numeric_limits<T>::quiet_NaN()), result);
+}
+
+template <class Mt>
+MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg mathOpAvx2(ExpOp, typename Mt::Reg x) {return expAvx2<Mt>(x);}
+
+template <class Mt>
+MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg mathOpAvx2(LogOp, typename Mt::Reg x) {return logAvx2<Mt>(x);}
+
+template <class Mt>
+MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg mathOpAvx2(Log10Op, typename Mt::Reg x) {
+    return Mt::Tr::apply(Mul(), logAvx2<Mt>(x), Mt::Tr::set1((typename Mt::Scalar) M_LOG10E));
+}
+
+template <class Mt>
+MATRIX_DSP_TARGET_AVX2 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg mathOpAvx2(AbsOp, typename Mt::Reg x) {return Mt::abs(x);}
+
+template <class Mt, class Op, class T>
+MATRIX_DSP_TARGET_AVX2 void mathAvx2(const T *input, T *output, std::size_t n) {
+    typedef typename Mt::Tr Tr;
+    const std::size_t w = Tr::width;
+    std::size_t i = 0;
+    for (; i + w <= n; i += w) {
+        Tr::store(output + i, mathOpAvx2<Mt>(Op(), Tr::load(input + i)));
+    }
+    if (i < n) {
+        T lanes[Tr::width];
+        for (std::size_t lane = 0; lane < w; lane++) {
+            lanes[lane] = i + lane < n ? input[i + lane] : 1;
+        }
+        Tr::store(lanes, mathOpAvx2<Mt>(Op(), Tr::load(lanes)));
+        for (std::size_t lane = 0; i + lane < n; lane++) {
+            output[i + lane] = lanes[lane];
+        }
+    }
+}
+
+/**
+ * \brief pow() of floats, computed as exp(y log x) in double so that the error of log x isn't
+ *      magnified by y.  Lanes that aren't positive and finite go to std::pow.
+ */
+template <class Mt>
+MATRIX_DSP_TARGET_AVX2 void powFloatAvx2(const float *input, float *output, std::size_t n, double exponent) {
+    typedef typename Mt::Tr Tr;
+    typedef typename Mt::Reg Reg;
+    // Two registers at a time, because each one is a long chain of dependent operations
+    const std::size_t w = 2 * Tr::width;
+    float lanes[2 * Tr::width];
+    for (std::size_t i = 0; i < n; i += w) {
+        const float *in = input + i;
+        if (i + w > n) {
+            for (std::size_t lane = 0; lane < w; lane++) {
+                lanes[lane] = i + lane < n ? input[i + lane] : 1;
+            }
+            in = lanes;
+        }
+        Reg x0 = Mt::loadFloats(in);
+        Reg x1 = Mt::loadFloats(in + Tr::width);
+        Reg result0 = expAvx2<Mt, powExpTerms>(Tr::apply(Mul(), logAvx2<Mt, powLogTerms>(x0), Tr::set1(exponent)));
+        Reg result1 = expAvx2<Mt, powExpTerms>(Tr::apply(Mul(), logAvx2<Mt, powLogTerms>(x1), Tr::set1(exponent)));
+        Reg infinity = Tr::set1(std::numeric_limits<double>::infinity());
+        bool special = Mt::any(Mt::template compare<_CMP_NGT_UQ>(x0, Tr::set1(0))) ||
+                       Mt::any(Mt::template compare<_CMP_NGT_UQ>(x1, Tr::set1(0))) ||
+                       Mt::any(Mt::template compare<_CMP_EQ_OQ>(x0, infinity)) ||
+                       Mt::any(Mt::template compare<_CMP_EQ_OQ>(x1, infinity));
+        if (i + w <= n && !special) {
+            Mt::storeFloats(output + i, result0);
+            Mt::storeFloats(output + i + Tr::width, result1);
+        }
+        else {
+            float resultLanes[2 * Tr::width];
+            Mt::storeFloats(resultLanes, result0);
+            Mt::storeFloats(resultLanes + Tr::width, result1);
+            for (std::size_t lane = 0; lane < w && i + lane < n; lane++) {
+                float value = in[lane];
+                output[i + lane] = value > 0 && value < std::numeric_limits<float>::infinity() ? resultLanes[lane] : std::pow(value, (float) exponent);
+            }
+        }
+    }
+}
+
+template <class Mt, class T>
+MATRIX_DSP_TARGET_AVX2 void powerDbAvx2(const std::complex<T> *input, T *output, std::size_t n) {
+    typedef typename Mt::Tr Tr;
+    const std::size_t w = Tr::width;
+    std::size_t i = 0;
+    for (; i + w <= n; i += w) {
+        Tr::store(output + i, Tr::apply(Mul(), logAvx2<Mt>(Mt::norms(input + i)), Tr::set1((T) (10 * M_LOG10E))));
+    }
+    if (i < n) {
+        std::complex<T> samples[Tr::width];
+        T lanes[Tr::width];
+        for (std::size_t lane = 0; lane < w; lane++) {
+            samples[lane] = i + lane < n ? input[i + lane] : std::complex<T>(1);
+        }
+        Tr::store(lanes, Tr::apply(Mul(), logAvx2<Mt>(Mt::norms(samples)), Tr::set1((T) (10 * M_LOG10E))));
+        for (std::size_t lane = 0; i + lane < n; lane++) {
+            output[i + lane] = lanes[lane];
+        }
+    }
+}
+
+template <class Mt, unsigned terms = MathConstants<typename Mt::Scalar>::expTerms>
+MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg expAvx512(typename Mt::Reg x) {
+    typedef typename Mt::Tr Tr;
+    typedef typename Mt::Reg Reg;
+    typedef typename Mt::Scalar T;
+    typedef MathConstants<T> C;
+    Reg clamped = Mt::min(Mt::max(x, Tr::set1(C::minExp())), Tr::set1(C::maxExp()));
+    Reg rounded = Tr::fmadd(clamped, Tr::set1((T) M_LOG2E), Tr::set1(C::roundMagic()));
+    Reg n = Tr::apply(Sub(), rounded, Tr::set1(C::roundMagic()));
+    Reg r = Tr::fmadd(n, Tr::set1(-C::ln2Hi()), clamped);
+    r = Tr::fmadd(n, Tr::set1(-C::ln2Lo()), r);
+    Reg p = Tr::set1((T) expCoefficients[terms - 1]);
+    MATRIX_DSP_UNROLL
+    for (unsigned term = terms - 1; term > 0; term--) {
+        p = Tr::fmadd(p, r, Tr::set1((T) expCoefficients[term - 1]));
+    }
+    p = Mt::scale(p, rounded);
+    p = Mt::select(Mt::template compare<_CMP_GT_OQ>(x, Tr::set1(C::maxExp())), Tr::set1(std::numeric_limits<T>::infinity()), p);
+    p = Mt::select(Mt::template compare<_CMP_LT_OQ>(x, Tr::set1(C::minExp())), Tr::set1(0), p);
+    return Mt::select(Mt::template compare<_CMP_UNORD_Q>(x, x), x, p);
+}
+
+template <class Mt, unsigned terms = MathConstants<typename Mt::Scalar>::logTerms>
+MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg logAvx512(typename Mt::Reg x) {
+    typedef typename Mt::Tr Tr;
+    typedef typename Mt::Reg Reg;
+    typedef typename Mt::Mask Mask;
+    typedef typename Mt::Scalar T;
+    typedef MathConstants<T> C;
+    Mask subnormal = Mt::template compare<_CMP_LT_OQ>(x, Tr::set1(std::numeric_limits<T>::min()));
+    Reg normal = Mt::select(subnormal, Tr::apply(Mul(), x, Tr::set1((T) (1LL << C::subnormalShift))), x);
+    Reg m;
+    Reg e = Mt::exponent(normal, m);
+    e = Tr::apply(Sub(), e, Mt::select(subnormal, Tr::set1((T) C::subnormalShift), Tr::set1(0)));
+    Mask big = Mt::template compare<_CMP_GT_OQ>(m, Tr::set1((T) M_SQRT2));
+    m = Mt::select(big, Tr::apply(Mul(), m, Tr::set1((T) 0.5)), m);
+    e = Mt::select(big, Tr::apply(Add(), e, Tr::set1(1)), e);
+    Reg f = Tr::apply(Sub(), m, Tr::set1(1));
+    Reg s = Tr::apply(Div(), f, Tr::apply(Add(), f, Tr::set1(2)));
+    Reg z = Tr::apply(Mul(), s, s);
+    Reg r = Tr::set1((T) logCoefficients[terms - 1]);
+    MATRIX_DSP_UNROLL
+    for (unsigned term = terms - 1; term > 0; term--) {
+        r = Tr::fmadd(r, z, Tr::set1((T) logCoefficients[term - 1]));
+    }
+    r = Tr::apply(Mul(), r, z);
+    Reg halfSquare = Tr::apply(Mul(), Tr::apply(Mul(), f, f), Tr::set1((T) 0.5));
+    Reg correction = Tr::fmadd(s, Tr::apply(Add(), halfSquare, r), Tr::apply(Mul(), e, Tr::set1(C::logLn2Lo())));
+    Reg result = Tr::fmadd(e, Tr::set1(C::logLn2Hi()), Tr::apply(Sub(), f, Tr::apply(Sub(), halfSquare, correction)));
+    result = Mt::select(Mt::template compare<_CMP_EQ_OQ>(x, Tr::set1(std::numeric_limits<T>::infinity())), x, result);
+    result = Mt::select(Mt::template compare<_CMP_EQ_OQ>(x, Tr::set1(0)), Tr::set1(-std::numeric_limits<T>::infinity()), result);
+    return Mt::select(Mt::template compare<_CMP_NGE_UQ>(x, Tr::set1(0)), Tr::set1(std::numeric_limits<T>::quiet_NaN()), result);
+}
+
+template <class Mt>
+MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg mathOpAvx512(ExpOp, typename Mt::Reg x) {return expAvx512<Mt>(x);}
+
+template <class Mt>
+MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg mathOpAvx512(LogOp, typename Mt::Reg x) {return logAvx512<Mt>(x);}
+
+template <class Mt>
+MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg mathOpAvx512(Log10Op, typename Mt::Reg x) {
+    return Mt::Tr::apply(Mul(), logAvx512<Mt>(x), Mt::Tr::set1((typename Mt::Scalar) M_LOG10E));
+}
+
+template <class Mt>
+MATRIX_DSP_TARGET_AVX512 MATRIX_DSP_ALWAYS_INLINE typename Mt::Reg mathOpAvx512(AbsOp, typename Mt::Reg x) {return Mt::abs(x);}
+
+template <class Mt, class Op, class T>
+MATRIX_DSP_TARGET_AVX512 void mathAvx512(const T *input, T *output, std::size_t n) {
+    typedef typename Mt::Tr Tr;
+    const std::size_t w = Tr::width;
+    std::size_t i = 0;
+    for (; i + w <= n; i += w) {
+        Tr::store(output + i, mathOpAvx512<Mt>(Op(), Tr::load(input + i)));
+    }
+    if (i < n) {
+        T lanes[Tr::width];
+        for (std::size_t lane = 0; lane < w; lane++) {
+            lanes[lane] = i + lane < n ? input[i + lane] : 1;
+        }
+        Tr::store(lanes, mathOpAvx512<Mt>(Op(), Tr::load(lanes)));
+        for (std::size_t lane = 0; i + lane < n; lane++) {
+            output[i + lane] = lanes[lane];
+        }
+    }
+}
+
+template <class Mt>
+MATRIX_DSP_TARGET_AVX512 void powFloatAvx512(const float *input, float *output, std::size_t n, double exponent) {
+    typedef typename Mt::Tr Tr;
+    typedef typename Mt::Reg Reg;
+    // Two registers at a time, because each one is a long chain of dependent operations
+    const std::size_t w = 2 * Tr::width;
+    float lanes[2 * Tr::width];
+    for (std::size_t i = 0; i < n; i += w) {
+        const float *in = input + i;
+        if (i + w > n) {
+            for (std::size_t lane = 0; lane < w; lane++) {
+                lanes[lane] = i + lane < n ? input[i + lane] : 1;
+            }
+            in = lanes;
+        }
+        Reg x0 = Mt::loadFloats(in);
+        Reg x1 = Mt::loadFloats(in + Tr::width);
+        Reg result0 = expAvx512<Mt, powExpTerms>(Tr::apply(Mul(), logAvx512<Mt, powLogTerms>(x0), Tr::set1(exponent)));
+        Reg result1 = expAvx512<Mt, powExpTerms>(Tr::apply(Mul(), logAvx512<Mt, powLogTerms>(x1), Tr::set1(exponent)));
+        Reg infinity = Tr::set1(std::numeric_limits<double>::infinity());
+        bool special = Mt::any(Mt::template compare<_CMP_NGT_UQ>(x0, Tr::set1(0))) ||
+                       Mt::any(Mt::template compare<_CMP_NGT_UQ>(x1, Tr::set1(0))) ||
+                       Mt::any(Mt::template compare<_CMP_EQ_OQ>(x0, infinity)) ||
+                       Mt::any(Mt::template compare<_CMP_EQ_OQ>(x1, infinity));
+        if (i + w <= n && !special) {
+            Mt::storeFloats(output + i, result0);
+            Mt::storeFloats(output + i + Tr::width, result1);
+        }
+        else {
+            float resultLanes[2 * Tr::width];
+            Mt::storeFloats(resultLanes, result0);
+            Mt::storeFloats(resultLanes + Tr::width, result1);
+            for (std::size_t lane = 0; lane < w && i + lane < n; lane++) {
+                float value = in[lane];
+                output[i + lane] = value > 0 && value < std::numeric_limits<float>::infinity() ? resultLanes[lane] : std::pow(value, (float) exponent);
+            }
+        }
+    }
+}
+
+template <class Mt, class T>
+MATRIX_DSP_TARGET_AVX512 void powerDbAvx512(const std::complex<T> *input, T *output, std::size_t n) {
+    typedef typename Mt::Tr Tr;
+    const std::size_t w = Tr::width;
+    std::size_t i = 0;
+    for (; i + w <= n; i += w) {
+        Tr::store(output + i, Tr::apply(Mul(), logAvx512<Mt>(Mt::norms(input + i)), Tr::set1((T) (10 * M_LOG10E))));
+    }
+    if (i < n) {
+        std::complex<T> samples[Tr::width];
+        T lanes[Tr::width];
+        for (std::size_t lane = 0; lane < w; lane++) {
+            samples[lane] = i + lane < n ? input[i + lane] : std::complex<T>(1);
+        }
+        Tr::store(lanes, Tr::apply(Mul(), logAvx512<Mt>(Mt::norms(samples)), Tr::set1((T) (10 * M_LOG10E))));
+        for (std::size_t lane = 0; i + lane < n; lane++) {
+            output[i + lane] = lanes[lane];
+        }
+    }
+}
+
+#endif // MATRIX_DSP_X86_SIMD
+
+/*****************************************************************************************
+                                        Dispatchers
+*****************************************************************************************/
+template <class Op, class T>
+void mathDispatch(const T *input, T *output, std::size_t n, std::false_type) {
+    mathGeneric<Op>(input, output, n);
+}
+
+template <class Op, class T>
+void mathDispatch(const T *input, T *output, std::size_t n, std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && Traits<Isa::Avx512, T>::available()) {
+        return mathAvx512<MathTraits<Isa::Avx512, T>, Op>(input, output, n);
+    }
+    if (isa >= Isa::Avx2 && Traits<Isa::Avx2, T>::available()) {
+        return mathAvx2<MathTraits<Isa::Avx2, T>, Op>(input, output, n);
+    }
+#endif
+    mathGeneric<Op>(input, output, n);
+}
+
+template <class T>
+void powDispatch(const T *input, T *output, std::size_t n, T exponent) {
+    powGeneric(input, output, n, exponent);
+}
+
+inline void powDispatch(const float *input, float *output, std::size_t n, float exponent) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    if (std::isfinite(exponent)) {
+        Isa isa = activeIsa();
+        if (isa >= Isa::Avx512 && Traits<Isa::Avx512, double>::available()) {
+            return powFloatAvx512<MathTraits<Isa::Avx512, double> >(input, output, n, exponent);
+        }
+        if (isa >= Isa::Avx2 && Traits<Isa::Avx2, double>::available()) {
+            return powFloatAvx2<MathTraits<Isa::Avx2, double> >(input, output, n, exponent);
+        }
+    }
+#endif
+    powGeneric(input, output, n, exponent);
+}
+
+template <class T>
+void powerDbDispatch(const std::complex<T> *input, T *output, std::size_t n, std::false_type) {
+    powerDbGeneric(input, output, n);
+}
+
+template <class T>
+void powerDbDispatch(const std::complex<T> *input, T *output, std::size_t n, std::true_type) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx512 && Traits<Isa::Avx512, T>::available()) {
+        return powerDbAvx512<MathTraits<Isa::Avx512, T> >(input, output, n);
+    }
+    if (isa >= Isa::Avx2 && Traits<Isa::Avx2, T>::available()) {
+        return powerDbAvx2<MathTraits<Isa::Avx2, T> >(input, output, n);
+    }
+#endif
+    powerDbGeneric(input, output, n);
+}
+
+/**
+ * \brief Sets output[i] to e^input[i].  "input" and "output" may be the same array.
+ */
+template <class T>
+void exp(const T *input, T *output, std::size_t n) {mathDispatch<ExpOp>(input, output, n, HasMathKernel<T>());}
+
+/**
+ * \brief Sets output[i] to the natural log of input[i].  "input" and "output" may be the same
+ *      array.
+ */
+template <class T>
+void log(const T *input, T *output, std::size_t n) {mathDispatch<LogOp>(input, output, n, HasMathKernel<T>());}
+
+/**
+ * \brief Sets output[i] to the base 10 log of input[i].  "input" and "output" may be the same
+ *      array.
+ */
+template <class T>
+void log10(const T *input, T *output, std::size_t n) {mathDispatch<Log10Op>(input, output, n, HasMathKernel<T>());}
+
+/**
+ * \brief Sets output[i] to the absolute value of input[i].  "input" and "output" may be the
+ *      same array.
+ */
+template <class T>
+void abs(const T *input, T *output, std::size_t n) {mathDispatch<AbsOp>(input, output, n, HasMathKernel<T>());}
+
+/**
+ * \brief Sets output[i] to input[i] to the power of "exponent".  "input" and "output" may be
+ *      the same array.
+ */
+template <class T>
+void pow(const T *input, T *output, std::size_t n, T exponent) {powDispatch(input, output, n, exponent);}
+
+/**
+ * \brief Sets output[i] to the power of input[i] in dB, 10 log10(|input[i]|^2).  Zeros give
+ *      -infinity.
+ */
+template <class T>
+void powerDb(const std::complex<T> *input, T *output, std::size_t n) {powerDbDispatch(input, output, n, HasMathKernel<T>());}
+
+}
+
+}
+
+#endif /* Transcendental_h */
@@ -0,0 +1,336 @@
+//
+//  Transpose.h
+//  MatrixDSP
+//
+//  Matrix transposes for row-major matrices.  The out-of-place transpose is cache oblivious:
+//  it splits the longer side of the matrix in half until the pieces are small enough that a
+//  piece of the input and of the output both fit in L1, whatever the cache sizes are.  The
+//  pieces are then done a square tile at a time, with the tile transposed in registers, so the
+//  reads and the writes are both whole rows of a tile.
+//
+//  Square matrices are transposed in place by swapping blocks across the diagonal through a
+//  small buffer.  Other shapes are transposed in place by following the cycles of the
+//  permutation, which needs a bit per element to mark the elements that have been moved but
+//  no copy of the matrix.  That is much slower than going through a second buffer, so it is
+//  only for when memory is tight.
+//
+//  The tiles are 8 x 8 (AVX2) or 4 x 4 (SSE2) for 4 byte types and 4 x 4 (AVX2) or 2 x 2 (SSE2)
+//  for 8 byte types, such as double and std::complex<float>.  A transpose only moves data, so
+//  any trivially copyable type of those sizes uses them.  Other types use plain loops over the
+//  same blocks.
+//
+
+#ifndef Transpose_h
+#define Transpose_h
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+#include "ScratchArena.h"
+#include "Simd.h"
+
+namespace MatrixDSP {
+namespace simd {
+
+/**
+ * \brief Blocks with both sides no longer than this are transposed a tile at a time.  A block
+ *      of the input and one of the output, 2 x 32 x 32 x 8 bytes for 8 byte types, fit in L1.
+ */
+const std::size_t transposeLeafSize = 32;
+
+/**
+ * \brief The size of the elements that the vector tiles handle for type "T", or 0 if they
+ *      don't handle "T".
+ */
+template <class T>
+struct TransposeTileBytes : std::integral_constant<std::size_t,
+        std::is_trivially_copyable<T>::value && (sizeof(T) == 4 || sizeof(T) == 8) ? sizeof(T) : 0> {};
+
+/**
+ * \brief Transposes a size x size tile with plain loops.
+ */
+template <class T>
+struct TransposeTileGeneric {
+    typedef T Scalar;
+    static const std::size_t size = 8;
+    static void run(const T *in, std::size_t ldi, T *out, std::size_t ldo) {
+        for (std::size_t row = 0; row < size; row++) {
+            for (std::size_t col = 0; col < size; col++) {
+                out[col * ldo + row] = in[row * ldi + col];
+            }
+        }
+    }
+};
+
+#if defined(MATRIX_DSP_X86_SIMD)
+
+/*****************************************************************************************
+                                        Tiles
+*****************************************************************************************/
+template <Isa isa, std::size_t bytes>
+struct TransposeTile;
+
+template <>
+struct TransposeTile<Isa::Sse2, 4> {
+    typedef float Scalar;
+    static const std::size_t size = 4;
+    static bool available() {return hasSse2();}
+    static MATRIX_DSP_TARGET_SSE2 void run(const float *in, std::size_t ldi, float *out, std::size_t ldo) {
+        __m128 row0 = _mm_loadu_ps(in);
+        __m128 row1 = _mm_loadu_ps(in + ldi);
+        __m128 row2 = _mm_loadu_ps(in + 2 * ldi);
+        __m128 row3 = _mm_loadu_ps(in + 3 * ldi);
+        _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+        _mm_storeu_ps(out, row0);
+        _mm_storeu_ps(out + ldo, row1);
+        _mm_storeu_ps(out + 2 * ldo, row2);
+        _mm_storeu_ps(out + 3 * ldo, row3);
+    }
+};
+
+template <>
+struct TransposeTile<Isa::Sse2, 8> {
+    typedef double Scalar;
+    static const std::size_t size = 2;
+    static bool available() {return hasSse2();}
+    static MATRIX_DSP_TARGET_SSE2 void run(const double *in, std::size_t ldi, double *out, std::size_t ldo) {
+        __m128d row0 = _mm_loadu_pd(in);
+        __m128d row1 = _mm_loadu_pd(in + ldi);
+        _mm_storeu_pd(out, _mm_unpacklo_pd(row0, row1));
+        _mm_storeu_pd(out + ldo, _mm_unpackhi_pd(row0, row1));
+    }
+};
+
+template <>
+struct TransposeTile<Isa::Avx2, 4> {
+    typedef float Scalar;
+    static const std::size_t size = 8;
+    static bool available() {return hasAvx2();}
+    static MATRIX_DSP_TARGET_AVX2 void run(const float *in, std::size_t ldi, float *out, std::size_t ldo) {
+        // Interleave pairs of rows, then pairs of pairs, then swap the 128 bit halves
+        __m256 t0 = _mm256_unpacklo_ps(_mm256_loadu_ps(in), _mm256_loadu_ps(in + ldi));
+        __m256 t1 = _mm256_unpackhi_ps(_mm256_loadu_ps(in), _mm256_loadu_ps(in + ldi));
+        __m256 t2 = _mm256_unpacklo_ps(_mm256_loadu_ps(in + 2 * ldi), _mm256_loadu_ps(in + 3 * ldi));
+        __m256 t3 = _mm256_unpackhi_ps(_mm256_loadu_ps(in + 2 * ldi), _mm256_loadu_ps(in + 3 * ldi));
+        __m256 t4 = _mm256_unpacklo_ps(_mm256_loadu_ps(in + 4 * ldi), _mm256_loadu_ps(in + 5 * ldi));
+        __m256 t5 = _mm256_unpackhi_ps(_mm256_loadu_ps(in + 4 * ldi), _mm256_loadu_ps(in + 5 * ldi));
+        __m256 t6 = _mm256_unpacklo_ps(_mm256_loadu_ps(in + 6 * ldi), _mm256_loadu_ps(in + 7 * ldi));
+        __m256 t7 = _mm256_unpackhi_ps(_mm256_loadu_ps(in + 6 * ldi), _mm256_loadu_ps(in + 7 * ldi));
+        __m256 s0 = _mm256_shuffle_ps(t0, t2, 0x44);
+        __m256 s1 = _mm256_shuffle_ps(t0, t2, 0xee);
+        __m256 s2 = _mm256_shuffle_ps(t1, t3, 0x44);
+        __m256 s3 = _mm256_shuffle_ps(t1, t3, 0xee);
+        __m256 s4 = _mm256_shuffle_ps(t4, t6, 0x44);
+        __m256 s5 = _mm256_shuffle_ps(t4, t6, 0xee);
+        __m256 s6 = _mm256_shuffle_ps(t5, t7, 0x44);
+        __m256 s7 = _mm256_shuffle_ps(t5, t7, 0xee);
+        _mm256_storeu_ps(out, _mm256_permute2f128_ps(s0, s4, 0x20));
+        _mm256_storeu_ps(out + ldo, _mm256_permute2f128_ps(s1, s5, 0x20));
+        _mm256_storeu_ps(out + 2 * ldo, _mm256_permute2f128_ps(s2, s6, 0x20));
+        _mm256_storeu_ps(out + 3 * ldo, _mm256_permute2f128_ps(s3, s7, 0x20));
+        _mm256_storeu_ps(out + 4 * ldo, _mm256_permute2f128_ps(s0, s4, 0x31));
+        _mm256_storeu_ps(out + 5 * ldo, _mm256_permute2f128_ps(s1, s5, 0x31));
+        _mm256_storeu_ps(out + 6 * ldo, _mm256_permute2f128_ps(s2, s6, 0x31));
+        _mm256_storeu_ps(out + 7 * ldo, _mm256_permute2f128_ps(s3, s7, 0x31));
+    }
+};
+
+template <>
+struct TransposeTile<Isa::Avx2, 8> {
+    typedef double Scalar;
+    static const std::size_t size = 4;
+    static bool available() {return hasAvx2();}
+    static MATRIX_DSP_TARGET_AVX2 void run(const double *in, std::size_t ldi, double *out, std::size_t ldo) {
+        __m256d row0 = _mm256_loadu_pd(in);
+        __m256d row1 = _mm256_loadu_pd(in + ldi);
+        __m256d row2 = _mm256_loadu_pd(in + 2 * ldi);
+        __m256d row3 = _mm256_loadu_pd(in + 3 * ldi);
+        __m256d t0 = _mm256_unpacklo_pd(row0, row1);
+        __m256d t1 = _mm256_unpackhi_pd(row0, row1);
+        __m256d t2 = _mm256_unpacklo_pd(row2, row3);
+        __m256d t3 = _mm256_unpackhi_pd(row2, row3);
+        _mm256_storeu_pd(out, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(out + ldo, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(out + 2 * ldo, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(out + 3 * ldo, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+};
+
+#endif // MATRIX_DSP_X86_SIMD
+
+/*****************************************************************************************
+                                        Blocking
+*****************************************************************************************/
+/**
+ * \brief Transposes a block that fits in L1, a tile at a time.
+ */
+template <class Tile, class T>
+void transposeLeaf(std::size_t rows, std::size_t cols, const T *in, std::size_t ldi, T *out, std::size_t ldo) {
+    typedef typename Tile::Scalar Scalar;
+    const std::size_t size = Tile::size;
+    std::size_t fullRows = rows / size * size;
+    std::size_t fullCols = cols / size * size;
+    for (std::size_t col = 0; col < fullCols; col += size) {
+        for (std::size_t row = 0; row < fullRows; row += size) {
+            Tile::run((const Scalar *) (in + row * ldi + col), ldi, (Scalar *) (out + col * ldo + row), ldo);
+        }
+    }
+    for (std::size_t row = 0; row < rows; row++) {
+        for (std::size_t col = row < fullRows ? fullCols : 0; col < cols; col++) {
+            out[col * ldo + row] = in[row * ldi + col];
+        }
+    }
+}
+
+/**
+ * \brief Transposes a block by splitting its longer side in half until the pieces fit in L1.
+ *      The splits are on tile boundaries.
+ */
+template <class Tile, class T>
+void transposeRecursive(std::size_t rows, std::size_t cols, const T *in, std::size_t ldi, T *out, std::size_t ldo) {
+    if (rows <= transposeLeafSize && cols <= transposeLeafSize) {
+        return transposeLeaf<Tile>(rows, cols, in, ldi, out, ldo);
+    }
+    const std::size_t size = Tile::size;
+    if (rows >= cols) {
+        std::size_t half = std::max(rows / 2 / size * size, size);
+        transposeRecursive<Tile>(half, cols, in, ldi, out, ldo);
+        transposeRecursive<Tile>(rows - half, cols, in + half * ldi, ldi, out + half, ldo);
+    }
+    else {
+        std::size_t half = std::max(cols / 2 / size * size, size);
+        transposeRecursive<Tile>(rows, half, in, ldi, out, ldo);
+        transposeRecursive<Tile>(rows, cols - half, in + half, ldi, out + half * ldo, ldo);
+    }
+}
+
+/**
+ * \brief Transposes an n x n matrix in place, swapping blocks across the diagonal.
+ */
+template <class Tile, class T>
+void transposeSquareInPlace(std::size_t n, T *data, std::size_t ld) {
+    const std::size_t block = transposeLeafSize;
+    ScratchBuffer<T> buffer(block * block);
+    for (std::size_t blockRow = 0; blockRow < n; blockRow += block) {
+        std::size_t rows = std::min(block, n - blockRow);
+        T *diagonal = data + blockRow * ld + blockRow;
+        transposeLeaf<Tile>(rows, rows, diagonal, ld, buffer.data(), rows);
+        for (std::size_t row = 0; row < rows; row++) {
+            std::copy(buffer.data() + row * rows, buffer.data() + (row + 1) * rows, diagonal + row * ld);
+        }
+        for (std::size_t blockCol = blockRow + block; blockCol < n; blockCol += block) {
+            std::size_t cols = std::min(block, n - blockCol);
+            T *upper = data + blockRow * ld + blockCol;
+            T *lower = data + blockCol * ld + blockRow;
+            transposeLeaf<Tile>(rows, cols, upper, ld, buffer.data(), rows);
+            transposeLeaf<Tile>(cols, rows, lower, ld, upper, ld);
+            for (std::size_t row = 0; row < cols; row++) {
+                std::copy(buffer.data() + row * rows, buffer.data() + (row + 1) * rows, lower + row * ld);
+            }
+        }
+    }
+}
+
+/**
+ * \brief Transposes a contiguous rows x cols matrix in place by following the cycles of the
+ *      permutation.  Element i moves to i * rows mod (rows * cols - 1).
+ */
+template <class T>
+void transposeCycles(std::size_t rows, std::size_t cols, T *data) {
+    std::size_t last = rows * cols - 1;
+    std::vector<bool> moved(rows * cols, false);
+    for (std::size_t start = 1; start < last; start++) {
+        if (moved[start]) {
+            continue;
+        }
+        T carried = data[start];
+        std::size_t from = start;
+        do {
+            std::size_t to = from * rows % last;
+            std::swap(carried, data[to]);
+            moved[to] = true;
+            from = to;
+        } while (from != start);
+    }
+}
+
+/*****************************************************************************************
+                                        Dispatchers
+*****************************************************************************************/
+template <class T>
+void transposeDispatch(std::size_t rows, std::size_t cols, const T *in, std::size_t ldi, T *out, std::size_t ldo,
+                       std::integral_constant<std::size_t, 0>) {
+    transposeRecursive< TransposeTileGeneric<T> >(rows, cols, in, ldi, out, ldo);
+}
+
+template <class T, std::size_t bytes>
+void transposeDispatch(std::size_t rows, std::size_t cols, const T *in, std::size_t ldi, T *out, std::size_t ldo,
+                       std::integral_constant<std::size_t, bytes>) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx2 && TransposeTile<Isa::Avx2, bytes>::available()) {
+        return transposeRecursive< TransposeTile<Isa::Avx2, bytes> >(rows, cols, in, ldi, out, ldo);
+    }
+    if (isa >= Isa::Sse2 && TransposeTile<Isa::Sse2, bytes>::available()) {
+        return transposeRecursive< TransposeTile<Isa::Sse2, bytes> >(rows, cols, in, ldi, out, ldo);
+    }
+#endif
+    transposeRecursive< TransposeTileGeneric<T> >(rows, cols, in, ldi, out, ldo);
+}
+
+template <class T>
+void transposeSquareDispatch(std::size_t n, T *data, std::size_t ld, std::integral_constant<std::size_t, 0>) {
+    transposeSquareInPlace< TransposeTileGeneric<T> >(n, data, ld);
+}
+
+template <class T, std::size_t bytes>
+void transposeSquareDispatch(std::size_t n, T *data, std::size_t ld, std::integral_constant<std::size_t, bytes>) {
+#if defined(MATRIX_DSP_X86_SIMD)
+    Isa isa = activeIsa();
+    if (isa >= Isa::Avx2 && TransposeTile<Isa::Avx2, bytes>::available()) {
+        return transposeSquareInPlace< TransposeTile<Isa::Avx2, bytes> >(n, data, ld);
+    }
+    if (isa >= Isa::Sse2 && TransposeTile<Isa::Sse2, bytes>::available()) {
+        return transposeSquareInPlace< TransposeTile<Isa::Sse2, bytes> >(n, data, ld);
+    }
+#endif
+    transposeSquareInPlace< TransposeTileGeneric<T> >(n, data, ld);
+}
+
+/**
+ * \brief out = transpose(in), where "in" is rows x cols and "out" is cols x rows, both
+ *      row-major.
+ *
+ * "ldi" and "ldo" are the distances between the starts of consecutive rows of "in" and "out".
+ * "out" must not overlap "in".
+ */
+template <class T>
+void transpose(std::size_t rows, std::size_t cols, const T *in, std::size_t ldi, T *out, std::size_t ldo) {
+    transposeDispatch(rows, cols, in, ldi, out, ldo, TransposeTileBytes<T>());
+}
+
+/**
+ * \brief Transposes a rows x cols matrix in place, so that it becomes a cols x rows matrix.
+ *
+ * Square matrices are fast, and their rows may start "ld" elements apart (0, the default,
+ * means "cols").  Other shapes must be contiguous, and follow the cycles of the permutation,
+ * which is much slower than transposing into a second buffer but only needs a bit of extra
+ * memory per element.
+ */
+template <class T>
+void transposeInPlace(std::size_t rows, std::size_t cols, T *data, std::size_t ld = 0) {
+    if (rows == cols) {
+        return transposeSquareDispatch(rows, data, ld == 0 ? cols : ld, TransposeTileBytes<T>());
+    }
+    assert(ld == 0 || ld == cols);
+    if (rows > 1 && cols > 1) {
+        transposeCycles(rows, cols, data);
+    }
+}
+
+}
+}
+
+#endif /* Transpose_h */
@@ -16,33 +16,22 @@
 #include <cmath>
 #include <cassert>
 #include <algorithm>
+#include <utility>
+#include "AlignedAllocator.h"
+#include "ScratchArena.h"
+#include "Selection.h"
+#include "Simd.h"
+#include "Expression.h"
+#include "Nco.h"
+#include "View.h"
 
 namespace MatrixDSP {
  
-template <class T>
+template <class T, class Alloc = AlignedAllocator<T> >
 class Vector {
 
-protected:
-    std::shared_ptr< std::vector<T> > scratchBuf;
-    
-    void copyToScratchBuf(std::vector<T> &from) {
-        scratchBuf->resize(from.size());
-        for (unsigned index=0; index<from.size(); index++) {
-            (*scratchBuf)[index] = from[index];
-        }
-    }
-
-    void initializeScratchBuf(std::shared_ptr< std::vector<T> > scratch) {
-        if (scratch == nullptr) {
-            scratchBuf = std::shared_ptr< std::vector<T> >(new std::vector<T>);
-        }
-        else {
-            scratchBuf = scratch;
-        }
-    }
-
 public:
-    std::vector<T> vec;
+    std::vector<T, Alloc> vec;
     bool rowVector;
     
     /*****************************************************************************************
@@ -51,81 +40,72 @@ public:
     /**
      * \brief Basic constructor.
      *
-     * Just sets the size of \ref vec and the pointer to the scratch buffer, if one is provided.
+     * Just sets the size of \ref vec.
      * \param len Length of \ref vec.
-     * \param scratch Pointer to a scratch buffer.  The scratch buffer can be shared by multiple
-     *      objects (in fact, I recommend it), but if there are multiple threads then it should
-     *      be shared only by objects that are accessed by a single thread.  Objects in other
-     *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
      */
-    Vector<T>(uint32_t len = 0, bool rowVec = false, std::shared_ptr< std::vector<T> > scratch = nullptr) {
+    Vector(uint32_t len = 0, bool rowVec = false) {
         vec.resize(len);
         rowVector = rowVec;
-        initializeScratchBuf(scratch);
     }
     
     /**
      * \brief Vector constructor.
      *
-     * Sets vec equal to the input "data" parameter and sets the pointer to the scratch buffer,
-     *      if one is provided.
+     * Sets vec equal to the input "data" parameter.
      * \param data Vector that \ref vec will be set equal to.
-     * \param scratch Pointer to a scratch buffer.  The scratch buffer can be shared by multiple
-     *      objects (in fact, I recommend it), but if there are multiple threads then it should
-     *      be shared only by objects that are accessed by a single thread.  Objects in other
-     *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
      */
-    Vector<T>(std::vector<T> *data, bool rowVec = false, std::shared_ptr< std::vector<T> > scratch = nullptr) {
-        vec = *data;
+    template <class OtherAlloc>
+    Vector(std::vector<T, OtherAlloc> *data, bool rowVec = false) {
+        vec.assign(data->begin(), data->end());
         rowVector = rowVec;
-        initializeScratchBuf(scratch);
     }
     
     /**
      * \brief Array constructor.
      *
-     * Sets vec equal to the input "data" array and sets the pointer to the scratch buffer,
-     *      if one is provided.
+     * Sets vec equal to the input "data" array.
      * \param data Array that \ref vec will be set equal to.
      * \param dataLen Length of "data".
-     * \param scratch Pointer to a scratch buffer.  The scratch buffer can be shared by multiple
-     *      objects (in fact, I recommend it), but if there are multiple threads then it should
-     *      be shared only by objects that are accessed by a single thread.  Objects in other
-     *      threads should have a separate scratch buffer.  If no scratch buffer is provided
-     *      then one will be created in methods that require one and destroyed when the method
-     *      returns.
      */
     template <class U>
-        Vector<T>(U *data, uint32_t dataLen, bool rowVec = false, std::shared_ptr< std::vector<T> > scratch = nullptr) {
-        vec.resize(dataLen);
-        for (uint32_t index=0; index<dataLen; index++) {
-            vec[index] = (T) data[index];
-        }
+        Vector(U *data, uint32_t dataLen, bool rowVec = false) {
+        vec.assign(data, data + dataLen);
         rowVector = rowVec;
-        initializeScratchBuf(scratch);
     }
     
-    Vector<T>(std::initializer_list<T> initVals, bool rowVec = false, std::shared_ptr< std::vector<T> > scratch = nullptr) : vec(initVals) {
+    Vector(std::initializer_list<T> initVals, bool rowVec = false) : vec(initVals) {
         rowVector = rowVec;
-        initializeScratchBuf(scratch);
+    }
+    
+    /**
+     * \brief Expression constructor.
+     *
+     * Evaluates an element-wise expression such as "a*b + c" in a single pass, without any
+     * temporary vectors.
+     * \param expr The expression to evaluate.
+     */
+    template <class E>
+    Vector(const VectorExpression<E> &expr) {
+        rowVector = expr.derived().rowVector();
+        vec.resize(expr.derived().size());
+        evaluateExpression(vec.data(), vectorOperand(expr.derived()), size());
     }
     
     /**
      * \brief Copy constructor.
      */
-    Vector<T>(const Vector<T>& other) {*this = other;}
+    Vector(const Vector<T, Alloc>& other) : vec(other.vec), rowVector(other.rowVector) {}
+    
+    /**
+     * \brief Move constructor.  Takes over the other vector's data without copying.
+     */
+    Vector(Vector<T, Alloc>&& other) noexcept : vec(std::move(other.vec)), rowVector(other.rowVector) {}
     
     /**
      * \brief Virtual destructor.
      */
     virtual ~Vector() = default;
     
-    std::shared_ptr< std::vector<T> > getScratchBuf(void) const {return scratchBuf;}
-
     /*****************************************************************************************
                                             Operators
     *****************************************************************************************/
@@ -146,20 +126,40 @@ public:
     /**
      * \brief Assignment operator.
      */
-    Vector<T>& operator=(const Vector<T>& rhs) {
-        vec.resize(rhs.size());
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = rhs[index];
-        }
+    Vector<T, Alloc>& operator=(const Vector<T, Alloc>& rhs) {
+        vec = rhs.vec;
+        rowVector = rhs.rowVector;
+        return *this;
+    }
+    
+    /**
+     * \brief Move assignment operator.
+     */
+    Vector<T, Alloc>& operator=(Vector<T, Alloc>&& rhs) noexcept {
+        vec = std::move(rhs.vec);
         rowVector = rhs.rowVector;
-        scratchBuf = rhs.scratchBuf;
+        return *this;
+    }
+    
+    /**
+     * \brief Expression assignment operator.
+     *
+     * Evaluates an element-wise expression such as "a*b + c" in a single pass.  This vector
+     * may appear in the expression.
+     */
+    template <class E>
+    Vector<T, Alloc>& operator=(const VectorExpression<E> &expr) {
+        const E &derivedExpr = expr.derived();
+        rowVector = derivedExpr.rowVector();
+        vec.resize(derivedExpr.size());
+        evaluateExpression(vec.data(), vectorOperand(derivedExpr), size());
         return *this;
     }
     
     /**
      * \brief Unary minus (negation) operator.
      */
-    Vector<T> & operator-() {
+    Vector<T, Alloc> & operator-() {
         for (unsigned index=0; index<vec.size(); index++) {
             vec[index] = -vec[index];
         }
@@ -169,92 +169,116 @@ public:
     /**
      * \brief Add Buffer/Assignment operator.
      */
-    template <class U>
-    Vector<T> & operator+=(const Vector<U> &rhs) {
+    template <class U, class OtherAlloc>
+    Vector<T, Alloc> & operator+=(const Vector<U, OtherAlloc> &rhs) {
         assert(vec.size() == rhs.size());
         
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] += rhs[index];
-        }
+        simd::binary<simd::Add>(vec.data(), vec.data(), rhs.vec.data(), vec.size());
+        return *this;
+    }
+    
+    /**
+     * \brief Add Expression/Assignment operator.  "rhs" can be a view or an expression such as
+     *      "a*b".
+     */
+    template <class E>
+    Vector<T, Alloc> & operator+=(const VectorExpression<E> &rhs) {
+        view() += rhs.derived();
         return *this;
     }
     
     /**
      * \brief Add Scalar/Assignment operator.
      */
-    Vector<T> & operator+=(const T &rhs) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] += rhs;
-        }
+    Vector<T, Alloc> & operator+=(const T &rhs) {
+        simd::binaryScalar<simd::Add>(vec.data(), vec.data(), rhs, vec.size());
         return *this;
     }
     
     /**
      * \brief Subtract Buffer/Assignment operator.
      */
-    template <class U>
-    Vector<T> & operator-=(const Vector<U> &rhs) {
+    template <class U, class OtherAlloc>
+    Vector<T, Alloc> & operator-=(const Vector<U, OtherAlloc> &rhs) {
         assert(vec.size() == rhs.size());
         
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] -= rhs[index];
-        }
+        simd::binary<simd::Sub>(vec.data(), vec.data(), rhs.vec.data(), vec.size());
+        return *this;
+    }
+    
+    /**
+     * \brief Subtract Expression/Assignment operator.  "rhs" can be a view or an expression such as
+     *      "a*b".
+     */
+    template <class E>
+    Vector<T, Alloc> & operator-=(const VectorExpression<E> &rhs) {
+        view() -= rhs.derived();
         return *this;
     }
     
     /**
      * \brief Subtract Scalar/Assignment operator.
      */
-    Vector<T> & operator-=(const T &rhs) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] -= rhs;
-        }
+    Vector<T, Alloc> & operator-=(const T &rhs) {
+        simd::binaryScalar<simd::Sub>(vec.data(), vec.data(), rhs, vec.size());
         return *this;
     }
     
     /**
      * \brief Multiply Buffer/Assignment operator.
      */
-    template <class U>
-    Vector<T> & operator*=(const Vector<U> &rhs) {
+    template <class U, class OtherAlloc>
+    Vector<T, Alloc> & operator*=(const Vector<U, OtherAlloc> &rhs) {
         assert(vec.size() == rhs.size());
         
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] *= rhs[index];
-        }
+        simd::binary<simd::Mul>(vec.data(), vec.data(), rhs.vec.data(), vec.size());
+        return *this;
+    }
+    
+    /**
+     * \brief Multiply Expression/Assignment operator.  "rhs" can be a view or an expression such as
+     *      "a*b".
+     */
+    template <class E>
+    Vector<T, Alloc> & operator*=(const VectorExpression<E> &rhs) {
+        view() *= rhs.derived();
         return *this;
     }
     
     /**
      * \brief Multiply Scalar/Assignment operator.
      */
-    Vector<T> & operator*=(const T &rhs) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] *= rhs;
-        }
+    Vector<T, Alloc> & operator*=(const T &rhs) {
+        simd::binaryScalar<simd::Mul>(vec.data(), vec.data(), rhs, vec.size());
         return *this;
     }
 
     /**
      * \brief Divide Buffer/Assignment operator.
      */
-    template <class U>
-    Vector<T> & operator/=(const Vector<U> &rhs) {
+    template <class U, class OtherAlloc>
+    Vector<T, Alloc> & operator/=(const Vector<U, OtherAlloc> &rhs) {
         assert(vec.size() == rhs.size());
         
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] /= rhs[index];
-        }
+        simd::binary<simd::Div>(vec.data(), vec.data(), rhs.vec.data(), vec.size());
+        return *this;
+    }
+    
+    /**
+     * \brief Divide Expression/Assignment operator.  "rhs" can be a view or an expression such as
+     *      "a*b".
+     */
+    template <class E>
+    Vector<T, Alloc> & operator/=(const VectorExpression<E> &rhs) {
+        view() /= rhs.derived();
         return *this;
     }
     
     /**
      * \brief Divide Scalar/Assignment operator.
      */
-    Vector<T> & operator/=(const T &rhs) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] /= rhs;
-        }
+    Vector<T, Alloc> & operator/=(const T &rhs) {
+        simd::binaryScalar<simd::Div>(vec.data(), vec.data(), rhs, vec.size());
         return *this;
     }
     
@@ -266,6 +290,19 @@ public:
      */
     const unsigned size() const {return (const unsigned) vec.size();};
     
+    /**
+     * \brief Returns a view of all of \ref vec.  The view is invalidated by anything that
+     *      resizes \ref vec.
+     */
+    VectorView<T> view() {return VectorView<T>(vec.data(), size(), rowVector);}
+    VectorView<const T> view() const {return VectorView<const T>(vec.data(), size(), rowVector);}
+    
+    /**
+     * \brief Returns a view of "len" elements of \ref vec, starting at "start".
+     */
+    VectorView<T> view(unsigned start, unsigned len) {return view().view(start, len);}
+    VectorView<const T> view(unsigned start, unsigned len) const {return view().view(start, len);}
+    
 	auto begin() { return vec.begin(); }
 	auto end() { return vec.end(); }
 
@@ -282,13 +319,7 @@ public:
     /**
      * \brief Returns the sum of all the elements in \ref vec.
      */
-    T sum() const {
-        T vecSum = 0;
-        for (T element : vec) {
-            vecSum += element;
-        }
-        return vecSum;
-    }
+    T sum() const {return view().sum();}
 
     /**
      * \brief Sets each element of \ref buf equal to its value to the power of "exponent".
@@ -296,60 +327,111 @@ public:
      * \param exponent Exponent to use.
      * \return Reference to "this".
      */
-    Vector<T> & pow(const T exponent) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = std::pow(vec[index], exponent);
-        }
+    Vector<T, Alloc> & pow(const T exponent) {
+        view().pow(exponent);
         return *this;
     }
     
     /**
      * \brief Returns the mean (average) of the data in \ref buf.
      */
-    const T mean() const {
-        return sum() / ((T) size());
-    }
+    const T mean() const {return view().mean();}
     
     /**
      * \brief Returns the variance of the data in \ref buf.
      */
-    const T var(const bool subset = true) const {
-        T squaredSum = 0;
-        T vecMean = mean();
-        unsigned normalizer = size();
-        if (subset) {
-            normalizer--;
-        }
-        
-        for (T element : vec) {
-            T val = element - vecMean;
-            squaredSum += val * val;
-        }
-        return squaredSum / ((T) normalizer);
-    }
+    const T var(const bool subset = true) const {return view().var(subset);}
     
     /**
      * \brief Returns the standard deviation of the data in \ref buf.
      */
-    const T stdDev(const bool subset = true) const {return std::sqrt(this->var(subset));}
+    const T stdDev(const bool subset = true) const {return view().stdDev(subset);}
+    
+    /**
+     * \brief Returns the sum, mean, variance and standard deviation of \ref vec, and for real
+     *      data the minimum and maximum and where they are, from one pass over the data.
+     *      Complex data also gets its power.  See VectorView::stats().
+     *
+     * \tparam Acc The type that the sums are done in.  Defaults to T (double for integers).
+     * \param subset Normalize the variance by N - 1 rather than N.  Defaults to true.
+     */
+    template <class Acc = typename StatsAccumulator<T>::type>
+    typename StatsResult<T, Acc>::type stats(const bool subset = true) const {return view().template stats<Acc>(subset);}
     
     /**
      * \brief Returns the median element of \ref buf.
+     *
+     * Finds the middle with std::nth_element() on a copy of the data, which is O(n), rather
+     * than sorting it.
      */
-    const T median() {
+    const T median() const {
         assert(vec.size() > 0);
         
-        copyToScratchBuf(vec);
-        std::sort(scratchBuf->begin(), scratchBuf->end());
+        ScratchBuffer<T> work(vec.size());
+        std::copy(vec.begin(), vec.end(), work.begin());
+        unsigned topHalfIndex = size()/2;
+        std::nth_element(work.begin(), work.begin() + topHalfIndex, work.end());
         if (this->size() & 1) {
             // Odd number of samples
-            return (*scratchBuf)[size()/2];
+            return work[topHalfIndex];
         }
         else {
-            // Even number of samples.  Average the two in the middle.
-            unsigned topHalfIndex = size()/2;
-            return ((*scratchBuf)[topHalfIndex] + (*scratchBuf)[topHalfIndex-1]) / ((T) 2);
+            // Even number of samples.  Average the two in the middle.  Everything below the
+            // top half is now at most work[topHalfIndex], so the other one is the largest of them.
+            T bottomHalfMax = *std::max_element(work.begin(), work.begin() + topHalfIndex);
+            return (work[topHalfIndex] + bottomHalfMax) / ((T) 2);
+        }
+    }
+    
+    /**
+     * \brief Returns quantile "p" of the data in \ref buf.
+     *
+     * Quantiles are defined as they are in MATLAB: the sorted samples are the quantiles at
+     * (i + 0.5)/N, and quantiles in between are linearly interpolated.  quantile(0.5) is the
+     * median.  See quantiles() for computing several at once.
+     *
+     * \param p The probability, from 0 to 1.
+     */
+    const T quantile(double p) const {
+        return quantiles(std::vector<double>(1, p))[0];
+    }
+    
+    /**
+     * \brief Returns the quantiles "probabilities" of the data in \ref buf.
+     *
+     * All of the quantiles are found with one multi-way selection on a copy of the data (see
+     * multiSelect()), which is O(N log K) for K quantiles, so asking for several at once is
+     * much cheaper than calling quantile() for each of them or sorting.
+     *
+     * \param probabilities The probabilities, from 0 to 1, in any order.
+     * \return The quantiles, in the order of "probabilities".
+     */
+    std::vector<T> quantiles(const std::vector<double> &probabilities) const {
+        assert(vec.size() > 0);
+        
+        ScratchBuffer<T> work(vec.size());
+        std::copy(vec.begin(), vec.end(), work.begin());
+        std::vector<T> result(probabilities.size());
+        selectQuantiles(work.begin(), work.end(), probabilities, result.data());
+        return result;
+    }
+    
+    /**
+     * \brief Returns percentile "percent" of the data in \ref buf.  The same as
+     *      quantile(percent / 100).
+     */
+    const T percentile(double percent) const {return quantile(percent / 100);}
+    
+    /**
+     * \brief Returns the percentiles "percents" of the data in \ref buf.  The same as
+     *      quantiles() with the percentages divided by 100.
+     */
+    std::vector<T> percentiles(const std::vector<double> &percents) const {
+        std::vector<double> probabilities(percents.size());
+        for (unsigned index=0; index<percents.size(); index++) {
+            probabilities[index] = percents[index] / 100;
         }
+        return quantiles(probabilities);
     }
     
     /**
@@ -360,23 +442,7 @@ public:
      *      to the maximum value the index of the first will be returned.
      *      Defaults to nullptr.
      */
-    const T max(unsigned *maxLoc = nullptr) const {
-        assert(vec.size() > 0);
-        
-        T maxVal = vec[0];
-        unsigned maxIndex = 0;
-        
-        for (unsigned index=1; index<vec.size(); index++) {
-            if (maxVal < vec[index]) {
-                maxVal = vec[index];
-                maxIndex = index;
-            }
-        }
-        if (maxLoc != nullptr) {
-            *maxLoc = maxIndex;
-        }
-        return maxVal;
-    }
+    const T max(unsigned *maxLoc = nullptr) const {return view().max(maxLoc);}
     
     /**
      * \brief Returns the minimum element in \ref buf.
@@ -386,23 +452,7 @@ public:
      *      to the minimum value the index of the first will be returned.
      *      Defaults to nullptr.
      */
-    const T min(unsigned *minLoc = nullptr) const {
-        assert(vec.size() > 0);
-        
-        T minVal = vec[0];
-        unsigned minIndex = 0;
-        
-        for (unsigned index=1; index<vec.size(); index++) {
-            if (minVal > vec[index]) {
-                minVal = vec[index];
-                minIndex = index;
-            }
-        }
-        if (minLoc != nullptr) {
-            *minLoc = minIndex;
-        }
-        return minVal;
-    }
+    const T min(unsigned *minLoc = nullptr) const {return view().min(minLoc);}
     
     /**
      * \brief Sets the upper and lower limit of the values in \ref buf.
@@ -412,13 +462,8 @@ public:
      *      any that are less than -val are made equal to -val.
      * \return Reference to "this".
      */
-    Vector<T> & saturate(T val) {
-        assert(val >= 0);
-        
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = std::min(vec[index], val);
-            vec[index] = std::max(vec[index], -val);
-        }
+    Vector<T, Alloc> & saturate(T val) {
+        view().saturate(val);
         return *this;
     }
 
@@ -426,10 +471,8 @@ public:
      * \brief Does a "ceil" operation on \ref vec.
      * \return Reference to "this".
      */
-    Vector<T> & ceil(void) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = std::ceil(vec[index]);
-        }
+    Vector<T, Alloc> & ceil(void) {
+        view().ceil();
         return *this;
     }
 
@@ -437,10 +480,8 @@ public:
      * \brief Does a "floor" operation on \ref vec.
      * \return Reference to "this".
      */
-    Vector<T> & floor(void) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = std::floor(vec[index]);
-        }
+    Vector<T, Alloc> & floor(void) {
+        view().floor();
         return *this;
     }
 
@@ -448,10 +489,8 @@ public:
      * \brief Does a "round" operation on \ref vec.
      * \return Reference to "this".
      */
-    Vector<T> & round(void) {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = std::round(vec[index]);
-        }
+    Vector<T, Alloc> & round(void) {
+        view().round();
         return *this;
     }
 
@@ -460,10 +499,8 @@ public:
      *
      * \return Reference to "this".
      */
-    Vector<T> & abs() {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = std::abs(vec[index]);
-        }
+    Vector<T, Alloc> & abs() {
+        view().abs();
         return *this;
     }
     
@@ -472,10 +509,8 @@ public:
      *
      * \return Reference to "this".
      */
-    Vector<T> & exp() {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = std::exp(vec[index]);
-        }
+    Vector<T, Alloc> & exp() {
+        view().exp();
         return *this;
     }
     
@@ -484,10 +519,8 @@ public:
      *
      * \return Reference to "this".
      */
-    Vector<T> & log() {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = std::log(vec[index]);
-        }
+    Vector<T, Alloc> & log() {
+        view().log();
         return *this;
     }
     
@@ -496,10 +529,8 @@ public:
      *
      * \return Reference to "this".
      */
-    Vector<T> & log10() {
-        for (unsigned index=0; index<vec.size(); index++) {
-            vec[index] = std::log10(vec[index]);
-        }
+    Vector<T, Alloc> & log10() {
+        view().log10();
         return *this;
     }
 
@@ -512,18 +543,8 @@ public:
      *      the left, and negative values shift it to the right.
      * \return Reference to "this".
      */
-    Vector<T> & vectorRotate(int numToShift) {
-        if (vec.size() <= 1) {
-            return *this;
-        }
-        while (numToShift >= (int) vec.size()) {
-            numToShift -= (int) vec.size();
-        }
-        while (numToShift < 0) {
-            numToShift += (int) vec.size();
-        }
-        
-        std::rotate(vec.begin(), vec.begin() + numToShift, vec.end());
+    Vector<T, Alloc> & vectorRotate(int numToShift) {
+        view().vectorRotate(numToShift);
         return *this;
     }
     
@@ -532,8 +553,8 @@ public:
      *
      * \return Reference to "this".
      */
-    Vector<T> & reverse() {
-        std::reverse(vec.begin(), vec.end());
+    Vector<T, Alloc> & reverse() {
+        view().reverse();
         return *this;
     }
 
@@ -546,7 +567,7 @@ public:
      * \param val The value to set any new elements to.  Defaults to 0.
      * \return Reference to "this".
      */
-    Vector<T> & resize(unsigned len, T val = (T) 0) {this->vec.resize(len, val); return *this;}
+    Vector<T, Alloc> & resize(unsigned len, T val = (T) 0) {this->vec.resize(len, val); return *this;}
     
     /**
      * \brief Lengthens \ref vec by "len" elements.
@@ -555,17 +576,20 @@ public:
      * \param val The value to set the new elements to.  Defaults to 0.
      * \return Reference to "this".
      */
-    Vector<T> & pad(unsigned len, T val = (T) 0) {this->vec.resize(this->size()+len, val); return *this;}
+    Vector<T, Alloc> & pad(unsigned len, T val = (T) 0) {this->vec.resize(this->size()+len, val); return *this;}
     
     /**
      * \brief Inserts rate-1 zeros between samples.
      *
+     * To interpolate, Interpolator (Resampler.h) does the upsampling and the filtering together
+     * without multiplying the zeros.
+     *
      * \param rate Indicates how many zeros should be inserted between samples.
      * \param phase Indicates how many of the zeros should be before the samples (as opposed to
      *      after).  Valid values are 0 to "rate"-1.  Defaults to 0.
      * \return Reference to "this".
      */
-    Vector<T> & upsample(int rate, int phase = 0) {
+    Vector<T, Alloc> & upsample(int rate, int phase = 0) {
         assert(rate > 0);
         assert(phase >= 0 && phase < rate);
         
@@ -585,12 +609,15 @@ public:
     /**
      * \brief Removes rate-1 samples out of every rate samples.
      *
+     * To decimate, Decimator (Resampler.h) does the filtering and the downsampling together
+     * without computing the samples that would be removed.
+     *
      * \param rate Indicates how many samples should be removed.
      * \param phase Tells the method which sample should be the first to be kept.  Valid values
      *      are 0 to "rate"-1.  Defaults to 0.
      * \return Reference to "this".
      */
-    Vector<T> & downsample(int rate, int phase = 0) {
+    Vector<T, Alloc> & downsample(int rate, int phase = 0) {
         assert(rate > 0);
         assert(phase >= 0 && phase < rate);
         if (rate == 1)
@@ -611,12 +638,8 @@ public:
      * \param initialVal Initializing value for the cumulative sum.  Defaults to zero.
      * \return Reference to "this".
      */
-    Vector<T> & cumsum(T initialVal = 0) {
-        T sum = initialVal;
-        for (unsigned i=0; i<vec.size(); i++) {
-            sum += vec[i];
-            vec[i] = sum;
-        }
+    Vector<T, Alloc> & cumsum(T initialVal = 0) {
+        view().cumsum(initialVal);
         return *this;
     }
     
@@ -628,7 +651,7 @@ public:
      *      previous vec.  Defaults to nullptr.
      * \return Reference to "this".
      */
-    Vector<T> & diff(T *previousVal = nullptr) {
+    Vector<T, Alloc> & diff(T *previousVal = nullptr) {
         if (previousVal == nullptr) {
             assert(size() > 1);
             for (unsigned i=0; i<(size()-1); i++) {
@@ -665,12 +688,9 @@ public:
             this->resize(numSamples);
         }
         
-        T phaseInc = (freq / sampleFreq) * 2 * M_PI;
-        for (unsigned i=0; i<size(); i++) {
-            vec[i] = std::sin(phase);
-            phase += phaseInc;
-        }
-        return phase;
+        Nco<T> nco(freq, sampleFreq, phase);
+        nco.sin(vec.data(), size());
+        return phase + size() * nco.phaseIncrement();
     }
     
     /**
@@ -684,8 +704,15 @@ public:
      * \return The next phase if the tone were to continue.
      */
     T cos(T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSamples = 0) {
-        T sinPhase = this->sin(freq, sampleFreq, phase + ((T) M_PI / 2), numSamples);
-        return sinPhase - ((T) M_PI / 2);
+        assert(sampleFreq > 0.0);
+        
+        if (numSamples && numSamples != size()) {
+            this->resize(numSamples);
+        }
+        
+        Nco<T> nco(freq, sampleFreq, phase);
+        nco.cos(vec.data(), size());
+        return phase + size() * nco.phaseIncrement();
     }
     
     /**
@@ -699,125 +726,158 @@ public:
     T modulate(T freq, T sampleFreq = 1.0, T phase = 0.0) {
         assert(sampleFreq > 0.0);
         
-        T phaseInc = (freq / sampleFreq) * 2 * M_PI;
-        for (unsigned i=0; i<size(); i++) {
-            vec[i] *= std::sin(phase);
-            phase += phaseInc;
+        Nco<T> nco(freq, sampleFreq, phase);
+        ScratchBuffer<T> sine(simd::ncoBlockSize);
+        for (unsigned start = 0; start < size(); start += simd::ncoBlockSize) {
+            unsigned len = std::min(size() - start, simd::ncoBlockSize);
+            nco.sin(sine.data(), len);
+            for (unsigned i = 0; i < len; i++) {
+                vec[start + i] *= sine[i];
+            }
         }
-        return phase;
+        return phase + size() * nco.phaseIncrement();
     }
 };
 
 
-template <class T, class U>
-inline Vector<T> operator+(Vector<T> lhs, const Vector<U>& rhs)
+/**
+ * \brief Makes a Vector an operand of an expression.
+ */
+template <class T, class Alloc>
+VectorOperand<T> vectorOperand(const Vector<T, Alloc> &vec) {return VectorOperand<T>(vec.vec.data(), vec.size(), vec.rowVector);}
+
+/*
+ * The arithmetic operators build expressions that are evaluated when they are assigned to a
+ * Vector.  See Expression.h.  The operands can be Vectors, ComplexVectors or other expressions.
+ */
+template <class L, class R>
+inline VectorBinaryResult<simd::Add, L, R> operator+(const L &lhs, const R &rhs)
 {
-    lhs += rhs;
-    return lhs;
+    return makeVectorExpression<simd::Add>(lhs, rhs);
 }
 
-template <class T>
-inline Vector<T> operator+(Vector<T> lhs, const T& rhs)
+template <class L>
+inline VectorScalarResult<simd::Add, L> operator+(const L &lhs, const typename VectorOperandType<L>::value_type &rhs)
 {
-    lhs += rhs;
-    return lhs;
+    return makeVectorExpression<simd::Add>(lhs, rhs);
 }
 
-template <class T, class U>
-inline Vector<T> operator-(Vector<T> lhs, const Vector<U>& rhs)
+template <class L, class R>
+inline VectorBinaryResult<simd::Sub, L, R> operator-(const L &lhs, const R &rhs)
 {
-    lhs -= rhs;
-    return lhs;
+    return makeVectorExpression<simd::Sub>(lhs, rhs);
 }
 
-template <class T>
-inline Vector<T> operator-(Vector<T> lhs, const T& rhs)
+template <class L>
+inline VectorScalarResult<simd::Sub, L> operator-(const L &lhs, const typename VectorOperandType<L>::value_type &rhs)
 {
-    lhs -= rhs;
-    return lhs;
+    return makeVectorExpression<simd::Sub>(lhs, rhs);
 }
 
-template <class T, class U>
-inline Vector<T> operator*(Vector<T> lhs, const Vector<U>& rhs)
+template <class L, class R>
+inline VectorBinaryResult<simd::Mul, L, R> operator*(const L &lhs, const R &rhs)
 {
-    lhs *= rhs;
-    return lhs;
+    return makeVectorExpression<simd::Mul>(lhs, rhs);
 }
 
-template <class T>
-inline Vector<T> operator*(Vector<T> lhs, const T& rhs)
+template <class L>
+inline VectorScalarResult<simd::Mul, L> operator*(const L &lhs, const typename VectorOperandType<L>::value_type &rhs)
 {
-    lhs *= rhs;
-    return lhs;
+    return makeVectorExpression<simd::Mul>(lhs, rhs);
 }
 
-template <class T, class U>
-inline Vector<T> operator/(Vector<T> lhs, const Vector<U>& rhs)
+template <class L, class R>
+inline VectorBinaryResult<simd::Div, L, R> operator/(const L &lhs, const R &rhs)
 {
-    lhs /= rhs;
-    return lhs;
+    return makeVectorExpression<simd::Div>(lhs, rhs);
 }
 
-template <class T>
-inline Vector<T> operator/(Vector<T> lhs, const T& rhs)
+template <class L>
+inline VectorScalarResult<simd::Div, L> operator/(const L &lhs, const typename VectorOperandType<L>::value_type &rhs)
 {
-    lhs /= rhs;
-    return lhs;
+    return makeVectorExpression<simd::Div>(lhs, rhs);
 }
 
-template <class T>
-inline Vector<T> operator==(Vector<T> lhs, const T& rhs) {
+template <class T, class Alloc>
+inline Vector<T, Alloc> operator==(Vector<T, Alloc> lhs, const T& rhs) {
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		lhs[index] = (T)(lhs[index] == rhs);
 	}
 	return lhs;
 }
 
-template <class T>
-inline Vector<T> operator!=(Vector<T> lhs, const T& rhs) {
+template <class T, class Alloc>
+inline Vector<T, Alloc> operator!=(Vector<T, Alloc> lhs, const T& rhs) {
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		lhs[index] = (T)(lhs[index] != rhs);
 	}
 	return lhs;
 }
 
-template <class T>
-Vector<T> operator<(Vector<T> lhs, const T& rhs) {
+template <class T, class Alloc>
+Vector<T, Alloc> operator<(Vector<T, Alloc> lhs, const T& rhs) {
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		lhs[index] = (T)(lhs[index] < rhs);
 	}
 	return lhs;
 }
 
-template <class T>
-Vector<T> operator<=(Vector<T> lhs, const T& rhs) {
+template <class T, class Alloc>
+Vector<T, Alloc> operator<=(Vector<T, Alloc> lhs, const T& rhs) {
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		lhs[index] = (T)(lhs[index] <= rhs);
 	}
 	return lhs;
 }
 
-template <class T>
-Vector<T> operator>(Vector<T> lhs, const T& rhs) {
+template <class T, class Alloc>
+Vector<T, Alloc> operator>(Vector<T, Alloc> lhs, const T& rhs) {
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		lhs[index] = (T)(lhs[index] > rhs);
 	}
 	return lhs;
 }
 
-template <class T>
-Vector<T> operator>=(Vector<T> lhs, const T& rhs) {
+template <class T, class Alloc>
+Vector<T, Alloc> operator>=(Vector<T, Alloc> lhs, const T& rhs) {
 	for (unsigned index = 0; index < lhs.size(); index++) {
 		lhs[index] = (T)(lhs[index] >= rhs);
 	}
 	return lhs;
 }
 
-template <class T>
-const unsigned size(Vector<T> &vec) {return vec.size();};
+/*
+ * Comparing an expression to a scalar evaluates the expression first.
+ */
+template <class Op, class L, class R>
+typename VectorBinaryExpression<Op, L, R>::vector_type operator==(const VectorBinaryExpression<Op, L, R> &lhs,
+        const typename VectorBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() == rhs;}
 
-template <class T>
-const unsigned length(Vector<T> &vec) {return vec.size();};
+template <class Op, class L, class R>
+typename VectorBinaryExpression<Op, L, R>::vector_type operator!=(const VectorBinaryExpression<Op, L, R> &lhs,
+        const typename VectorBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() != rhs;}
+
+template <class Op, class L, class R>
+typename VectorBinaryExpression<Op, L, R>::vector_type operator<(const VectorBinaryExpression<Op, L, R> &lhs,
+        const typename VectorBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() < rhs;}
+
+template <class Op, class L, class R>
+typename VectorBinaryExpression<Op, L, R>::vector_type operator<=(const VectorBinaryExpression<Op, L, R> &lhs,
+        const typename VectorBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() <= rhs;}
+
+template <class Op, class L, class R>
+typename VectorBinaryExpression<Op, L, R>::vector_type operator>(const VectorBinaryExpression<Op, L, R> &lhs,
+        const typename VectorBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() > rhs;}
+
+template <class Op, class L, class R>
+typename VectorBinaryExpression<Op, L, R>::vector_type operator>=(const VectorBinaryExpression<Op, L, R> &lhs,
+        const typename VectorBinaryExpression<Op, L, R>::value_type &rhs) {return lhs.eval() >= rhs;}
+
+template <class T, class Alloc>
+const unsigned size(Vector<T, Alloc> &vec) {return vec.size();};
+
+template <class T, class Alloc>
+const unsigned length(Vector<T, Alloc> &vec) {return vec.size();};
 
 /**
  * \brief Finds the first instance of "val" in \ref vec.
@@ -826,14 +886,17 @@ const unsigned length(Vector<T> &vec) {return vec.size();};
  * \return Index of first instance of "val".  If there aren't any elements equal to "val"
  *      it returns -1.
  */
-template <class T>
-std::vector<unsigned> find(const Vector<T> &vec) {return vec.find();}
+template <class T, class Alloc>
+std::vector<unsigned> find(const Vector<T, Alloc> &vec) {return vec.find();}
+
+template <class Op, class L, class R>
+std::vector<unsigned> find(const VectorBinaryExpression<Op, L, R> &expr) {return expr.find();}
 
 /**
  * \brief Returns the sum of all the elements in \ref vec.
  */
-template <class T>
-T sum(Vector<T> &vec) {return vec.sum();}
+template <class T, class Alloc>
+T sum(Vector<T, Alloc> &vec) {return vec.sum();}
 
 /**
  * \brief Sets each element of \ref buf equal to its value to the power of "exponent".
@@ -841,32 +904,65 @@ T sum(Vector<T> &vec) {return vec.sum();}
  * \param exponent Exponent to use.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & pow(Vector<T> &vec, const T exponent) {return vec.pow(exponent);}
+template <class T, class Alloc>
+Vector<T, Alloc> & pow(Vector<T, Alloc> &vec, const T exponent) {return vec.pow(exponent);}
 
 /**
  * \brief Returns the mean (average) of the data in \ref buf.
  */
-template <class T>
-const T mean(Vector<T> &vec) {return vec.mean();}
+template <class T, class Alloc>
+const T mean(Vector<T, Alloc> &vec) {return vec.mean();}
 
 /**
  * \brief Returns the variance of the data in \ref buf.
  */
-template <class T>
-const T var(Vector<T> &vec, const bool subset = true) {return vec.var(subset);}
+template <class T, class Alloc>
+const T var(Vector<T, Alloc> &vec, const bool subset = true) {return vec.var(subset);}
 
 /**
  * \brief Returns the standard deviation of the data in \ref buf.
  */
-template <class T>
-const T stdDev(Vector<T> &vec, const bool subset = true) {return vec.stdDev(subset);}
+template <class T, class Alloc>
+const T stdDev(Vector<T, Alloc> &vec, const bool subset = true) {return vec.stdDev(subset);}
+
+/**
+ * \brief Returns the sum, mean, variance, standard deviation, and either the minimum and maximum
+ *      (real data) or the power (complex data) of \ref buf from one pass over the data.
+ */
+template <class T, class Alloc>
+typename StatsResult<T, typename StatsAccumulator<T>::type>::type stats(Vector<T, Alloc> &vec, const bool subset = true) {
+    return vec.stats(subset);
+}
 
 /**
  * \brief Returns the median element of \ref buf.
  */
-template <class T>
-const T median(Vector<T> &vec) {return vec.median();}
+template <class T, class Alloc>
+const T median(Vector<T, Alloc> &vec) {return vec.median();}
+
+/**
+ * \brief Returns quantile "p" of the data in \ref buf.
+ */
+template <class T, class Alloc>
+const T quantile(Vector<T, Alloc> &vec, double p) {return vec.quantile(p);}
+
+/**
+ * \brief Returns the quantiles "probabilities" of the data in \ref buf.
+ */
+template <class T, class Alloc>
+std::vector<T> quantiles(Vector<T, Alloc> &vec, const std::vector<double> &probabilities) {return vec.quantiles(probabilities);}
+
+/**
+ * \brief Returns percentile "percent" of the data in \ref buf.
+ */
+template <class T, class Alloc>
+const T percentile(Vector<T, Alloc> &vec, double percent) {return vec.percentile(percent);}
+
+/**
+ * \brief Returns the percentiles "percents" of the data in \ref buf.
+ */
+template <class T, class Alloc>
+std::vector<T> percentiles(Vector<T, Alloc> &vec, const std::vector<double> &percents) {return vec.percentiles(percents);}
 
 /**
  * \brief Returns the maximum element in \ref buf.
@@ -876,8 +972,8 @@ const T median(Vector<T> &vec) {return vec.median();}
  *      to the maximum value the index of the first will be returned.
  *      Defaults to nullptr.
  */
-template <class T>
-const T max(Vector<T> &vec, unsigned *maxLoc = nullptr) {return vec.max(maxLoc);}
+template <class T, class Alloc>
+const T max(Vector<T, Alloc> &vec, unsigned *maxLoc = nullptr) {return vec.max(maxLoc);}
 
 /**
  * \brief Returns the minimum element in \ref buf.
@@ -887,8 +983,8 @@ const T max(Vector<T> &vec, unsigned *maxLoc = nullptr) {return vec.max(maxLoc);
  *      to the minimum value the index of the first will be returned.
  *      Defaults to nullptr.
  */
-template <class T>
-const T min(Vector<T> &vec, unsigned *minLoc = nullptr) {return vec.min(minLoc);}
+template <class T, class Alloc>
+const T min(Vector<T, Alloc> &vec, unsigned *minLoc = nullptr) {return vec.min(minLoc);}
 
 /**
  * \brief Sets the upper and lower limit of the values in \ref buf.
@@ -898,61 +994,61 @@ const T min(Vector<T> &vec, unsigned *minLoc = nullptr) {return vec.min(minLoc);
  *      any that are less than -val are made equal to -val.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & saturate(Vector<T> &vec, T val) {return vec.saturate(val);}
+template <class T, class Alloc>
+Vector<T, Alloc> & saturate(Vector<T, Alloc> &vec, T val) {return vec.saturate(val);}
 
 /**
  * \brief Does a "ceil" operation on \ref vec.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & ceil(Vector<T> &vec) {return vec.ceil();}
+template <class T, class Alloc>
+Vector<T, Alloc> & ceil(Vector<T, Alloc> &vec) {return vec.ceil();}
 
 /**
  * \brief Does a "floor" operation on \ref vec.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & floor(Vector<T> &vec) {return vec.floor();}
+template <class T, class Alloc>
+Vector<T, Alloc> & floor(Vector<T, Alloc> &vec) {return vec.floor();}
 
 /**
  * \brief Does a "round" operation on \ref vec.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & round(Vector<T> &vec) {return vec.round();}
+template <class T, class Alloc>
+Vector<T, Alloc> & round(Vector<T, Alloc> &vec) {return vec.round();}
 
 /**
  * \brief Changes the elements of \ref vec to their absolute value.
  *
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & abs(Vector<T> &vec) {return vec.abs();}
+template <class T, class Alloc>
+Vector<T, Alloc> & abs(Vector<T, Alloc> &vec) {return vec.abs();}
 
 /**
  * \brief Sets each element of \ref vec to e^(element).
  *
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & exp(Vector<T> &vec) {return vec.exp();}
+template <class T, class Alloc>
+Vector<T, Alloc> & exp(Vector<T, Alloc> &vec) {return vec.exp();}
 
 /**
  * \brief Sets each element of \ref vec to the natural log of the element.
  *
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & log(Vector<T> &vec) {return vec.log();}
+template <class T, class Alloc>
+Vector<T, Alloc> & log(Vector<T, Alloc> &vec) {return vec.log();}
 
 /**
  * \brief Sets each element of \ref vec to the base 10 log of the element.
  *
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & log10(Vector<T> &vec) {return vec.log10();}
+template <class T, class Alloc>
+Vector<T, Alloc> & log10(Vector<T, Alloc> &vec) {return vec.log10();}
 
 /**
  * \brief Circular rotation.
@@ -963,27 +1059,27 @@ Vector<T> & log10(Vector<T> &vec) {return vec.log10();}
  *      the left, and negative values shift it to the right.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & vectorRotate(Vector<T> &vec, int numToShift) {return vec.vectorRotate(numToShift);}
+template <class T, class Alloc>
+Vector<T, Alloc> & vectorRotate(Vector<T, Alloc> &vec, int numToShift) {return vec.vectorRotate(numToShift);}
 
 /**
  * \brief Reverses the order of the elements in \ref vec.
  *
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & reverse(Vector<T> &vec) {return vec.reverse();}
+template <class T, class Alloc>
+Vector<T, Alloc> & reverse(Vector<T, Alloc> &vec) {return vec.reverse();}
 
-template <class T>
-Vector<T> & fliplr(Vector<T> &vec) {
+template <class T, class Alloc>
+Vector<T, Alloc> & fliplr(Vector<T, Alloc> &vec) {
     if (vec.rowVector) {
         return vec.reverse();
     }
     return vec;
 }
 
-template <class T>
-Vector<T> & flipud(Vector<T> &vec) {
+template <class T, class Alloc>
+Vector<T, Alloc> & flipud(Vector<T, Alloc> &vec) {
     if (vec.rowVector == false) {
         return vec.reverse();
     }
@@ -999,8 +1095,8 @@ Vector<T> & flipud(Vector<T> &vec) {
  * \param val The value to set any new elements to.  Defaults to 0.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & resize(Vector<T> &vec, unsigned len, T val = (T) 0) {return vec.resize(len, val);}
+template <class T, class Alloc>
+Vector<T, Alloc> & resize(Vector<T, Alloc> &vec, unsigned len, T val = (T) 0) {return vec.resize(len, val);}
 
 /**
  * \brief Lengthens \ref vec by "len" elements.
@@ -1009,8 +1105,8 @@ Vector<T> & resize(Vector<T> &vec, unsigned len, T val = (T) 0) {return vec.resi
  * \param val The value to set the new elements to.  Defaults to 0.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & pad(Vector<T> &vec, unsigned len, T val = (T) 0) {return vec.pad(len, val);}
+template <class T, class Alloc>
+Vector<T, Alloc> & pad(Vector<T, Alloc> &vec, unsigned len, T val = (T) 0) {return vec.pad(len, val);}
 
 /**
  * \brief Inserts rate-1 zeros between samples.
@@ -1020,8 +1116,8 @@ Vector<T> & pad(Vector<T> &vec, unsigned len, T val = (T) 0) {return vec.pad(len
  *      after).  Valid values are 0 to "rate"-1.  Defaults to 0.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & upsample(Vector<T> &vec, int rate, int phase = 0) {return vec.upsample(rate, phase);}
+template <class T, class Alloc>
+Vector<T, Alloc> & upsample(Vector<T, Alloc> &vec, int rate, int phase = 0) {return vec.upsample(rate, phase);}
 
 /**
  * \brief Removes rate-1 samples out of every rate samples.
@@ -1031,8 +1127,8 @@ Vector<T> & upsample(Vector<T> &vec, int rate, int phase = 0) {return vec.upsamp
  *      are 0 to "rate"-1.  Defaults to 0.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & downsample(Vector<T> &vec, int rate, int phase = 0) {return vec.downsample(rate, phase);}
+template <class T, class Alloc>
+Vector<T, Alloc> & downsample(Vector<T, Alloc> &vec, int rate, int phase = 0) {return vec.downsample(rate, phase);}
 
 /**
  * \brief Replaces \ref vec with the cumulative sum of the samples in \ref vec.
@@ -1040,8 +1136,8 @@ Vector<T> & downsample(Vector<T> &vec, int rate, int phase = 0) {return vec.down
  * \param initialVal Initializing value for the cumulative sum.  Defaults to zero.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & cumsum(Vector<T> &vec, T initialVal = 0) {return vec.cumsum(initialVal);}
+template <class T, class Alloc>
+Vector<T, Alloc> & cumsum(Vector<T, Alloc> &vec, T initialVal = 0) {return vec.cumsum(initialVal);}
 
 /**
  * \brief Replaces \ref vec with the difference between successive samples in vec.
@@ -1051,8 +1147,8 @@ Vector<T> & cumsum(Vector<T> &vec, T initialVal = 0) {return vec.cumsum(initialV
  *      previous vec.  Defaults to nullptr.
  * \return Reference to "this".
  */
-template <class T>
-Vector<T> & diff(Vector<T> &vec, T *previousVal = nullptr) {return vec.diff(previousVal);}
+template <class T, class Alloc>
+Vector<T, Alloc> & diff(Vector<T, Alloc> &vec, T *previousVal = nullptr) {return vec.diff(previousVal);}
 
 /**
  * \brief Generates a real sinusoid.
@@ -1064,8 +1160,8 @@ Vector<T> & diff(Vector<T> &vec, T *previousVal = nullptr) {return vec.diff(prev
  *      this->size() samples.  Defaults to 0.
  * \return The next phase if the tone were to continue.
  */
-template <class T>
-T sin(Vector<T> &vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSamples = 0) {return vec.sin(freq, sampleFreq, phase, numSamples);}
+template <class T, class Alloc>
+T sin(Vector<T, Alloc> &vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSamples = 0) {return vec.sin(freq, sampleFreq, phase, numSamples);}
 
 /**
  * \brief Generates a real cosinusoid.
@@ -1077,8 +1173,8 @@ T sin(Vector<T> &vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSam
  *      this->size() samples.  Defaults to 0.
  * \return The next phase if the tone were to continue.
  */
-template <class T>
-T cos(Vector<T> &vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSamples = 0) {return vec.cos(freq, sampleFreq, phase, numSamples);}
+template <class T, class Alloc>
+T cos(Vector<T, Alloc> &vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSamples = 0) {return vec.cos(freq, sampleFreq, phase, numSamples);}
 
 /**
  * \brief Modulates the data with a real sinusoid.
@@ -1088,8 +1184,8 @@ T cos(Vector<T> &vec, T freq, T sampleFreq = 1.0, T phase = 0.0, unsigned numSam
  * \param phase The modulating tone's starting phase, in radians.  Defaults to 0.
  * \return The next phase if the tone were to continue.
  */
-template <class T>
-T modulate(Vector<T> &vec, T freq, T sampleFreq = 1.0, T phase = 0.0) {return vec.modulate(freq, sampleFreq, phase);}
+template <class T, class Alloc>
+T modulate(Vector<T, Alloc> &vec, T freq, T sampleFreq = 1.0, T phase = 0.0) {return vec.modulate(freq, sampleFreq, phase);}
     
 }
 
@@ -8,8 +8,13 @@
 #ifndef VectorMatrix_h
 #define VectorMatrix_h
 
+#include <algorithm>
+#include <complex>
 #include "ComplexVector.h"
+#include "Gemm.h"
+#include "Gemv.h"
 #include "Matrix2d.h"
+#include "ScratchArena.h"
 
 namespace MatrixDSP {
 
@@ -17,78 +22,242 @@ namespace MatrixDSP {
 // (m x n) * (n x p) = (m x p) - 1/4
 // (1 x m) * (m x n) = (1 x n) - 2/4
 
-template <class T>
-Vector<T> operator*(Matrix2d<T> lhs, const Vector<T> &rhs) {
+// The matrix-vector products use the GEMV kernels in Gemv.h.  A real matrix times a complex
+// vector is done without converting the matrix to complex.
+
+template <class T, class MatrixAlloc, class VectorAlloc>
+Vector<T, VectorAlloc> operator*(const Matrix2d<T, MatrixAlloc> &lhs, const Vector<T, VectorAlloc> &rhs) {
     assert(lhs.getCols() == rhs.size());
     assert(rhs.rowVector == false);
     
-    Vector<T> result(lhs.getRows(), false);
-    for (unsigned row=0; row<lhs.getRows(); row++) {
-        for (unsigned col=0; col<lhs.getCols(); col++) {
-            result(row) += lhs(row, col) * rhs(col);
-        }
-    }
+    Vector<T, VectorAlloc> result(lhs.getRows(), false);
+    simd::gemv(lhs.getRows(), lhs.getCols(), lhs.data(), lhs.ld(), rhs.vec.data(), result.vec.data());
     return result;
 }
 
-template <class T>
-ComplexVector<T> operator*(Matrix2d<T> lhs, const ComplexVector<T> &rhs) {
+template <class T, class MatrixAlloc, class VectorAlloc>
+ComplexVector<T, VectorAlloc> operator*(const Matrix2d<T, MatrixAlloc> &lhs, const ComplexVector<T, VectorAlloc> &rhs) {
     assert(lhs.getCols() == rhs.size());
     assert(rhs.rowVector == false);
     
-    ComplexVector<T> result(lhs.getRows(), false);
-    for (unsigned row=0; row<lhs.getRows(); row++) {
-        for (unsigned col=0; col<lhs.getCols(); col++) {
-            result(row) += lhs(row, col) * rhs(col);
-        }
-    }
+    ComplexVector<T, VectorAlloc> result(lhs.getRows(), false);
+    simd::gemv(lhs.getRows(), lhs.getCols(), lhs.data(), lhs.ld(), rhs.vec.data(), result.vec.data());
     return result;
 }
 
-template <class T>
-Vector<T> operator*(Vector<T> lhs, const Matrix2d<T> &rhs) {
+template <class T, class VectorAlloc, class MatrixAlloc>
+Vector<T, VectorAlloc> operator*(const Vector<T, VectorAlloc> &lhs, const Matrix2d<T, MatrixAlloc> &rhs) {
     assert(lhs.size() == rhs.getRows());
     assert(lhs.rowVector == true);
     
-    Vector<T> result(rhs.getCols(), true);
-    for (unsigned col=0; col<rhs.getCols(); col++) {
-        for (unsigned row=0; row<rhs.getRows(); row++) {
-            result(col) += lhs(row) * rhs(row, col);
-        }
-    }
+    Vector<T, VectorAlloc> result(rhs.getCols(), true);
+    simd::gemvTransposed(rhs.getRows(), rhs.getCols(), rhs.data(), rhs.ld(), lhs.vec.data(), result.vec.data());
     return result;
 }
 
-template <class T>
-ComplexVector<T> operator*(ComplexVector<T> lhs, const Matrix2d<T> &rhs) {
+template <class T, class VectorAlloc, class MatrixAlloc>
+ComplexVector<T, VectorAlloc> operator*(const ComplexVector<T, VectorAlloc> &lhs, const Matrix2d<T, MatrixAlloc> &rhs) {
     assert(lhs.size() == rhs.getRows());
     assert(lhs.rowVector == true);
     
-    ComplexVector<T> result(rhs.getCols(), true);
-    for (unsigned col=0; col<rhs.getCols(); col++) {
-        for (unsigned row=0; row<rhs.getRows(); row++) {
-            result(col) += lhs(row) * rhs(row, col);
-        }
-    }
+    ComplexVector<T, VectorAlloc> result(rhs.getCols(), true);
+    simd::gemvTransposed(rhs.getRows(), rhs.getCols(), rhs.data(), rhs.ld(), lhs.vec.data(), result.vec.data());
     return result;
 }
 
-template <class T>
-Matrix2d<T> operator*(Matrix2d<T> lhs, const Matrix2d<T> &rhs) {
+/**
+ * \brief Matrix multiplication.  Uses the blocked GEMM in Gemm.h, and big products are split
+ *      over defaultThreadPool().  The result's rows are padded if the rows of "lhs" are.
+ */
+template <class T, class Alloc, class OtherAlloc>
+Matrix2d<T, Alloc> operator*(const Matrix2d<T, Alloc> &lhs, const Matrix2d<T, OtherAlloc> &rhs) {
     assert(lhs.getCols() == rhs.getRows());
     
-    Matrix2d<T> result(lhs.getRows(), rhs.getCols());
-    for (unsigned row=0; row<lhs.getRows(); row++) {
-        for (unsigned col=0; col<rhs.getCols(); col++) {
-            for (unsigned colRow=0; colRow<lhs.getCols(); colRow++) {
-                result(row, col) += lhs(row, colRow) * rhs(colRow, col);
+    Matrix2d<T, Alloc> result;
+    result.padRows(lhs.rowsPadded());
+    result.resize(lhs.getRows(), rhs.getCols());
+    std::size_t multiplies = (std::size_t) lhs.getRows() * rhs.getCols() * lhs.getCols();
+    if (multiplies >= simd::gemmParallelMinSize) {
+        simd::gemm(lhs.getRows(), rhs.getCols(), lhs.getCols(), lhs.data(), lhs.ld(),
+                   rhs.data(), rhs.ld(), result.data(), result.ld(), defaultThreadPool());
+    }
+    else {
+        simd::gemm(lhs.getRows(), rhs.getCols(), lhs.getCols(), lhs.data(), lhs.ld(),
+                   rhs.data(), rhs.ld(), result.data(), result.ld());
+    }
+    return result;
+}
+
+/*
+ * Products with an expression evaluate the expression first.
+ */
+template <class Op, class L, class R, class T, class VectorAlloc>
+auto operator*(const MatrixBinaryExpression<Op, L, R> &lhs, const Vector<T, VectorAlloc> &rhs) -> decltype(lhs.eval() * rhs) {
+    return lhs.eval() * rhs;
+}
+
+template <class Op, class L, class R, class T, class VectorAlloc>
+auto operator*(const MatrixBinaryExpression<Op, L, R> &lhs, const ComplexVector<T, VectorAlloc> &rhs) -> decltype(lhs.eval() * rhs) {
+    return lhs.eval() * rhs;
+}
+
+template <class T, class MatrixAlloc, class Op, class L, class R>
+auto operator*(const Matrix2d<T, MatrixAlloc> &lhs, const VectorBinaryExpression<Op, L, R> &rhs) -> decltype(lhs * rhs.eval()) {
+    return lhs * rhs.eval();
+}
+
+template <class Op, class L, class R, class VectorOp, class VectorL, class VectorR>
+auto operator*(const MatrixBinaryExpression<Op, L, R> &lhs, const VectorBinaryExpression<VectorOp, VectorL, VectorR> &rhs)
+        -> decltype(lhs.eval() * rhs.eval()) {
+    return lhs.eval() * rhs.eval();
+}
+
+template <class Op, class L, class R, class T, class MatrixAlloc>
+auto operator*(const VectorBinaryExpression<Op, L, R> &lhs, const Matrix2d<T, MatrixAlloc> &rhs) -> decltype(lhs.eval() * rhs) {
+    return lhs.eval() * rhs;
+}
+
+template <class T, class VectorAlloc, class Op, class L, class R>
+auto operator*(const Vector<T, VectorAlloc> &lhs, const MatrixBinaryExpression<Op, L, R> &rhs) -> decltype(lhs * rhs.eval()) {
+    return lhs * rhs.eval();
+}
+
+template <class T, class VectorAlloc, class Op, class L, class R>
+auto operator*(const ComplexVector<T, VectorAlloc> &lhs, const MatrixBinaryExpression<Op, L, R> &rhs) -> decltype(lhs * rhs.eval()) {
+    return lhs * rhs.eval();
+}
+
+template <class VectorOp, class VectorL, class VectorR, class Op, class L, class R>
+auto operator*(const VectorBinaryExpression<VectorOp, VectorL, VectorR> &lhs, const MatrixBinaryExpression<Op, L, R> &rhs)
+        -> decltype(lhs.eval() * rhs.eval()) {
+    return lhs.eval() * rhs.eval();
+}
+
+template <class Op, class L, class R, class T, class MatrixAlloc>
+auto operator*(const MatrixBinaryExpression<Op, L, R> &lhs, const Matrix2d<T, MatrixAlloc> &rhs) -> decltype(lhs.eval() * rhs) {
+    return lhs.eval() * rhs;
+}
+
+template <class T, class MatrixAlloc, class Op, class L, class R>
+auto operator*(const Matrix2d<T, MatrixAlloc> &lhs, const MatrixBinaryExpression<Op, L, R> &rhs) -> decltype(lhs * rhs.eval()) {
+    return lhs * rhs.eval();
+}
+
+template <class LhsOp, class LhsL, class LhsR, class Op, class L, class R>
+auto operator*(const MatrixBinaryExpression<LhsOp, LhsL, LhsR> &lhs, const MatrixBinaryExpression<Op, L, R> &rhs)
+        -> decltype(lhs.eval() * rhs.eval()) {
+    return lhs.eval() * rhs.eval();
+}
+
+/*****************************************************************************************
+                                    Multi-channel FFTs
+*****************************************************************************************/
+/**
+ * \brief The number of channels that are transformed together as one interleaved batch.
+ *
+ * Big enough to fill a couple of AVX-512 registers per butterfly, small enough that a batch
+ * of a few thousand points stays in cache.
+ */
+const unsigned fftBatchWidth = 16;
+
+/**
+ * \brief Does the same length FFT on many channels with one setup.
+ *
+ * Sample n of channel c is input[n*sampleStride + c*channelStride], and bin n of channel c
+ * is written to output[n*outSampleStride + c*outChannelStride].  The channels are copied
+ * fftBatchWidth at a time into an interleaved scratch buffer and transformed as a batch (see
+ * kissfft::transform_batch()), so the twiddles are shared by the whole batch and the
+ * butterflies are vectorized across channels.  input and output may be the same, as long as
+ * the strides are too.
+ */
+template <class T, class U>
+void fftChannels(const U *input, std::complex<T> *output, unsigned fftLen, unsigned numChannels,
+                 unsigned sampleStride, unsigned channelStride, unsigned outSampleStride,
+                 unsigned outChannelStride, bool inverseFft) {
+    auto *fftSetup = fftSetupManager<T>().getFftSetup(fftLen, inverseFft);
+    unsigned batchWidth = std::min(numChannels, fftBatchWidth);
+    ScratchBuffer< std::complex<T> > packed(fftLen * batchWidth);
+    ScratchBuffer< std::complex<T> > transformed(fftLen * batchWidth);
+    for (unsigned first=0; first<numChannels; first+=batchWidth) {
+        unsigned width = std::min(batchWidth, numChannels - first);
+        for (unsigned n=0; n<fftLen; n++) {
+            for (unsigned c=0; c<width; c++) {
+                packed[n*width + c] = input[n*sampleStride + (first + c)*channelStride];
+            }
+        }
+        fftSetup->transform_batch(packed.data(), transformed.data(), width);
+        for (unsigned n=0; n<fftLen; n++) {
+            for (unsigned c=0; c<width; c++) {
+                output[n*outSampleStride + (first + c)*outChannelStride] = transformed[n*width + c];
             }
         }
     }
-    return result;
 }
 
+/**
+ * \brief Gives "output" the dimensions of "input".  The contents aren't kept.
+ */
+template <class T, class U, class InputAlloc, class OutputAlloc>
+void sizeFftOutput(const Matrix2d<U, InputAlloc> &input, Matrix2d< std::complex<T>, OutputAlloc > &output) {
+    if (output.getRows() != input.getRows() || output.getCols() != input.getCols()) {
+        output.resize(0, 0);
+        output.resize(input.getRows(), input.getCols());
+    }
+}
+
+/**
+ * \brief FFT of every row of a matrix.
+ *
+ * \param input The data to transform.  Each row is a channel.
+ * \param output The FFTs of the rows.  Resized to the size of "input".  May be "input".
+ * \param inverseFft Do inverse FFTs instead of forward ones.  Defaults to false.
+ * \return Reference to "output".
+ */
+template <class T, class InputAlloc, class OutputAlloc>
+Matrix2d< std::complex<T>, OutputAlloc > & fftRows(const Matrix2d< std::complex<T>, InputAlloc > &input,
+                                                   Matrix2d< std::complex<T>, OutputAlloc > &output,
+                                      bool inverseFft = false) {
+    assert(input.getCols() > 1);
+    sizeFftOutput(input, output);
+    fftChannels(input.data(), output.data(), input.getCols(), input.getRows(), 1, input.ld(), 1, output.ld(), inverseFft);
+    return output;
+}
+
+template <class T, class InputAlloc, class OutputAlloc>
+Matrix2d< std::complex<T>, OutputAlloc > & fftRows(const Matrix2d<T, InputAlloc> &input, Matrix2d< std::complex<T>, OutputAlloc > &output,
+                                                   bool inverseFft = false) {
+    assert(input.getCols() > 1);
+    sizeFftOutput(input, output);
+    fftChannels(input.data(), output.data(), input.getCols(), input.getRows(), 1, input.ld(), 1, output.ld(), inverseFft);
+    return output;
+}
 
+/**
+ * \brief FFT of every column of a matrix.
+ *
+ * \param input The data to transform.  Each column is a channel.
+ * \param output The FFTs of the columns.  Resized to the size of "input".  May be "input".
+ * \param inverseFft Do inverse FFTs instead of forward ones.  Defaults to false.
+ * \return Reference to "output".
+ */
+template <class T, class InputAlloc, class OutputAlloc>
+Matrix2d< std::complex<T>, OutputAlloc > & fftCols(const Matrix2d< std::complex<T>, InputAlloc > &input,
+                                                   Matrix2d< std::complex<T>, OutputAlloc > &output,
+                                      bool inverseFft = false) {
+    assert(input.getRows() > 1);
+    sizeFftOutput(input, output);
+    fftChannels(input.data(), output.data(), input.getRows(), input.getCols(), input.ld(), 1, output.ld(), 1, inverseFft);
+    return output;
+}
+
+template <class T, class InputAlloc, class OutputAlloc>
+Matrix2d< std::complex<T>, OutputAlloc > & fftCols(const Matrix2d<T, InputAlloc> &input, Matrix2d< std::complex<T>, OutputAlloc > &output,
+                                                   bool inverseFft = false) {
+    assert(input.getRows() > 1);
+    sizeFftOutput(input, output);
+    fftChannels(input.data(), output.data(), input.getRows(), input.getCols(), input.ld(), 1, output.ld(), 1, inverseFft);
+    return output;
+}
 
 }
 
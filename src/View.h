@@ -0,0 +1,655 @@
+//
+//  View.h
+//  MatrixDSP
+//
+//  Views of data that belongs to someone else: part of a Vector or Matrix2d, a std::vector,
+//  or memory that the library doesn't know about at all, such as a DMA or memory mapped
+//  buffer.  A view is a pointer and a size, so making one doesn't copy anything, and the
+//  in-place methods and operators work directly on the underlying memory.
+//
+//  A VectorView covers contiguous elements.  A MatrixView covers a block of a row-major
+//  matrix: the elements of each row are contiguous, and the rows start "ld" elements apart,
+//  so a view of a few columns of a bigger matrix works too.
+//
+//  Views don't own their data, so they must not outlive it, and a view of a Vector or Matrix2d
+//  is invalidated by anything that resizes it.  Views are expression operands like Vector and
+//  Matrix2d (see Expression.h), and assigning an expression to a view writes the elements of
+//  the view instead of pointing the view somewhere else.  Copying a view makes another view of
+//  the same data.  Use "VectorView<const T>" and "MatrixView<const T>" for read-only data.
+//
+
+#ifndef View_h
+#define View_h
+
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include "Simd.h"
+#include "Statistics.h"
+#include "Transcendental.h"
+#include "Expression.h"
+
+namespace MatrixDSP {
+
+/*****************************************************************************************
+                                        VectorView
+*****************************************************************************************/
+template <class T>
+class VectorView : public VectorExpression< VectorView<T> > {
+    private:
+    T *dataPtr;
+    unsigned len;
+    bool rowVec;
+
+    public:
+    typedef typename std::remove_const<T>::type value_type;
+
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Pointer constructor.
+     *
+     * \param data The first element of the view.
+     * \param length The number of elements in the view.
+     * \param rowVector True if the view is a row vector.  Defaults to false.
+     */
+    VectorView(T *data = nullptr, unsigned length = 0, bool rowVector = false) : dataPtr(data), len(length), rowVec(rowVector) {}
+
+    /**
+     * \brief std::vector constructor.  The view covers all of "data".
+     */
+    template <class U, class Alloc>
+    VectorView(std::vector<U, Alloc> &data, bool rowVector = false) : dataPtr(data.data()), len((unsigned) data.size()), rowVec(rowVector) {}
+
+    template <class U, class Alloc>
+    VectorView(const std::vector<U, Alloc> &data, bool rowVector = false) : dataPtr(data.data()), len((unsigned) data.size()), rowVec(rowVector) {}
+
+    /**
+     * \brief Conversion constructor, for making a read-only view from a writeable one.
+     */
+    template <class U>
+    VectorView(const VectorView<U> &other) : dataPtr(other.data()), len(other.size()), rowVec(other.rowVector()) {}
+
+    VectorView(const VectorView<T> &other) = default;
+
+    /*****************************************************************************************
+                                            Operators
+    *****************************************************************************************/
+    T & operator[](unsigned index) const {return dataPtr[index];}
+
+    T & operator()(unsigned index) const {return dataPtr[index];}
+
+    /**
+     * \brief Assignment operator.  Copies the elements of "rhs" into this view, which must be
+     *      the same size.
+     */
+    VectorView<T> & operator=(const VectorView<T> &rhs) {
+        assert(len == rhs.size());
+        evaluateExpression(dataPtr, vectorOperand(rhs), len);
+        return *this;
+    }
+
+    /**
+     * \brief Expression assignment operator.
+     *
+     * Evaluates an element-wise expression such as "a*b + c" straight into the viewed data,
+     * which must be the same size as the expression.  The view may appear in the expression,
+     * but views that partly overlap it may not.
+     */
+    template <class E>
+    VectorView<T> & operator=(const VectorExpression<E> &expr) {
+        assert(len == expr.derived().size());
+        evaluateExpression(dataPtr, vectorOperand(expr.derived()), len);
+        return *this;
+    }
+
+    /**
+     * \brief Unary minus (negation) operator.
+     */
+    VectorView<T> & operator-() {
+        for (unsigned index=0; index<len; index++) {
+            dataPtr[index] = -dataPtr[index];
+        }
+        return *this;
+    }
+
+    /**
+     * \brief Add Buffer/Assignment operator.  "rhs" can be a scalar, a Vector, a view or an
+     *      expression.
+     */
+    template <class R>
+    VectorView<T> & operator+=(const R &rhs) {
+        evaluateExpression(dataPtr, makeVectorExpression<simd::Add>(*this, rhs), len);
+        return *this;
+    }
+
+    /**
+     * \brief Subtract Buffer/Assignment operator.
+     */
+    template <class R>
+    VectorView<T> & operator-=(const R &rhs) {
+        evaluateExpression(dataPtr, makeVectorExpression<simd::Sub>(*this, rhs), len);
+        return *this;
+    }
+
+    /**
+     * \brief Multiply Buffer/Assignment operator.
+     */
+    template <class R>
+    VectorView<T> & operator*=(const R &rhs) {
+        evaluateExpression(dataPtr, makeVectorExpression<simd::Mul>(*this, rhs), len);
+        return *this;
+    }
+
+    /**
+     * \brief Divide Buffer/Assignment operator.
+     */
+    template <class R>
+    VectorView<T> & operator/=(const R &rhs) {
+        evaluateExpression(dataPtr, makeVectorExpression<simd::Div>(*this, rhs), len);
+        return *this;
+    }
+
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    /**
+     * \brief Returns the number of elements in the view.
+     */
+    unsigned size() const {return len;}
+
+    bool rowVector() const {return rowVec;}
+
+    T * data() const {return dataPtr;}
+
+    T * begin() const {return dataPtr;}
+    T * end() const {return dataPtr + len;}
+
+    /**
+     * \brief Returns a view of "length" elements of this view, starting at "start".
+     */
+    VectorView<T> view(unsigned start, unsigned length) const {
+        assert(start + length <= len);
+        return VectorView<T>(dataPtr + start, length, rowVec);
+    }
+
+    /**
+     * \brief Sets every element to "val".
+     *
+     * \return Reference to "this".
+     */
+    VectorView<T> & fill(const value_type &val) {
+        std::fill(dataPtr, dataPtr + len, val);
+        return *this;
+    }
+
+    std::vector<unsigned> find() const {
+        std::vector<unsigned> list(0);
+        for (unsigned index=0; index<len; index++) {
+            if (std::abs(dataPtr[index])) {
+                list.push_back(index);
+            }
+        }
+        return list;
+    }
+
+    /**
+     * \brief Returns the sum of all the elements.
+     */
+    value_type sum() const {return sum(std::is_floating_point<value_type>());}
+
+    /**
+     * \brief Returns the mean (average) of the elements.
+     */
+    value_type mean() const {return mean(std::is_floating_point<value_type>());}
+
+    /**
+     * \brief Returns the variance of the elements.
+     */
+    value_type var(const bool subset = true) const {return var(subset, std::is_floating_point<value_type>());}
+
+    /**
+     * \brief Returns the standard deviation of the elements.
+     */
+    value_type stdDev(const bool subset = true) const {return stdDev(subset, std::is_floating_point<value_type>());}
+
+    /**
+     * \brief Returns the sum, mean, variance and standard deviation of the elements, and for real
+     *      elements the minimum and maximum and where they are, from one pass over the data.
+     *      Complex elements also get their power.  See Stats and ComplexStats.
+     *
+     * The elements are summed in blocks with a compensated sum, and the variance is built up
+     * from the deviations of each block from its own mean, so the results are accurate even for
+     * long views of float data.
+     *
+     * \tparam Acc The type that the sums are done in.  Defaults to the type of the elements
+     *      (double for integers).  "double" gets more accuracy for float data.
+     * \param subset Normalize the variance by N - 1 rather than N.  Defaults to true.
+     */
+    template <class Acc = typename StatsAccumulator<value_type>::type>
+    typename StatsResult<value_type, Acc>::type stats(const bool subset = true) const {
+        return simd::stats<Acc>(static_cast<const value_type *>(dataPtr), len, subset);
+    }
+
+    /**
+     * \brief Returns the maximum element.
+     *
+     * \param maxLoc If it isn't equal to nullptr the index of the maximum element
+     *      will be returned via this pointer.  If more than one element is equal
+     *      to the maximum value the index of the first will be returned.
+     *      Defaults to nullptr.
+     */
+    value_type max(unsigned *maxLoc = nullptr) const {
+        assert(len > 0);
+
+        unsigned maxIndex = 0;
+        for (unsigned index=1; index<len; index++) {
+            if (dataPtr[maxIndex] < dataPtr[index]) {
+                maxIndex = index;
+            }
+        }
+        if (maxLoc != nullptr) {
+            *maxLoc = maxIndex;
+        }
+        return dataPtr[maxIndex];
+    }
+
+    /**
+     * \brief Returns the minimum element.
+     *
+     * \param minLoc If it isn't equal to nullptr the index of the minimum element
+     *      will be returned via this pointer.  If more than one element is equal
+     *      to the minimum value the index of the first will be returned.
+     *      Defaults to nullptr.
+     */
+    value_type min(unsigned *minLoc = nullptr) const {
+        assert(len > 0);
+
+        unsigned minIndex = 0;
+        for (unsigned index=1; index<len; index++) {
+            if (dataPtr[minIndex] > dataPtr[index]) {
+                minIndex = index;
+            }
+        }
+        if (minLoc != nullptr) {
+            *minLoc = minIndex;
+        }
+        return dataPtr[minIndex];
+    }
+
+    /**
+     * \brief Limits the elements to the range [-val, val].
+     *
+     * \return Reference to "this".
+     */
+    VectorView<T> & saturate(value_type val) {
+        assert(val >= 0);
+
+        for (unsigned index=0; index<len; index++) {
+            dataPtr[index] = std::max(std::min(dataPtr[index], val), -val);
+        }
+        return *this;
+    }
+
+    /**
+     * \brief Does a "ceil" operation on the elements.
+     * \return Reference to "this".
+     */
+    VectorView<T> & ceil() {
+        for (unsigned index=0; index<len; index++) {
+            dataPtr[index] = std::ceil(dataPtr[index]);
+        }
+        return *this;
+    }
+
+    /**
+     * \brief Does a "floor" operation on the elements.
+     * \return Reference to "this".
+     */
+    VectorView<T> & floor() {
+        for (unsigned index=0; index<len; index++) {
+            dataPtr[index] = std::floor(dataPtr[index]);
+        }
+        return *this;
+    }
+
+    /**
+     * \brief Does a "round" operation on the elements.
+     * \return Reference to "this".
+     */
+    VectorView<T> & round() {
+        for (unsigned index=0; index<len; index++) {
+            dataPtr[index] = std::round(dataPtr[index]);
+        }
+        return *this;
+    }
+
+    /**
+     * \brief Changes the elements to their absolute value.
+     *
+     * \return Reference to "this".
+     */
+    VectorView<T> & abs() {
+        simd::abs(dataPtr, dataPtr, len);
+        return *this;
+    }
+
+    /**
+     * \brief Sets each element to e^(element).
+     *
+     * \return Reference to "this".
+     */
+    VectorView<T> & exp() {
+        simd::exp(dataPtr, dataPtr, len);
+        return *this;
+    }
+
+    /**
+     * \brief Sets each element to its natural log.
+     *
+     * \return Reference to "this".
+     */
+    VectorView<T> & log() {
+        simd::log(dataPtr, dataPtr, len);
+        return *this;
+    }
+
+    /**
+     * \brief Sets each element to its base 10 log.
+     *
+     * \return Reference to "this".
+     */
+    VectorView<T> & log10() {
+        simd::log10(dataPtr, dataPtr, len);
+        return *this;
+    }
+
+    /**
+     * \brief Sets each element to its value to the power of "exponent".
+     *
+     * \return Reference to "this".
+     */
+    VectorView<T> & pow(const value_type exponent) {
+        simd::pow(dataPtr, dataPtr, len, exponent);
+        return *this;
+    }
+
+    /**
+     * \brief Circular rotation.  See Vector::vectorRotate().
+     *
+     * \return Reference to "this".
+     */
+    VectorView<T> & vectorRotate(int numToShift) {
+        if (len <= 1) {
+            return *this;
+        }
+        numToShift %= (int) len;
+        if (numToShift < 0) {
+            numToShift += (int) len;
+        }
+        std::rotate(dataPtr, dataPtr + numToShift, dataPtr + len);
+        return *this;
+    }
+
+    /**
+     * \brief Reverses the order of the elements.
+     *
+     * \return Reference to "this".
+     */
+    VectorView<T> & reverse() {
+        std::reverse(dataPtr, dataPtr + len);
+        return *this;
+    }
+
+    /**
+     * \brief Replaces the elements with their cumulative sum.
+     *
+     * \param initialVal Initializing value for the cumulative sum.  Defaults to zero.
+     * \return Reference to "this".
+     */
+    VectorView<T> & cumsum(value_type initialVal = 0) {
+        value_type runningSum = initialVal;
+        for (unsigned index=0; index<len; index++) {
+            runningSum += dataPtr[index];
+            dataPtr[index] = runningSum;
+        }
+        return *this;
+    }
+
+    /**
+     * \brief Replaces the elements with the difference between successive elements.
+     *
+     * A view can't change size, so unlike Vector::diff() the value before the first element
+     * must be given.
+     * \param previousVal The last value in the sample stream before the first element.  It is
+     *      set to the last element, ready for the next block of the stream.
+     * \return Reference to "this".
+     */
+    VectorView<T> & diff(value_type *previousVal) {
+        assert(previousVal != nullptr);
+        assert(len > 0);
+
+        value_type nextPreviousVal = dataPtr[len - 1];
+        for (unsigned index=len-1; index>0; index--) {
+            dataPtr[index] = dataPtr[index] - dataPtr[index - 1];
+        }
+        dataPtr[0] = dataPtr[0] - *previousVal;
+        *previousVal = nextPreviousVal;
+        return *this;
+    }
+
+    private:
+    // Floating point elements go through stats().  Integers keep the textbook formulas in
+    // integer arithmetic, so the mean and variance are truncated the way they always were (use
+    // stats() for exact ones).  So do complex elements, whose variance is the mean of the
+    // complex squares of the deviations.
+    value_type sum(std::true_type) const {return (value_type) stats().sum;}
+
+    value_type sum(std::false_type) const {
+        value_type viewSum = 0;
+        for (unsigned index=0; index<len; index++) {
+            viewSum += dataPtr[index];
+        }
+        return viewSum;
+    }
+
+    value_type mean(std::true_type) const {return (value_type) stats().mean;}
+
+    value_type mean(std::false_type) const {return sum() / ((value_type) len);}
+
+    value_type var(const bool subset, std::true_type) const {return (value_type) stats(subset).var;}
+
+    value_type var(const bool subset, std::false_type) const {
+        value_type squaredSum = 0;
+        value_type viewMean = mean();
+        unsigned normalizer = len;
+        if (subset) {
+            normalizer--;
+        }
+
+        for (unsigned index=0; index<len; index++) {
+            value_type val = dataPtr[index] - viewMean;
+            squaredSum += val * val;
+        }
+        return squaredSum / ((value_type) normalizer);
+    }
+
+    value_type stdDev(const bool subset, std::true_type) const {return (value_type) stats(subset).stdDev;}
+
+    value_type stdDev(const bool subset, std::false_type) const {return std::sqrt(var(subset));}
+};
+
+/**
+ * \brief Makes a VectorView an operand of an expression.
+ */
+template <class T>
+VectorOperand<typename VectorView<T>::value_type> vectorOperand(const VectorView<T> &view) {
+    return VectorOperand<typename VectorView<T>::value_type>(view.data(), view.size(), view.rowVector());
+}
+
+/*****************************************************************************************
+                                        MatrixView
+*****************************************************************************************/
+template <class T>
+class MatrixView : public MatrixExpression< MatrixView<T> > {
+    private:
+    T *dataPtr;
+    unsigned numRows;
+    unsigned numCols;
+    unsigned stride;
+
+    public:
+    typedef typename std::remove_const<T>::type value_type;
+    typedef std::pair<unsigned, unsigned> size_type;
+
+    /*****************************************************************************************
+                                        Constructors
+    *****************************************************************************************/
+    /**
+     * \brief Pointer constructor.
+     *
+     * \param data The first element of the first row.
+     * \param rows Number of rows.
+     * \param cols Number of columns.
+     * \param ld The distance, in elements, between the starts of neighbouring rows.  0, the
+     *      default, means "cols".
+     */
+    MatrixView(T *data = nullptr, unsigned rows = 0, unsigned cols = 0, unsigned ld = 0) :
+            dataPtr(data), numRows(rows), numCols(cols), stride(ld == 0 ? cols : ld) {
+        assert(stride >= numCols);
+    }
+
+    /**
+     * \brief Conversion constructor, for making a read-only view from a writeable one.
+     */
+    template <class U>
+    MatrixView(const MatrixView<U> &other) :
+            dataPtr(other.data()), numRows(other.getRows()), numCols(other.getCols()), stride(other.ld()) {}
+
+    MatrixView(const MatrixView<T> &other) = default;
+
+    /*****************************************************************************************
+                                            Operators
+    *****************************************************************************************/
+    T & operator()(unsigned row, unsigned col) const {return dataPtr[row * stride + col];}
+
+    /**
+     * \brief Assignment operator.  Copies the elements of "rhs" into this view, which must be
+     *      the same size.
+     */
+    MatrixView<T> & operator=(const MatrixView<T> &rhs) {
+        assert(numRows == rhs.getRows() && numCols == rhs.getCols());
+        evaluateMatrixExpression(dataPtr, stride, matrixOperand(rhs), numRows, numCols);
+        return *this;
+    }
+
+    /**
+     * \brief Expression assignment operator.
+     *
+     * Evaluates an element-wise expression straight into the viewed data, which must be the
+     * same size as the expression.  The view may appear in the expression, but views that
+     * partly overlap it may not.
+     */
+    template <class E>
+    MatrixView<T> & operator=(const MatrixExpression<E> &expr) {
+        assert(numRows == expr.derived().getRows() && numCols == expr.derived().getCols());
+        evaluateMatrixExpression(dataPtr, stride, matrixOperand(expr.derived()), numRows, numCols);
+        return *this;
+    }
+
+    /**
+     * \brief Add Buffer/Assignment operator.  "rhs" can be a scalar, a Matrix2d, a view or an
+     *      expression.
+     */
+    template <class R>
+    MatrixView<T> & operator+=(const R &rhs) {
+        evaluateMatrixExpression(dataPtr, stride, makeMatrixExpression<simd::Add>(*this, rhs), numRows, numCols);
+        return *this;
+    }
+
+    /**
+     * \brief Subtract Buffer/Assignment operator.
+     */
+    template <class R>
+    MatrixView<T> & operator-=(const R &rhs) {
+        evaluateMatrixExpression(dataPtr, stride, makeMatrixExpression<simd::Sub>(*this, rhs), numRows, numCols);
+        return *this;
+    }
+
+    /**
+     * \brief Multiply Scalar/Assignment operator.
+     */
+    MatrixView<T> & operator*=(const value_type &rhs) {
+        evaluateMatrixExpression(dataPtr, stride, makeMatrixExpression<simd::Mul>(*this, rhs), numRows, numCols);
+        return *this;
+    }
+
+    /**
+     * \brief Divide Scalar/Assignment operator.
+     */
+    MatrixView<T> & operator/=(const value_type &rhs) {
+        evaluateMatrixExpression(dataPtr, stride, makeMatrixExpression<simd::Div>(*this, rhs), numRows, numCols);
+        return *this;
+    }
+
+    /*****************************************************************************************
+                                            Methods
+    *****************************************************************************************/
+    size_type size() const {return std::make_pair(numRows, numCols);}
+
+    unsigned getRows() const {return numRows;}
+    unsigned getCols() const {return numCols;}
+
+    /**
+     * \brief The distance, in elements, between the starts of neighbouring rows.
+     */
+    unsigned ld() const {return stride;}
+
+    T * data() const {return dataPtr;}
+
+    /**
+     * \brief Returns a view of row "row".
+     */
+    VectorView<T> row(unsigned row) const {
+        assert(row < numRows);
+        return VectorView<T>(dataPtr + row * stride, numCols, true);
+    }
+
+    /**
+     * \brief Returns a view of the "rows" x "cols" block whose top left element is at
+     *      ("row", "col").
+     */
+    MatrixView<T> view(unsigned row, unsigned col, unsigned rows, unsigned cols) const {
+        assert(row + rows <= numRows);
+        assert(col + cols <= numCols);
+        return MatrixView<T>(dataPtr + row * stride + col, rows, cols, stride);
+    }
+
+    /**
+     * \brief Sets every element to "val".
+     *
+     * \return Reference to "this".
+     */
+    MatrixView<T> & fill(const value_type &val) {
+        for (unsigned row=0; row<numRows; row++) {
+            std::fill(dataPtr + row * stride, dataPtr + row * stride + numCols, val);
+        }
+        return *this;
+    }
+};
+
+/**
+ * \brief Makes a MatrixView an operand of an expression.
+ */
+template <class T>
+MatrixOperand<typename MatrixView<T>::value_type> matrixOperand(const MatrixView<T> &view) {
+    return MatrixOperand<typename MatrixView<T>::value_type>(view.data(), view.getRows(), view.getCols(), view.ld());
+}
+
+}
+
+#endif /* View_h */
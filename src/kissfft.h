@@ -10,13 +10,26 @@
 #define KISSFFT_CLASS_HH
 
 #include <complex>
+#include <algorithm>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <cassert>
 #include <iostream>
 #include <iomanip>
+#include <type_traits>
+#include "FftButterflies.h"
 
 
+/// How a kissfft does its transform: Bluestein's algorithm, or the radix of each of the mixed
+/// radix stages, outermost first.  The radices must multiply up to the length, and an empty
+/// list means kissfft's own factorization (see @c kissfft::factorize()).
+struct kissfft_plan
+{
+    bool chirpZ = false;
+    std::vector<std::size_t> radices;
+};
+
 template <typename scalar_t, typename RealIterator, typename ComplexIterator>
 class kissfft
 {
@@ -24,10 +37,27 @@ class kissfft
 
         using cpx_t = std::complex<scalar_t>;
 
-        kissfft( const std::size_t nfft, const bool inverse, std::shared_ptr< std::vector<cpx_t> > scratch = nullptr )
+        // The vectorized butterflies need the output to be contiguous, and float or double
+        using contiguous = std::integral_constant<bool, std::is_same<ComplexIterator, cpx_t*>::value ||
+                std::is_same<ComplexIterator, typename std::vector<cpx_t>::iterator>::value>;
+        using simd_enabled = std::integral_constant<bool, contiguous::value && MatrixDSP::simd::HasButterflyKernel<scalar_t>::value>;
+
+        /// @c chirpZ does the transform with Bluestein's algorithm instead of the mixed radix
+        /// stages: the DFT is written as a convolution with a chirp, which is done with FFTs of a
+        /// power of two length of at least @c 2*nfft-1.  That's a few times slower than the
+        /// mixed radix stages when @c nfft only has small factors, but the generic butterfly
+        /// for a factor @c p costs @c O(nfft*p), so it's much faster when @c nfft has a large
+        /// prime factor.  FftSetupManager turns it on for those lengths.
+        kissfft( const std::size_t nfft, const bool inverse, const bool chirpZ = false )
+            :kissfft(nfft, inverse, kissfft_plan{chirpZ, {}})
+        {
+        }
+
+        /// Makes the transform the way @c plan says, which is how FftSetupManager uses a
+        /// measured plan.
+        kissfft( const std::size_t nfft, const bool inverse, const kissfft_plan &plan )
             :_nfft(nfft)
             ,_inverse(inverse)
-			,_scratchBuf(scratch)
         {
             // fill twiddle factors
             _twiddles.resize(_nfft);
@@ -35,9 +65,36 @@ class kissfft
             for (std::size_t i=0;i<_nfft;++i)
                 _twiddles[i] = exp( cpx_t(0,i*phinc) );
 
-            //factorize
-            //start factoring out 4's, then 2's, then 3,5,7,9,...
-            std::size_t n= _nfft;
+            _stageRadix = plan.radices.empty() ? factorize(_nfft) : plan.radices;
+            std::size_t n = _nfft;
+            for (std::size_t p : _stageRadix) {
+                assert(p >= 1 && n % p == 0);
+                n /= p;
+                _stageRemainder.push_back(n);
+            }
+            assert(n == 1);
+
+            // contiguous twiddles for the radix 2 to 5 stages, for the vectorized and batched butterflies
+            if (contiguous::value) {
+                _butterflyStages.resize(_stageRadix.size());
+                std::size_t fstride = 1;
+                for (std::size_t stage=0;stage<_stageRadix.size();++stage) {
+                    if (_stageRadix[stage] >= 2 && _stageRadix[stage] <= 5)
+                        _butterflyStages[stage] = MatrixDSP::simd::makeButterflyStage(_twiddles, _stageRadix[stage],
+                                _stageRemainder[stage], fstride, _inverse);
+                    fstride *= _stageRadix[stage];
+                }
+            }
+
+            if (plan.chirpZ)
+                make_chirp();
+        }
+
+        /// kissfft's own factorization of @c nfft into stages: 4's, then 2's, then 3,5,7,9,...
+        static std::vector<std::size_t> factorize( const std::size_t nfft )
+        {
+            std::vector<std::size_t> radices;
+            std::size_t n= nfft;
             std::size_t p=4;
             do {
                 while (n % p) {
@@ -50,21 +107,21 @@ class kissfft
                         p = n;// no more factors
                 }
                 n /= p;
-                _stageRadix.push_back(p);
-                _stageRemainder.push_back(n);
+                radices.push_back(p);
             }while(n>1);
+            return radices;
+        }
 
-			if (p > 5) {
-				// For any factor greater than 5, we'll have to use the generic butterfly, which means we'll need the scratch buffer.
-				if (_scratchBuf == nullptr) {
-					_scratchBuf = std::make_shared< std::vector<cpx_t> >(p);
-				}
-				else {
-					_scratchBuf->resize(p);
-				}
-			}
+        /// The plan that the transform was made with, with the radices filled in unless it uses
+        /// Bluestein's algorithm.
+        kissfft_plan plan() const
+        {
+            return chirp_z() ? kissfft_plan{true, {}} : kissfft_plan{false, _stageRadix};
         }
 
+        /// True if the transform uses Bluestein's algorithm.
+        bool chirp_z() const {return (bool) _chirpFft;}
+
         /// Calculates the complex Discrete Fourier Transform.
         ///
         /// The size of the passed arrays must be passed in the constructor.
@@ -80,6 +137,10 @@ class kissfft
         void transform(ComplexIterator fft_in, ComplexIterator fft_out, const std::size_t stage = 0, const std::size_t fstride = 1) const
         {
             //printf("## ComplexIterator FFT ##\n");
+            if (stage == 0 && _chirpFft) {
+                chirp_transform(fft_in, fft_out);
+                return;
+            }
             const std::size_t p = _stageRadix[stage];
             const std::size_t m = _stageRemainder[stage];
             ComplexIterator const Fout_beg = fft_out;
@@ -109,6 +170,8 @@ class kissfft
             //this->print(fft_out);
             
             // recombine the p smaller DFTs
+            if (kf_bfly_simd(fft_out, stage, simd_enabled()))
+                return;
             switch (p) {
                 case 2: kf_bfly2(fft_out,fstride,m); break;
                 case 3: kf_bfly3(fft_out,fstride,m); break;
@@ -122,6 +185,10 @@ class kissfft
         void transform(RealIterator fft_in, ComplexIterator fft_out, const std::size_t stage = 0, const std::size_t fstride = 1) const
         {
             //printf("## RealIterator FFT ##\n");
+            if (stage == 0 && _chirpFft) {
+                chirp_transform(fft_in, fft_out);
+                return;
+            }
             const std::size_t p = _stageRadix[stage];
             const std::size_t m = _stageRemainder[stage];
             ComplexIterator const Fout_beg = fft_out;
@@ -153,6 +220,8 @@ class kissfft
             //this->print(fft_out);
             
             // recombine the p smaller DFTs
+            if (kf_bfly_simd(fft_out, stage, simd_enabled()))
+                return;
             switch (p) {
                 case 2: kf_bfly2(fft_out,fstride,m); break;
                 case 3: kf_bfly3(fft_out,fstride,m); break;
@@ -163,6 +232,57 @@ class kissfft
             //this->print(fft_out);
         }
 
+        /// Calculates @c batch transforms at once.
+        ///
+        /// The transforms are interleaved: element @c n of transform @c b is
+        /// @c fft_in[n*batch + b], and likewise for @c fft_out.  Every
+        /// stage is done for the whole batch with the same twiddles, which
+        /// makes it much cheaper than @c batch separate transforms when the
+        /// transforms are short.  The iterators must be contiguous, and the
+        /// scaling is the same as @c transform().
+        void transform_batch(ComplexIterator fft_in, ComplexIterator fft_out, const std::size_t batch,
+                const std::size_t stage = 0, const std::size_t fstride = 1) const
+        {
+            static_assert(contiguous::value, "transform_batch needs contiguous iterators");
+            if (stage == 0 && _chirpFft) {
+                // One at a time, through a contiguous copy of each
+                thread_local std::vector<cpx_t> column;
+                if (column.size() < 2*_nfft)
+                    column.resize(2*_nfft);
+                for (std::size_t b=0;b<batch;++b) {
+                    for (std::size_t n=0;n<_nfft;++n)
+                        column[n] = fft_in[n*batch + b];
+                    chirp_transform(column.data(), column.data() + _nfft);
+                    for (std::size_t n=0;n<_nfft;++n)
+                        fft_out[n*batch + b] = column[_nfft + n];
+                }
+                return;
+            }
+            const std::size_t p = _stageRadix[stage];
+            const std::size_t m = _stageRemainder[stage];
+            ComplexIterator const Fout_beg = fft_out;
+            ComplexIterator const Fout_end = fft_out + p*m*batch;
+
+            if (m==1) {
+                do{
+                    std::copy(fft_in, fft_in + batch, fft_out);
+                    fft_in += fstride*batch;
+                }while( (fft_out += batch) != Fout_end );
+            }else{
+                do{
+                    transform_batch(fft_in, fft_out, batch, stage+1, fstride*p);
+                    fft_in += fstride*batch;
+                }while( (fft_out += m*batch) != Fout_end );
+            }
+
+            fft_out=Fout_beg;
+
+            if (p <= 5)
+                MatrixDSP::simd::butterflyBatch(&*fft_out, _butterflyStages[stage], batch);
+            else
+                kf_bfly_generic_batch(fft_out, fstride, m, p, batch);
+        }
+
         void print(ComplexIterator it) const {
             for (unsigned index=0; index<_nfft; index++) {
                 std::cout << std::setw(10) << std::setprecision(4) << it[index].real() << " " << std::setw(10) << std::setprecision(4) << it[index].imag() << "i" << std::endl;
@@ -202,6 +322,77 @@ class kissfft
 
     private:
 
+        static cpx_t cmul(const cpx_t &a, const cpx_t &b)
+        {
+            // Without the infinity and NaN checks of std::complex's operator*
+            return cpx_t(a.real()*b.real() - a.imag()*b.imag(), a.real()*b.imag() + a.imag()*b.real());
+        }
+
+        /* the chirp, and the spectrum of the filter that Bluestein's algorithm convolves with */
+        void make_chirp()
+        {
+            std::size_t m = 1;
+            while (m < 2*_nfft - 1)
+                m *= 2;
+            _chirpFft = std::make_shared< kissfft<scalar_t, scalar_t *, cpx_t *> >(m, false);
+
+            // chirp[n] = exp(-+ j pi n^2 / nfft).  The phase only depends on n^2 mod 2*nfft, which
+            // keeps it exact however long the transform is.
+            const double pi = acos(-1.0);
+            _chirp.resize(_nfft);
+            for (std::size_t n=0;n<_nfft;++n) {
+                const unsigned long long square = (unsigned long long) n * n % (2 * _nfft);
+                const double phase = (_inverse ? pi : -pi) * (double) square / (double) _nfft;
+                _chirp[n] = cpx_t((scalar_t) cos(phase), (scalar_t) sin(phase));
+            }
+
+            // The filter is the conjugate chirp at lags -(nfft-1) to nfft-1, wrapped around.  Its
+            // spectrum is divided by m, which makes up for the unscaled inverse FFT.
+            std::vector<cpx_t> filter(m, cpx_t(0));
+            filter[0] = std::conj(_chirp[0]);
+            for (std::size_t n=1;n<_nfft;++n)
+                filter[n] = filter[m-n] = std::conj(_chirp[n]);
+            _chirpFilter.resize(m);
+            _chirpFft->transform(filter.data(), _chirpFilter.data());
+            for (cpx_t &bin : _chirpFilter)
+                bin /= (scalar_t) m;
+        }
+
+        /* Bluestein's algorithm: X[k] = chirp[k] * sum(x[n] chirp[n] conj(chirp[k-n])) */
+        template <class InputIterator, class OutputIterator>
+        void chirp_transform(InputIterator fft_in, OutputIterator fft_out) const
+        {
+            const std::size_t m = _chirpFilter.size();
+            // One buffer per thread, like the generic butterfly, and the input is read before
+            // anything is written, so the transform can be done in place
+            thread_local std::vector<cpx_t> work;
+            if (work.size() < 2*m)
+                work.resize(2*m);
+            cpx_t *a = work.data();
+            cpx_t *spectrum = a + m;
+            for (std::size_t n=0;n<_nfft;++n)
+                a[n] = cmul(cpx_t(fft_in[n]), _chirp[n]);
+            std::fill(a + _nfft, a + m, cpx_t(0));
+            _chirpFft->transform(a, spectrum);
+            // The inverse FFT is done as conj(FFT(conj(.))), so one setup does both
+            for (std::size_t k=0;k<m;++k)
+                spectrum[k] = std::conj(cmul(spectrum[k], _chirpFilter[k]));
+            _chirpFft->transform(spectrum, a);
+            for (std::size_t k=0;k<_nfft;++k)
+                fft_out[k] = cmul(_chirp[k], std::conj(a[k]));
+        }
+
+        bool kf_bfly_simd( ComplexIterator Fout, const std::size_t stage, std::true_type) const
+        {
+            const MatrixDSP::simd::ButterflyStage<scalar_t> &simdStage = _butterflyStages[stage];
+            return simdStage.radix != 0 && MatrixDSP::simd::butterfly(&*Fout, simdStage);
+        }
+
+        bool kf_bfly_simd( ComplexIterator, const std::size_t, std::false_type) const
+        {
+            return false;
+        }
+
         void kf_bfly2( ComplexIterator Fout, const size_t fstride, const std::size_t m) const
         {
             for (std::size_t k=0;k<m;++k) {
@@ -338,35 +529,197 @@ class kissfft
                 ) const
         {
             const cpx_t * twiddles = &_twiddles[0];
-            //cpx_t scratchbuf[p];
+            // One scratch buffer per thread, so that a plan can be used by several threads at once
+            thread_local std::vector<cpx_t> scratchbuf;
+            if (scratchbuf.size() < p)
+                scratchbuf.resize(p);
 
             for ( std::size_t u=0; u<m; ++u ) {
                 std::size_t k = u;
                 for ( std::size_t q1=0 ; q1<p ; ++q1 ) {
-                    (*_scratchBuf)[q1] = Fout[ k  ];
+                    scratchbuf[q1] = Fout[ k  ];
                     k += m;
                 }
 
                 k=u;
                 for ( std::size_t q1=0 ; q1<p ; ++q1 ) {
                     std::size_t twidx=0;
-                    Fout[ k ] = (*_scratchBuf)[0];
+                    Fout[ k ] = scratchbuf[0];
                     for ( std::size_t q=1;q<p;++q ) {
                         twidx += fstride * k;
                         if (twidx>=_nfft)
                           twidx-=_nfft;
-                        Fout[ k ] += (*_scratchBuf)[q] * twiddles[twidx];
+                        Fout[ k ] += scratchbuf[q] * twiddles[twidx];
                     }
                     k += m;
                 }
             }
         }
 
-		std::shared_ptr< std::vector<cpx_t> > _scratchBuf;
+        /* the generic butterfly for a batch of interleaved transforms */
+        void kf_bfly_generic_batch(
+                ComplexIterator const Fout,
+                const size_t fstride,
+                const std::size_t m,
+                const std::size_t p,
+                const std::size_t batch
+                ) const
+        {
+            const cpx_t * twiddles = &_twiddles[0];
+            thread_local std::vector<cpx_t> scratchbuf;
+            if (scratchbuf.size() < p)
+                scratchbuf.resize(p);
+
+            for ( std::size_t u=0; u<m; ++u ) {
+                for ( std::size_t b=0; b<batch; ++b ) {
+                    std::size_t k = u;
+                    for ( std::size_t q1=0 ; q1<p ; ++q1 ) {
+                        scratchbuf[q1] = Fout[ k*batch + b ];
+                        k += m;
+                    }
+
+                    k=u;
+                    for ( std::size_t q1=0 ; q1<p ; ++q1 ) {
+                        std::size_t twidx=0;
+                        Fout[ k*batch + b ] = scratchbuf[0];
+                        for ( std::size_t q=1;q<p;++q ) {
+                            twidx += fstride * k;
+                            if (twidx>=_nfft)
+                              twidx-=_nfft;
+                            Fout[ k*batch + b ] += scratchbuf[q] * twiddles[twidx];
+                        }
+                        k += m;
+                    }
+                }
+            }
+        }
+
         std::size_t _nfft;
         bool _inverse;
         std::vector<cpx_t> _twiddles;
         std::vector<std::size_t> _stageRadix;
         std::vector<std::size_t> _stageRemainder;
+        std::vector< MatrixDSP::simd::ButterflyStage<scalar_t> > _butterflyStages;
+        // Bluestein's algorithm, when it's used
+        std::shared_ptr< kissfft<scalar_t, scalar_t *, cpx_t *> > _chirpFft;
+        std::vector<cpx_t> _chirp;
+        std::vector<cpx_t> _chirpFilter;
+};
+
+/// Real-input FFT of even length @c nfft, done with a complex FFT of half the length.
+///
+/// The @c nfft reals are packed into @c nfft/2 complex values (even samples in the real
+/// parts, odd samples in the imaginary parts), transformed, and then separated with one extra
+/// set of twiddles.  This is roughly half the work of a complex FFT of the same length.
+/// Only the @c nfft/2+1 non-redundant bins are produced; the rest follow from
+///     @code
+///         DFT(src)[nfft-k] == conj( DFT(src)[k] );
+///     @endcode
+/// The scaling is the same as @c kissfft::transform(), so @c inverse(transform(x)) is
+/// @c nfft times @c x.
+template <typename scalar_t, typename RealIterator, typename ComplexIterator>
+class kissfftr
+{
+    public:
+
+        using cpx_t = std::complex<scalar_t>;
+
+        /// @c chirpZ is passed on to the half length complex FFTs (see kissfft).
+        kissfftr( const std::size_t nfft, const bool chirpZ = false )
+            :kissfftr(nfft, kissfft_plan{chirpZ, {}})
+        {
+        }
+
+        /// @c plan is the plan for the half length complex FFTs.
+        kissfftr( const std::size_t nfft, const kissfft_plan &plan )
+            :_nfft(nfft)
+            ,_ncfft(nfft/2)
+            ,_forward(nfft/2, false, plan)
+            ,_backward(nfft/2, true, plan)
+        {
+            assert(nfft >= 2 && nfft % 2 == 0);
+            _superTwiddles.resize(_ncfft);
+            const scalar_t phinc = -2 * acos( (scalar_t) -1) / _nfft;
+            for (std::size_t i=0;i<_ncfft;++i)
+                _superTwiddles[i] = exp( cpx_t(0,i*phinc) );
+        }
+
+        std::size_t size() const {return _nfft;}
+
+        /// The plan of the half length complex FFTs.
+        kissfft_plan plan() const {return _forward.plan();}
+
+        /// Forward transform of @c nfft reals into @c nfft/2+1 bins.
+        ///
+        /// @c scratch must have room for @c nfft/2 complex values.
+        void transform(RealIterator src, ComplexIterator dst, ComplexIterator scratch) const
+        {
+            const std::size_t ncfft = _ncfft;
+            for (std::size_t i=0;i<ncfft;++i)
+                scratch[i] = cpx_t(src[2*i], src[2*i+1]);
+
+            if (ncfft == 1)
+                dst[0] = scratch[0];
+            else
+                _forward.transform(scratch, dst);
+
+            // Bins 0 and nfft/2 only depend on the DC bin of the half length transform
+            const cpx_t z0 = dst[0];
+            dst[0] = cpx_t(z0.real() + z0.imag(), 0);
+            dst[ncfft] = cpx_t(z0.real() - z0.imag(), 0);
+
+            // Separate the transforms of the even and odd samples and recombine them, two bins
+            // at a time because bins k and ncfft-k use the same pair of inputs.
+            for (std::size_t k=1;2*k<ncfft;++k) {
+                const cpx_t zk = dst[k];
+                const cpx_t zmk = std::conj(dst[ncfft-k]);
+                const cpx_t even = (zk + zmk) * scalar_t(0.5);
+                const cpx_t odd = (zk - zmk) * cpx_t(0, scalar_t(-0.5));
+                const cpx_t twiddledOdd = _superTwiddles[k] * odd;
+                dst[k] = even + twiddledOdd;
+                dst[ncfft-k] = std::conj(even - twiddledOdd);
+            }
+            if (ncfft % 2 == 0 && ncfft > 1)
+                dst[ncfft/2] = std::conj(dst[ncfft/2]);
+        }
+
+        /// Inverse transform of @c nfft/2+1 bins (of a Hermitian spectrum) into @c nfft reals.
+        ///
+        /// @c scratch must have room for @c nfft complex values.
+        void inverse(ComplexIterator src, RealIterator dst, ComplexIterator scratch) const
+        {
+            const std::size_t ncfft = _ncfft;
+            ComplexIterator packed = scratch;
+            ComplexIterator unpacked = scratch + ncfft;
+
+            // Rebuild the half length spectrum of (even samples) + j*(odd samples).  The factor
+            // of two that the forward transform divides out is left in, which keeps the usual
+            // unnormalized inverse scaling.
+            for (std::size_t k=0;k<ncfft;++k) {
+                const cpx_t xk = src[k];
+                const cpx_t xmk = std::conj(src[ncfft-k]);
+                const cpx_t even = xk + xmk;
+                const cpx_t odd = (xk - xmk) * std::conj(_superTwiddles[k]);
+                packed[k] = even + cpx_t(-odd.imag(), odd.real());
+            }
+
+            if (ncfft == 1)
+                unpacked[0] = packed[0];
+            else
+                _backward.transform(packed, unpacked);
+
+            for (std::size_t i=0;i<ncfft;++i) {
+                dst[2*i] = unpacked[i].real();
+                dst[2*i+1] = unpacked[i].imag();
+            }
+        }
+
+    private:
+
+        std::size_t _nfft;
+        std::size_t _ncfft;
+        kissfft<scalar_t, RealIterator, ComplexIterator> _forward;
+        kissfft<scalar_t, RealIterator, ComplexIterator> _backward;
+        std::vector<cpx_t> _superTwiddles;
 };
 #endif
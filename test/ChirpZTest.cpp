@@ -0,0 +1,123 @@
+//
+//  ChirpZTest.cpp
+//  MatrixDspTests
+//
+
+#include "ChirpZ.h"
+#include "ComplexVector.h"
+#include "TestHelpers.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <complex>
+#include <vector>
+
+using namespace MatrixDspTests;
+
+TEST(ChirpZ, UsesChirpZ) {
+    typedef FftSetupManager<float, float *, std::complex<float> *> Manager;
+    EXPECT_FALSE(Manager::usesChirpZ(1));
+    EXPECT_FALSE(Manager::usesChirpZ(1024));
+    EXPECT_FALSE(Manager::usesChirpZ(1000));
+    EXPECT_FALSE(Manager::usesChirpZ(7 * 64));
+    EXPECT_FALSE(Manager::usesChirpZ(11));
+    EXPECT_TRUE(Manager::usesChirpZ(127));
+    EXPECT_TRUE(Manager::usesChirpZ(1009));
+    EXPECT_TRUE(Manager::usesChirpZ(10007));
+    EXPECT_TRUE(Manager::usesChirpZ(61 * 64));
+}
+
+TEST(ChirpZ, PrimeLengthFft) {
+    // Complex, odd length real and even length real (whose half length FFT is prime) inputs,
+    // forward and inverse
+    for (unsigned len : {1009u, 2026u, 4099u}) {
+        for (bool inverse : {false, true}) {
+            MatrixDSP::ComplexVector<float> input = testSignal< MatrixDSP::ComplexVector<float> >(len);
+            MatrixDSP::ComplexVector<float> output;
+            output.fft(input, inverse);
+            EXPECT_LT(relativeError(dftReference(input, inverse), output), 2e-5) << len;
+
+            MatrixDSP::ComplexVector<double> doubleInput = testSignal< MatrixDSP::ComplexVector<double> >(len);
+            MatrixDSP::ComplexVector<double> doubleOutput;
+            doubleOutput.fft(doubleInput, inverse);
+            EXPECT_LT(relativeError(dftReference(doubleInput, inverse), doubleOutput), 1e-12) << len;
+
+            MatrixDSP::Vector<double> realInput(len);
+            MatrixDSP::ComplexVector<double> realAsComplex(len);
+            for (unsigned index = 0; index < len; index++) {
+                realInput[index] = doubleInput[index].real();
+                realAsComplex[index] = realInput[index];
+            }
+            doubleOutput.fft(realInput, inverse);
+            EXPECT_LT(relativeError(dftReference(realAsComplex, inverse), doubleOutput), 1e-12) << len;
+        }
+    }
+}
+
+TEST(ChirpZ, Dft) {
+    // The defaults give the DFT, and fewer or more points than samples continue around the
+    // unit circle
+    const unsigned len = 100;
+    MatrixDSP::ComplexVector<double> input = testSignal< MatrixDSP::ComplexVector<double> >(len);
+    std::vector< std::complex<double> > expected = dftReference(input, false);
+    const std::complex<double> w = std::polar(1.0, -2 * M_PI / len);
+    for (unsigned numPoints : {len, 37u, 250u}) {
+        MatrixDSP::ChirpZ<double> chirpZ(len, numPoints, w);
+        EXPECT_EQ(len, chirpZ.inputLength());
+        EXPECT_EQ(numPoints, chirpZ.outputLength());
+        EXPECT_GE(chirpZ.fftLength(), len + numPoints - 1);
+        MatrixDSP::ComplexVector<double> output;
+        chirpZ.transform(input, output);
+        ASSERT_EQ(numPoints, output.size());
+        for (unsigned k = 0; k < numPoints; k++) {
+            EXPECT_NEAR(0, std::abs(expected[k % len] - output[k]), 1e-11) << k;
+        }
+    }
+
+    // A point off the unit circle, against the z-transform
+    std::complex<double> a(0.9, 0.2), spiral = std::polar(1.001, -0.05);
+    MatrixDSP::ComplexVector<double> output;
+    MatrixDSP::czt(input, output, 20, spiral, a);
+    for (unsigned k = 0; k < 20; k++) {
+        std::complex<double> z = a * std::pow(spiral, -(double) k);
+        std::complex<double> sum;
+        for (unsigned n = 0; n < len; n++) {
+            sum += input[n] * std::pow(z, -(double) n);
+        }
+        EXPECT_NEAR(0, std::abs(sum - output[k]) / std::abs(sum), 1e-10) << k;
+    }
+}
+
+TEST(ChirpZ, ZoomFft) {
+    // A tone between the bins of a 1000 point FFT, looked at closely
+    const unsigned len = 1000;
+    const double sampleFreq = 48000, toneFreq = 1234.3;
+    MatrixDSP::ComplexVector<float> input(len);
+    for (unsigned index = 0; index < len; index++) {
+        input[index] = std::polar(1.0f, (float) std::fmod(2 * M_PI * toneFreq * index / sampleFreq, 2 * M_PI));
+    }
+    const double startFreq = 1200, binSpacing = 1;
+    MatrixDSP::ComplexVector<float> output;
+    MatrixDSP::zoomFft(input, output, 64, startFreq, binSpacing, sampleFreq);
+    ASSERT_EQ(64, output.size());
+    unsigned peak = 0;
+    for (unsigned k = 0; k < 64; k++) {
+        double freq = startFreq + k * binSpacing;
+        std::complex<double> expected;
+        for (unsigned n = 0; n < len; n++) {
+            expected += std::complex<double>(input[n]) * std::polar(1.0, -2 * M_PI * std::fmod(freq * n / sampleFreq, 1.0));
+        }
+        EXPECT_NEAR(0, std::abs(expected - std::complex<double>(output[k])), 1e-5 * len) << k;
+        if (std::abs(output[k]) > std::abs(output[peak])) {
+            peak = k;
+        }
+    }
+    EXPECT_EQ(34, peak);
+
+    // In place, with fewer points than samples
+    MatrixDSP::ChirpZ<float> chirpZ(len, 64, startFreq, binSpacing, sampleFreq);
+    chirpZ.transform(input, input);
+    ASSERT_EQ(64, input.size());
+    for (unsigned k = 0; k < 64; k++) {
+        EXPECT_EQ(output[k], input[k]);
+    }
+}
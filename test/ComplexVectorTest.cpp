@@ -1,6 +1,9 @@
 #include "ComplexVector.h"
+#include "TestHelpers.h"
 #include "gtest/gtest.h"
 #include <ctime>
+#include <thread>
+#include <vector>
 
 
 TEST(ComplexVectorInit, Ctor_Size) {
@@ -41,6 +44,46 @@ TEST(ComplexVectorInit, Ctor_Initializer_List) {
     EXPECT_EQ(false, buf.rowVector);
 }
 
+TEST(ComplexVectorInit, Ctor_Move) {
+    static_assert(std::is_nothrow_move_constructible< MatrixDSP::ComplexVector<float> >::value, "");
+    static_assert(std::is_nothrow_move_assignable< MatrixDSP::ComplexVector<float> >::value, "");
+
+    // Growing a std::vector of ComplexVectors moves them instead of copying them
+    std::vector< MatrixDSP::ComplexVector<float> > channels;
+    channels.emplace_back(100);
+    const std::complex<float> *data = channels[0].vec.data();
+    for (unsigned index=0; index<10; index++) {
+        channels.emplace_back(100);
+    }
+    EXPECT_EQ(data, channels[0].vec.data());
+
+    MatrixDSP::ComplexVector<float> assigned;
+    assigned = std::move(channels[0]);
+    EXPECT_EQ(data, assigned.vec.data());
+    EXPECT_EQ(100, assigned.size());
+
+    MatrixDSP::Vector< std::complex<float> > base({{1, 2}, 3});
+    data = base.vec.data();
+    MatrixDSP::ComplexVector<float> fromBase(std::move(base));
+    EXPECT_EQ(data, fromBase.vec.data());
+    EXPECT_EQ(std::complex<float>(1, 2), fromBase[0]);
+}
+
+TEST(ComplexVectorInit, Aligned) {
+    for (unsigned size : {1u, 5u, 1000u}) {
+        MatrixDSP::ComplexVector<float> floats(size);
+        MatrixDSP::ComplexVector<double> doubles(size);
+        EXPECT_EQ(0u, (uintptr_t) floats.vec.data() % MatrixDSP::defaultAlignment);
+        EXPECT_EQ(0u, (uintptr_t) doubles.vec.data() % MatrixDSP::defaultAlignment);
+    }
+
+    MatrixDSP::ComplexVector< float, std::allocator< std::complex<float> > > unaligned(8);
+    unaligned[1] = 1;
+    MatrixDSP::ComplexVector<float> spectrum;
+    spectrum.fft(unaligned);
+    EXPECT_NEAR(0, std::abs(spectrum[2] - std::complex<float>(0, -1)), 1e-6);
+}
+
 TEST(ComplexVectorInit, Parenthesis_Indexing) {
     MatrixDSP::ComplexVector<float> buf({3, {4, 1}, 5});
     
@@ -322,6 +365,19 @@ TEST(ComplexVector_Operator, DivideVector_Real) {
     EXPECT_EQ(std::complex<float>(3.0f/6, 0), buf3[2]);
 }
 
+TEST(ComplexVector_Operator, FusedExpression) {
+    MatrixDSP::ComplexVector<float> buf1({{1, 1}, 2, {0, 3}});
+    MatrixDSP::ComplexVector<float> buf2({{0, 1}, {2, -1}, 1});
+    MatrixDSP::Vector<float> gain({2, 3, 4});
+    MatrixDSP::ComplexVector<float> buf3;
+    
+    buf3 = buf1 * buf2 * gain + std::complex<float>(1, 0);
+    EXPECT_EQ(3, buf3.size());
+    EXPECT_EQ(std::complex<float>(-1, 2), buf3[0]);
+    EXPECT_EQ(std::complex<float>(13, -6), buf3[1]);
+    EXPECT_EQ(std::complex<float>(1, 12), buf3[2]);
+}
+
 TEST(ComplexVector_Method, Find) {
     MatrixDSP::ComplexVector<float> buf({5, 2, 3, 3, 4, 1});
     
@@ -384,6 +440,42 @@ TEST(ComplexVector_Method, StdDev) {
     EXPECT_NEAR(1.2910f, buf.stdDev(false).real(), .001);
 }
 
+TEST(ComplexVector_Method, Stats) {
+    MatrixDspTests::IsaScope isaScope;
+    MatrixDSP::ComplexVector<float> buf({{1, 2}, {3, -2}, {-1, 0}, {1, 4}});
+    MatrixDSP::ComplexStats<float> stats = MatrixDSP::stats(buf);
+    EXPECT_EQ(std::complex<float>(4, 4), stats.sum);
+    EXPECT_EQ(std::complex<float>(1, 1), stats.mean);
+    // Squared deviations 1, 13, 5, 9
+    EXPECT_NEAR(28.0f / 3, stats.var, 1e-5);
+    EXPECT_NEAR(7, buf.stats(false).var, 1e-5);
+    EXPECT_NEAR(std::sqrt(28.0f / 3), stats.stdDev, 1e-5);
+    EXPECT_NEAR(9, stats.power, 1e-5);
+
+    // Several blocks, with every kernel
+    unsigned len = 3001;
+    MatrixDSP::ComplexVector<double> data(len);
+    double power = 0;
+    std::complex<double> sum = 0;
+    for (unsigned index=0; index<len; index++) {
+        data[index] = std::complex<double>((index % 7) + 100.0, (double) (index % 5) - 2);
+        sum += data[index];
+        power += std::norm(data[index]);
+    }
+    std::complex<double> mean = sum / (double) len;
+    double m2 = 0;
+    for (unsigned index=0; index<len; index++) {
+        m2 += std::norm(data[index] - mean);
+    }
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        MatrixDSP::ComplexStats<double> dataStats = data.stats();
+        EXPECT_NEAR(0, std::abs(dataStats.mean - mean), 1e-12) << "isa " << (int) isa;
+        EXPECT_NEAR(m2 / (len - 1), dataStats.var, 1e-9) << "isa " << (int) isa;
+        EXPECT_NEAR(power / len, dataStats.power, 1e-8) << "isa " << (int) isa;
+    }
+}
+
 TEST(ComplexVector_Method, Max) {
     MatrixDSP::ComplexVector<float> buf({1, 4, {3, 4}, 2, 4.9});
     unsigned maxLoc;
@@ -400,6 +492,80 @@ TEST(ComplexVector_Method, Min) {
     EXPECT_EQ(3, minLoc);
 }
 
+template <class T>
+void checkMaxMinLoc() {
+    MatrixDspTests::IsaScope isaScope;
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        // Lengths with and without a scalar tail, and the extremes in every lane
+        for (unsigned len : {1u, 7u, 16u, 37u, 100u}) {
+            for (unsigned at=0; at<len; at++) {
+                MatrixDSP::ComplexVector<T> buf(len);
+                for (unsigned index=0; index<len; index++) {
+                    buf[index] = std::complex<T>((T) (index % 5) + 2, (T) (index % 3));
+                }
+                buf[at] = std::complex<T>(0, 9);
+                buf[len - 1 - at] = std::complex<T>(-9, 0);
+                unsigned maxLoc, minLoc;
+                buf.max(&maxLoc);
+                EXPECT_EQ(std::min(at, len - 1 - at), maxLoc) << "isa " << (int) isa << ", len " << len;
+                buf[at] = std::complex<T>(0, (T) 0.5);
+                buf.min(&minLoc);
+                EXPECT_EQ(at, minLoc) << "isa " << (int) isa << ", len " << len;
+            }
+        }
+    }
+}
+
+TEST(ComplexVector_Method, MaxMinLoc) {
+    checkMaxMinLoc<float>();
+    checkMaxMinLoc<double>();
+}
+
+TEST(ComplexVector_Method, TopK) {
+    MatrixDSP::ComplexVector<float> buf({1, {0, -5}, 3, {3, 4}, 2, {-4, 3}, 6});
+    std::vector<unsigned> top = buf.topK(4);
+    // Equal magnitudes are in index order
+    EXPECT_EQ(std::vector<unsigned>({6, 1, 3, 5}), top);
+    EXPECT_EQ(std::vector<unsigned>({6}), MatrixDSP::topK(buf, 1));
+    EXPECT_EQ(7u, buf.topK(10).size());
+    EXPECT_EQ(0u, buf.topK(0).size());
+}
+
+TEST(ComplexVector_Method, Peaks) {
+    MatrixDSP::ComplexVector<double> buf({5, 1, {0, 3}, 1, 2, 2, 1, 4, 4, 6, 1, 2, 1, 7});
+    // The ends aren't peaks, and neither is a flat stretch that goes back up
+    EXPECT_EQ(std::vector<unsigned>({2, 4, 9, 11}), buf.peaks(0));
+    EXPECT_EQ(std::vector<unsigned>({2, 9}), buf.peaks(2.5));
+    // 9 is the biggest, so 11 goes, then 2 is next and 4 goes
+    EXPECT_EQ(std::vector<unsigned>({2, 9}), MatrixDSP::peaks(buf, 0.0, 3));
+    EXPECT_EQ(std::vector<unsigned>({2, 4, 9, 11}), buf.peaks(0, 2));
+    EXPECT_EQ(std::vector<unsigned>({9}), buf.peaks(0, 8));
+}
+
+TEST(ComplexVector_Method, InterpolatePeak) {
+    // A Hann windowed tone between bins 5 and 6 of a 64 point FFT
+    unsigned len = 64;
+    double bin = 5.3;
+    MatrixDSP::ComplexVector<double> tone(len), spectrum;
+    for (unsigned index=0; index<len; index++) {
+        double window = 0.5 - 0.5 * std::cos(2 * M_PI * index / len);
+        tone[index] = std::polar(window, 2 * M_PI * bin * index / len);
+    }
+    spectrum.fft(tone);
+    unsigned peak;
+    spectrum.max(&peak);
+    EXPECT_EQ(5u, peak);
+    double magnitude;
+    double estimate = MatrixDSP::interpolatePeak(spectrum, peak, &magnitude);
+    EXPECT_NEAR(bin, estimate, 0.02);
+    EXPECT_GT(magnitude, std::abs(spectrum[peak]));
+
+    MatrixDSP::ComplexVector<float> parabola({0, 4, 5, 4, 0});
+    EXPECT_EQ(2, parabola.interpolatePeak(2));
+    EXPECT_EQ(0, parabola.interpolatePeak(0));
+}
+
 TEST(ComplexVector_Method, Saturate) {
     MatrixDSP::ComplexVector<float> buf({{-10, 1}, {8, 12}, {3, -6}});
     buf.saturate(std::complex<float>(5, 4));
@@ -729,6 +895,115 @@ TEST(ComplexVector_Method, Fft) {
     EXPECT_NEAR(-5.1962, bufOut[5].imag(), .0001);
 }
 
+TEST(ComplexVector_Method, Fft_RealMatchesComplex) {
+    for (unsigned len : {2u, 3u, 4u, 6u, 8u, 9u, 10u, 12u, 16u, 30u, 64u, 100u}) {
+        MatrixDSP::Vector<double> realIn(len);
+        MatrixDSP::ComplexVector<double> complexIn(len);
+        for (unsigned index=0; index<len; index++) {
+            realIn[index] = std::cos(0.3 * index * index) + 0.1 * index;
+            complexIn[index] = realIn[index];
+        }
+        
+        for (bool inverse : {false, true}) {
+            MatrixDSP::ComplexVector<double> expected, full, half;
+            fft(complexIn, expected, inverse);
+            fft(realIn, full, inverse);
+            fft(realIn, half, inverse, true);
+            EXPECT_EQ(len, full.size());
+            EXPECT_EQ(len/2 + 1, half.size());
+            for (unsigned index=0; index<len; index++) {
+                EXPECT_NEAR(expected[index].real(), full[index].real(), 1e-9) << "len " << len << ", index " << index;
+                EXPECT_NEAR(expected[index].imag(), full[index].imag(), 1e-9) << "len " << len << ", index " << index;
+                if (index < half.size()) {
+                    EXPECT_NEAR(expected[index].real(), half[index].real(), 1e-9) << "len " << len << ", index " << index;
+                    EXPECT_NEAR(expected[index].imag(), half[index].imag(), 1e-9) << "len " << len << ", index " << index;
+                }
+            }
+        }
+    }
+}
+
+TEST(ComplexVector_Method, IfftReal) {
+    for (unsigned len : {2u, 5u, 6u, 8u, 15u, 20u, 64u}) {
+        MatrixDSP::Vector<float> bufIn(len);
+        for (unsigned index=0; index<len; index++) {
+            bufIn[index] = (float) std::sin(0.7 * index) + 0.25f;
+        }
+        
+        MatrixDSP::ComplexVector<float> half, full;
+        MatrixDSP::Vector<float> fromHalf, fromFull;
+        fft(bufIn, half, false, true);
+        fft(bufIn, full);
+        if (len % 2 == 0) {
+            ifftReal(half, fromHalf);
+        }
+        else {
+            ifftReal(half, fromHalf, len);
+        }
+        ifftReal(full, fromFull, len);
+        EXPECT_EQ(len, fromHalf.size());
+        EXPECT_EQ(len, fromFull.size());
+        for (unsigned index=0; index<len; index++) {
+            EXPECT_NEAR(bufIn[index] * len, fromHalf[index], .0001 * len) << "len " << len << ", index " << index;
+            EXPECT_NEAR(bufIn[index] * len, fromFull[index], .0001 * len) << "len " << len << ", index " << index;
+        }
+    }
+}
+
+TEST(ComplexVector_Method, Fft_Threads) {
+    // Several threads creating and using the same (previously unused) setups at once, including
+    // lengths with radix 7 and 37 stages that use the generic butterfly's scratch buffer.
+    const std::vector<unsigned> lengths = {777, 1000, 1792, 2590};
+    const unsigned numThreads = 4;
+    const unsigned iterations = 20;
+    std::vector< std::vector< MatrixDSP::ComplexVector<double> > > results(numThreads);
+    std::vector<std::thread> threads;
+    for (unsigned thread=0; thread<numThreads; thread++) {
+        threads.emplace_back([&, thread] {
+            for (unsigned iteration=0; iteration<iterations; iteration++) {
+                for (unsigned len : lengths) {
+                    MatrixDSP::Vector<double> realIn(len);
+                    MatrixDSP::ComplexVector<double> complexIn(len);
+                    for (unsigned index=0; index<len; index++) {
+                        realIn[index] = std::sin(0.01 * index * (thread + 1));
+                        complexIn[index] = std::complex<double>(realIn[index], -realIn[index]);
+                    }
+                    MatrixDSP::ComplexVector<double> complexOut, realOut;
+                    fft(complexIn, complexOut, (iteration % 2) == 1);
+                    fft(realIn, realOut);
+                    if (iteration == iterations - 1) {
+                        results[thread].push_back(complexOut);
+                        results[thread].push_back(realOut);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (unsigned thread=0; thread<numThreads; thread++) {
+        ASSERT_EQ(2 * lengths.size(), results[thread].size());
+        for (unsigned lenIndex=0; lenIndex<lengths.size(); lenIndex++) {
+            unsigned len = lengths[lenIndex];
+            MatrixDSP::Vector<double> realIn(len);
+            MatrixDSP::ComplexVector<double> complexIn(len);
+            for (unsigned index=0; index<len; index++) {
+                realIn[index] = std::sin(0.01 * index * (thread + 1));
+                complexIn[index] = std::complex<double>(realIn[index], -realIn[index]);
+            }
+            MatrixDSP::ComplexVector<double> complexOut, realOut;
+            fft(complexIn, complexOut, ((iterations - 1) % 2) == 1);
+            fft(realIn, realOut);
+            for (unsigned index=0; index<len; index++) {
+                ASSERT_EQ(complexOut[index], results[thread][2*lenIndex][index]) << "thread " << thread << ", len " << len;
+                ASSERT_EQ(realOut[index], results[thread][2*lenIndex + 1][index]) << "thread " << thread << ", len " << len;
+            }
+        }
+    }
+}
+
 TEST(ComplexVector_Operator, Comparison) {
 	MatrixDSP::ComplexVector<float> buf({ 11, 2, {3, 1}, 3, 1 });
 	MatrixDSP::ComplexVector<float> result;
@@ -0,0 +1,135 @@
+//
+//  ConvolutionTest.cpp
+//  MatrixDspTests
+//
+
+#include "ComplexVector.h"
+#include "Convolution.h"
+#include "TestHelpers.h"
+#include "gtest/gtest.h"
+#include <complex>
+#include <vector>
+
+namespace {
+
+using namespace MatrixDspTests;
+
+// Checks every mode against the reference
+template <class V, class T, class U>
+void checkConv(unsigned aLen, unsigned bLen, double tolerance) {
+    MatrixDSP::Vector<T> a = testSignal< MatrixDSP::Vector<T> >(aLen, 0);
+    MatrixDSP::Vector<U> b = testSignal< MatrixDSP::Vector<U> >(bLen, 500);
+    std::vector<V> full = convReference<V>(a.vec, b.vec);
+    MatrixDSP::Vector<V> output;
+
+    MatrixDSP::conv(a, b, output);
+    ASSERT_EQ(full.size(), output.size());
+    for (unsigned index = 0; index < full.size(); index++) {
+        ASSERT_NEAR(0, std::abs(full[index] - output[index]), tolerance) << index;
+    }
+
+    MatrixDSP::conv(a, b, output, MatrixDSP::ConvMode::Same);
+    ASSERT_EQ(aLen, output.size());
+    for (unsigned index = 0; index < aLen; index++) {
+        ASSERT_NEAR(0, std::abs(full[index + bLen / 2] - output[index]), tolerance) << index;
+    }
+
+    MatrixDSP::conv(a, b, output, MatrixDSP::ConvMode::Valid);
+    ASSERT_EQ(aLen >= bLen ? aLen - bLen + 1 : 0, output.size());
+    for (unsigned index = 0; index < output.size(); index++) {
+        ASSERT_NEAR(0, std::abs(full[index + bLen - 1] - output[index]), tolerance) << index;
+    }
+}
+
+}
+
+TEST(Convolution, FastFftLength) {
+    EXPECT_EQ(1, MatrixDSP::fastFftLength(0));
+    EXPECT_EQ(1, MatrixDSP::fastFftLength(1));
+    EXPECT_EQ(8, MatrixDSP::fastFftLength(7));
+    EXPECT_EQ(100, MatrixDSP::fastFftLength(97));
+    EXPECT_EQ(1080, MatrixDSP::fastFftLength(1025));
+    EXPECT_EQ(1048576, MatrixDSP::fastFftLength(1048576));
+    EXPECT_EQ(108, MatrixDSP::fastFftLength(101, true));
+    for (unsigned len = 1; len < 2000; len++) {
+        unsigned fast = MatrixDSP::fastFftLength(len);
+        EXPECT_GE(fast, len);
+        unsigned rest = fast;
+        for (unsigned factor : {2, 3, 5}) {
+            while (rest % factor == 0) {
+                rest /= factor;
+            }
+        }
+        EXPECT_EQ(1, rest) << len;
+        EXPECT_EQ(0, MatrixDSP::fastFftLength(len, true) % 2) << len;
+    }
+}
+
+TEST(Convolution, Short) {
+    checkConv<double, double, double>(20, 5, 1e-12);
+    checkConv<double, double, double>(5, 20, 1e-12);
+    checkConv<double, double, double>(1, 1, 1e-12);
+    checkConv<float, float, float>(300, 31, 1e-4);
+    checkConv<std::complex<double>, std::complex<double>, double>(50, 9, 1e-12);
+    checkConv<std::complex<double>, double, std::complex<double> >(50, 9, 1e-12);
+    checkConv<std::complex<double>, double, std::complex<double> >(9, 50, 1e-12);
+    checkConv<std::complex<double>, std::complex<double>, std::complex<double> >(40, 40, 1e-12);
+}
+
+TEST(Convolution, Long) {
+    // Similar lengths use one FFT of each, and a long input with shorter taps uses overlap-save
+    unsigned taps = std::max(MatrixDSP::FirFilter<double>::crossover(),
+                             MatrixDSP::FirFilter< std::complex<double>, std::complex<double> >::crossover());
+    checkConv<double, double, double>(2 * taps + 7, taps + 3, 1e-9);
+    checkConv<double, double, double>(20 * taps, taps + 1, 1e-9);
+    checkConv<std::complex<double>, std::complex<double>, std::complex<double> >(3 * taps, taps, 1e-9);
+    checkConv<std::complex<double>, double, std::complex<double> >(10 * taps, taps, 1e-9);
+}
+
+TEST(Convolution, Xcorr) {
+    // A template hidden in a longer signal shows up as a peak at its offset
+    MatrixDSP::ComplexVector<double> pattern(64);
+    for (unsigned index = 0; index < pattern.size(); index++) {
+        pattern[index] = testValue< std::complex<double> >(index * 7);
+    }
+    MatrixDSP::ComplexVector<double> signal(1000);
+    for (unsigned index = 0; index < pattern.size(); index++) {
+        signal[300 + index] = pattern[index];
+    }
+    MatrixDSP::ComplexVector<double> output;
+    MatrixDSP::xcorr(signal, pattern, output, 400);
+    ASSERT_EQ(801, output.size());
+    unsigned peak = 0;
+    for (unsigned index = 0; index < output.size(); index++) {
+        if (std::abs(output[index]) > std::abs(output[peak])) {
+            peak = index;
+        }
+    }
+    EXPECT_EQ(400 + 300, peak);
+    double energy = 0;
+    for (unsigned index = 0; index < pattern.size(); index++) {
+        energy += std::norm(pattern[index]);
+    }
+    EXPECT_NEAR(energy, output[peak].real(), 1e-9);
+    EXPECT_NEAR(0, output[peak].imag(), 1e-9);
+
+    // Every lag against the definition, including lags past the ends of the inputs
+    MatrixDSP::Vector<double> a = testSignal< MatrixDSP::Vector<double> >(30, 0);
+    MatrixDSP::Vector<double> b = testSignal< MatrixDSP::Vector<double> >(12, 100);
+    MatrixDSP::Vector<double> realOutput;
+    MatrixDSP::xcorr(a, b, realOutput, 40);
+    ASSERT_EQ(81, realOutput.size());
+    for (int lag = -40; lag <= 40; lag++) {
+        double expected = 0;
+        for (int n = 0; n < (int) b.size(); n++) {
+            if (n + lag >= 0 && n + lag < (int) a.size()) {
+                expected += a[n + lag] * b[n];
+            }
+        }
+        EXPECT_NEAR(expected, realOutput[lag + 40], 1e-12) << lag;
+    }
+
+    MatrixDSP::xcorr(a, b, realOutput);
+    EXPECT_EQ(59, realOutput.size());
+    EXPECT_NEAR(a[0] * b[11], realOutput[29 - 11], 1e-12);
+}
@@ -0,0 +1,159 @@
+//
+//  FftSetupManagerTest.cpp
+//  MatrixDspTests
+//
+
+#include "FftSetupManager.h"
+#include "TestHelpers.h"
+#include "gtest/gtest.h"
+#include <complex>
+#include <cstdio>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+using namespace MatrixDspTests;
+
+typedef FftSetupManager<float, float *, std::complex<float> *> FloatManager;
+typedef FftSetupManager<double, double *, std::complex<double> *> DoubleManager;
+typedef kissfft<double, double *, std::complex<double> *> DoubleFft;
+
+std::size_t product(const std::vector<std::size_t> &radices) {
+    std::size_t result = 1;
+    for (std::size_t radix : radices) {
+        result *= radix;
+    }
+    return result;
+}
+
+}
+
+TEST(FftSetupManager, Plans) {
+    // Any order and grouping of the factors gives the same transform, one at a time or batched
+    const std::size_t len = 240, batch = 3;
+    std::vector< std::complex<double> > input = testSignal< std::vector< std::complex<double> > >(len * batch);
+    for (bool inverse : {false, true}) {
+        DoubleFft reference(len, inverse);
+        EXPECT_EQ(DoubleFft::factorize(len), reference.plan().radices);
+        EXPECT_FALSE(reference.plan().chirpZ);
+        std::vector< std::complex<double> > expected(len * batch);
+        reference.transform_batch(input.data(), expected.data(), batch);
+
+        std::vector< std::vector<std::size_t> > radixLists = {{2, 2, 2, 2, 3, 5}, {5, 3, 2, 2, 2, 2}, {3, 4, 5, 4}, {16, 15}, {240}};
+        for (const std::vector<std::size_t> &radices : radixLists) {
+            DoubleFft fft(len, inverse, kissfft_plan{false, radices});
+            EXPECT_EQ(radices, fft.plan().radices);
+            std::vector< std::complex<double> > column(len), single(len), batched(len * batch);
+            for (std::size_t index = 0; index < len; index++) {
+                column[index] = input[index * batch];
+            }
+            fft.transform(column.data(), single.data());
+            fft.transform_batch(input.data(), batched.data(), batch);
+            for (std::size_t index = 0; index < len; index++) {
+                EXPECT_NEAR(0, std::abs(single[index] - batched[index * batch]), 1e-10) << radices[0];
+            }
+            for (std::size_t index = 0; index < len * batch; index++) {
+                EXPECT_NEAR(0, std::abs(expected[index] - batched[index]), 1e-10) << radices[0];
+            }
+        }
+    }
+}
+
+TEST(FftSetupManager, Measure) {
+    FloatManager manager;
+    EXPECT_EQ(MatrixDSP::FftPlanning::Estimate, manager.getPlanning());
+    EXPECT_TRUE(manager.getPlan(1024).radices.empty());
+    EXPECT_FALSE(manager.getPlan(1024).chirpZ);
+    EXPECT_TRUE(manager.getPlan(1009).chirpZ);
+
+    manager.setPlanning(MatrixDSP::FftPlanning::Measure);
+    EXPECT_EQ(MatrixDSP::FftPlanning::Measure, manager.getPlanning());
+    for (std::size_t len : {1u, 2u, 64u, 720u, 1024u, 4096u}) {
+        kissfft_plan plan = manager.getPlan(len);
+        EXPECT_FALSE(plan.chirpZ) << len;
+        EXPECT_EQ(len, product(plan.radices)) << len;
+    }
+    // Bluestein's algorithm is many times faster for a large prime
+    EXPECT_TRUE(manager.getPlan(1009).chirpZ);
+
+    // Setups use the measured plans, complex and real
+    kissfft_plan plan = manager.getPlan(720);
+    EXPECT_EQ(plan.radices, manager.getFftSetup(720)->plan().radices);
+    EXPECT_EQ(plan.radices, manager.getFftSetup(720, true)->plan().radices);
+    EXPECT_EQ(plan.radices, manager.getRealFftSetup(1440)->plan().radices);
+    EXPECT_TRUE(manager.getRealFftSetup(2018)->plan().chirpZ);
+
+    std::vector< std::complex<float> > input = testSignal< std::vector< std::complex<float> > >(720);
+    std::vector< std::complex<float> > expected(720), output(720);
+    FloatManager().getFftSetup(720)->transform(input.data(), expected.data());
+    manager.getFftSetup(720)->transform(input.data(), output.data());
+    for (std::size_t index = 0; index < input.size(); index++) {
+        EXPECT_NEAR(0, std::abs(expected[index] - output[index]), 1e-3);
+    }
+}
+
+TEST(FftSetupManager, Wisdom) {
+    FloatManager measured;
+    measured.setPlanning(MatrixDSP::FftPlanning::Measure);
+    std::vector<std::size_t> lengths = {1, 96, 1009, 1024, 3000};
+    for (std::size_t len : lengths) {
+        measured.getPlan(len);
+    }
+    std::stringstream wisdom;
+    ASSERT_TRUE(measured.exportWisdom(wisdom));
+    std::string text = wisdom.str();
+    EXPECT_EQ(0u, text.find("MatrixDSP FFT wisdom float\n"));
+    EXPECT_NE(std::string::npos, text.find("\n1009 bluestein\n"));
+
+    // Another manager gets the same plans without measuring, whatever its planning mode
+    FloatManager imported;
+    ASSERT_TRUE(imported.importWisdom(wisdom));
+    EXPECT_EQ(MatrixDSP::FftPlanning::Estimate, imported.getPlanning());
+    for (std::size_t len : lengths) {
+        EXPECT_EQ(measured.getPlan(len).chirpZ, imported.getPlan(len).chirpZ) << len;
+        EXPECT_EQ(measured.getPlan(len).radices, imported.getPlan(len).radices) << len;
+        EXPECT_EQ(measured.getPlan(len).radices, imported.getFftSetup(len)->plan().radices) << len;
+    }
+
+    // Through a file
+    const std::string path = "FftSetupManagerTest.wisdom";
+    ASSERT_TRUE(measured.exportWisdom(path));
+    FloatManager fromFile;
+    ASSERT_TRUE(fromFile.importWisdom(path));
+    EXPECT_EQ(measured.getPlan(3000).radices, fromFile.getPlan(3000).radices);
+    std::remove(path.c_str());
+    EXPECT_FALSE(fromFile.importWisdom(path));
+
+    fromFile.forgetWisdom();
+    EXPECT_TRUE(fromFile.getPlan(3000).radices.empty());
+}
+
+TEST(FftSetupManager, BadWisdom) {
+    // Wisdom for another type, or that doesn't make sense, is rejected and changes nothing
+    FloatManager manager;
+    std::istringstream good("MatrixDSP FFT wisdom float\n\n64 2 2 2 2 2 2\n");
+    ASSERT_TRUE(manager.importWisdom(good));
+    EXPECT_EQ(std::vector<std::size_t>({2, 2, 2, 2, 2, 2}), manager.getPlan(64).radices);
+
+    std::stringstream doubleWisdom;
+    DoubleManager doubleManager;
+    doubleManager.setPlanning(MatrixDSP::FftPlanning::Measure);
+    doubleManager.getPlan(64);
+    ASSERT_TRUE(doubleManager.exportWisdom(doubleWisdom));
+    EXPECT_FALSE(manager.importWisdom(doubleWisdom));
+
+    for (const char *text : {"", "not wisdom\n64 4 4 4\n",
+                             "MatrixDSP FFT wisdom float\n64 4 4 4\n128 4 4\n",
+                             "MatrixDSP FFT wisdom float\n64 4 4 4\n64 4 4 2\n",
+                             "MatrixDSP FFT wisdom float\n64 4 4 4x\n",
+                             "MatrixDSP FFT wisdom float\n64\n",
+                             "MatrixDSP FFT wisdom float\n64 1 4 4 4\n",
+                             "MatrixDSP FFT wisdom float\n0 bluestein\n",
+                             "MatrixDSP FFT wisdom float\n61 bluestein 61\n",
+                             "MatrixDSP FFT wisdom float\nsixty four\n"}) {
+        std::istringstream bad(text);
+        EXPECT_FALSE(manager.importWisdom(bad)) << text;
+        EXPECT_EQ(std::vector<std::size_t>({2, 2, 2, 2, 2, 2}), manager.getPlan(64).radices) << text;
+    }
+}
@@ -0,0 +1,108 @@
+//
+//  FirFilterTest.cpp
+//  MatrixDspTests
+//
+
+#include "ComplexVector.h"
+#include "FirFilter.h"
+#include "TestHelpers.h"
+#include "gtest/gtest.h"
+#include <complex>
+#include <vector>
+
+namespace {
+
+using namespace MatrixDspTests;
+
+// Filters in uneven blocks with both methods and compares with the reference
+template <class T, class Tap>
+void checkFilter(unsigned numTaps, double tolerance) {
+    std::vector<Tap> taps(numTaps);
+    for (unsigned tap = 0; tap < numTaps; tap++) {
+        taps[tap] = testValue<Tap>(tap + 1000) / (Tap) (tap + 1);
+    }
+    std::vector<T> input = testSignal< std::vector<T> >(3000);
+    std::vector<T> expected = filterReference(input, taps);
+
+    const MatrixDSP::FirMethod methods[] = {MatrixDSP::FirMethod::Direct, MatrixDSP::FirMethod::OverlapSave};
+    const unsigned blocks[] = {1, 2, 3, 17, 64, 113, 1000, 500};
+    IsaScope isaScope;
+    for (MatrixDSP::simd::Isa isa : testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        for (MatrixDSP::FirMethod method : methods) {
+            MatrixDSP::FirFilter<T, Tap> filter(taps.data(), numTaps, method);
+            EXPECT_EQ(method, filter.filterMethod());
+            std::vector<T> output(input.size());
+            unsigned start = 0;
+            for (unsigned block = 0; start < input.size(); block++) {
+                unsigned len = std::min<unsigned>(blocks[block % 8], input.size() - start);
+                filter.filter(input.data() + start, output.data() + start, len);
+                start += len;
+            }
+            for (unsigned index = 0; index < output.size(); index++) {
+                EXPECT_NEAR(0, std::abs(expected[index] - output[index]), tolerance) << "method " << (int) method << " index " << index;
+            }
+        }
+    }
+}
+
+}
+
+TEST(FirFilter, Real) {
+    checkFilter<float, float>(1, 1e-5);
+    checkFilter<float, float>(7, 1e-5);
+    checkFilter<float, float>(100, 1e-5);
+    checkFilter<double, double>(33, 1e-12);
+    checkFilter<double, double>(300, 1e-12);
+}
+
+TEST(FirFilter, Complex) {
+    checkFilter<std::complex<float>, float>(20, 1e-5);
+    checkFilter<std::complex<double>, double>(129, 1e-12);
+    checkFilter<std::complex<float>, std::complex<float> >(9, 1e-5);
+    checkFilter<std::complex<double>, std::complex<double> >(70, 1e-12);
+}
+
+TEST(FirFilter, Auto) {
+    unsigned crossover = MatrixDSP::FirFilter<float>::crossover();
+    EXPECT_GE(crossover, 16);
+    EXPECT_LE(crossover, 4096);
+    EXPECT_EQ(crossover, MatrixDSP::FirFilter<float>::crossover());
+
+    std::vector<float> taps(crossover, 0.5f);
+    MatrixDSP::FirFilter<float> longFilter(taps.data(), crossover);
+    EXPECT_EQ(MatrixDSP::FirMethod::OverlapSave, longFilter.filterMethod());
+    EXPECT_GE(longFilter.fftLength(), 4 * crossover);
+    EXPECT_EQ(longFilter.fftLength() - crossover + 1, longFilter.blockLength());
+    MatrixDSP::FirFilter<float> shortFilter(taps.data(), crossover - 1);
+    EXPECT_EQ(MatrixDSP::FirMethod::Direct, shortFilter.filterMethod());
+    EXPECT_EQ(0, shortFilter.fftLength());
+}
+
+TEST(FirFilter, Vectors) {
+    MatrixDSP::Vector<double> taps({1, 2, 3});
+    MatrixDSP::Vector<double> input({1, 0, 0, 1, 1});
+    MatrixDSP::Vector<double> output;
+    MatrixDSP::firFilter(input, output, taps);
+    MatrixDSP::Vector<double> expected({1, 2, 3, 1, 3});
+    EXPECT_EQ(expected.vec, output.vec);
+
+    // Carries on from the first block in place, and starts again after reset()
+    MatrixDSP::FirFilter<double> filter(taps, MatrixDSP::FirMethod::OverlapSave);
+    filter.filter(input, output);
+    filter.filter(input);
+    MatrixDSP::Vector<double> carried({6, 5, 3, 1, 3});
+    for (unsigned index = 0; index < input.size(); index++) {
+        EXPECT_NEAR(carried[index], input[index], 1e-12);
+    }
+    filter.reset();
+    filter.filter(output);
+    EXPECT_NEAR(1, output[0], 1e-12);
+
+    MatrixDSP::ComplexVector<float> complexInput({{1, -1}, {0, 2}});
+    MatrixDSP::Vector< std::complex<float> > complexOutput;
+    MatrixDSP::Vector<float> realTaps({2, 1});
+    MatrixDSP::firFilter(complexInput, complexOutput, realTaps);
+    EXPECT_EQ(std::complex<float>(2, -2), complexOutput[0]);
+    EXPECT_EQ(std::complex<float>(1, 3), complexOutput[1]);
+}
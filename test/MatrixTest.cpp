@@ -1,6 +1,9 @@
 #include "Matrix2d.h"
+#include "TestHelpers.h"
 #include "gtest/gtest.h"
 #include <cstdio>
+#include <complex>
+#include <cstdint>
 //#include "Timer.h"
 
 TEST(Matrix2d_Iterator, Sort) {
@@ -263,6 +266,31 @@ TEST(Matrix2dIterator, Sort) {
 	}
 }
 
+TEST(Matrix2d_Operator, Move) {
+    static_assert(std::is_nothrow_move_constructible< MatrixDSP::Matrix2d<float> >::value, "");
+    static_assert(std::is_nothrow_move_assignable< MatrixDSP::Matrix2d<float> >::value, "");
+
+    MatrixDSP::Matrix2d<float> mat = {{1, 2, 3}, {4, 5, 6}};
+    const float *data = mat.data();
+
+    MatrixDSP::Matrix2d<float> moved(std::move(mat));
+    EXPECT_EQ(data, moved.data());
+    EXPECT_EQ(2u, moved.getRows());
+    EXPECT_EQ(3u, moved.getCols());
+    EXPECT_EQ(0u, mat.getRows());
+    EXPECT_EQ(0u, mat.getCols());
+
+    MatrixDSP::Matrix2d<float> assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(data, assigned.data());
+    EXPECT_EQ(6, assigned(1, 2));
+    EXPECT_EQ(0u, moved.getRows());
+
+    MatrixDSP::Matrix2d<float> copy(assigned);
+    EXPECT_NE(data, copy.data());
+    EXPECT_EQ(5, copy(1, 1));
+}
+
 TEST(Matrix2d_Operator, Negation) {
 	MatrixDSP::Matrix2d<float> mat1({ { 1, 2, 3 }, { 4, 5, 6 } });
 	MatrixDSP::Matrix2d<float> mat2;
@@ -456,6 +484,48 @@ TEST(Matrix2d_Operator, DivideScalar) {
 	EXPECT_EQ(6, mat2(1, 2));
 }
 
+TEST(Matrix2d_Operator, FusedExpression) {
+	MatrixDSP::Matrix2d<float> mat1({ { 1, 2, 3 }, { 4, 5, 6 } });
+	MatrixDSP::Matrix2d<float> mat2({ { 2, 3, 4 }, { 6, 7, 8 } });
+
+	MatrixDSP::Matrix2d<float> mat3 = (mat1 + mat2) * 2.0f - mat1;
+	EXPECT_EQ(2, mat3.getRows());
+	EXPECT_EQ(3, mat3.getCols());
+	EXPECT_EQ(5, mat3(0, 0));
+	EXPECT_EQ(8, mat3(0, 1));
+	EXPECT_EQ(11, mat3(0, 2));
+	EXPECT_EQ(16, mat3(1, 0));
+	EXPECT_EQ(19, mat3(1, 1));
+	EXPECT_EQ(22, mat3(1, 2));
+}
+
+TEST(Matrix2d_Operator, ExpressionMethods) {
+	// Code written when the operators returned a Matrix2d still compiles and gives the same answers
+	MatrixDSP::Matrix2d<float> mat1({ { 1, 2, 3 }, { 4, 5, 6 } });
+	MatrixDSP::Matrix2d<float> mat2({ { 2, 3, 4 }, { 6, 7, 8 } });
+
+	typedef std::vector< std::pair<unsigned, unsigned> > Locations;
+	EXPECT_EQ(std::make_pair(2u, 3u), (mat1 + mat2).size());
+	MatrixDSP::Matrix2d<float> greater = (mat1 + mat2) > 10.0f;
+	EXPECT_EQ(Locations({ {1, 1}, {1, 2} }), greater.find());
+	EXPECT_EQ(Locations({ {1, 1}, {1, 2} }), ((mat1 + mat2) > 10.0f).find());
+	MatrixDSP::Matrix2d<float> less = (mat2 - 1.0f) < mat1;
+	EXPECT_EQ(Locations(), less.find());
+
+	MatrixDSP::Matrix2d<float> transposed = (mat1 * 2.0f).transpose();
+	EXPECT_EQ(3, transposed.getRows());
+	EXPECT_EQ(2, transposed.getCols());
+	EXPECT_EQ(8, transposed(0, 1));
+	MatrixDSP::Matrix2d<float> output;
+	transpose(mat1 + mat2, output);
+	EXPECT_EQ(10, output(0, 1));
+
+	MatrixDSP::Matrix2d<float> negated = -(mat2 - mat1);
+	EXPECT_EQ(-1, negated(0, 0));
+	EXPECT_EQ(-2, negated(1, 2));
+	EXPECT_EQ(1, mat1(0, 0));
+}
+
 TEST(Matrix2d_Method, AppendRow) {
 	MatrixDSP::Matrix2d<float> mat({ { 1, 2, 3 }, { 4, 5, 6 } });
 	MatrixDSP::Vector<float> buf({ 7, 8, 9 });
@@ -676,3 +746,186 @@ TEST(Matrix2d_Operator, ComparisonMatrix) {
     EXPECT_EQ(1, result(1, 1));
     EXPECT_EQ(0, result(1, 2));
 }
+
+namespace {
+
+template <class T>
+MatrixDSP::Matrix2d<T> numberedMatrix(unsigned rows, unsigned cols) {
+    MatrixDSP::Matrix2d<T> mat(rows, cols);
+    for (unsigned row=0; row<rows; row++) {
+        for (unsigned col=0; col<cols; col++) {
+            mat(row, col) = (T) (row * cols + col);
+        }
+    }
+    return mat;
+}
+
+template <class T>
+void checkTransposed(const MatrixDSP::Matrix2d<T> &original, MatrixDSP::Matrix2d<T> &transposed, const char *how) {
+    ASSERT_EQ(original.getCols(), transposed.getRows()) << how;
+    ASSERT_EQ(original.getRows(), transposed.getCols()) << how;
+    for (unsigned row=0; row<original.getRows(); row++) {
+        for (unsigned col=0; col<original.getCols(); col++) {
+            ASSERT_EQ(original.data()[row * original.getCols() + col], transposed(col, row))
+                << how << ", " << original.getRows() << "x" << original.getCols() << " (" << row << ", " << col << ")";
+        }
+    }
+}
+
+// Checks all of the ways of transposing, with sizes that give partial tiles and that are split
+// into several blocks
+template <class T>
+void checkTranspose() {
+    const unsigned sizes[][2] = {{1, 1}, {1, 7}, {7, 1}, {3, 5}, {8, 8}, {33, 47}, {64, 64}, {100, 37}, {129, 128}, {150, 150}};
+    for (auto &size : sizes) {
+        MatrixDSP::Matrix2d<T> original = numberedMatrix<T>(size[0], size[1]);
+        MatrixDSP::Matrix2d<T> result(1, 1);
+        transpose(original, result);
+        checkTransposed(original, result, "out of place");
+
+        result = numberedMatrix<T>(size[0], size[1]);
+        transpose(result);
+        checkTransposed(original, result, "transpose()");
+
+        result = numberedMatrix<T>(size[0], size[1]);
+        transposeInPlace(result);
+        checkTransposed(original, result, "transposeInPlace()");
+
+        result = numberedMatrix<T>(size[0], size[1]);
+        transpose(result, result);
+        checkTransposed(original, result, "aliased");
+    }
+}
+
+}
+
+TEST(Matrix2d_Methods, Transpose_Blocked) {
+    MatrixDspTests::IsaScope isaScope;
+    for (MatrixDSP::simd::Isa isa : {MatrixDSP::simd::Isa::Scalar, MatrixDSP::simd::Isa::Sse2, MatrixDSP::simd::Isa::Avx2}) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        checkTranspose<float>();
+        checkTranspose<int32_t>();
+        checkTranspose<double>();
+        checkTranspose< std::complex<float> >();
+        checkTranspose< std::complex<double> >();
+        checkTranspose<int16_t>();
+    }
+}
+
+TEST(Matrix2d_Methods, Transpose_SubMatrix) {
+    // Transpose the interior of a larger matrix into the interior of another
+    MatrixDSP::Matrix2d<float> in = numberedMatrix<float>(40, 50);
+    MatrixDSP::Matrix2d<float> out(60, 45);
+    MatrixDSP::simd::transpose<float>(35, 41, in.data() + 2 * 50 + 3, 50, out.data() + 45 + 1, 45);
+    for (unsigned row=0; row<60; row++) {
+        for (unsigned col=0; col<45; col++) {
+            if (row >= 1 && row < 42 && col >= 1 && col < 36) {
+                EXPECT_EQ(in(2 + col - 1, 3 + row - 1), out(row, col));
+            }
+            else {
+                EXPECT_EQ(0, out(row, col));
+            }
+        }
+    }
+}
+
+TEST(Matrix2d_Methods, PadRows) {
+    MatrixDSP::Matrix2d<float> packed = numberedMatrix<float>(5, 7);
+    EXPECT_EQ(0u, (uintptr_t) packed.data() % MatrixDSP::defaultAlignment);
+    EXPECT_EQ(7u, packed.ld());
+    EXPECT_FALSE(packed.rowsPadded());
+
+    MatrixDSP::Matrix2d<float> padded = packed;
+    padded.padRows();
+    EXPECT_TRUE(padded.rowsPadded());
+    EXPECT_EQ(16u, padded.ld());
+    for (unsigned row=0; row<5; row++) {
+        EXPECT_EQ(0u, (uintptr_t) &padded(row, 0) % MatrixDSP::defaultAlignment);
+        for (unsigned col=0; col<7; col++) {
+            EXPECT_EQ(packed(row, col), padded(row, col));
+        }
+    }
+
+    // Operators and expressions skip the padding
+    padded *= 2.0f;
+    padded += packed;
+    padded -= 1.0f;
+    MatrixDSP::Matrix2d<float> sum = padded + packed;
+    padded = padded + packed;
+    EXPECT_EQ(16u, padded.ld());
+    EXPECT_EQ(7u, sum.ld());
+    for (unsigned row=0; row<5; row++) {
+        for (unsigned col=0; col<7; col++) {
+            EXPECT_EQ(4 * packed(row, col) - 1, padded(row, col));
+            EXPECT_EQ(padded(row, col), sum(row, col));
+        }
+    }
+
+    // The iterators step over the padding
+    padded = packed;
+    padded.padRows();
+    std::vector<float> byRow(padded.begin(true), padded.end(true));
+    std::vector<float> byCol(padded.begin(), padded.end());
+    ASSERT_EQ(35u, byRow.size());
+    ASSERT_EQ(35u, byCol.size());
+    EXPECT_EQ(7, byRow[7]);
+    EXPECT_EQ(7, byCol[1]);
+    EXPECT_EQ(34, byCol[34]);
+    EXPECT_EQ(22, *std::next(padded.colBegin(1), 3));
+    EXPECT_EQ(7u, std::distance(padded.rowBegin(4), padded.rowEnd(4)));
+
+    MatrixDSP::Matrix2d<float> transposed = padded;
+    transposed.transpose();
+    EXPECT_EQ(16u, transposed.ld());
+    checkTransposed(packed, transposed, "padded");
+    transposed = padded;
+    transposed.transposeInPlace();
+    checkTransposed(packed, transposed, "padded in place");
+    transposed.transpose(padded);
+    checkTransposed(packed, transposed, "padded out of place");
+
+    MatrixDSP::Matrix2d<float> resized = padded;
+    resized.resize(6, 20, -1);
+    EXPECT_EQ(32u, resized.ld());
+    for (unsigned row=0; row<6; row++) {
+        for (unsigned col=0; col<20; col++) {
+            EXPECT_EQ(row < 5 && col < 7 ? packed(row, col) : -1, resized(row, col));
+        }
+    }
+    resized.resize(3, 2);
+    EXPECT_EQ(16u, resized.ld());
+    EXPECT_EQ(8, resized(1, 1));
+    EXPECT_EQ(15, resized(2, 1));
+
+    MatrixDSP::Matrix2d<float> reshaped = packed;
+    reshaped.reshape(7, 5);
+    resized = padded;
+    resized.reshape(7, 5);
+    for (unsigned row=0; row<7; row++) {
+        for (unsigned col=0; col<5; col++) {
+            EXPECT_EQ(reshaped(row, col), resized(row, col));
+        }
+    }
+
+    MatrixDSP::Vector<float> newRow = {1, 2, 3, 4, 5, 6, 7};
+    MatrixDSP::Vector<float> newCol = {1, 2, 3, 4, 5, 6};
+    MatrixDSP::Matrix2d<float> appended = padded;
+    appended.appendRow(newRow);
+    appended.appendCol(newCol);
+    MatrixDSP::Matrix2d<float> copy = appended;
+    appended.appendCols(copy);
+    EXPECT_EQ(6u, appended.getRows());
+    EXPECT_EQ(16u, appended.getCols());
+    EXPECT_EQ(16u, appended.ld());
+    EXPECT_EQ(34, appended(4, 6));
+    EXPECT_EQ(7, appended(5, 6));
+    EXPECT_EQ(6, appended(5, 7));
+    EXPECT_EQ(34, appended(4, 14));
+    EXPECT_EQ(6, appended(5, 15));
+
+    padded.padRows(false);
+    EXPECT_EQ(7u, padded.ld());
+    for (unsigned index=0; index<35; index++) {
+        EXPECT_EQ(packed.data()[index], padded.data()[index]);
+    }
+}
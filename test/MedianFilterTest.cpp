@@ -0,0 +1,65 @@
+//
+//  MedianFilterTest.cpp
+//  MatrixDspTests
+//
+
+#include "MedianFilter.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// The median of the latest "windowLen" samples up to and including sample "index"
+template <class T>
+T windowMedian(const MatrixDSP::Vector<T> &input, unsigned index, unsigned windowLen) {
+    unsigned first = index + 1 >= windowLen ? index + 1 - windowLen : 0;
+    MatrixDSP::Vector<T> window(input.vec.data() + first, index + 1 - first);
+    return window.median();
+}
+
+}
+
+TEST(MedianFilter, Basic) {
+    MatrixDSP::Vector<float> input = {1, 5, 2, 100, 3, 4, -50, 6, 7};
+    MatrixDSP::Vector<float> output;
+    MatrixDSP::medianFilter(input, output, 3);
+    MatrixDSP::Vector<float> expected = {1, 3, 2, 5, 3, 4, 3, 4, 6};
+    EXPECT_EQ(expected.vec, output.vec);
+
+    MatrixDSP::MedianFilter<float> filter(1);
+    EXPECT_EQ(1u, filter.windowLength());
+    filter.filter(input, output);
+    EXPECT_EQ(input.vec, output.vec);
+}
+
+TEST(MedianFilter, Streaming) {
+    // Noise with impulses and repeated values, in blocks of different sizes
+    MatrixDSP::Vector<double> input(500);
+    for (unsigned index=0; index<input.size(); index++) {
+        input[index] = (double) ((index * 37u) % 23u);
+        if (index % 41 == 0) {
+            input[index] = 1000;
+        }
+    }
+    const unsigned blockSizes[] = {1, 7, 64, 3, 100};
+    for (unsigned windowLen : {1u, 2u, 3u, 4u, 7u, 16u, 31u}) {
+        MatrixDSP::MedianFilter<double> filter(windowLen);
+        MatrixDSP::Vector<double> output;
+        for (unsigned pass=0; pass<2; pass++) {
+            unsigned start = 0, block = 0;
+            while (start < input.size()) {
+                unsigned len = std::min(blockSizes[block++ % 5], input.size() - start);
+                MatrixDSP::Vector<double> chunk(input.vec.data() + start, len);
+                filter.filter(chunk);
+                for (unsigned index=0; index<len; index++) {
+                    ASSERT_EQ(windowMedian(input, start + index, windowLen), chunk[index])
+                        << "window " << windowLen << ", sample " << start + index;
+                }
+                start += len;
+            }
+            // The second pass checks that reset() starts over
+            filter.reset();
+        }
+    }
+}
@@ -0,0 +1,205 @@
+//
+//  NcoTest.cpp
+//  MatrixDspTests
+//
+
+#include "ComplexVector.h"
+#include "Nco.h"
+#include "TestHelpers.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace {
+
+const MatrixDSP::NcoEngine engines[] = {MatrixDSP::NcoEngine::Polynomial, MatrixDSP::NcoEngine::Phasor,
+                                        MatrixDSP::NcoEngine::Table};
+// Sample "index" of the tone that "nco" generates, worked out in double precision from the
+// phase and frequency it actually uses
+template <class T>
+std::complex<double> expectedSample(const MatrixDSP::Nco<T> &nco, double startPhase, unsigned index) {
+    double cycles = std::fmod(index * (double) nco.frequency(), 1.0);
+    return std::polar(1.0, startPhase + 2 * M_PI * cycles);
+}
+
+// The phasor engine's error grows with the number of steps each phasor takes in a block, so it
+// gets its own tolerance
+template <class T>
+void checkAccuracy(T tolerance, T phasorTolerance) {
+    MatrixDspTests::IsaScope isaScope;
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        for (MatrixDSP::NcoEngine engine : engines) {
+            MatrixDSP::Nco<T> nco((T) 0.1234567, 1, (T) 1.3, engine);
+            double startPhase = nco.phase();
+            std::vector< std::complex<T> > output(1000);
+            nco.generate(output.data(), output.size());
+            T limit = engine == MatrixDSP::NcoEngine::Phasor ? phasorTolerance : tolerance;
+            for (unsigned index = 0; index < output.size(); index++) {
+                std::complex<double> expected = expectedSample(nco, startPhase, index);
+                EXPECT_NEAR(expected.real(), output[index].real(), limit) << "engine " << (int) engine << " index " << index;
+                EXPECT_NEAR(expected.imag(), output[index].imag(), limit) << "engine " << (int) engine << " index " << index;
+            }
+        }
+    }
+}
+
+}
+
+TEST(Nco, Accuracy) {
+    checkAccuracy<float>(2e-7f, 3e-6f);
+    checkAccuracy<double>(1e-13, 1e-13);
+}
+
+TEST(Nco, Quadrants) {
+    // A quarter cycle per sample lands exactly on each quadrant boundary
+    for (MatrixDSP::NcoEngine engine : engines) {
+        MatrixDSP::Nco<double> nco(-0.25, 1, 0, engine);
+        std::complex<double> output[8];
+        nco.generate(output, 8);
+        for (unsigned index = 0; index < 8; index++) {
+            std::complex<double> expected = std::polar(1.0, -M_PI / 2 * index);
+            EXPECT_NEAR(expected.real(), output[index].real(), 1e-15);
+            EXPECT_NEAR(expected.imag(), output[index].imag(), 1e-15);
+        }
+    }
+}
+
+TEST(Nco, PhaseContinuity) {
+    MatrixDspTests::IsaScope isaScope;
+    // Generating in pieces, and switching engines between them, gives the same tone as
+    // generating it all at once
+    const unsigned len = 1000;
+    const unsigned pieces[] = {1, 7, 300, 256, 436};
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        for (MatrixDSP::NcoEngine engine : engines) {
+            MatrixDSP::Nco<float> whole(0.01f, 1, 0.5f, engine);
+            std::vector< std::complex<float> > expected(len);
+            whole.generate(expected.data(), len);
+
+            MatrixDSP::Nco<float> pieced(0.01f, 1, 0.5f, engine);
+            std::vector< std::complex<float> > output(len);
+            unsigned start = 0;
+            for (unsigned piece : pieces) {
+                pieced.generate(output.data() + start, piece);
+                start += piece;
+            }
+            EXPECT_FLOAT_EQ(whole.phase(), pieced.phase());
+            for (unsigned index = 0; index < len; index++) {
+                EXPECT_NEAR(expected[index].real(), output[index].real(), 1e-6f);
+                EXPECT_NEAR(expected[index].imag(), output[index].imag(), 1e-6f);
+            }
+
+            MatrixDSP::Nco<float> switched(0.01f, 1, 0.5f, MatrixDSP::NcoEngine::Table);
+            switched.generate(output.data(), 500);
+            switched.setEngine(engine);
+            switched.generate(output.data() + 500, 500);
+            for (unsigned index = 0; index < len; index++) {
+                EXPECT_NEAR(expected[index].real(), output[index].real(), 2e-6f);
+                EXPECT_NEAR(expected[index].imag(), output[index].imag(), 2e-6f);
+            }
+        }
+    }
+}
+
+TEST(Nco, NoDrift) {
+    // After millions of samples the tone is still on frequency, at unit magnitude
+    const unsigned len = 1u << 22;
+    std::vector< std::complex<float> > output(len);
+    for (MatrixDSP::NcoEngine engine : engines) {
+        MatrixDSP::Nco<float> nco(0.0123f, 1, 0, engine);
+        nco.generate(output.data(), len);
+        std::complex<double> expected = expectedSample(nco, 0, len - 1);
+        EXPECT_NEAR(expected.real(), output[len - 1].real(), 2e-6f);
+        EXPECT_NEAR(expected.imag(), output[len - 1].imag(), 2e-6f);
+        EXPECT_NEAR(1, std::abs(output[len - 1]), 2e-6f);
+    }
+}
+
+TEST(Nco, LongTone) {
+    MatrixDspTests::IsaScope isaScope;
+    // A third of the sample rate isn't a whole number of phase steps, but a million samples on
+    // the phase is still within a few nanoradians of the ideal
+    const unsigned len = 1u << 20;
+    std::vector< std::complex<double> > output(len);
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        for (MatrixDSP::NcoEngine engine : engines) {
+            MatrixDSP::Nco<double> nco(1, 3, 0, engine);
+            nco.generate(output.data(), len);
+            double worst = 0;
+            for (unsigned index = 0; index < len; index++) {
+                std::complex<double> expected = std::polar(1.0, 2 * M_PI * (index % 3) / 3);
+                worst = std::max(worst, std::abs(std::arg(output[index] * std::conj(expected))));
+            }
+            EXPECT_LT(worst, 1e-8) << "isa " << (int) isa << " engine " << (int) engine;
+        }
+    }
+}
+
+TEST(Nco, Frequency) {
+    MatrixDSP::Nco<double> nco(1000, 48000);
+    EXPECT_NEAR(1000, nco.frequency(48000), 48000 / 4294967296.0);
+    EXPECT_NEAR(2 * M_PI * 1000 / 48000, nco.phaseIncrement(), 1e-9);
+    nco.setFrequency(-1000, 48000);
+    EXPECT_NEAR(-1000, nco.frequency(48000), 48000 / 4294967296.0);
+
+    // The increment isn't wrapped, even above half the sample rate
+    nco.setFrequency(30000, 48000);
+    EXPECT_NEAR(-18000, nco.frequency(48000), 48000 / 4294967296.0);
+    EXPECT_DOUBLE_EQ(2 * M_PI * 30000 / 48000, nco.phaseIncrement());
+    MatrixDSP::Vector<double> tone(100);
+    EXPECT_DOUBLE_EQ(0.3 + 100 * 2 * M_PI * 30000 / 48000, tone.sin(30000, 48000, 0.3));
+
+    nco.setPhase(-M_PI / 2);
+    EXPECT_NEAR(3 * M_PI / 2, nco.phase(), 1e-9);
+    nco.setPhase(5 * M_PI);
+    EXPECT_NEAR(M_PI, nco.phase(), 1e-9);
+}
+
+TEST(Nco, Mix) {
+    MatrixDSP::ComplexVector<double> data(600), tone(600), expected(600);
+    for (unsigned index = 0; index < data.size(); index++) {
+        data[index] = std::complex<double>(std::sin(index * 0.3), std::cos(index * 0.7));
+    }
+    MatrixDSP::Nco<double> toneNco(-0.2, 1, 0.1);
+    toneNco.generate(tone);
+    for (unsigned index = 0; index < data.size(); index++) {
+        expected[index] = data[index] * tone[index];
+    }
+    MatrixDSP::Nco<double> mixer(-0.2, 1, 0.1);
+    mixer.mix(data);
+    for (unsigned index = 0; index < data.size(); index++) {
+        EXPECT_NEAR(expected[index].real(), data[index].real(), 1e-12);
+        EXPECT_NEAR(expected[index].imag(), data[index].imag(), 1e-12);
+    }
+
+    MatrixDSP::Vector<double> real(600);
+    for (unsigned index = 0; index < real.size(); index++) {
+        real[index] = std::sin(index * 0.3);
+    }
+    MatrixDSP::ComplexVector<double> output;
+    MatrixDSP::Nco<double> realMixer(-0.2, 1, 0.1);
+    realMixer.mix(real, output);
+    EXPECT_EQ(600, output.size());
+    for (unsigned index = 0; index < output.size(); index++) {
+        EXPECT_NEAR(real[index] * tone[index].real(), output[index].real(), 1e-12);
+        EXPECT_NEAR(real[index] * tone[index].imag(), output[index].imag(), 1e-12);
+    }
+}
+
+TEST(Nco, SinCos) {
+    MatrixDSP::Nco<float> cosNco(0.05f, 1, 0.2f);
+    MatrixDSP::Nco<float> sinNco(0.05f, 1, 0.2f);
+    double startPhase = cosNco.phase();
+    std::vector<float> cosine(300), sine(300);
+    cosNco.cos(cosine.data(), 300);
+    sinNco.sin(sine.data(), 300);
+    for (unsigned index = 0; index < 300; index++) {
+        std::complex<double> expected = expectedSample(cosNco, startPhase, index);
+        EXPECT_NEAR(expected.real(), cosine[index], 2e-7f);
+        EXPECT_NEAR(expected.imag(), sine[index], 2e-7f);
+    }
+}
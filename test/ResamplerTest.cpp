@@ -0,0 +1,110 @@
+//
+//  ResamplerTest.cpp
+//  MatrixDspTests
+//
+
+#include "ComplexVector.h"
+#include "Resampler.h"
+#include "TestHelpers.h"
+#include "gtest/gtest.h"
+#include <complex>
+#include <vector>
+
+namespace {
+
+using namespace MatrixDspTests;
+
+// Resamples in uneven blocks and compares with the reference
+template <class T>
+void checkResampler(unsigned interpolation, unsigned decimation, unsigned numTaps, double tolerance) {
+    typedef typename MatrixDSP::ResamplerTap<T>::type Tap;
+    std::vector<Tap> taps(numTaps);
+    for (unsigned tap = 0; tap < numTaps; tap++) {
+        taps[tap] = (Tap) (1.0 / (tap + 2)) * (tap % 3 == 1 ? -1 : 1);
+    }
+    std::vector<T> input = testSignal< std::vector<T> >(1000);
+    std::vector<T> expected = resampleReference(input, taps, interpolation, decimation);
+
+    const unsigned blocks[] = {1, 2, 3, 17, 64, 113, 300, 500};
+    IsaScope isaScope;
+    for (MatrixDSP::simd::Isa isa : testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        MatrixDSP::Resampler<T> resampler(taps.data(), numTaps, interpolation, decimation);
+        std::vector<T> output;
+        unsigned start = 0;
+        for (unsigned block = 0; start < input.size(); block++) {
+            unsigned len = std::min<unsigned>(blocks[block % 8], input.size() - start);
+            std::vector<T> blockOutput(resampler.outputLength(len));
+            EXPECT_EQ(blockOutput.size(), resampler.filter(input.data() + start, len, blockOutput.data()));
+            output.insert(output.end(), blockOutput.begin(), blockOutput.end());
+            start += len;
+        }
+        ASSERT_EQ(expected.size(), output.size());
+        for (unsigned index = 0; index < output.size(); index++) {
+            EXPECT_NEAR(0, std::abs(expected[index] - output[index]), tolerance) << index;
+        }
+    }
+}
+
+}
+
+TEST(Resampler, Decimator) {
+    checkResampler<float>(1, 8, 64, 1e-5);
+    checkResampler<float>(1, 3, 7, 1e-5);
+    checkResampler< std::complex<double> >(1, 8, 61, 1e-12);
+}
+
+TEST(Resampler, Interpolator) {
+    checkResampler<float>(4, 1, 33, 1e-5);
+    checkResampler<float>(3, 1, 2, 1e-5);
+    checkResampler< std::complex<double> >(5, 1, 40, 1e-12);
+}
+
+TEST(Resampler, Rational) {
+    checkResampler<float>(3, 2, 25, 1e-5);
+    checkResampler<float>(2, 5, 31, 1e-5);
+    checkResampler<float>(4, 6, 24, 1e-5);
+    checkResampler< std::complex<double> >(7, 3, 50, 1e-12);
+}
+
+TEST(Resampler, Vectors) {
+    MatrixDSP::Vector<float> taps({1, 1, 1, 1});
+    MatrixDSP::Vector<float> input({1, 2, 3, 4, 5, 6, 7, 8, 9});
+    MatrixDSP::Vector<float> output;
+
+    // A moving sum of 4, keeping every other output
+    MatrixDSP::decimate(input, output, taps, 2);
+    MatrixDSP::Vector<float> expected({1, 6, 14, 22, 30});
+    EXPECT_EQ(expected.vec, output.vec);
+
+    // Each sample held for 4 outputs
+    MatrixDSP::interpolate(input, output, taps, 4);
+    EXPECT_EQ(36, output.size());
+    for (unsigned index = 0; index < output.size(); index++) {
+        EXPECT_EQ(input[index / 4], output[index]);
+    }
+
+    MatrixDSP::resample(input, output, taps, 2, 3);
+    EXPECT_EQ(6, output.size());
+
+    MatrixDSP::ComplexVector<float> complexInput(10);
+    for (unsigned index = 0; index < complexInput.size(); index++) {
+        complexInput[index] = std::complex<float>(1, -1);
+    }
+    MatrixDSP::ComplexVector<float> complexOutput;
+    MatrixDSP::Decimator< std::complex<float> > decimator(taps, 2);
+    EXPECT_EQ(2, decimator.decimationRate());
+    EXPECT_EQ(4, decimator.numTaps());
+    decimator.filter(complexInput, complexOutput);
+    EXPECT_EQ(5, complexOutput.size());
+    EXPECT_EQ(std::complex<float>(1, -1), complexOutput[0]);
+    EXPECT_EQ(std::complex<float>(3, -3), complexOutput[1]);
+    EXPECT_EQ(std::complex<float>(4, -4), complexOutput[2]);
+
+    // Carries on from the first block, and starts again after reset()
+    decimator.filter(complexInput, complexOutput);
+    EXPECT_EQ(std::complex<float>(4, -4), complexOutput[0]);
+    decimator.reset();
+    decimator.filter(complexInput, complexOutput);
+    EXPECT_EQ(std::complex<float>(1, -1), complexOutput[0]);
+}
@@ -0,0 +1,94 @@
+//
+//  ScratchArenaTest.cpp
+//  MatrixDspTests
+//
+
+#include "ScratchArena.h"
+#include "ComplexVector.h"
+#include "Matrix2d.h"
+#include "gtest/gtest.h"
+#include <complex>
+#include <cstdint>
+#include <thread>
+
+TEST(ScratchArena, Checkpoints) {
+    MatrixDSP::ScratchArena arena;
+    EXPECT_EQ(0u, arena.capacity());
+
+    char *first = static_cast<char *>(arena.allocate(10));
+    EXPECT_EQ(0u, (uintptr_t) first % MatrixDSP::defaultAlignment);
+    EXPECT_EQ(MatrixDSP::scratchFirstBlockSize, arena.capacity());
+    EXPECT_EQ(MatrixDSP::defaultAlignment, arena.used());
+
+    MatrixDSP::ScratchArena::Checkpoint mark = arena.checkpoint();
+    double *second = arena.allocate<double>(100);
+    EXPECT_EQ(first + MatrixDSP::defaultAlignment, (char *) second);
+    {
+        MatrixDSP::ScratchArena::Scope scope(arena);
+        // Too big for the first block, so it goes in a second one
+        float *big = arena.allocate<float>(MatrixDSP::scratchFirstBlockSize);
+        EXPECT_EQ(0u, (uintptr_t) big % MatrixDSP::defaultAlignment);
+        EXPECT_EQ(5 * MatrixDSP::scratchFirstBlockSize, arena.capacity());
+    }
+    EXPECT_EQ(arena.allocate<double>(1), second + 100 + 4);
+    arena.rewind(mark);
+    EXPECT_EQ(second, arena.allocate<double>(100));
+
+    // The blocks are kept, so doing the same again doesn't allocate
+    arena.rewind(mark);
+    std::size_t capacity = arena.capacity();
+    arena.allocate<float>(MatrixDSP::scratchFirstBlockSize);
+    EXPECT_EQ(capacity, arena.capacity());
+
+    arena.rewind(MatrixDSP::ScratchArena::Checkpoint{0, 0});
+    EXPECT_EQ(0u, arena.used());
+    arena.release();
+    EXPECT_EQ(0u, arena.capacity());
+}
+
+TEST(ScratchArena, Buffers) {
+    MatrixDSP::ScratchArena &arena = MatrixDSP::scratchArena();
+    std::size_t used = arena.used();
+    {
+        MatrixDSP::ScratchBuffer< std::complex<float> > outer(7);
+        EXPECT_EQ(7u, outer.size());
+        EXPECT_EQ(std::complex<float>(0, 0), outer[6]);
+        {
+            MatrixDSP::ScratchBuffer<int> inner(3);
+            EXPECT_EQ(0u, (uintptr_t) inner.data() % MatrixDSP::defaultAlignment);
+            EXPECT_NE((void *) outer.data(), (void *) inner.data());
+        }
+        MatrixDSP::ScratchBuffer<int> reused(3);
+        EXPECT_GT(arena.used(), used);
+    }
+    EXPECT_EQ(used, arena.used());
+
+    // Each thread has its own arena
+    MatrixDSP::ScratchArena *other = nullptr;
+    std::thread thread([&other]() {other = &MatrixDSP::scratchArena();});
+    thread.join();
+    EXPECT_NE(&arena, other);
+}
+
+TEST(ScratchArena, Methods) {
+    // Methods that need scratch space leave the arena as they found it
+    MatrixDSP::ScratchArena &arena = MatrixDSP::scratchArena();
+    std::size_t used = arena.used();
+
+    MatrixDSP::Vector<double> vec = {5, 1, 4, 2, 3, 6};
+    EXPECT_EQ(3.5, vec.median());
+    EXPECT_EQ(5, vec[0]);
+
+    MatrixDSP::ComplexVector<double> spectrum;
+    MatrixDSP::Vector<double> real = {1, 2, 3, 4, 5, 6, 7, 8}, restored;
+    spectrum.fft(real, false, true);
+    spectrum.ifftReal(restored);
+    EXPECT_NEAR(8 * 8, restored[7], 1e-12);
+
+    MatrixDSP::Matrix2d<float> mat = {{1, 2, 3}, {4, 5, 6}};
+    mat.transpose();
+    mat.reshape(2, 3);
+    mat.padRows();
+    EXPECT_EQ(6, mat(1, 2));
+    EXPECT_EQ(used, arena.used());
+}
@@ -0,0 +1,182 @@
+//
+//  SimdTest.cpp
+//  MatrixDspTests
+//
+
+#include "Vector.h"
+#include "ComplexVector.h"
+#include "Simd.h"
+#include "TestHelpers.h"
+#include "gtest/gtest.h"
+#include <vector>
+#include <cmath>
+
+namespace {
+
+const MatrixDSP::simd::Isa allIsas[] = {MatrixDSP::simd::Isa::Scalar, MatrixDSP::simd::Isa::Sse2,
+        MatrixDSP::simd::Isa::Avx2, MatrixDSP::simd::Isa::Avx512};
+
+template <class T>
+std::vector<T> testData(unsigned len, int offset) {
+    std::vector<T> data(len);
+    for (unsigned index=0; index<len; index++) {
+        data[index] = (T) ((int) ((index * 7 + offset) % 23) - 11);
+        if (data[index] == 0) {
+            data[index] = 1;
+        }
+    }
+    return data;
+}
+
+template <class T, class Op>
+void checkBinary() {
+    MatrixDspTests::IsaScope isaScope;
+    for (MatrixDSP::simd::Isa isa : allIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        // Lengths that exercise the unrolled loop, the single vector loop and the scalar tail
+        for (unsigned len : {0u, 1u, 3u, 17u, 64u, 133u}) {
+            std::vector<T> a = testData<T>(len, 3);
+            std::vector<T> b = testData<T>(len, 5);
+            std::vector<T> out(len);
+            MatrixDSP::simd::binary<Op>(out.data(), a.data(), b.data(), len);
+            T scalar = b.size() ? b[len/2] : (T) 3;
+            std::vector<T> outScalar(len);
+            MatrixDSP::simd::binaryScalar<Op>(outScalar.data(), a.data(), scalar, len);
+            for (unsigned index=0; index<len; index++) {
+                T expected = a[index];
+                Op::apply(expected, b[index]);
+                EXPECT_EQ(expected, out[index]) << "isa " << (int) isa << ", len " << len << ", index " << index;
+                expected = a[index];
+                Op::apply(expected, scalar);
+                EXPECT_EQ(expected, outScalar[index]) << "isa " << (int) isa << ", len " << len << ", index " << index;
+            }
+        }
+    }
+}
+
+template <class T>
+void checkFft(double tolerance) {
+    MatrixDspTests::IsaScope isaScope;
+    // Sizes with radix 2, 3, 4 and 5 stages, with and without a scalar tail, and one with a
+    // radix 7 stage that has to use the generic butterfly.
+    for (unsigned len : {8u, 20u, 48u, 75u, 96u, 250u, 360u, 448u, 1024u}) {
+        MatrixDSP::ComplexVector<T> input(len);
+        for (unsigned index=0; index<len; index++) {
+            input[index] = std::complex<T>((T) std::sin(0.37 * index), (T) std::cos(1.3 * index + 0.2));
+        }
+        for (bool inverse : {false, true}) {
+            std::vector< std::complex<double> > expected = MatrixDspTests::dftReference(input, inverse);
+            for (MatrixDSP::simd::Isa isa : allIsas) {
+                MatrixDSP::simd::setMaxIsa(isa);
+                MatrixDSP::ComplexVector<T> output;
+                output.fft(input, inverse);
+                ASSERT_EQ(len, output.size());
+                for (unsigned bin=0; bin<len; bin++) {
+                    EXPECT_NEAR(expected[bin].real(), output[bin].real(), tolerance * len) << "isa " << (int) isa << ", len " << len << ", bin " << bin;
+                    EXPECT_NEAR(expected[bin].imag(), output[bin].imag(), tolerance * len) << "isa " << (int) isa << ", len " << len << ", bin " << bin;
+                }
+            }
+        }
+    }
+}
+
+}
+
+TEST(Simd, CpuFeatures) {
+    // A kernel is only used if the CPU has every feature that its target attribute enables
+    using namespace MatrixDSP::simd;
+    const CpuFeatures &features = cpuFeatures();
+    EXPECT_EQ(features.avx512f && features.avx512bw && features.avx2 && features.fma, hasAvx512());
+    EXPECT_EQ(features.avx2 && features.fma, hasAvx2());
+    EXPECT_EQ(hasAvx512(), (Traits<Isa::Avx512, float>::available()));
+    EXPECT_EQ(hasAvx512(), (Traits<Isa::Avx512, double>::available()));
+    EXPECT_EQ(hasAvx512(), (Traits<Isa::Avx512, int16_t>::available()));
+    EXPECT_EQ(hasAvx512(), (Traits<Isa::Avx512, int32_t>::available()));
+    EXPECT_EQ(hasAvx512(), (ComplexTraits<Isa::Avx512, float>::available()));
+    EXPECT_EQ(hasAvx2(), (Traits<Isa::Avx2, float>::available()));
+    EXPECT_EQ(hasAvx2(), (ComplexTraits<Isa::Avx2, double>::available()));
+    EXPECT_EQ(hasAvx512(), detectedIsa() == Isa::Avx512);
+    if (!hasAvx512()) {
+        EXPECT_LE(activeIsa(), Isa::Avx2);
+    }
+}
+
+TEST(Simd, MaxIsa) {
+    // An ISA sweep puts the limit back the way it found it
+    using namespace MatrixDSP::simd;
+    MatrixDspTests::IsaScope outer;
+    setMaxIsa(Isa::Avx2);
+    EXPECT_EQ(Isa::Avx2, maxIsa());
+    {
+        MatrixDspTests::IsaScope inner;
+        setMaxIsa(Isa::Scalar);
+        EXPECT_EQ(Isa::Scalar, activeIsa());
+    }
+    EXPECT_EQ(Isa::Avx2, maxIsa());
+    EXPECT_LE(activeIsa(), Isa::Avx2);
+}
+
+TEST(Simd, Float) {
+    checkBinary<float, MatrixDSP::simd::Add>();
+    checkBinary<float, MatrixDSP::simd::Sub>();
+    checkBinary<float, MatrixDSP::simd::Mul>();
+    checkBinary<float, MatrixDSP::simd::Div>();
+}
+
+TEST(Simd, Double) {
+    checkBinary<double, MatrixDSP::simd::Add>();
+    checkBinary<double, MatrixDSP::simd::Sub>();
+    checkBinary<double, MatrixDSP::simd::Mul>();
+    checkBinary<double, MatrixDSP::simd::Div>();
+}
+
+TEST(Simd, Int16) {
+    checkBinary<int16_t, MatrixDSP::simd::Add>();
+    checkBinary<int16_t, MatrixDSP::simd::Sub>();
+    checkBinary<int16_t, MatrixDSP::simd::Mul>();
+    checkBinary<int16_t, MatrixDSP::simd::Div>();
+}
+
+TEST(Simd, Int32) {
+    checkBinary<int32_t, MatrixDSP::simd::Add>();
+    checkBinary<int32_t, MatrixDSP::simd::Sub>();
+    checkBinary<int32_t, MatrixDSP::simd::Mul>();
+    checkBinary<int32_t, MatrixDSP::simd::Div>();
+}
+
+TEST(Simd, Int32_MultiplyWraps) {
+    MatrixDspTests::IsaScope isaScope;
+    std::vector<int32_t> a = {0x12345678, -7, 65536, 46341, 3};
+    std::vector<int32_t> b = {0x10, 9, 65536, 46341, -5};
+    std::vector<int32_t> out(a.size());
+    for (MatrixDSP::simd::Isa isa : allIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        MatrixDSP::simd::binary<MatrixDSP::simd::Mul>(out.data(), a.data(), b.data(), a.size());
+        for (unsigned index=0; index<a.size(); index++) {
+            EXPECT_EQ((int32_t) ((uint32_t) a[index] * (uint32_t) b[index]), out[index]);
+        }
+    }
+}
+
+TEST(Simd, VectorOperators) {
+    MatrixDSP::Vector<int16_t> buf1(40);
+    MatrixDSP::Vector<int16_t> buf2(40);
+    for (unsigned index=0; index<40; index++) {
+        buf1[index] = (int16_t) index;
+        buf2[index] = (int16_t) (2 * index + 1);
+    }
+
+    buf1 *= buf2;
+    buf1 -= (int16_t) 1;
+    for (unsigned index=0; index<40; index++) {
+        EXPECT_EQ((int16_t) (index * (2 * index + 1) - 1), buf1[index]);
+    }
+}
+
+TEST(Simd, FftButterflies_Float) {
+    checkFft<float>(1e-5);
+}
+
+TEST(Simd, FftButterflies_Double) {
+    checkFft<double>(1e-12);
+}
@@ -0,0 +1,168 @@
+//
+//  TestHelpers.h
+//  MatrixDspTests
+//
+//  Test signals, brute force references and the instruction set sweep that the filter and
+//  transform tests share.
+//
+
+#ifndef TestHelpers_h
+#define TestHelpers_h
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <vector>
+#include "Simd.h"
+
+namespace MatrixDspTests {
+
+/*****************************************************************************************
+                                    Instruction sets
+*****************************************************************************************/
+/**
+ * \brief The instruction sets that the kernels come in.  Loop over them with setMaxIsa() inside
+ *      an IsaScope.
+ */
+const MatrixDSP::simd::Isa testIsas[] = {MatrixDSP::simd::Isa::Scalar, MatrixDSP::simd::Isa::Avx2,
+                                         MatrixDSP::simd::Isa::Avx512};
+
+/**
+ * \brief Puts the instruction set limit back the way it was when it goes out of scope, so a
+ *      test that sweeps the instruction sets leaves the next test as it found it, even if an
+ *      ASSERT returns early.
+ */
+class IsaScope {
+    MatrixDSP::simd::Isa previous;
+
+public:
+    IsaScope() : previous(MatrixDSP::simd::maxIsa()) {}
+    ~IsaScope() {MatrixDSP::simd::setMaxIsa(previous);}
+    IsaScope(const IsaScope &) = delete;
+    IsaScope & operator=(const IsaScope &) = delete;
+};
+
+/*****************************************************************************************
+                                        Signals
+*****************************************************************************************/
+/**
+ * \brief Sample "index" of a signal with no simple structure: two incommensurate tones, complex
+ *      for complex types.
+ */
+template <class T>
+T testValue(unsigned index);
+
+template <>
+inline float testValue<float>(unsigned index) {return std::sin(index * 0.37f) + 0.5f * std::cos(index * 1.9f);}
+
+template <>
+inline double testValue<double>(unsigned index) {return std::sin(index * 0.37) + 0.5 * std::cos(index * 1.9);}
+
+template <>
+inline std::complex<float> testValue< std::complex<float> >(unsigned index) {
+    return std::complex<float>(std::sin(index * 0.37f), std::cos(index * 0.11f) - 0.25f);
+}
+
+template <>
+inline std::complex<double> testValue< std::complex<double> >(unsigned index) {
+    return std::complex<double>(std::sin(index * 0.37), std::cos(index * 0.11) - 0.25);
+}
+
+/**
+ * \brief Returns "len" samples of testValue() starting at sample "offset", in any container
+ *      that can be constructed with a size and indexed.
+ */
+template <class V>
+V testSignal(unsigned len, unsigned offset = 0) {
+    typedef typename std::decay<decltype(std::declval<V &>()[0])>::type T;
+    V signal(len);
+    for (unsigned index = 0; index < len; index++) {
+        signal[index] = testValue<T>(index + offset);
+    }
+    return signal;
+}
+
+/*****************************************************************************************
+                                    Brute force references
+*****************************************************************************************/
+/**
+ * \brief Upsamples by "interpolation", filters with "taps" and keeps every "decimation"-th
+ *      sample, the long way.
+ */
+template <class T, class Tap>
+std::vector<T> resampleReference(const std::vector<T> &input, const std::vector<Tap> &taps, unsigned interpolation,
+                                 unsigned decimation) {
+    std::vector<T> upsampled(input.size() * interpolation);
+    for (unsigned index = 0; index < input.size(); index++) {
+        upsampled[index * interpolation] = input[index];
+    }
+    std::vector<T> output;
+    for (unsigned time = 0; time < upsampled.size(); time += decimation) {
+        T sum = T();
+        for (unsigned tap = 0; tap < taps.size() && tap <= time; tap++) {
+            sum += taps[tap] * upsampled[time - tap];
+        }
+        output.push_back(sum);
+    }
+    return output;
+}
+
+/**
+ * \brief Filters "input" with "taps", starting from silence, the long way.
+ */
+template <class T, class Tap>
+std::vector<T> filterReference(const std::vector<T> &input, const std::vector<Tap> &taps) {
+    return resampleReference(input, taps, 1, 1);
+}
+
+/**
+ * \brief The full linear convolution of "a" and "b", in type V.
+ */
+template <class V, class A, class B>
+std::vector<V> convReference(const A &a, const B &b) {
+    std::vector<V> output(a.size() + b.size() - 1);
+    for (unsigned i = 0; i < a.size(); i++) {
+        for (unsigned j = 0; j < b.size(); j++) {
+            output[i + j] += V(a[i]) * V(b[j]);
+        }
+    }
+    return output;
+}
+
+/**
+ * \brief The DFT the long way, with the twiddle index reduced mod N so it stays exact.
+ */
+template <class V>
+std::vector< std::complex<double> > dftReference(const V &input, bool inverse) {
+    const unsigned len = input.size();
+    std::vector< std::complex<double> > twiddles(len), output(len);
+    for (unsigned index = 0; index < len; index++) {
+        twiddles[index] = std::polar(1.0, (inverse ? 2 : -2) * M_PI * index / len);
+    }
+    for (unsigned k = 0; k < len; k++) {
+        std::complex<double> sum;
+        for (unsigned n = 0; n < len; n++) {
+            sum += std::complex<double>(input[n]) * twiddles[(unsigned long long) n * k % len];
+        }
+        output[k] = sum;
+    }
+    return output;
+}
+
+/**
+ * \brief The largest error of "actual" relative to the RMS of "expected".
+ */
+template <class V>
+double relativeError(const std::vector< std::complex<double> > &expected, const V &actual) {
+    double power = 0, error = 0;
+    for (unsigned index = 0; index < expected.size(); index++) {
+        power += std::norm(expected[index]);
+        error = std::max(error, std::abs(expected[index] - std::complex<double>(actual[index])));
+    }
+    return error / std::sqrt(power / expected.size());
+}
+
+}
+
+#endif /* TestHelpers_h */
@@ -0,0 +1,69 @@
+//
+//  ThreadPoolTest.cpp
+//  MatrixDspTests
+//
+
+#include "ThreadPool.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <vector>
+
+TEST(ThreadPool, ParallelFor) {
+    for (unsigned numThreads : {1u, 2u, 4u, 7u}) {
+        MatrixDSP::ThreadPool pool(numThreads);
+        EXPECT_EQ(numThreads, pool.size());
+        for (std::size_t numTasks : {0u, 1u, 3u, 100u, 1000u}) {
+            std::vector< std::atomic<int> > calls(numTasks);
+            for (auto &count : calls) {
+                count = 0;
+            }
+            pool.parallelFor(numTasks, [&calls](std::size_t index) {calls[index]++;});
+            for (std::size_t index = 0; index < numTasks; index++) {
+                EXPECT_EQ(1, calls[index].load()) << numThreads << " threads, " << numTasks << " tasks, index " << index;
+            }
+        }
+    }
+}
+
+TEST(ThreadPool, UnevenTasks) {
+    // The expensive tasks are all at the start, so they land in the same queue and have to be
+    // stolen to finish in reasonable time
+    MatrixDSP::ThreadPool pool(4);
+    std::vector<double> results(64);
+    pool.parallelFor(results.size(), [&results](std::size_t index) {
+        unsigned iterations = index < 8 ? 200000 : 100;
+        double sum = 0;
+        for (unsigned iter = 0; iter < iterations; iter++) {
+            sum += 1.0 / (iter + index + 1);
+        }
+        results[index] = sum;
+    });
+    for (std::size_t index = 0; index < results.size(); index++) {
+        EXPECT_LT(0, results[index]);
+    }
+}
+
+TEST(ThreadPool, Nested) {
+    MatrixDSP::ThreadPool pool(3);
+    std::atomic<int> total(0);
+    pool.parallelFor(6, [&pool, &total](std::size_t) {
+        pool.parallelFor(10, [&total](std::size_t index) {total += (int) index;});
+    });
+    EXPECT_EQ(6 * 45, total.load());
+}
+
+TEST(ThreadPool, Affinity) {
+    MatrixDSP::ThreadPool pool(3, {0});
+    std::atomic<int> count(0);
+    pool.parallelFor(50, [&count](std::size_t) {count++;});
+    EXPECT_EQ(50, count.load());
+}
+
+TEST(ThreadPool, DefaultPool) {
+    MatrixDSP::ThreadPool pool(2);
+    MatrixDSP::setDefaultThreadPool(&pool);
+    EXPECT_EQ(&pool, &MatrixDSP::defaultThreadPool());
+    MatrixDSP::setDefaultThreadPool(nullptr);
+    EXPECT_NE(&pool, &MatrixDSP::defaultThreadPool());
+    EXPECT_EQ(MatrixDSP::ThreadPool::hardwareThreads(), MatrixDSP::defaultThreadPool().size());
+}
@@ -0,0 +1,199 @@
+//
+//  TranscendentalTest.cpp
+//  MatrixDspTests
+//
+
+#include "ComplexVector.h"
+#include "TestHelpers.h"
+#include "Transcendental.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+// The error of "actual" in units in the last place of "expected" rounded to T
+template <class T>
+double ulpError(T actual, long double expected) {
+    T rounded = (T) expected;
+    if (std::isinf(rounded) || rounded == 0) {
+        return actual == rounded ? 0 : std::numeric_limits<double>::infinity();
+    }
+    T ulp = std::nextafter(std::fabs(rounded), std::numeric_limits<T>::infinity()) - std::fabs(rounded);
+    return (double) (std::fabs(actual - expected) / ulp);
+}
+
+// Positive finite numbers with random bit patterns, so every exponent is covered
+template <class T>
+std::vector<T> randomPositive(unsigned n) {
+    std::mt19937_64 generator(1);
+    std::vector<T> values(n);
+    for (T &value : values) {
+        do {
+            uint64_t bits = generator() >> (65 - 8 * sizeof(T));
+            std::memcpy(&value, &bits, sizeof(T));
+        } while (!std::isfinite(value) || value == 0);
+    }
+    return values;
+}
+
+template <class T>
+std::vector<T> randomUniform(unsigned n, T low, T high) {
+    std::mt19937_64 generator(2);
+    std::uniform_real_distribution<T> distribution(low, high);
+    std::vector<T> values(n);
+    for (T &value : values) {
+        value = distribution(generator);
+    }
+    return values;
+}
+
+template <class T>
+void checkAccuracy(T expLimit) {
+    MatrixDspTests::IsaScope isaScope;
+    const unsigned len = 100003;
+    std::vector<T> exponents = randomUniform<T>(len, -expLimit, expLimit);
+    std::vector<T> positives = randomPositive<T>(len);
+    std::vector<T> bases = randomUniform<T>(len, 0.01f, 100);
+    std::vector<T> output(len);
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        double expError = 0, logError = 0, log10Error = 0, powError = 0;
+        MatrixDSP::simd::exp(exponents.data(), output.data(), len);
+        for (unsigned index = 0; index < len; index++) {
+            expError = std::max(expError, ulpError(output[index], std::exp((long double) exponents[index])));
+        }
+        MatrixDSP::simd::log(positives.data(), output.data(), len);
+        for (unsigned index = 0; index < len; index++) {
+            logError = std::max(logError, ulpError(output[index], std::log((long double) positives[index])));
+        }
+        MatrixDSP::simd::log10(positives.data(), output.data(), len);
+        for (unsigned index = 0; index < len; index++) {
+            log10Error = std::max(log10Error, ulpError(output[index], std::log10((long double) positives[index])));
+        }
+        for (T exponent : {(T) 2, (T) 0.5, (T) -1.7, (T) 13.25}) {
+            MatrixDSP::simd::pow(bases.data(), output.data(), len, exponent);
+            for (unsigned index = 0; index < len; index++) {
+                powError = std::max(powError, ulpError(output[index], std::pow((long double) bases[index], (long double) exponent)));
+            }
+        }
+        EXPECT_LE(expError, 1);
+        EXPECT_LE(logError, 1);
+        EXPECT_LE(log10Error, 2);
+        EXPECT_LE(powError, 1);
+    }
+}
+
+template <class T>
+void checkSpecialValues() {
+    MatrixDspTests::IsaScope isaScope;
+    const T inf = std::numeric_limits<T>::infinity();
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    const T denormMin = std::numeric_limits<T>::denorm_min();
+    std::vector<T> input = {0, (T) -0.0, 1, -1, inf, -inf, nan, denormMin, std::numeric_limits<T>::min() / 3,
+                            std::numeric_limits<T>::max(), 1000, -1000, std::log(std::numeric_limits<T>::min()) - 3};
+    std::vector<T> output(input.size());
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        MatrixDSP::simd::exp(input.data(), output.data(), input.size());
+        for (unsigned index = 0; index < input.size(); index++) {
+            T expected = std::exp(input[index]);
+            if (std::isnan(expected)) {
+                EXPECT_TRUE(std::isnan(output[index])) << index;
+            }
+            else {
+                EXPECT_LE(ulpError(output[index], expected), 1) << index;
+            }
+        }
+        MatrixDSP::simd::log(input.data(), output.data(), input.size());
+        for (unsigned index = 0; index < input.size(); index++) {
+            T expected = std::log(input[index]);
+            if (std::isnan(expected)) {
+                EXPECT_TRUE(std::isnan(output[index])) << index;
+            }
+            else {
+                EXPECT_LE(ulpError(output[index], expected), 1) << index;
+            }
+        }
+        std::vector<T> bases = {-2, 0, (T) -0.0, inf, -inf, nan, 1, 4};
+        for (T exponent : {(T) 3, (T) -2, (T) 0.5, (T) 0}) {
+            MatrixDSP::simd::pow(bases.data(), output.data(), bases.size(), exponent);
+            for (unsigned index = 0; index < bases.size(); index++) {
+                T expected = std::pow(bases[index], exponent);
+                if (std::isnan(expected)) {
+                    EXPECT_TRUE(std::isnan(output[index])) << index;
+                }
+                else {
+                    EXPECT_EQ(expected, output[index]) << index;
+                }
+            }
+        }
+    }
+}
+
+}
+
+TEST(Transcendental, Accuracy) {
+    checkAccuracy<float>(88);
+    checkAccuracy<double>(700);
+}
+
+TEST(Transcendental, SpecialValues) {
+    checkSpecialValues<float>();
+    checkSpecialValues<double>();
+}
+
+TEST(Transcendental, Abs) {
+    MatrixDspTests::IsaScope isaScope;
+    std::vector<double> input = randomUniform<double>(37, -10, 10);
+    input.push_back(-0.0);
+    std::vector<double> output(input.size());
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        MatrixDSP::simd::abs(input.data(), output.data(), input.size());
+        for (unsigned index = 0; index < input.size(); index++) {
+            EXPECT_EQ(std::abs(input[index]), output[index]);
+            EXPECT_FALSE(std::signbit(output[index]));
+        }
+    }
+}
+
+TEST(Transcendental, PowerDb) {
+    MatrixDspTests::IsaScope isaScope;
+    // Every length up to a few registers, so the partial last register is covered
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        for (unsigned len = 0; len < 40; len++) {
+            MatrixDSP::ComplexVector<float> input(len);
+            for (unsigned index = 0; index < len; index++) {
+                input[index] = std::complex<float>(std::cos(index * 0.7f) * (index + 1), std::sin(index * 1.3f) * 1e-3f);
+            }
+            if (len > 5) {
+                input[5] = 0;
+            }
+            MatrixDSP::Vector<float> output;
+            MatrixDSP::powerDb(input, output);
+            EXPECT_EQ(len, output.size());
+            for (unsigned index = 0; index < len; index++) {
+                float power = std::norm(input[index]);
+                if (power == 0) {
+                    EXPECT_EQ(-std::numeric_limits<float>::infinity(), output[index]);
+                }
+                else {
+                    EXPECT_NEAR(10 * std::log10((double) power), output[index], 2e-5);
+                }
+            }
+        }
+    }
+
+    MatrixDSP::ComplexVector<double> input({{3, 4}, {0.1, 0}, {0, -1e-3}});
+    MatrixDSP::Vector<double> output;
+    input.powerDb(output);
+    EXPECT_NEAR(20 * std::log10(5.0), output[0], 1e-13);
+    EXPECT_NEAR(-20, output[1], 1e-13);
+    EXPECT_NEAR(-60, output[2], 1e-13);
+}
@@ -6,6 +6,7 @@
 //
 
 #include "VectorMatrix.h"
+#include "TestHelpers.h"
 #include "gtest/gtest.h"
 
 
@@ -70,3 +71,376 @@ TEST(VectorMatrix, MatrixMatrixMult) {
     EXPECT_EQ(79, result(1, 1));
 }
 
+
+namespace {
+
+template <class T>
+MatrixDSP::Matrix2d< std::complex<T> > testSignals(unsigned rows, unsigned cols) {
+    MatrixDSP::Matrix2d< std::complex<T> > mat(rows, cols);
+    for (unsigned row=0; row<rows; row++) {
+        for (unsigned col=0; col<cols; col++) {
+            mat(row, col) = std::complex<T>((T) std::sin(0.3 * row + 0.11 * col * col), (T) std::cos(0.05 * row * col + col));
+        }
+    }
+    return mat;
+}
+
+// Checks fftRows() and fftCols() against a ComplexVector::fft() of each channel
+template <class T>
+void checkMatrixFft(unsigned fftLen, unsigned numChannels, bool inverse, double tolerance) {
+    MatrixDSP::Matrix2d< std::complex<T> > byRow = testSignals<T>(numChannels, fftLen);
+    MatrixDSP::Matrix2d< std::complex<T> > byCol = testSignals<T>(fftLen, numChannels);
+    MatrixDSP::Matrix2d<T> realByRow(numChannels, fftLen);
+    for (unsigned row=0; row<numChannels; row++) {
+        for (unsigned col=0; col<fftLen; col++) {
+            realByRow(row, col) = byRow(row, col).real();
+        }
+    }
+
+    MatrixDSP::Matrix2d< std::complex<T> > rowsOut, colsOut, realRowsOut;
+    fftRows(byRow, rowsOut, inverse);
+    fftCols(byCol, colsOut, inverse);
+    fftRows(realByRow, realRowsOut, inverse);
+    ASSERT_EQ(numChannels, rowsOut.getRows());
+    ASSERT_EQ(fftLen, rowsOut.getCols());
+    ASSERT_EQ(fftLen, colsOut.getRows());
+    ASSERT_EQ(numChannels, colsOut.getCols());
+
+    for (unsigned channel=0; channel<numChannels; channel++) {
+        MatrixDSP::ComplexVector<T> rowIn(fftLen), colIn(fftLen), realIn(fftLen), rowExpected, colExpected, realExpected;
+        for (unsigned n=0; n<fftLen; n++) {
+            rowIn[n] = byRow(channel, n);
+            colIn[n] = byCol(n, channel);
+            realIn[n] = realByRow(channel, n);
+        }
+        rowExpected.fft(rowIn, inverse);
+        colExpected.fft(colIn, inverse);
+        realExpected.fft(realIn, inverse);
+        for (unsigned n=0; n<fftLen; n++) {
+            EXPECT_NEAR(0, std::abs(rowExpected[n] - rowsOut(channel, n)), tolerance) << "len " << fftLen << ", channel " << channel << ", bin " << n;
+            EXPECT_NEAR(0, std::abs(colExpected[n] - colsOut(n, channel)), tolerance) << "len " << fftLen << ", channel " << channel << ", bin " << n;
+            EXPECT_NEAR(0, std::abs(realExpected[n] - realRowsOut(channel, n)), tolerance) << "len " << fftLen << ", channel " << channel << ", bin " << n;
+        }
+    }
+}
+
+}
+
+TEST(VectorMatrix, ExpressionMult) {
+    // Products with expressions, which used to be products with temporaries
+    MatrixDSP::Matrix2d<float> mat({{1, 2}, {3, 4}});
+    MatrixDSP::Vector<float> col({1, 1});
+    MatrixDSP::Vector<float> row({1, 1}, true);
+    
+    MatrixDSP::Vector<float> result = (mat + mat) * col;
+    EXPECT_EQ(MatrixDSP::Vector<float>({6, 14}).vec, result.vec);
+    result = mat * (col + col);
+    EXPECT_EQ(MatrixDSP::Vector<float>({6, 14}).vec, result.vec);
+    result = (mat * 2.0f) * (col * 2.0f);
+    EXPECT_EQ(MatrixDSP::Vector<float>({12, 28}).vec, result.vec);
+    result = (row + row) * mat;
+    EXPECT_EQ(MatrixDSP::Vector<float>({8, 12}).vec, result.vec);
+    EXPECT_EQ(true, result.rowVector);
+    result = row * (mat - mat);
+    EXPECT_EQ(MatrixDSP::Vector<float>({0, 0}).vec, result.vec);
+    
+    MatrixDSP::Matrix2d<float> product = (mat + mat) * mat;
+    EXPECT_EQ(14, product(0, 0));
+    EXPECT_EQ(44, product(1, 1));
+    product = mat * (mat + mat);
+    EXPECT_EQ(30, product(1, 0));
+    product = (mat + mat) * (mat + mat);
+    EXPECT_EQ(88, product(1, 1));
+}
+
+TEST(VectorMatrix, FftRowsCols) {
+    // Radix 2, 3, 4 and 5 stages, a radix 7 stage that uses the generic butterfly and a prime
+    // length that uses Bluestein's algorithm, with channel counts that give full and partial batches
+    for (unsigned fftLen : {2u, 16u, 60u, 112u, 125u, 127u}) {
+        for (unsigned numChannels : {1u, 3u, 16u, 37u}) {
+            checkMatrixFft<float>(fftLen, numChannels, false, 1e-4 * fftLen);
+            checkMatrixFft<double>(fftLen, numChannels, true, 1e-11 * fftLen);
+        }
+    }
+}
+
+TEST(VectorMatrix, FftRowsCols_AllIsas) {
+    MatrixDspTests::IsaScope isaScope;
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        checkMatrixFft<float>(240, 21, false, 1e-4 * 240);
+        checkMatrixFft<double>(240, 21, true, 1e-11 * 240);
+    }
+}
+
+TEST(VectorMatrix, FftRowsCols_InPlace) {
+    MatrixDSP::Matrix2d< std::complex<float> > mat = testSignals<float>(20, 32);
+    MatrixDSP::Matrix2d< std::complex<float> > rowsOut, colsOut;
+    fftRows(mat, rowsOut);
+    fftCols(mat, colsOut);
+
+    MatrixDSP::Matrix2d< std::complex<float> > inPlace = mat;
+    fftRows(inPlace, inPlace);
+    for (unsigned row=0; row<20; row++) {
+        for (unsigned col=0; col<32; col++) {
+            EXPECT_EQ(rowsOut(row, col), inPlace(row, col));
+        }
+    }
+    inPlace = mat;
+    fftCols(inPlace, inPlace);
+    for (unsigned row=0; row<20; row++) {
+        for (unsigned col=0; col<32; col++) {
+            EXPECT_EQ(colsOut(row, col), inPlace(row, col));
+        }
+    }
+}
+
+namespace {
+
+template <class T>
+T gemmTestValue(unsigned row, unsigned col, double seed, T) {
+    return (T) std::sin(seed + 0.37 * row + 0.71 * col);
+}
+
+template <class T>
+std::complex<T> gemmTestValue(unsigned row, unsigned col, double seed, std::complex<T>) {
+    return std::complex<T>((T) std::sin(seed + 0.37 * row + 0.71 * col), (T) std::cos(seed * row - 0.23 * col));
+}
+
+template <class T>
+MatrixDSP::Matrix2d<T> gemmTestMatrix(unsigned rows, unsigned cols, double seed) {
+    MatrixDSP::Matrix2d<T> mat(rows, cols);
+    for (unsigned row=0; row<rows; row++) {
+        for (unsigned col=0; col<cols; col++) {
+            mat(row, col) = gemmTestValue(row, col, seed, T());
+        }
+    }
+    return mat;
+}
+
+// Checks operator* against a straightforward triple loop, with sizes that give ragged edges
+// and that span several blocks
+template <class T>
+void checkGemm(double tolerance) {
+    const unsigned sizes[][3] = {{1, 1, 1}, {2, 3, 4}, {7, 13, 50}, {37, 41, 300}, {130, 70, 33}, {64, 64, 64}, {300, 20, 20}};
+    for (auto &size : sizes) {
+        unsigned m = size[0], n = size[1], k = size[2];
+        MatrixDSP::Matrix2d<T> lhs = gemmTestMatrix<T>(m, k, 0.5);
+        MatrixDSP::Matrix2d<T> rhs = gemmTestMatrix<T>(k, n, 1.5);
+        MatrixDSP::Matrix2d<T> result = lhs * rhs;
+        ASSERT_EQ(m, result.getRows());
+        ASSERT_EQ(n, result.getCols());
+        for (unsigned row=0; row<m; row++) {
+            for (unsigned col=0; col<n; col++) {
+                T expected = T();
+                for (unsigned p=0; p<k; p++) {
+                    expected += lhs(row, p) * rhs(p, col);
+                }
+                EXPECT_NEAR(0, std::abs(expected - result(row, col)), tolerance * k) << m << "x" << n << "x" << k << " (" << row << ", " << col << ")";
+            }
+        }
+    }
+}
+
+}
+
+TEST(VectorMatrix, MatrixMatrixMult_Gemm) {
+    MatrixDspTests::IsaScope isaScope;
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        checkGemm<float>(1e-5);
+        checkGemm<double>(1e-13);
+        checkGemm< std::complex<float> >(1e-5);
+        checkGemm< std::complex<double> >(1e-13);
+    }
+}
+
+TEST(VectorMatrix, MatrixMatrixMult_Int) {
+    MatrixDSP::Matrix2d<int> lhs(20, 30);
+    for (unsigned row=0; row<20; row++) {
+        for (unsigned col=0; col<30; col++) {
+            lhs(row, col) = (int) (row * 3 + col) % 7 - 3;
+        }
+    }
+    MatrixDSP::Matrix2d<int> rhs(30, 25);
+    for (unsigned row=0; row<30; row++) {
+        for (unsigned col=0; col<25; col++) {
+            rhs(row, col) = (int) (row + col * 5) % 11 - 5;
+        }
+    }
+    MatrixDSP::Matrix2d<int> result = lhs * rhs;
+    for (unsigned row=0; row<20; row++) {
+        for (unsigned col=0; col<25; col++) {
+            int expected = 0;
+            for (unsigned p=0; p<30; p++) {
+                expected += lhs(row, p) * rhs(p, col);
+            }
+            EXPECT_EQ(expected, result(row, col));
+        }
+    }
+}
+
+TEST(VectorMatrix, Gemm_LeadingDimensions) {
+    // Multiply the interior blocks of larger matrices
+    MatrixDSP::Matrix2d<float> big = gemmTestMatrix<float>(50, 60, 0.25);
+    MatrixDSP::Matrix2d<float> out(45, 55);
+    std::fill(out.data(), out.data() + 45 * 55, -1.0f);
+    const unsigned m = 30, n = 40, k = 20;
+    MatrixDSP::simd::gemm<float>(m, n, k, big.data() + 2 * 60 + 3, 60, big.data() + 5 * 60 + 7, 60, out.data() + 55 + 1, 55);
+    for (unsigned row=0; row<45; row++) {
+        for (unsigned col=0; col<55; col++) {
+            if (row < 1 || row >= 1 + m || col < 1 || col >= 1 + n) {
+                EXPECT_EQ(-1, out(row, col));
+                continue;
+            }
+            float expected = 0;
+            for (unsigned p=0; p<k; p++) {
+                expected += big(2 + row - 1, 3 + p) * big(5 + p, 7 + col - 1);
+            }
+            EXPECT_NEAR(expected, out(row, col), 1e-4);
+        }
+    }
+}
+
+namespace {
+
+// Checks the four matrix-vector products against straightforward loops
+template <class T>
+void checkGemv(unsigned rows, unsigned cols, double tolerance) {
+    MatrixDSP::Matrix2d<T> mat = gemmTestMatrix<T>(rows, cols, 0.75);
+    MatrixDSP::Vector<T> colVec(cols, false), rowVec(rows, true);
+    MatrixDSP::ComplexVector<T> complexColVec(cols, false), complexRowVec(rows, true);
+    for (unsigned col=0; col<cols; col++) {
+        colVec[col] = gemmTestValue(col, 0, 2.0, T());
+        complexColVec[col] = gemmTestValue(col, 1, 2.5, std::complex<T>());
+    }
+    for (unsigned row=0; row<rows; row++) {
+        rowVec[row] = gemmTestValue(row, 2, 3.0, T());
+        complexRowVec[row] = gemmTestValue(row, 3, 3.5, std::complex<T>());
+    }
+
+    MatrixDSP::Vector<T> matVec = mat * colVec;
+    MatrixDSP::ComplexVector<T> matComplexVec = mat * complexColVec;
+    MatrixDSP::Vector<T> vecMat = rowVec * mat;
+    MatrixDSP::ComplexVector<T> complexVecMat = complexRowVec * mat;
+    ASSERT_EQ(rows, matVec.size());
+    ASSERT_EQ(rows, matComplexVec.size());
+    ASSERT_EQ(cols, vecMat.size());
+    ASSERT_EQ(cols, complexVecMat.size());
+
+    for (unsigned row=0; row<rows; row++) {
+        T expected = 0;
+        std::complex<T> complexExpected = 0;
+        for (unsigned col=0; col<cols; col++) {
+            expected += mat(row, col) * colVec[col];
+            complexExpected += mat(row, col) * complexColVec[col];
+        }
+        EXPECT_NEAR(expected, matVec[row], tolerance * cols) << rows << "x" << cols << ", row " << row;
+        EXPECT_NEAR(0, std::abs(complexExpected - matComplexVec[row]), tolerance * cols) << rows << "x" << cols << ", row " << row;
+    }
+    for (unsigned col=0; col<cols; col++) {
+        T expected = 0;
+        std::complex<T> complexExpected = 0;
+        for (unsigned row=0; row<rows; row++) {
+            expected += rowVec[row] * mat(row, col);
+            complexExpected += complexRowVec[row] * mat(row, col);
+        }
+        EXPECT_NEAR(expected, vecMat[col], tolerance * rows) << rows << "x" << cols << ", col " << col;
+        EXPECT_NEAR(0, std::abs(complexExpected - complexVecMat[col]), tolerance * rows) << rows << "x" << cols << ", col " << col;
+    }
+}
+
+}
+
+TEST(VectorMatrix, MatrixVectorMult_Gemv) {
+    MatrixDspTests::IsaScope isaScope;
+    const unsigned sizes[][2] = {{1, 1}, {3, 5}, {8, 16}, {13, 37}, {64, 100}, {101, 7}};
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        for (auto &size : sizes) {
+            checkGemv<float>(size[0], size[1], 1e-6);
+            checkGemv<double>(size[0], size[1], 1e-14);
+        }
+    }
+}
+
+TEST(VectorMatrix, PaddedRows) {
+    MatrixDSP::Matrix2d<double> lhs = gemmTestMatrix<double>(13, 37, 0.5);
+    MatrixDSP::Matrix2d<double> rhs = gemmTestMatrix<double>(37, 11, 1.5);
+    MatrixDSP::Matrix2d<double> paddedLhs = lhs, paddedRhs = rhs;
+    paddedLhs.padRows();
+    paddedRhs.padRows();
+
+    MatrixDSP::Matrix2d<double> expected = lhs * rhs;
+    MatrixDSP::Matrix2d<double> result = paddedLhs * paddedRhs;
+    EXPECT_TRUE(result.rowsPadded());
+    EXPECT_EQ(16u, result.ld());
+    for (unsigned row=0; row<13; row++) {
+        for (unsigned col=0; col<11; col++) {
+            EXPECT_NEAR(expected(row, col), result(row, col), 1e-12);
+        }
+    }
+
+    MatrixDSP::Vector<double> vec(37, false);
+    for (unsigned index=0; index<37; index++) {
+        vec[index] = index * 0.25;
+    }
+    MatrixDSP::Vector<double> matVec = lhs * vec, paddedMatVec = paddedLhs * vec;
+    for (unsigned index=0; index<13; index++) {
+        EXPECT_NEAR(matVec[index], paddedMatVec[index], 1e-12);
+    }
+    vec.vec.resize(13);
+    vec.rowVector = true;
+    MatrixDSP::Vector<double> vecMat = vec * lhs, paddedVecMat = vec * paddedLhs;
+    for (unsigned index=0; index<37; index++) {
+        EXPECT_NEAR(vecMat[index], paddedVecMat[index], 1e-12);
+    }
+
+    MatrixDSP::Matrix2d< std::complex<float> > signals = testSignals<float>(20, 30);
+    MatrixDSP::Matrix2d< std::complex<float> > paddedSignals = signals;
+    paddedSignals.padRows();
+    MatrixDSP::Matrix2d< std::complex<float> > rowsOut, colsOut, paddedRowsOut, paddedColsOut;
+    paddedRowsOut.padRows();
+    fftRows(signals, rowsOut);
+    fftCols(signals, colsOut);
+    fftRows(paddedSignals, paddedRowsOut);
+    fftCols(paddedSignals, paddedColsOut);
+    EXPECT_EQ(32u, paddedRowsOut.ld());
+    EXPECT_EQ(30u, paddedColsOut.ld());
+    fftCols(paddedSignals, paddedSignals);
+    for (unsigned row=0; row<20; row++) {
+        for (unsigned col=0; col<30; col++) {
+            EXPECT_EQ(rowsOut(row, col), paddedRowsOut(row, col));
+            EXPECT_EQ(colsOut(row, col), paddedColsOut(row, col));
+            EXPECT_EQ(colsOut(row, col), paddedSignals(row, col));
+        }
+    }
+}
+
+TEST(VectorMatrix, MatrixMatrixMult_Parallel) {
+    // Big enough to be split over the pool, with sizes that give ragged tiles
+    MatrixDSP::ThreadPool pool(4);
+    MatrixDSP::Matrix2d< std::complex<float> > lhs = gemmTestMatrix< std::complex<float> >(150, 131, 0.5);
+    MatrixDSP::Matrix2d< std::complex<float> > rhs = gemmTestMatrix< std::complex<float> >(131, 170, 1.5);
+    MatrixDSP::Matrix2d< std::complex<float> > serial(150, 170), parallel(150, 170);
+    MatrixDSP::simd::gemm(150, 170, 131, lhs.data(), 131, rhs.data(), 170, serial.data(), 170);
+    MatrixDSP::simd::gemm(150, 170, 131, lhs.data(), 131, rhs.data(), 170, parallel.data(), 170, pool);
+    for (unsigned row=0; row<150; row++) {
+        for (unsigned col=0; col<170; col++) {
+            EXPECT_EQ(serial(row, col), parallel(row, col)) << "(" << row << ", " << col << ")";
+        }
+    }
+
+    MatrixDSP::setDefaultThreadPool(&pool);
+    MatrixDSP::Matrix2d<double> dLhs = gemmTestMatrix<double>(200, 120, 0.5);
+    MatrixDSP::Matrix2d<double> dRhs = gemmTestMatrix<double>(120, 100, 1.5);
+    MatrixDSP::Matrix2d<double> dSerial(200, 100);
+    MatrixDSP::simd::gemm(200, 100, 120, dLhs.data(), 120, dRhs.data(), 100, dSerial.data(), 100);
+    MatrixDSP::Matrix2d<double> dResult = dLhs * dRhs;
+    MatrixDSP::setDefaultThreadPool(nullptr);
+    for (unsigned row=0; row<200; row++) {
+        for (unsigned col=0; col<100; col++) {
+            EXPECT_EQ(dSerial(row, col), dResult(row, col)) << "(" << row << ", " << col << ")";
+        }
+    }
+}
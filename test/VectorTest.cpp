@@ -1,4 +1,5 @@
 #include "Vector.h"
+#include "TestHelpers.h"
 #include "gtest/gtest.h"
 
 
@@ -50,6 +51,46 @@ TEST(VectorInit, Ctor_Initializer_List) {
     EXPECT_EQ(false, buf.rowVector);
 }
 
+TEST(VectorInit, Ctor_Move) {
+    static_assert(std::is_nothrow_move_constructible< MatrixDSP::Vector<float> >::value, "");
+    static_assert(std::is_nothrow_move_assignable< MatrixDSP::Vector<float> >::value, "");
+
+    MatrixDSP::Vector<float> buf({3, 4, 5}, true);
+    const float *data = buf.vec.data();
+
+    MatrixDSP::Vector<float> moved(std::move(buf));
+    EXPECT_EQ(data, moved.vec.data());
+    EXPECT_EQ(true, moved.rowVector);
+
+    MatrixDSP::Vector<float> assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(data, assigned.vec.data());
+    EXPECT_EQ(5, assigned[2]);
+
+    MatrixDSP::Vector<float> copy(assigned);
+    EXPECT_NE(data, copy.vec.data());
+    EXPECT_EQ(assigned.vec, copy.vec);
+}
+
+TEST(VectorInit, Aligned) {
+    for (unsigned size : {1u, 3u, 17u, 1000u}) {
+        MatrixDSP::Vector<float> floats(size);
+        MatrixDSP::Vector<double> doubles(size);
+        MatrixDSP::Vector<int16_t> shorts(size);
+        EXPECT_EQ(0u, (uintptr_t) floats.vec.data() % MatrixDSP::defaultAlignment);
+        EXPECT_EQ(0u, (uintptr_t) doubles.vec.data() % MatrixDSP::defaultAlignment);
+        EXPECT_EQ(0u, (uintptr_t) shorts.vec.data() % MatrixDSP::defaultAlignment);
+    }
+
+    // Any allocator can be used
+    std::vector<float> stdVec = {1, 2, 3};
+    MatrixDSP::Vector< float, std::allocator<float> > unaligned(&stdVec);
+    MatrixDSP::Vector<float> aligned(&stdVec);
+    aligned += unaligned;
+    EXPECT_EQ(6, aligned[2]);
+    EXPECT_EQ(2, unaligned.median());
+}
+
 TEST(VectorInit, Parenthesis_Indexing) {
     MatrixDSP::Vector<float> buf({3, 4, 5});
     
@@ -237,6 +278,75 @@ TEST(Operator, DivideScalar) {
     EXPECT_EQ(1.5f, buf2[2]);
 }
 
+TEST(Operator, FusedExpression) {
+    MatrixDSP::Vector<float> a({1, 2, 3}, true);
+    MatrixDSP::Vector<float> b({4, 5, 6});
+    MatrixDSP::Vector<float> c({7, 8, 9});
+    MatrixDSP::Vector<float> d({-1, 0, 1});
+    MatrixDSP::Vector<float> e({10, 20, 30});
+    
+    MatrixDSP::Vector<float> result = a*b + c*d - e / 2.0f;
+    EXPECT_EQ(3, result.size());
+    EXPECT_EQ(true, result.rowVector);
+    EXPECT_EQ(4 - 7 - 5, result[0]);
+    EXPECT_EQ(10 + 0 - 10, result[1]);
+    EXPECT_EQ(18 + 9 - 15, result[2]);
+}
+
+TEST(Operator, ExpressionAliasing) {
+    MatrixDSP::Vector<float> a({1, 2, 3});
+    MatrixDSP::Vector<float> b({4, 5, 6});
+    
+    a = b - a * 2.0f;
+    EXPECT_EQ(3, a.size());
+    EXPECT_EQ(2, a[0]);
+    EXPECT_EQ(1, a[1]);
+    EXPECT_EQ(0, a[2]);
+}
+
+TEST(Operator, ExpressionMixedTypes) {
+    MatrixDSP::Vector<int16_t> a({100, 200, 300});
+    MatrixDSP::Vector<float> b({0.5, 0.25, 2});
+    
+    MatrixDSP::Vector<int16_t> result = a * b + (int16_t) 1;
+    EXPECT_EQ(51, result[0]);
+    EXPECT_EQ(51, result[1]);
+    EXPECT_EQ(601, result[2]);
+}
+
+TEST(Operator, ExpressionMethods) {
+    // Code written when the operators returned a Vector still compiles and gives the same answers
+    MatrixDSP::Vector<float> a({1, 2, 3, 4});
+    MatrixDSP::Vector<float> b({4, 3, 2, 1});
+    
+    EXPECT_EQ(20, (a + b).sum());
+    EXPECT_EQ(5, (a + b).mean());
+    EXPECT_EQ(0, (a + b).var());
+    EXPECT_EQ(6, (a * b).max());
+    EXPECT_EQ(-3, (a - b).min());
+    EXPECT_EQ(std::vector<unsigned>({2, 3}), find(a - b > 0.0f));
+    EXPECT_EQ(std::vector<unsigned>({0, 1}), ((a - b) < 0.0f).find());
+    
+    MatrixDSP::Vector<float> greater = (a - b) > 0.0f;
+    EXPECT_EQ(MatrixDSP::Vector<float>({0, 0, 1, 1}).vec, greater.vec);
+    MatrixDSP::Vector<float> equal = (a * 2.0f) == 4.0f;
+    EXPECT_EQ(MatrixDSP::Vector<float>({0, 1, 0, 0}).vec, equal.vec);
+    MatrixDSP::Vector<float> negated = -(a + b);
+    EXPECT_EQ(MatrixDSP::Vector<float>({-5, -5, -5, -5}).vec, negated.vec);
+    MatrixDSP::Vector<float> squared = (a - b).pow(2);
+    EXPECT_EQ(MatrixDSP::Vector<float>({9, 1, 1, 9}).vec, squared.vec);
+    MatrixDSP::Vector<float> absDiff = (a - b).abs();
+    EXPECT_EQ(MatrixDSP::Vector<float>({3, 1, 1, 3}).vec, absDiff.vec);
+    MatrixDSP::Vector<float> summed = (a + 1.0f).cumsum();
+    EXPECT_EQ(MatrixDSP::Vector<float>({2, 5, 9, 14}).vec, summed.vec);
+    EXPECT_EQ(8, (a + b).upsample(2).size());
+    EXPECT_EQ(5, (a + b)(2));
+    
+    // The operands are unchanged
+    EXPECT_EQ(MatrixDSP::Vector<float>({1, 2, 3, 4}).vec, a.vec);
+    EXPECT_EQ(MatrixDSP::Vector<float>({4, 3, 2, 1}).vec, b.vec);
+}
+
 TEST(Method, Find) {
     MatrixDSP::Vector<float> buf({5, 2, 3, 3, 4, 1});
 
@@ -296,6 +406,107 @@ TEST(Method, StdDev) {
     EXPECT_NEAR(1.2910f, MatrixDSP::stdDev(buf, false), .001);
 }
 
+TEST(Method, IntegerMeanVar) {
+    // Integer vectors are averaged in integer arithmetic, so the results are truncated.  stats()
+    // gives the exact ones.
+    MatrixDSP::Vector<int> buf({1, 2});
+    
+    EXPECT_EQ(3, buf.sum());
+    EXPECT_EQ(1, buf.mean());
+    EXPECT_EQ(1, buf.var());
+    EXPECT_EQ(0, buf.var(false));
+    EXPECT_EQ(1, buf.stdDev());
+    EXPECT_EQ(1.5, buf.stats().mean);
+    EXPECT_EQ(0.5, buf.stats().var);
+    
+    MatrixDSP::Vector<int16_t> shorts({-7, 2, 4});
+    EXPECT_EQ(-1, shorts.sum());
+    EXPECT_EQ(0, shorts.mean());
+    EXPECT_EQ(34, shorts.var());
+}
+
+TEST(Method, Stats) {
+    MatrixDspTests::IsaScope isaScope;
+    MatrixDSP::Vector<float> buf({5, 2, 3, 3, 4, 1, 5, 1});
+    MatrixDSP::Stats<float> stats = MatrixDSP::stats(buf);
+    EXPECT_EQ(24, stats.sum);
+    EXPECT_EQ(3, stats.mean);
+    EXPECT_NEAR(18.0f / 7, stats.var, .001);
+    EXPECT_NEAR(std::sqrt(18.0f / 7), stats.stdDev, .001);
+    // The first of equal values
+    EXPECT_EQ(1, stats.min);
+    EXPECT_EQ(5u, stats.minLoc);
+    EXPECT_EQ(5, stats.max);
+    EXPECT_EQ(0u, stats.maxLoc);
+
+    MatrixDSP::Vector<int> ints({-3, 7, 2});
+    MatrixDSP::Stats<int, double> intStats = ints.stats(false);
+    EXPECT_EQ(2.0, intStats.mean);
+    EXPECT_NEAR(50.0 / 3, intStats.var, 1e-12);
+    EXPECT_EQ(1u, intStats.maxLoc);
+
+    // Long enough for several blocks, with every kernel.  A large offset makes the
+    // one-pass sum-of-squares formula useless in float, and a running float sum drifts.
+    unsigned len = 100003;
+    MatrixDSP::Vector<float> data(len);
+    double sum = 0;
+    for (unsigned index=0; index<len; index++) {
+        data[index] = 10000.0f + (float) ((index * 37) % 101) / 8;
+        sum += data[index];
+    }
+    data[70001] = 20000;
+    data[90001] = 20000;
+    data[3] = -1;
+    sum += 20000 - (double) 10000.0f - (float) ((70001u * 37) % 101) / 8;
+    sum += 20000 - (double) 10000.0f - (float) ((90001u * 37) % 101) / 8;
+    sum += -1 - (double) 10000.0f - (float) ((3u * 37) % 101) / 8;
+    double mean = sum / len;
+    double m2 = 0;
+    for (float element : data) {
+        m2 += (element - mean) * (element - mean);
+    }
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        MatrixDSP::Stats<float> single = data.stats();
+        EXPECT_NEAR(1, single.sum / sum, 1e-6) << "isa " << (int) isa;
+        EXPECT_NEAR(1, single.var / (m2 / (len - 1)), 1e-4) << "isa " << (int) isa;
+        EXPECT_EQ(-1, single.min);
+        EXPECT_EQ(3u, single.minLoc);
+        EXPECT_EQ(20000, single.max);
+        EXPECT_EQ(70001u, single.maxLoc);
+
+        MatrixDSP::Stats<float, double> wide = data.stats<double>();
+        EXPECT_NEAR(1, wide.sum / sum, 1e-12) << "isa " << (int) isa;
+        EXPECT_NEAR(1, wide.var / (m2 / (len - 1)), 1e-9) << "isa " << (int) isa;
+        EXPECT_EQ(70001u, wide.maxLoc);
+        EXPECT_NEAR(wide.mean, data.mean(), 1e-3);
+    }
+}
+
+TEST(Method, StatsNaN) {
+    // A NaN at the start of a block is skipped, so the extremes later in that block still count
+    MatrixDspTests::IsaScope isaScope;
+    MatrixDSP::Vector<float> data(3000);
+    for (unsigned index=0; index<data.size(); index++) {
+        data[index] = 1;
+    }
+    data[1024] = std::numeric_limits<float>::quiet_NaN();
+    data[1500] = -100;
+    data[1600] = 100;
+    for (MatrixDSP::simd::Isa isa : MatrixDspTests::testIsas) {
+        MatrixDSP::simd::setMaxIsa(isa);
+        MatrixDSP::Stats<float> single = data.stats();
+        EXPECT_EQ(-100, single.min) << "isa " << (int) isa;
+        EXPECT_EQ(1500u, single.minLoc) << "isa " << (int) isa;
+        EXPECT_EQ(100, single.max) << "isa " << (int) isa;
+        EXPECT_EQ(1600u, single.maxLoc) << "isa " << (int) isa;
+        MatrixDSP::Stats<float, double> wide = data.stats<double>();
+        EXPECT_EQ(1500u, wide.minLoc) << "isa " << (int) isa;
+        EXPECT_EQ(1600u, wide.maxLoc) << "isa " << (int) isa;
+        EXPECT_EQ(data.min(), single.min) << "isa " << (int) isa;
+    }
+}
+
 TEST(Method, Median) {
     MatrixDSP::Vector<float> buf1({10, 2, 3, 8, 9});
     EXPECT_EQ(8, MatrixDSP::median(buf1));
@@ -304,6 +515,43 @@ TEST(Method, Median) {
     EXPECT_EQ(5.5f, MatrixDSP::median(buf2));
 }
 
+TEST(Method, Quantile) {
+    MatrixDSP::Vector<double> buf({7, 3, 10, 1, 5, 9, 2, 8, 6, 4});
+    EXPECT_EQ(3, MatrixDSP::quantile(buf, 0.25));
+    EXPECT_EQ(5.5, buf.quantile(0.5));
+    EXPECT_EQ(9.5, MatrixDSP::percentile(buf, 90));
+    EXPECT_EQ(1, buf.quantile(0));
+    EXPECT_EQ(1, buf.quantile(0.01));
+    EXPECT_EQ(10, buf.quantile(1));
+    EXPECT_EQ(7, buf[0]);
+
+    std::vector<double> percents = MatrixDSP::percentiles(buf, {95, 5, 50, 50, 33});
+    ASSERT_EQ(5u, percents.size());
+    EXPECT_EQ(10, percents[0]);
+    EXPECT_EQ(1, percents[1]);
+    EXPECT_EQ(5.5, percents[2]);
+    EXPECT_EQ(5.5, percents[3]);
+    EXPECT_NEAR(3.8, percents[4], 1e-12);
+
+    // Against a sort, with lots of repeated values.  Quantile (k + 0.5)/N is sample k.
+    MatrixDSP::Vector<double> noise(1001);
+    for (unsigned index=0; index<noise.size(); index++) {
+        noise[index] = (index * 7919u) % 97u;
+    }
+    std::vector<double> sorted(noise.vec.begin(), noise.vec.end());
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<unsigned> ranks = {999, 500, 100, 250, 0, 750, 900, 1000};
+    std::vector<double> probabilities;
+    for (unsigned rank : ranks) {
+        probabilities.push_back((rank + 0.5) / 1001);
+    }
+    std::vector<double> quantiles = MatrixDSP::quantiles(noise, probabilities);
+    for (unsigned index=0; index<ranks.size(); index++) {
+        EXPECT_NEAR(sorted[ranks[index]], quantiles[index], 1e-9) << ranks[index];
+    }
+    EXPECT_EQ(sorted[500], noise.median());
+}
+
 TEST(Method, Max) {
     MatrixDSP::Vector<float> buf1({10, 2, 3, 8, 9});
     EXPECT_EQ(10, MatrixDSP::max(buf1));
@@ -0,0 +1,184 @@
+//
+//  ViewTest.cpp
+//  MatrixDspTests
+//
+
+#include "Matrix2d.h"
+#include "ComplexVector.h"
+#include "gtest/gtest.h"
+#include <complex>
+#include <vector>
+
+TEST(VectorView, ExternalMemory) {
+    float buffer[8] = {1, -2, 3, -4, 5, -6, 7, -8};
+    MatrixDSP::VectorView<float> view(buffer + 2, 4);
+
+    EXPECT_EQ(4u, view.size());
+    EXPECT_EQ(buffer + 2, view.data());
+    EXPECT_EQ(3, view[0]);
+    EXPECT_EQ(-6, view(3));
+    EXPECT_EQ(-2, view.sum());
+    EXPECT_EQ(-0.5, view.mean());
+    unsigned loc;
+    EXPECT_EQ(5, view.max(&loc));
+    EXPECT_EQ(2u, loc);
+    EXPECT_EQ(-6, view.min(&loc));
+    EXPECT_EQ(3u, loc);
+
+    view.abs();
+    view *= 2.0f;
+    view += 1.0f;
+    float expected[8] = {1, -2, 7, 9, 11, 13, 7, -8};
+    for (unsigned index=0; index<8; index++) {
+        EXPECT_EQ(expected[index], buffer[index]);
+    }
+
+    view.reverse();
+    EXPECT_EQ(13, buffer[2]);
+    EXPECT_EQ(7, buffer[5]);
+    view.vectorRotate(-1);
+    EXPECT_EQ(7, buffer[2]);
+    EXPECT_EQ(13, buffer[3]);
+    view.fill(0);
+    EXPECT_EQ(-2, buffer[1]);
+    EXPECT_EQ(0, buffer[2]);
+    EXPECT_EQ(0, buffer[5]);
+    EXPECT_EQ(7, buffer[6]);
+}
+
+TEST(VectorView, Expressions) {
+    MatrixDSP::Vector<double> a = {1, 2, 3, 4, 5, 6};
+    MatrixDSP::Vector<double> b = {6, 5, 4, 3, 2, 1};
+    std::vector<double> buffer(8, 100);
+
+    MatrixDSP::VectorView<double> out(buffer.data() + 1, 6);
+    out = a * b + a;
+    for (unsigned index=0; index<6; index++) {
+        EXPECT_EQ(a[index] * b[index] + a[index], buffer[index + 1]);
+    }
+    EXPECT_EQ(100, buffer[0]);
+    EXPECT_EQ(100, buffer[7]);
+
+    // Views are operands too, and compound operators take expressions
+    MatrixDSP::Vector<double> c = out - a.view();
+    out -= a;
+    for (unsigned index=0; index<6; index++) {
+        EXPECT_EQ(a[index] * b[index], c[index]);
+        EXPECT_EQ(c[index], out[index]);
+    }
+    out += a * b;
+    a -= out.view(0, 6);
+    for (unsigned index=0; index<6; index++) {
+        EXPECT_EQ(2 * c[index], out[index]);
+        EXPECT_EQ(index + 1 - 2 * c[index], a[index]);
+    }
+
+    // Assigning a view to a view copies the elements
+    MatrixDSP::VectorView<double> first(buffer.data(), 3);
+    MatrixDSP::VectorView<double> last(buffer.data() + 5, 3);
+    first = last;
+    EXPECT_EQ(buffer[5], buffer[0]);
+    EXPECT_EQ(buffer[7], buffer[2]);
+    EXPECT_EQ(buffer.data() + 5, last.data());
+}
+
+TEST(VectorView, OfVector) {
+    MatrixDSP::Vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8};
+    MatrixDSP::VectorView<int> middle = vec.view(2, 4);
+    middle.cumsum();
+    MatrixDSP::Vector<int> expected = {1, 2, 3, 7, 12, 18, 7, 8};
+    EXPECT_EQ(expected.vec, vec.vec);
+
+    int previous = 0;
+    middle.diff(&previous);
+    EXPECT_EQ(18, previous);
+    EXPECT_EQ(3, vec[2]);
+    EXPECT_EQ(6, vec[5]);
+
+    const MatrixDSP::Vector<int> &constVec = vec;
+    MatrixDSP::VectorView<const int> readOnly = constVec.view();
+    MatrixDSP::Vector<int> copy = readOnly;
+    EXPECT_EQ(vec.vec, copy.vec);
+    EXPECT_EQ(8u, readOnly.size());
+    EXPECT_EQ(36, readOnly.sum());
+
+    std::vector<int> stdVec = {1, 2};
+    MatrixDSP::VectorView<int> stdView(stdVec);
+    stdView *= 3;
+    EXPECT_EQ(6, stdVec[1]);
+
+    MatrixDSP::ComplexVector<float> complexVec(4);
+    complexVec.view(1, 2) += std::complex<float>(1, 2);
+    EXPECT_EQ(std::complex<float>(0, 0), complexVec[0]);
+    EXPECT_EQ(std::complex<float>(1, 2), complexVec[2]);
+    EXPECT_EQ(std::complex<float>(0, 0), complexVec[3]);
+}
+
+TEST(MatrixView, Strided) {
+    std::vector<float> buffer(6 * 10);
+    for (unsigned index=0; index<buffer.size(); index++) {
+        buffer[index] = (float) index;
+    }
+    // 4 x 5 block of a 6 x 10 matrix
+    MatrixDSP::MatrixView<float> full(buffer.data(), 6, 10);
+    MatrixDSP::MatrixView<float> block = full.view(1, 2, 4, 5);
+    EXPECT_EQ(4u, block.getRows());
+    EXPECT_EQ(5u, block.getCols());
+    EXPECT_EQ(10u, block.ld());
+    EXPECT_EQ(12, block(0, 0));
+    EXPECT_EQ(46, block(3, 4));
+
+    MatrixDSP::Matrix2d<float> copy = block;
+    EXPECT_EQ(4u, copy.getRows());
+    EXPECT_EQ(5u, copy.getCols());
+    EXPECT_EQ(24, copy(1, 2));
+
+    block *= 2.0f;
+    block -= copy;
+    block += copy + copy;
+    for (unsigned row=0; row<6; row++) {
+        for (unsigned col=0; col<10; col++) {
+            float original = (float) (row * 10 + col);
+            bool inBlock = row >= 1 && row < 5 && col >= 2 && col < 7;
+            EXPECT_EQ(inBlock ? 3 * original : original, full(row, col));
+        }
+    }
+
+    MatrixDSP::VectorView<float> row = block.row(2);
+    EXPECT_EQ(5u, row.size());
+    EXPECT_EQ(3 * 32, row[0]);
+
+    block.fill(-1);
+    EXPECT_EQ(-1, buffer[12]);
+    EXPECT_EQ(11, buffer[11]);
+    EXPECT_EQ(17, buffer[17]);
+}
+
+TEST(MatrixView, OfMatrix) {
+    MatrixDSP::Matrix2d<double> a = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+    MatrixDSP::Matrix2d<double> b = {{10, 20}, {30, 40}};
+
+    // Write to the bottom right corner, reading the top left corner
+    a.view(1, 2, 2, 2) = b + a.view(0, 0, 2, 2);
+    MatrixDSP::Matrix2d<double> expected = {{1, 2, 3, 4}, {5, 6, 11, 22}, {9, 10, 35, 46}};
+    for (unsigned row=0; row<3; row++) {
+        for (unsigned col=0; col<4; col++) {
+            EXPECT_EQ(expected(row, col), a(row, col));
+        }
+    }
+
+    b -= a.view(0, 1, 2, 2);
+    EXPECT_EQ(8, b(0, 0));
+    EXPECT_EQ(29, b(1, 1));
+
+    a.rowView(0) *= 2.0;
+    EXPECT_EQ(6, a(0, 2));
+    EXPECT_EQ(5, a(1, 0));
+
+    const MatrixDSP::Matrix2d<double> &constA = a;
+    MatrixDSP::MatrixView<const double> readOnly = constA.view(1, 0, 2, 3);
+    MatrixDSP::Matrix2d<double> sum = readOnly + readOnly;
+    EXPECT_EQ(2u, sum.getRows());
+    EXPECT_EQ(3u, sum.getCols());
+    EXPECT_EQ(70, sum(1, 2));
+}